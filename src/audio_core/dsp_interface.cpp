@@ -2,23 +2,40 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <cstring>
 #include "audio_core/dsp_interface.h"
 #include "audio_core/sink.h"
 #include "audio_core/sink_details.h"
 #include "common/assert.h"
+#include "core/perf_stats.h"
 #include "core/settings.h"
 
 namespace AudioCore {
 
+// Bounds of the amount of audio kept queued ahead of the sink, in seconds
+constexpr double min_target_latency = 0.025;
+constexpr double max_target_latency = 0.200;
+// How long the output has to go without underruns before the target latency is lowered, in seconds
+constexpr double latency_decay_interval = 5.0;
+
 DspInterface::DspInterface() = default;
 DspInterface::~DspInterface() = default;
 
 void DspInterface::SetSink(const std::string& sink_id, const std::string& audio_device) {
-    sink = CreateSinkFromID(Settings::values.sink_id, Settings::values.audio_device_id);
+    sink = CreateSinkFromID(sink_id, audio_device);
+    output_sample_rate = sink->GetNativeSampleRate();
+    time_stretcher.SetOutputSampleRate(output_sample_rate);
+    target_latency_frames = static_cast<std::size_t>(output_sample_rate * min_target_latency);
+    frames_since_adjustment = 0;
+    refilling = true;
+    starved = true;
+    UpdateTargetLatency(0, false);
     sink->SetCallback(
         [this](s16* buffer, std::size_t num_frames) { OutputCallback(buffer, num_frames); });
-    time_stretcher.SetOutputSampleRate(sink->GetNativeSampleRate());
 }
 
 Sink& DspInterface::GetSink() {
@@ -36,6 +53,10 @@ void DspInterface::EnableStretching(bool enable) {
     perform_time_stretching = enable;
 }
 
+void DspInterface::SetPerfStats(Core::PerfStats* perf_stats) {
+    this->perf_stats = perf_stats;
+}
+
 void DspInterface::OutputFrame(StereoFrame16& frame) {
     if (!sink)
         return;
@@ -51,18 +72,46 @@ void DspInterface::OutputSample(std::array<s16, 2> sample) {
 }
 
 void DspInterface::OutputCallback(s16* buffer, std::size_t num_frames) {
+    const bool stretching = perform_time_stretching;
+    // Whether the output was meant to be playing audio rather than holding the last frame
+    bool playing = true;
     std::size_t frames_written;
-    if (perform_time_stretching) {
-        const std::vector<s16> in{fifo.Pop()};
-        const std::size_t num_in{in.size() / 2};
-        frames_written = time_stretcher.Process(in.data(), num_in, buffer, num_frames);
+    if (stretching) {
+        // The time stretcher keeps its backlog at the target latency by itself
+        const std::size_t num_in = fifo.Pop(stretch_buffer.data(), fifo_capacity);
+        frames_written = time_stretcher.Process(stretch_buffer.data(), num_in, buffer, num_frames);
+        refilling = false;
     } else if (flushing_time_stretcher) {
         time_stretcher.Flush();
         frames_written = time_stretcher.Process(nullptr, 0, buffer, num_frames);
-        frames_written += fifo.Pop(buffer, num_frames - frames_written);
+        frames_written += fifo.Pop(buffer + 2 * frames_written, num_frames - frames_written);
         flushing_time_stretcher = false;
     } else {
-        frames_written = fifo.Pop(buffer, num_frames);
+        // After running dry, build the queue back up to the target latency before resuming so
+        // that the next hiccup of the sink or the emulation can be absorbed.
+        if (refilling && fifo.Size() >= target_latency_frames) {
+            refilling = false;
+        }
+        playing = !refilling;
+        frames_written = playing ? PopAndCatchUp(buffer, num_frames) : 0;
+    }
+
+    // Only count running dry once, rather than for every callback until audio resumes
+    const bool ran_dry = playing && frames_written < num_frames;
+    const bool underrun = ran_dry && !starved;
+    starved = ran_dry;
+    if (ran_dry && !stretching) {
+        refilling = true;
+    }
+    UpdateTargetLatency(num_frames, underrun);
+
+    if (Core::PerfStats* stats = perf_stats.load(std::memory_order_relaxed)) {
+        std::size_t queued_frames = fifo.Size() + num_frames;
+        if (stretching) {
+            queued_frames += time_stretcher.GetBacklog();
+        }
+        stats->AddAudioOutput(
+            std::chrono::microseconds(queued_frames * 1'000'000 / output_sample_rate), underrun);
     }
 
     if (frames_written > 0) {
@@ -86,4 +135,54 @@ void DspInterface::OutputCallback(s16* buffer, std::size_t num_frames) {
     }
 }
 
+std::size_t DspInterface::PopAndCatchUp(s16* buffer, std::size_t num_frames) {
+    // Frames queued beyond what is needed for this callback and the target latency
+    const std::size_t queued = fifo.Size();
+    const std::size_t excess =
+        queued > target_latency_frames + num_frames ? queued - target_latency_frames - num_frames
+                                                    : 0;
+    // Play at most ~1.5% faster, which is hardly audible
+    const std::size_t skip =
+        num_frames < fifo_capacity ? std::min({excess, num_frames / 64, fifo_capacity - num_frames})
+                                   : 0;
+    if (skip == 0) {
+        return fifo.Pop(buffer, num_frames);
+    }
+
+    const std::size_t num_in = fifo.Pop(stretch_buffer.data(), num_frames + skip);
+    const double step = static_cast<double>(num_in - 1) / static_cast<double>(num_frames - 1);
+    for (std::size_t i = 0; i < num_frames; i++) {
+        const double position = i * step;
+        const auto index = std::min(static_cast<std::size_t>(position), num_in - 2);
+        const double fraction = position - index;
+        for (std::size_t channel = 0; channel < 2; channel++) {
+            const s16 a = stretch_buffer[index * 2 + channel];
+            const s16 b = stretch_buffer[index * 2 + 2 + channel];
+            buffer[i * 2 + channel] = static_cast<s16>(a + (b - a) * fraction);
+        }
+    }
+    return num_frames;
+}
+
+void DspInterface::UpdateTargetLatency(std::size_t num_frames, bool underrun) {
+    const auto max_frames = static_cast<std::size_t>(output_sample_rate * max_target_latency);
+    if (underrun) {
+        // Back off quickly, as whatever caused the underrun is likely to happen again. The queue
+        // has to be able to hold at least one more callback's worth of frames.
+        target_latency_frames = std::min(target_latency_frames * 3 / 2 + num_frames, max_frames);
+        frames_since_adjustment = 0;
+    } else {
+        frames_since_adjustment += num_frames;
+        if (frames_since_adjustment >= output_sample_rate * latency_decay_interval) {
+            const auto min_frames =
+                static_cast<std::size_t>(output_sample_rate * min_target_latency);
+            target_latency_frames =
+                std::max(target_latency_frames - target_latency_frames / 8, min_frames);
+            frames_since_adjustment = 0;
+        }
+    }
+    time_stretcher.SetTargetLatency(static_cast<double>(target_latency_frames) /
+                                    output_sample_rate);
+}
+
 } // namespace AudioCore
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <vector>
 #include "audio_core/audio_types.h"
@@ -12,6 +13,10 @@
 #include "common/ring_buffer.h"
 #include "core/memory.h"
 
+namespace Core {
+class PerfStats;
+} // namespace Core
+
 namespace Service::DSP {
 class DSP_DSP;
 } // namespace Service::DSP
@@ -98,6 +103,8 @@ public:
     Sink& GetSink();
     /// Enable/Disable audio stretching.
     void EnableStretching(bool enable);
+    /// Sets where the latency and underruns of the audio output are reported to.
+    void SetPerfStats(Core::PerfStats* perf_stats);
 
 protected:
     void OutputFrame(StereoFrame16& frame);
@@ -106,13 +113,35 @@ protected:
 private:
     void FlushResidualStretcherAudio();
     void OutputCallback(s16* buffer, std::size_t num_frames);
+    /// Pops frames from the fifo, playing them slightly faster while too many are queued.
+    std::size_t PopAndCatchUp(s16* buffer, std::size_t num_frames);
+    /// Grows the target latency after an underrun, and slowly shrinks it back while there are none.
+    void UpdateTargetLatency(std::size_t num_frames, bool underrun);
+
+    static constexpr std::size_t fifo_capacity = 0x2000;
 
     std::unique_ptr<Sink> sink;
+    std::atomic<Core::PerfStats*> perf_stats = nullptr;
     std::atomic<bool> perform_time_stretching = false;
     std::atomic<bool> flushing_time_stretcher = false;
-    Common::RingBuffer<s16, 0x2000, 2> fifo;
+    Common::RingBuffer<s16, fifo_capacity, 2> fifo;
+    /// Scratch space the fifo is drained into before being time stretched or resampled.
+    std::array<s16, fifo_capacity * 2> stretch_buffer{};
     std::array<s16, 2> last_frame{};
     TimeStretcher time_stretcher;
+
+    // The following are only accessed by the sink's callback (once the sink is set).
+
+    /// Sample rate of the sink
+    unsigned int output_sample_rate = native_sample_rate;
+    /// Number of frames the output tries to keep queued ahead of the sink
+    std::size_t target_latency_frames = 0;
+    /// Number of frames output since the target latency was last changed
+    std::size_t frames_since_adjustment = 0;
+    /// Whether output is held until the fifo holds target_latency_frames again
+    bool refilling = true;
+    /// Whether the previous callback ran out of samples while playing
+    bool starved = true;
 };
 
 } // namespace AudioCore
@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <thread>
 #include "audio_core/audio_types.h"
 #ifdef HAVE_MF
 #include "audio_core/hle/wmf_decoder.h"
@@ -19,6 +21,7 @@
 #include "common/common_types.h"
 #include "common/hash.h"
 #include "common/logging/log.h"
+#include "common/thread_worker.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 
@@ -29,6 +32,9 @@ namespace AudioCore {
 
 static constexpr u64 audio_frame_ticks = 1310252ull; ///< Units: ARM11 cycles
 
+/// Upper bound on the number of threads generating sources, as there are only 24 of them
+static constexpr unsigned max_source_workers = 4;
+
 struct DspHle::Impl final {
 public:
     explicit Impl(DspHle& parent, Memory::MemorySystem& memory);
@@ -72,6 +78,9 @@ private:
     }};
     HLE::Mixers mixers;
 
+    /// Sources don't share any state, so they are generated in parallel when this isn't null
+    std::unique_ptr<Common::ThreadWorker> source_workers;
+
     DspHle& parent;
     Core::TimingEventType* tick_event;
 
@@ -87,6 +96,11 @@ DspHle::Impl::Impl(DspHle& parent_, Memory::MemorySystem& memory) : parent(paren
         source.SetMemory(memory);
     }
 
+    const unsigned num_workers = std::min(std::thread::hardware_concurrency(), max_source_workers);
+    if (num_workers > 1) {
+        source_workers = std::make_unique<Common::ThreadWorker>(num_workers, "DspHle");
+    }
+
 #ifdef HAVE_MF
     decoder = std::make_unique<HLE::WMFDecoder>(memory);
 #elif HAVE_FFMPEG
@@ -352,10 +366,26 @@ StereoFrame16 DspHle::Impl::GenerateCurrentFrame() {
 
     std::array<QuadFrame32, 3> intermediate_mixes = {};
 
+    // Generate every stride-th source, starting at first
+    const auto tick_sources = [&](std::size_t first, std::size_t stride) {
+        for (std::size_t i = first; i < HLE::num_sources; i += stride) {
+            write.source_statuses.status[i] = sources[i].Tick(read.source_configurations.config[i],
+                                                              read.adpcm_coefficients.coeff[i]);
+        }
+    };
+    if (source_workers) {
+        const std::size_t num_workers = source_workers->NumWorkers();
+        for (std::size_t worker = 0; worker < num_workers; worker++) {
+            source_workers->QueueWork(
+                [&tick_sources, worker, num_workers] { tick_sources(worker, num_workers); });
+        }
+        source_workers->WaitForRequests();
+    } else {
+        tick_sources(0, 1);
+    }
+
     // Generate intermediate mixes
     for (std::size_t i = 0; i < HLE::num_sources; i++) {
-        write.source_statuses.status[i] =
-            sources[i].Tick(read.source_configurations.config[i], read.adpcm_coefficients.coeff[i]);
         for (std::size_t mix = 0; mix < 3; mix++) {
             sources[i].MixInto(intermediate_mixes[mix], mix);
         }
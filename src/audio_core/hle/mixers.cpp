@@ -4,6 +4,10 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
 #include "audio_core/hle/mixers.h"
 #include "common/assert.h"
 #include "common/logging/log.h"
@@ -94,6 +98,39 @@ static std::array<s16, 2> AddAndClampToS16(const std::array<s16, 2>& a,
             ClampToS16(static_cast<s32>(a[1]) + static_cast<s32>(b[1]))};
 }
 
+/// Downmixes quadraphonic samples to stereo and accumulates them into frame
+static void DownmixStereoAndMix(StereoFrame16& frame, float gain, const QuadFrame32& samples) {
+#ifdef ARCHITECTURE_x86_64
+    const __m128 vgain = _mm_set1_ps(gain);
+    for (std::size_t samplei = 0; samplei < samples_per_frame; samplei++) {
+        // Downmix to stereo
+        const __m128i sample =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples[samplei].data()));
+        const __m128 scaled = _mm_mul_ps(vgain, _mm_cvtepi32_ps(sample));
+        const __m128i stereo =
+            _mm_cvttps_epi32(_mm_add_ps(scaled, _mm_movehl_ps(scaled, scaled)));
+
+        // Mix into frame. Both the downmix and the accumulation saturate to 16 bits.
+        s32 accumulator;
+        std::memcpy(&accumulator, &frame[samplei], sizeof(accumulator));
+        const s32 mixed = _mm_cvtsi128_si32(
+            _mm_adds_epi16(_mm_cvtsi32_si128(accumulator), _mm_packs_epi32(stereo, stereo)));
+        std::memcpy(&frame[samplei], &mixed, sizeof(mixed));
+    }
+#else
+    std::transform(
+        frame.begin(), frame.end(), samples.begin(), frame.begin(),
+        [gain](const std::array<s16, 2>& accumulator,
+               const std::array<s32, 4>& sample) -> std::array<s16, 2> {
+            // Downmix to stereo
+            s16 left = ClampToS16(static_cast<s32>(gain * sample[0] + gain * sample[2]));
+            s16 right = ClampToS16(static_cast<s32>(gain * sample[1] + gain * sample[3]));
+            // Mix into current frame
+            return AddAndClampToS16(accumulator, {left, right});
+        });
+#endif
+}
+
 void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& samples) {
     // TODO(merry): Limiter. (Currently we're performing final mixing assuming a disabled limiter.)
 
@@ -117,16 +154,7 @@ void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& sample
         // fallthrough
 
     case OutputFormat::Stereo:
-        std::transform(
-            current_frame.begin(), current_frame.end(), samples.begin(), current_frame.begin(),
-            [gain](const std::array<s16, 2>& accumulator,
-                   const std::array<s32, 4>& sample) -> std::array<s16, 2> {
-                // Downmix to stereo
-                s16 left = ClampToS16(static_cast<s32>(gain * sample[0] + gain * sample[2]));
-                s16 right = ClampToS16(static_cast<s32>(gain * sample[1] + gain * sample[3]));
-                // Mix into current frame
-                return AddAndClampToS16(accumulator, {left, right});
-            });
+        DownmixStereoAndMix(current_frame, gain, samples);
         return;
     }
 
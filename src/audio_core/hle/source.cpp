@@ -4,6 +4,10 @@
 
 #include <algorithm>
 #include <array>
+#include <cstring>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
 #include "audio_core/codec.h"
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/source.h"
@@ -30,6 +34,24 @@ void Source::MixInto(QuadFrame32& dest, std::size_t intermediate_mix_id) const {
         return;
 
     const std::array<float, 4>& gains = state.gain.at(intermediate_mix_id);
+    if (gains == std::array<float, 4>{}) {
+        return;
+    }
+
+#ifdef ARCHITECTURE_x86_64
+    const __m128 gain = _mm_loadu_ps(gains.data());
+    for (std::size_t samplei = 0; samplei < samples_per_frame; samplei++) {
+        // Spread the stereo sample to the four quadraphonic channels as left, right, left, right
+        s32 stereo;
+        std::memcpy(&stereo, &current_frame[samplei], sizeof(stereo));
+        __m128i sample = _mm_shuffle_epi32(_mm_cvtsi32_si128(stereo), 0);
+        sample = _mm_srai_epi32(_mm_unpacklo_epi16(sample, sample), 16);
+
+        const __m128i scaled = _mm_cvttps_epi32(_mm_mul_ps(gain, _mm_cvtepi32_ps(sample)));
+        __m128i* const dest_sample = reinterpret_cast<__m128i*>(&dest[samplei]);
+        _mm_storeu_si128(dest_sample, _mm_add_epi32(_mm_loadu_si128(dest_sample), scaled));
+    }
+#else
     for (std::size_t samplei = 0; samplei < samples_per_frame; samplei++) {
         // Conversion from stereo (current_frame) to quadraphonic (dest) occurs here.
         dest[samplei][0] += static_cast<s32>(gains[0] * current_frame[samplei][0]);
@@ -37,6 +59,7 @@ void Source::MixInto(QuadFrame32& dest, std::size_t intermediate_mix_id) const {
         dest[samplei][2] += static_cast<s32>(gains[2] * current_frame[samplei][0]);
         dest[samplei][3] += static_cast<s32>(gains[3] * current_frame[samplei][1]);
     }
+#endif
 }
 
 void Source::Reset() {
@@ -232,7 +255,7 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config,
 void Source::GenerateFrame() {
     current_frame.fill({});
 
-    if (state.current_buffer.empty() && !DequeueBuffer()) {
+    if (CurrentBufferEmpty() && !DequeueBuffer()) {
         state.enabled = false;
         state.buffer_update = true;
         state.current_buffer_id = 0;
@@ -243,24 +266,30 @@ void Source::GenerateFrame() {
 
     state.current_sample_number = state.next_sample_number;
     while (frame_position < current_frame.size()) {
-        if (state.current_buffer.empty() && !DequeueBuffer()) {
+        if (CurrentBufferEmpty() && !DequeueBuffer()) {
             break;
         }
 
+        const std::array<s16, 2>* input =
+            state.current_buffer.data() + state.current_buffer_position;
+        const std::size_t input_size = state.current_buffer.size() - state.current_buffer_position;
         switch (state.interpolation_mode) {
         case InterpolationMode::None:
-            AudioInterp::None(state.interp_state, state.current_buffer, state.rate_multiplier,
-                              current_frame, frame_position);
+            state.current_buffer_position +=
+                AudioInterp::None(state.interp_state, input, input_size, state.rate_multiplier,
+                                  current_frame, frame_position);
             break;
         case InterpolationMode::Linear:
-            AudioInterp::Linear(state.interp_state, state.current_buffer, state.rate_multiplier,
-                                current_frame, frame_position);
+            state.current_buffer_position +=
+                AudioInterp::Linear(state.interp_state, input, input_size, state.rate_multiplier,
+                                    current_frame, frame_position);
             break;
         case InterpolationMode::Polyphase:
             // TODO(merry): Implement polyphase interpolation
             LOG_DEBUG(Audio_DSP, "Polyphase interpolation unimplemented; falling back to linear");
-            AudioInterp::Linear(state.interp_state, state.current_buffer, state.rate_multiplier,
-                                current_frame, frame_position);
+            state.current_buffer_position +=
+                AudioInterp::Linear(state.interp_state, input, input_size, state.rate_multiplier,
+                                    current_frame, frame_position);
             break;
         default:
             UNIMPLEMENTED();
@@ -272,9 +301,13 @@ void Source::GenerateFrame() {
     state.filters.ProcessFrame(current_frame);
 }
 
+bool Source::CurrentBufferEmpty() const {
+    // Only the historical samples are left
+    return state.current_buffer.size() - state.current_buffer_position <= 2;
+}
+
 bool Source::DequeueBuffer() {
-    ASSERT_MSG(state.current_buffer.empty(),
-               "Shouldn't dequeue; we still have data in current_buffer");
+    ASSERT_MSG(CurrentBufferEmpty(), "Shouldn't dequeue; we still have data in current_buffer");
 
     if (state.input_queue.empty())
         return false;
@@ -291,18 +324,23 @@ bool Source::DequeueBuffer() {
     // firmware.
     const u8* const memory = memory_system->GetPhysicalPointer(buf.physical_address & 0xFFFFFFFC);
     if (memory) {
+        state.current_buffer.clear();
+        state.current_buffer.push_back(state.interp_state.xn2);
+        state.current_buffer.push_back(state.interp_state.xn1);
+        state.current_buffer_position = 0;
+
         const unsigned num_channels = buf.mono_or_stereo == MonoOrStereo::Stereo ? 2 : 1;
         switch (buf.format) {
         case Format::PCM8:
-            state.current_buffer = Codec::DecodePCM8(num_channels, memory, buf.length);
+            Codec::DecodePCM8(num_channels, memory, buf.length, state.current_buffer);
             break;
         case Format::PCM16:
-            state.current_buffer = Codec::DecodePCM16(num_channels, memory, buf.length);
+            Codec::DecodePCM16(num_channels, memory, buf.length, state.current_buffer);
             break;
         case Format::ADPCM:
             DEBUG_ASSERT(num_channels == 1);
-            state.current_buffer =
-                Codec::DecodeADPCM(memory, buf.length, state.adpcm_coeffs, state.adpcm_state);
+            Codec::DecodeADPCM(memory, buf.length, state.adpcm_coeffs, state.adpcm_state,
+                               state.current_buffer);
             break;
         default:
             UNIMPLEMENTED();
@@ -313,6 +351,7 @@ bool Source::DequeueBuffer() {
                     "source_id={} buffer_id={} length={}: Invalid physical address {:#010x}",
                     source_id, buf.buffer_id, buf.length, buf.physical_address);
         state.current_buffer.clear();
+        state.current_buffer_position = 0;
         return true;
     }
 
@@ -328,7 +367,7 @@ bool Source::DequeueBuffer() {
     }
 
     LOG_TRACE(Audio_DSP, "source_id={} buffer_id={} from_queue={} current_buffer.size()={}",
-              source_id, buf.buffer_id, buf.from_queue, state.current_buffer.size());
+              source_id, buf.buffer_id, buf.from_queue, state.current_buffer.size() - 2);
     return true;
 }
 
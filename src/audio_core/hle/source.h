@@ -115,7 +115,11 @@ private:
 
         u32 current_sample_number = 0;
         u32 next_sample_number = 0;
-        AudioInterp::StereoBuffer16 current_buffer;
+        /// Decoded samples of the current buffer, preceded by the two historical samples of the
+        /// interpolator. The storage is reused from buffer to buffer.
+        StereoBuffer16 current_buffer;
+        /// Index of the historical samples for the next unconsumed sample of current_buffer
+        std::size_t current_buffer_position = 0;
 
         // buffer_id state
 
@@ -145,6 +149,8 @@ private:
     void ParseConfig(SourceConfiguration::Configuration& config, const s16_le (&adpcm_coeffs)[16]);
     /// INTERNAL: Generate the current audio output for this frame based on our internal state.
     void GenerateFrame();
+    /// INTERNAL: Returns whether every sample of current_buffer has been consumed.
+    bool CurrentBufferEmpty() const;
     /// INTERNAL: Dequeues a buffer and does preprocessing on it (decoding, resampling). Puts it
     /// into current_buffer.
     bool DequeueBuffer();
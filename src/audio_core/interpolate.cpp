@@ -16,24 +16,38 @@ constexpr u64 scale_mask = scale_factor - 1;
 /// Here we step over the input in steps of rate, until we consume all of the input.
 /// Three adjacent samples are passed to fn each step.
 template <typename Function>
-static void StepOverSamples(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
-                            std::size_t& outputi, Function fn) {
+static std::size_t StepOverSamples(State& state, const std::array<s16, 2>* input,
+                                   std::size_t input_size, float rate, StereoFrame16& output,
+                                   std::size_t& outputi, Function fn) {
     ASSERT(rate > 0);
 
-    if (input.empty())
-        return;
-
-    input.insert(input.begin(), {state.xn2, state.xn1});
+    if (input_size <= 2)
+        return 0;
 
     const u64 step_size = static_cast<u64>(rate * scale_factor);
     u64 fposition = state.fposition;
     std::size_t inputi = 0;
 
+    // At the native rate every output sample is an input sample, as both interpolators return x0
+    // when the fraction is zero.
+    if (step_size == scale_factor && (fposition & scale_mask) == 0) {
+        const std::size_t start = static_cast<std::size_t>(fposition / scale_factor);
+        if (start + 2 < input_size) {
+            const std::size_t count = std::min(output.size() - outputi, input_size - 2 - start);
+            if (count > 0) {
+                std::copy_n(input + start, count, output.begin() + outputi);
+                outputi += count;
+                inputi = start + count - 1;
+                fposition += count * scale_factor;
+            }
+        }
+    }
+
     while (outputi < output.size()) {
         inputi = static_cast<std::size_t>(fposition / scale_factor);
 
-        if (inputi + 2 >= input.size()) {
-            inputi = input.size() - 2;
+        if (inputi + 2 >= input_size) {
+            inputi = input_size - 2;
             break;
         }
 
@@ -47,30 +61,30 @@ static void StepOverSamples(State& state, StereoBuffer16& input, float rate, Ste
     state.xn1 = input[inputi + 1];
     state.fposition = fposition - inputi * scale_factor;
 
-    input.erase(input.begin(), std::next(input.begin(), inputi + 2));
+    return inputi;
 }
 
-void None(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
-          std::size_t& outputi) {
-    StepOverSamples(
-        state, input, rate, output, outputi,
+std::size_t None(State& state, const std::array<s16, 2>* input, std::size_t input_size,
+                 float rate, StereoFrame16& output, std::size_t& outputi) {
+    return StepOverSamples(
+        state, input, input_size, rate, output, outputi,
         [](u64 fraction, const auto& x0, const auto& x1, const auto& x2) { return x0; });
 }
 
-void Linear(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
-            std::size_t& outputi) {
+std::size_t Linear(State& state, const std::array<s16, 2>* input, std::size_t input_size,
+                   float rate, StereoFrame16& output, std::size_t& outputi) {
     // Note on accuracy: Some values that this produces are +/- 1 from the actual firmware.
-    StepOverSamples(state, input, rate, output, outputi,
-                    [](u64 fraction, const auto& x0, const auto& x1, const auto& x2) {
-                        // This is a saturated subtraction. (Verified by black-box fuzzing.)
-                        s64 delta0 = std::clamp<s64>(x1[0] - x0[0], -32768, 32767);
-                        s64 delta1 = std::clamp<s64>(x1[1] - x0[1], -32768, 32767);
-
-                        return std::array<s16, 2>{
-                            static_cast<s16>(x0[0] + fraction * delta0 / scale_factor),
-                            static_cast<s16>(x0[1] + fraction * delta1 / scale_factor),
-                        };
-                    });
+    return StepOverSamples(state, input, input_size, rate, output, outputi,
+                           [](u64 fraction, const auto& x0, const auto& x1, const auto& x2) {
+                               // This is a saturated subtraction. (Verified by black-box fuzzing.)
+                               s64 delta0 = std::clamp<s64>(x1[0] - x0[0], -32768, 32767);
+                               s64 delta1 = std::clamp<s64>(x1[1] - x0[1], -32768, 32767);
+
+                               return std::array<s16, 2>{
+                                   static_cast<s16>(x0[0] + fraction * delta0 / scale_factor),
+                                   static_cast<s16>(x0[1] + fraction * delta1 / scale_factor),
+                               };
+                           });
 }
 
 } // namespace AudioCore::AudioInterp
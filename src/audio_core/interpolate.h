@@ -5,15 +5,11 @@
 #pragma once
 
 #include <array>
-#include <deque>
 #include "audio_core/audio_types.h"
 #include "common/common_types.h"
 
 namespace AudioCore::AudioInterp {
 
-/// A variable length buffer of signed PCM16 stereo samples.
-using StereoBuffer16 = std::deque<std::array<s16, 2>>;
-
 struct State {
     /// Two historical samples.
     std::array<s16, 2> xn1 = {}; ///< x[n-1]
@@ -25,25 +21,31 @@ struct State {
 /**
  * No interpolation. This is equivalent to a zero-order hold. There is a two-sample predelay.
  * @param state Interpolation state.
- * @param input Input buffer.
+ * @param input Input samples, starting with the two historical samples state.xn2 and state.xn1.
+ * @param input_size Number of samples in input, including the historical samples.
  * @param rate Stretch factor. Must be a positive non-zero value.
  *             rate > 1.0 performs decimation and rate < 1.0 performs upsampling.
  * @param output The resampled audio buffer.
  * @param outputi The index of output to start writing to.
+ * @return Number of input samples consumed. The next two input samples are the new historical
+ *         samples.
  */
-void None(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
-          std::size_t& outputi);
+std::size_t None(State& state, const std::array<s16, 2>* input, std::size_t input_size,
+                 float rate, StereoFrame16& output, std::size_t& outputi);
 
 /**
  * Linear interpolation. This is equivalent to a first-order hold. There is a two-sample predelay.
  * @param state Interpolation state.
- * @param input Input buffer.
+ * @param input Input samples, starting with the two historical samples state.xn2 and state.xn1.
+ * @param input_size Number of samples in input, including the historical samples.
  * @param rate Stretch factor. Must be a positive non-zero value.
  *             rate > 1.0 performs decimation and rate < 1.0 performs upsampling.
  * @param output The resampled audio buffer.
  * @param outputi The index of output to start writing to.
+ * @return Number of input samples consumed. The next two input samples are the new historical
+ *         samples.
  */
-void Linear(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
-            std::size_t& outputi);
+std::size_t Linear(State& state, const std::array<s16, 2>* input, std::size_t input_size,
+                   float rate, StereoFrame16& output, std::size_t& outputi);
 
 } // namespace AudioCore::AudioInterp
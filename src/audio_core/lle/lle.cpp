@@ -4,13 +4,15 @@
 
 #include <array>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 #include <teakra/teakra.h>
 #include "audio_core/lle/lle.h"
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/swap.h"
-#include "common/thread.h"
+#include "common/threadsafe_queue.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/lock.h"
@@ -139,46 +141,196 @@ struct DspLle::Impl final {
     Core::TimingEventType* teakra_slice_event;
     std::atomic<bool> loaded = false;
 
+    /// Register write from the CPU, applied by the Teakra thread between slices
+    struct Command {
+        enum class Type : u8 { SendData, SetSemaphore };
+        Type type;
+        u8 register_number;
+        u16 value;
+    };
+
+    /// Interrupt raised by the DSP, signalled to the DSP service on the CPU thread
+    struct Event {
+        Service::DSP::DSP_DSP::InterruptType type;
+        DspPipe pipe;
+    };
+
     const bool multithread;
     std::thread teakra_thread;
-    Common::Barrier teakra_slice_barrier{2};
-    std::atomic<bool> stop_signal = false;
-    std::size_t stop_generation;
+    Common::SPSCQueue<Command> commands;
+    Common::SPSCQueue<Event> events;
+    std::weak_ptr<Service::DSP::DSP_DSP> service;
+
+    /// Held by the Teakra thread while it runs Teakra
+    std::mutex teakra_mutex;
+    /// Number of CPU-side requests for the Teakra thread to pause between slices
+    std::atomic<u32> pause_requests = 0;
+
+    /// Guards the cycle counters and stop_signal
+    std::mutex budget_mutex;
+    /// Signalled when the Teakra thread is allowed to run more cycles or has to stop
+    std::condition_variable budget_cv;
+    /// Signalled when the Teakra thread has run more cycles
+    std::condition_variable progress_cv;
+    /// DSP cycles the Teakra thread has been given to run so far
+    u64 cycles_granted = 0;
+    /// DSP cycles the Teakra thread has run so far
+    u64 cycles_run = 0;
+    bool stop_signal = false;
 
     static constexpr u32 DspDataOffset = 0x40000;
     static constexpr u32 TeakraSlice = 20000;
+    /// Cycles the Teakra thread runs between checks for commands and pause requests
+    static constexpr u32 TeakraThreadSlice = TeakraSlice / 8;
+    /// How far the Teakra thread may run ahead of the cycles it has been given
+    static constexpr u64 MaxRunAhead = TeakraSlice * 2;
+    /// How far the Teakra thread may fall behind before the CPU waits for it
+    static constexpr u64 MaxLag = TeakraSlice * 4;
 
     void TeakraThread() {
         while (true) {
-            teakra.Run(TeakraSlice);
-            teakra_slice_barrier.Sync();
-            if (stop_signal) {
-                if (stop_generation == teakra_slice_barrier.Generation())
+            {
+                std::unique_lock lock(budget_mutex);
+                budget_cv.wait(lock, [this] {
+                    return stop_signal || cycles_run < cycles_granted + MaxRunAhead;
+                });
+                if (stop_signal)
                     break;
             }
+
+            {
+                std::lock_guard lock(teakra_mutex);
+                ApplyCommands();
+                teakra.Run(TeakraThreadSlice);
+            }
+
+            {
+                std::lock_guard lock(budget_mutex);
+                cycles_run += TeakraThreadSlice;
+            }
+            progress_cv.notify_all();
+
+            // Hand teakra_mutex over to the CPU before running on
+            while (pause_requests > 0)
+                std::this_thread::yield();
         }
-        stop_signal = false;
+    }
+
+    void StartTeakraThread() {
+        cycles_granted = 0;
+        cycles_run = 0;
+        commands.Clear();
+        teakra_thread = std::thread(&Impl::TeakraThread, this);
     }
 
     void StopTeakraThread() {
         if (teakra_thread.joinable()) {
-            stop_generation = teakra_slice_barrier.Generation() + 1;
-            stop_signal = true;
-            teakra_slice_barrier.Sync();
+            {
+                std::lock_guard lock(budget_mutex);
+                stop_signal = true;
+            }
+            budget_cv.notify_all();
             teakra_thread.join();
+            stop_signal = false;
+        }
+    }
+
+    /**
+     * Pauses the Teakra thread at its next slice boundary, so that the CPU can safely access the
+     * DSP memory shared with it. The thread resumes when the returned lock is released.
+     */
+    std::unique_lock<std::mutex> PauseTeakraThread() {
+        if (!teakra_thread.joinable())
+            return {};
+
+        ++pause_requests;
+        std::unique_lock lock(teakra_mutex);
+        --pause_requests;
+        return lock;
+    }
+
+    /// Applies the register writes queued by the CPU. Called on the Teakra thread.
+    void ApplyCommands() {
+        while (!commands.Empty()) {
+            const Command& command = commands.Front();
+            if (command.type == Command::Type::SendData) {
+                // Keep the command queued until the DSP has read the previous value
+                if (!teakra.SendDataIsEmpty(command.register_number))
+                    return;
+                teakra.SendData(command.register_number, command.value);
+            } else {
+                teakra.SetSemaphore(command.value);
+            }
+            commands.Pop();
+        }
+    }
+
+    void SendData(u8 register_number, u16 value) {
+        if (teakra_thread.joinable()) {
+            commands.Push(Command{Command::Type::SendData, register_number, value});
+            return;
+        }
+
+        while (!teakra.SendDataIsEmpty(register_number))
+            RunTeakraSlice();
+        teakra.SendData(register_number, value);
+    }
+
+    void SetSemaphore(u16 value) {
+        if (teakra_thread.joinable()) {
+            commands.Push(Command{Command::Type::SetSemaphore, 0, value});
+            return;
+        }
+
+        teakra.SetSemaphore(value);
+    }
+
+    /// Signals the interrupts raised by the DSP to the DSP service. Called on the CPU thread.
+    void SignalEvents() {
+        Event event;
+        while (events.Pop(event)) {
+            if (event.type == Service::DSP::DSP_DSP::InterruptType::Pipe &&
+                event.pipe == static_cast<DspPipe>(0)) {
+                // pipe 0 is for debug. 3DS automatically drains this pipe and discards the data
+                ReadPipe(0, GetPipeReadableSize(0));
+                continue;
+            }
+
+            std::lock_guard lock(HLE::g_hle_lock);
+            if (auto locked = service.lock()) {
+                locked->SignalInterrupt(event.type, event.pipe);
+            }
         }
     }
 
+    /// Runs the DSP for a slice on top of the emulated time, for when the CPU waits on it.
     void RunTeakraSlice() {
-        if (multithread) {
-            teakra_slice_barrier.Sync();
+        if (teakra_thread.joinable()) {
+            std::unique_lock lock(budget_mutex);
+            cycles_granted += TeakraSlice;
+            const u64 target = cycles_granted;
+            budget_cv.notify_one();
+            progress_cv.wait(lock, [this, target] { return cycles_run >= target; });
         } else {
             teakra.Run(TeakraSlice);
         }
+        SignalEvents();
     }
 
     void TeakraSliceEvent(u64 late) {
-        RunTeakraSlice();
+        if (teakra_thread.joinable()) {
+            // Let the Teakra thread run on concurrently, only waiting for it when it falls too
+            // far behind the emulated time.
+            std::unique_lock lock(budget_mutex);
+            cycles_granted += TeakraSlice;
+            budget_cv.notify_one();
+            progress_cv.wait(lock, [this] { return cycles_run + MaxLag >= cycles_granted; });
+            lock.unlock();
+            SignalEvents();
+        } else {
+            RunTeakraSlice();
+        }
+
         u64 next = TeakraSlice * 2; // DSP runs at clock rate half of the CPU rate
         if (next < late)
             next = 0;
@@ -219,6 +371,7 @@ struct DspLle::Impl final {
     }
 
     void WritePipe(u8 pipe_index, const std::vector<u8>& data) {
+        auto lock = PauseTeakraThread();
         PipeStatus pipe_status = GetPipeStatus(pipe_index, PipeDirection::CPUtoDSP);
         bool need_update = false;
         const u8* buffer_ptr = data.data();
@@ -250,13 +403,12 @@ struct DspLle::Impl final {
         }
         if (need_update) {
             UpdatePipeStatus(pipe_status);
-            while (!teakra.SendDataIsEmpty(2))
-                RunTeakraSlice();
-            teakra.SendData(2, pipe_status.slot_index);
+            SendData(2, pipe_status.slot_index);
         }
     }
 
     std::vector<u8> ReadPipe(u8 pipe_index, u16 bsize) {
+        auto lock = PauseTeakraThread();
         PipeStatus pipe_status = GetPipeStatus(pipe_index, PipeDirection::DSPtoCPU);
         bool need_update = false;
         std::vector<u8> data(bsize);
@@ -287,13 +439,12 @@ struct DspLle::Impl final {
         }
         if (need_update) {
             UpdatePipeStatus(pipe_status);
-            while (!teakra.SendDataIsEmpty(2))
-                RunTeakraSlice();
-            teakra.SendData(2, pipe_status.slot_index);
+            SendData(2, pipe_status.slot_index);
         }
         return data;
     }
-    u16 GetPipeReadableSize(u8 pipe_index) const {
+    u16 GetPipeReadableSize(u8 pipe_index) {
+        auto lock = PauseTeakraThread();
         PipeStatus pipe_status = GetPipeStatus(pipe_index, PipeDirection::DSPtoCPU);
         u16 size = pipe_status.write_bptr - pipe_status.read_bptr;
         if (pipe_status.IsWrapped()) {
@@ -327,8 +478,9 @@ struct DspLle::Impl final {
 
         Core::System::GetInstance().CoreTiming().ScheduleEvent(TeakraSlice, teakra_slice_event, 0);
 
+        events.Clear();
         if (multithread) {
-            teakra_thread = std::thread(&Impl::TeakraThread, this);
+            StartTeakraThread();
         }
 
         // Wait for initialization
@@ -359,10 +511,7 @@ struct DspLle::Impl final {
 
         // Send finalization signal via command/reply register 2
         constexpr u16 FinalizeSignal = 0x8000;
-        while (!teakra.SendDataIsEmpty(2))
-            RunTeakraSlice();
-
-        teakra.SendData(2, FinalizeSignal);
+        SendData(2, FinalizeSignal);
 
         // Wait for completion
         while (!teakra.RecvDataIsReady(2))
@@ -387,7 +536,7 @@ bool DspLle::RecvDataIsReady(u32 register_number) const {
 }
 
 void DspLle::SetSemaphore(u16 semaphore_value) {
-    impl->teakra.SetSemaphore(semaphore_value);
+    impl->SetSemaphore(semaphore_value);
 }
 
 std::vector<u8> DspLle::PipeRead(DspPipe pipe_number, u32 length) {
@@ -407,28 +556,24 @@ std::array<u8, Memory::DSP_RAM_SIZE>& DspLle::GetDspMemory() {
 }
 
 void DspLle::SetServiceToInterrupt(std::weak_ptr<Service::DSP::DSP_DSP> dsp) {
-    impl->teakra.SetRecvDataHandler(0, [this, dsp]() {
+    impl->service = std::move(dsp);
+
+    impl->teakra.SetRecvDataHandler(0, [this]() {
         if (!impl->loaded)
             return;
 
-        std::lock_guard lock(HLE::g_hle_lock);
-        if (auto locked = dsp.lock()) {
-            locked->SignalInterrupt(Service::DSP::DSP_DSP::InterruptType::Zero,
-                                    static_cast<DspPipe>(0));
-        }
+        impl->events.Push(Impl::Event{Service::DSP::DSP_DSP::InterruptType::Zero,
+                                      static_cast<DspPipe>(0)});
     });
-    impl->teakra.SetRecvDataHandler(1, [this, dsp]() {
+    impl->teakra.SetRecvDataHandler(1, [this]() {
         if (!impl->loaded)
             return;
 
-        std::lock_guard lock(HLE::g_hle_lock);
-        if (auto locked = dsp.lock()) {
-            locked->SignalInterrupt(Service::DSP::DSP_DSP::InterruptType::One,
-                                    static_cast<DspPipe>(0));
-        }
+        impl->events.Push(Impl::Event{Service::DSP::DSP_DSP::InterruptType::One,
+                                      static_cast<DspPipe>(0)});
     });
 
-    auto ProcessPipeEvent = [this, dsp](bool event_from_data) {
+    auto ProcessPipeEvent = [this](bool event_from_data) {
         if (!impl->loaded)
             return;
 
@@ -448,16 +593,8 @@ void DspLle::SetServiceToInterrupt(std::weak_ptr<Service::DSP::DSP_DSP> dsp) {
             ASSERT(pipe < 16);
             if (side != static_cast<u16>(PipeDirection::DSPtoCPU))
                 return;
-            if (pipe == 0) {
-                // pipe 0 is for debug. 3DS automatically drains this pipe and discards the data
-                impl->ReadPipe(pipe, impl->GetPipeReadableSize(pipe));
-            } else {
-                std::lock_guard lock(HLE::g_hle_lock);
-                if (auto locked = dsp.lock()) {
-                    locked->SignalInterrupt(Service::DSP::DSP_DSP::InterruptType::Pipe,
-                                            static_cast<DspPipe>(pipe));
-                }
-            }
+            impl->events.Push(Impl::Event{Service::DSP::DSP_DSP::InterruptType::Pipe,
+                                          static_cast<DspPipe>(pipe)});
         }
     };
 
@@ -5,11 +5,17 @@
 #pragma once
 
 #include <cstddef>
+#include <functional>
+#include <utility>
 #include "audio_core/audio_types.h"
 #include "audio_core/sink.h"
 
 namespace AudioCore {
 
+/**
+ * Sink that discards audio. It has no audio thread of its own; audio is only requested from the
+ * callback when Pull is called.
+ */
 class NullSink final : public Sink {
 public:
     explicit NullSink(std::string_view) {}
@@ -19,7 +25,22 @@ public:
         return native_sample_rate;
     }
 
-    void SetCallback(std::function<void(s16*, std::size_t)>) override {}
+    void SetCallback(std::function<void(s16*, std::size_t)> cb) override {
+        this->cb = std::move(cb);
+    }
+
+    /**
+     * Requests audio from the callback, as the audio thread of a real sink would.
+     * @param buffer Buffer to receive num_frames stereo frames
+     * @param num_frames Number of frames to request
+     */
+    void Pull(s16* buffer, std::size_t num_frames) {
+        if (cb)
+            cb(buffer, num_frames);
+    }
+
+private:
+    std::function<void(s16*, std::size_t)> cb;
 };
 
 } // namespace AudioCore
@@ -25,7 +25,15 @@ TimeStretcher::~TimeStretcher() = default;
 
 void TimeStretcher::SetOutputSampleRate(unsigned int sample_rate) {
     sound_touch->setSampleRate(sample_rate);
-    sample_rate = native_sample_rate;
+    this->sample_rate = sample_rate;
+}
+
+void TimeStretcher::SetTargetLatency(double latency) {
+    target_latency = latency;
+}
+
+std::size_t TimeStretcher::GetBacklog() const {
+    return sound_touch->numSamples();
 }
 
 std::size_t TimeStretcher::Process(const s16* in, std::size_t num_in, s16* out,
@@ -33,8 +41,8 @@ std::size_t TimeStretcher::Process(const s16* in, std::size_t num_in, s16* out,
     const double time_delta = static_cast<double>(num_out) / sample_rate; // seconds
     double current_ratio = static_cast<double>(num_in) / static_cast<double>(num_out);
 
-    const double max_latency = 0.25; // seconds
-    const double max_backlog = sample_rate * max_latency;
+    // The backlog is twice the target latency when full
+    const double max_backlog = sample_rate * target_latency * 2.0;
     const double backlog_fullness = sound_touch->numSamples() / max_backlog;
     if (backlog_fullness > 4.0) {
         // Too many samples in backlog: Don't push anymore on
@@ -22,6 +22,12 @@ public:
 
     void SetOutputSampleRate(unsigned int sample_rate);
 
+    /// Sets the amount of audio (in seconds) the stretcher tries to keep in its backlog
+    void SetTargetLatency(double latency);
+
+    /// Returns the number of stretched frames ready to be output
+    std::size_t GetBacklog() const;
+
     /// @param in       Input sample buffer
     /// @param num_in   Number of input frames in `in`
     /// @param out      Output sample buffer
@@ -37,6 +43,7 @@ private:
     unsigned int sample_rate;
     std::unique_ptr<soundtouch::SoundTouch> sound_touch;
     double stretch_ratio = 1.0;
+    double target_latency = 0.125; // seconds
 };
 
 } // namespace AudioCore
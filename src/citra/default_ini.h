@@ -91,6 +91,10 @@ udp_pad_index=
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_cpu_jit =
 
+# Whether to mirror the emulated address space in host memory to speed up memory accesses.
+# Only available on Linux. 0 (default): Off, 1: On
+use_fastmem =
+
 [Renderer]
 # Whether to render using GLES or OpenGL
 # 0 (default): OpenGL, 1: GLES
@@ -116,6 +120,14 @@ shaders_accurate_gs =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to store generated shaders on disk and load them when the same title is started again
+# 0: Off, 1 (default): On
+use_disk_shader_cache =
+
+# Whether textures with identical data share one upload, even if they are at different addresses
+# 0 (default): Off, 1: On
+use_texture_dedup =
+
 # Resolution scale factor
 # 0: Auto (scales resolution to window size), 1: Native 3DS screen resolution, Otherwise a scale
 # factor for the 3DS resolution
@@ -129,6 +141,10 @@ vsync_enabled =
 # 0: Off, 1: On (default)
 use_frame_limit =
 
+# Whether to process GPU command lists on a separate thread, overlapping CPU and GPU emulation
+# 0 (default): Off, 1: On
+use_asynchronous_gpu_emulation =
+
 # Limits the speed of the game to run no faster than this value as a percentage of target speed
 # 1 - 9999: Speed limit as a percentage of target game speed. 100 (default)
 frame_limit =
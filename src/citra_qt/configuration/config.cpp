@@ -54,7 +54,7 @@ const std::array<std::array<int, 5>, Settings::NativeAnalog::NumAnalogs> Config:
 // QKeySequnce(...).toString() is NOT ALLOWED HERE.
 // This must be in alphabetical order according to action name as it must have the same order as
 // UISetting::values.shortcuts, which is alphabetically ordered.
-const std::array<UISettings::Shortcut, 19> Config::default_hotkeys{
+const std::array<UISettings::Shortcut, 21> Config::default_hotkeys{
     {{"Advance Frame", "Main Window", {"\\", Qt::ApplicationShortcut}},
      {"Capture Screenshot", "Main Window", {"Ctrl+P", Qt::ApplicationShortcut}},
      {"Continue/Pause Emulation", "Main Window", {"F4", Qt::WindowShortcut}},
@@ -65,8 +65,10 @@ const std::array<UISettings::Shortcut, 19> Config::default_hotkeys{
      {"Increase Speed Limit", "Main Window", {"+", Qt::ApplicationShortcut}},
      {"Load Amiibo", "Main Window", {"F2", Qt::ApplicationShortcut}},
      {"Load File", "Main Window", {"Ctrl+O", Qt::WindowShortcut}},
+     {"Load State", "Main Window", {"F8", Qt::ApplicationShortcut}},
      {"Remove Amiibo", "Main Window", {"F3", Qt::ApplicationShortcut}},
      {"Restart Emulation", "Main Window", {"F6", Qt::WindowShortcut}},
+     {"Save State", "Main Window", {"F7", Qt::ApplicationShortcut}},
      {"Stop Emulation", "Main Window", {"F5", Qt::WindowShortcut}},
      {"Swap Screens", "Main Window", {"F9", Qt::WindowShortcut}},
      {"Toggle Filter Bar", "Main Window", {"Ctrl+F", Qt::WindowShortcut}},
@@ -145,6 +147,7 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Core");
     Settings::values.use_cpu_jit = ReadSetting("use_cpu_jit", true).toBool();
+    Settings::values.use_fastmem = ReadSetting("use_fastmem", false).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
@@ -160,6 +163,8 @@ void Config::ReadValues() {
     Settings::values.shaders_accurate_gs = ReadSetting("shaders_accurate_gs", true).toBool();
     Settings::values.shaders_accurate_mul = ReadSetting("shaders_accurate_mul", false).toBool();
     Settings::values.use_shader_jit = ReadSetting("use_shader_jit", true).toBool();
+    Settings::values.use_disk_shader_cache = ReadSetting("use_disk_shader_cache", true).toBool();
+    Settings::values.use_texture_dedup = ReadSetting("use_texture_dedup", false).toBool();
     Settings::values.resolution_factor =
         static_cast<u16>(ReadSetting("resolution_factor", 1).toInt());
     Settings::values.vsync_enabled = ReadSetting("vsync_enabled", false).toBool();
@@ -442,6 +447,7 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Core");
     WriteSetting("use_cpu_jit", Settings::values.use_cpu_jit, true);
+    WriteSetting("use_fastmem", Settings::values.use_fastmem, false);
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
@@ -450,6 +456,8 @@ void Config::SaveValues() {
     WriteSetting("shaders_accurate_gs", Settings::values.shaders_accurate_gs, true);
     WriteSetting("shaders_accurate_mul", Settings::values.shaders_accurate_mul, false);
     WriteSetting("use_shader_jit", Settings::values.use_shader_jit, true);
+    WriteSetting("use_disk_shader_cache", Settings::values.use_disk_shader_cache, true);
+    WriteSetting("use_texture_dedup", Settings::values.use_texture_dedup, false);
     WriteSetting("resolution_factor", Settings::values.resolution_factor, 1);
     WriteSetting("vsync_enabled", Settings::values.vsync_enabled, false);
     WriteSetting("use_frame_limit", Settings::values.use_frame_limit, true);
@@ -32,7 +32,7 @@ private:
     void WriteSetting(const QString& name, const QVariant& value);
     void WriteSetting(const QString& name, const QVariant& value, const QVariant& default_value);
 
-    static const std::array<UISettings::Shortcut, 19> default_hotkeys;
+    static const std::array<UISettings::Shortcut, 21> default_hotkeys;
 
     std::unique_ptr<QSettings> qt_config;
     std::string qt_config_loc;
@@ -16,7 +16,6 @@
 #include "citra_qt/debugger/graphics/graphics_cmdlists.h"
 #include "citra_qt/util/spinbox.h"
 #include "citra_qt/util/util.h"
-#include "common/vector_math.h"
 #include "core/core.h"
 #include "core/memory.h"
 #include "video_core/debug_utils/debug_utils.h"
@@ -26,14 +25,9 @@
 
 namespace {
 QImage LoadTexture(const u8* src, const Pica::Texture::TextureInfo& info) {
-    QImage decoded_image(info.width, info.height, QImage::Format_ARGB32);
-    for (u32 y = 0; y < info.height; ++y) {
-        for (u32 x = 0; x < info.width; ++x) {
-            Common::Vec4<u8> color = Pica::Texture::LookupTexture(src, x, y, info, true);
-            decoded_image.setPixel(x, y, qRgba(color.r(), color.g(), color.b(), color.a()));
-        }
-    }
-
+    QImage decoded_image(info.width, info.height, QImage::Format_RGBA8888);
+    Pica::Texture::DecodeTexture(src, info, decoded_image.bits(), decoded_image.bytesPerLine(),
+                                 true);
     return decoded_image;
 }
 
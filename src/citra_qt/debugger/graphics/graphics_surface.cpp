@@ -583,12 +583,10 @@ void GraphicsSurfaceWidget::OnUpdate() {
         info.format = static_cast<Pica::TexturingRegs::TextureFormat>(surface_format);
         info.SetDefaultStride();
 
-        for (unsigned int y = 0; y < surface_height; ++y) {
-            for (unsigned int x = 0; x < surface_width; ++x) {
-                Common::Vec4<u8> color = Pica::Texture::LookupTexture(buffer, x, y, info, true);
-                decoded_image.setPixel(x, y, qRgba(color.r(), color.g(), color.b(), color.a()));
-            }
-        }
+        // The decoded texels are stored in R, G, B, A byte order
+        decoded_image = QImage(surface_width, surface_height, QImage::Format_RGBA8888);
+        Pica::Texture::DecodeTexture(buffer, info, decoded_image.bits(),
+                                     decoded_image.bytesPerLine(), true);
     } else {
         // We handle depth formats here because DebugUtils only supports TextureFormats
 
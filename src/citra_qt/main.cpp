@@ -428,6 +428,10 @@ void GMainWindow::InitializeHotkeys() {
             &QShortcut::activated, ui.action_Enable_Frame_Advancing, &QAction::trigger);
     connect(hotkey_registry.GetHotkey("Main Window", "Advance Frame", this), &QShortcut::activated,
             ui.action_Advance_Frame, &QAction::trigger);
+    connect(hotkey_registry.GetHotkey("Main Window", "Save State", this), &QShortcut::activated,
+            ui.action_Save_State, &QAction::trigger);
+    connect(hotkey_registry.GetHotkey("Main Window", "Load State", this), &QShortcut::activated,
+            ui.action_Load_State, &QAction::trigger);
     connect(hotkey_registry.GetHotkey("Main Window", "Load Amiibo", this), &QShortcut::activated,
             this, [&] {
                 if (ui.action_Load_Amiibo->isEnabled()) {
@@ -533,6 +537,10 @@ void GMainWindow::ConnectMenuEvents() {
     connect(ui.action_Pause, &QAction::triggered, this, &GMainWindow::OnPauseGame);
     connect(ui.action_Stop, &QAction::triggered, this, &GMainWindow::OnStopGame);
     connect(ui.action_Restart, &QAction::triggered, this, [this] { BootGame(QString(game_path)); });
+    connect(ui.action_Save_State, &QAction::triggered, this,
+            [] { Core::System::GetInstance().RequestQuickSave(); });
+    connect(ui.action_Load_State, &QAction::triggered, this,
+            [] { Core::System::GetInstance().RequestQuickLoad(); });
     connect(ui.action_Report_Compatibility, &QAction::triggered, this,
             &GMainWindow::OnMenuReportCompatibility);
     connect(ui.action_Configure, &QAction::triggered, this, &GMainWindow::OnConfigure);
@@ -895,6 +903,8 @@ void GMainWindow::ShutdownGame() {
     ui.action_Pause->setEnabled(false);
     ui.action_Stop->setEnabled(false);
     ui.action_Restart->setEnabled(false);
+    ui.action_Save_State->setEnabled(false);
+    ui.action_Load_State->setEnabled(false);
     ui.action_Cheats->setEnabled(false);
     ui.action_Load_Amiibo->setEnabled(false);
     ui.action_Remove_Amiibo->setEnabled(false);
@@ -1190,6 +1200,8 @@ void GMainWindow::OnStartGame() {
     ui.action_Pause->setEnabled(true);
     ui.action_Stop->setEnabled(true);
     ui.action_Restart->setEnabled(true);
+    ui.action_Save_State->setEnabled(true);
+    ui.action_Load_State->setEnabled(true);
     ui.action_Cheats->setEnabled(true);
     ui.action_Load_Amiibo->setEnabled(true);
     ui.action_Report_Compatibility->setEnabled(true);
@@ -1205,6 +1217,8 @@ void GMainWindow::OnPauseGame() {
     ui.action_Start->setEnabled(true);
     ui.action_Pause->setEnabled(false);
     ui.action_Stop->setEnabled(true);
+    ui.action_Save_State->setEnabled(false);
+    ui.action_Load_State->setEnabled(false);
     ui.action_Capture_Screenshot->setEnabled(false);
 }
 
@@ -0,0 +1,173 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include "common/compression.h"
+
+namespace Common::Compression {
+
+namespace {
+
+constexpr std::size_t MIN_MATCH = 4;
+constexpr std::size_t MAX_OFFSET = 0xFFFF;
+/// The last 5 bytes of a block are always literals
+constexpr std::size_t LAST_LITERALS = 5;
+/// A match can't start within the last 12 bytes of a block
+constexpr std::size_t MATCH_LIMIT = 12;
+
+constexpr u32 HASH_BITS = 16;
+/// Misses in a row after which the search starts skipping bytes in incompressible data
+constexpr u32 SKIP_TRIGGER = 6;
+
+u32 Read32(const u8* data) {
+    u32 value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+u32 Hash(u32 sequence) {
+    return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+void WriteLength(std::vector<u8>& out, std::size_t length) {
+    for (; length >= 255; length -= 255) {
+        out.push_back(255);
+    }
+    out.push_back(static_cast<u8>(length));
+}
+
+void WriteSequence(std::vector<u8>& out, const u8* literals, std::size_t num_literals,
+                   std::size_t offset, std::size_t match_length) {
+    const std::size_t extra_match = match_length - MIN_MATCH;
+    const u8 token = static_cast<u8>((num_literals < 15 ? num_literals : 15) << 4 |
+                                     (extra_match < 15 ? extra_match : 15));
+    out.push_back(token);
+    if (num_literals >= 15) {
+        WriteLength(out, num_literals - 15);
+    }
+    out.insert(out.end(), literals, literals + num_literals);
+    out.push_back(static_cast<u8>(offset));
+    out.push_back(static_cast<u8>(offset >> 8));
+    if (extra_match >= 15) {
+        WriteLength(out, extra_match - 15);
+    }
+}
+
+void WriteLastLiterals(std::vector<u8>& out, const u8* literals, std::size_t num_literals) {
+    out.push_back(static_cast<u8>((num_literals < 15 ? num_literals : 15) << 4));
+    if (num_literals >= 15) {
+        WriteLength(out, num_literals - 15);
+    }
+    out.insert(out.end(), literals, literals + num_literals);
+}
+
+/// Reads the extension bytes of a length, returns false if the input ends first
+bool ReadLength(const u8* data, std::size_t size, std::size_t& pos, std::size_t& length) {
+    u8 byte;
+    do {
+        if (pos >= size) {
+            return false;
+        }
+        byte = data[pos++];
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+} // Anonymous namespace
+
+std::vector<u8> CompressBlock(const u8* data, std::size_t size) {
+    std::vector<u8> out;
+    out.reserve(size / 2 + 16);
+
+    std::size_t anchor = 0;
+    if (size > MATCH_LIMIT) {
+        // Position of the last occurrence of each hashed 4-byte sequence
+        std::vector<u32> table(std::size_t{1} << HASH_BITS, 0);
+        const std::size_t match_end = size - LAST_LITERALS;
+        std::size_t pos = 0;
+        u32 misses = 0;
+
+        while (pos < size - MATCH_LIMIT) {
+            const u32 sequence = Read32(data + pos);
+            const u32 hash = Hash(sequence);
+            const std::size_t candidate = table[hash];
+            table[hash] = static_cast<u32>(pos);
+
+            if (candidate >= pos || pos - candidate > MAX_OFFSET ||
+                Read32(data + candidate) != sequence) {
+                pos += 1 + (misses++ >> SKIP_TRIGGER);
+                continue;
+            }
+            misses = 0;
+
+            std::size_t length = MIN_MATCH;
+            while (pos + length < match_end && data[candidate + length] == data[pos + length]) {
+                ++length;
+            }
+            WriteSequence(out, data + anchor, pos - anchor, pos - candidate, length);
+            pos += length;
+            anchor = pos;
+        }
+    }
+    WriteLastLiterals(out, data + anchor, size - anchor);
+    return out;
+}
+
+bool DecompressBlock(const u8* data, std::size_t size, u8* out, std::size_t out_size) {
+    std::size_t pos = 0;
+    std::size_t out_pos = 0;
+    while (true) {
+        if (pos >= size) {
+            return false;
+        }
+        const u8 token = data[pos++];
+
+        std::size_t num_literals = token >> 4;
+        if (num_literals == 15 && !ReadLength(data, size, pos, num_literals)) {
+            return false;
+        }
+        if (num_literals > size - pos || num_literals > out_size - out_pos) {
+            return false;
+        }
+        std::memcpy(out + out_pos, data + pos, num_literals);
+        pos += num_literals;
+        out_pos += num_literals;
+
+        // The last sequence has no match
+        if (pos == size) {
+            return out_pos == out_size;
+        }
+
+        if (size - pos < 2) {
+            return false;
+        }
+        const std::size_t offset = data[pos] | data[pos + 1] << 8;
+        pos += 2;
+        if (offset == 0 || offset > out_pos) {
+            return false;
+        }
+
+        std::size_t length = token & 0xF;
+        if (length == 15 && !ReadLength(data, size, pos, length)) {
+            return false;
+        }
+        length += MIN_MATCH;
+        if (length > out_size - out_pos) {
+            return false;
+        }
+        const u8* match = out + out_pos - offset;
+        if (offset >= length) {
+            std::memcpy(out + out_pos, match, length);
+        } else {
+            // The match overlaps the bytes it produces, so it is copied byte by byte
+            for (std::size_t i = 0; i < length; ++i) {
+                out[out_pos + i] = match[i];
+            }
+        }
+        out_pos += length;
+    }
+}
+
+} // namespace Common::Compression
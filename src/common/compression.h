@@ -0,0 +1,32 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common::Compression {
+
+/**
+ * Compresses a block of data in the LZ4 block format. This favours speed over ratio and is meant
+ * for large buffers with long runs of repeated data, such as emulated memory.
+ * @param data Block of data to compress
+ * @param size Size of the block in bytes
+ * @returns the compressed data, which may be slightly larger than the input if it doesn't compress
+ */
+std::vector<u8> CompressBlock(const u8* data, std::size_t size);
+
+/**
+ * Decompresses a block created by CompressBlock, or any other LZ4 block.
+ * @param data Compressed data
+ * @param size Size of the compressed data in bytes
+ * @param out Buffer that receives the decompressed data
+ * @param out_size Size of the decompressed data in bytes
+ * @returns false if the data is malformed or doesn't decompress to exactly out_size bytes
+ */
+bool DecompressBlock(const u8* data, std::size_t size, u8* out, std::size_t out_size);
+
+} // namespace Common::Compression
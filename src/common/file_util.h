@@ -236,6 +236,11 @@ public:
         return nullptr != m_file;
     }
 
+    /// Returns the underlying C file handle, e.g. for memory mapping the file
+    std::FILE* GetHandle() const {
+        return m_file;
+    }
+
     // m_good is set to false when a read, write or other function fails
     bool IsGood() const {
         return m_good;
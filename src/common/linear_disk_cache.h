@@ -4,18 +4,20 @@
 
 #pragma once
 
+#include <cstring>
 #include <fstream>
 #include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/scm_rev.h"
 
-// defined in Version.cpp
-extern const char* scm_rev_git_str;
+namespace Common {
 
 // On disk format:
 // header{
 // u32 'DCAC';
-// u32 version;  // svn_rev
 // u16 sizeof(key_type);
 // u16 sizeof(value_type);
+// char ver[40]; // git revision
 //}
 
 // key_value_pair{
@@ -102,7 +104,7 @@ public:
         // failed to open file for reading or bad header
         // close and recreate file
         Close();
-        m_file.open(filename, ios_base::out | ios_base::trunc | ios_base::binary);
+        OpenFStream(m_file, filename, ios_base::out | ios_base::trunc | ios_base::binary);
         WriteHeader();
         return 0;
     }
@@ -138,7 +140,7 @@ private:
         char file_header[sizeof(Header)];
 
         return (Read(file_header, sizeof(Header)) &&
-                !memcmp((const char*)&m_header, file_header, sizeof(Header)));
+                !std::memcmp((const char*)&m_header, file_header, sizeof(Header)));
     }
 
     template <typename D>
@@ -152,8 +154,8 @@ private:
     }
 
     struct Header {
-        Header() : id(*(u32*)"DCAC"), key_t_size(sizeof(K)), value_t_size(sizeof(V)) {
-            memcpy(ver, scm_rev_git_str, 40);
+        Header() : id(*(u32*)"DCAC"), key_t_size(sizeof(K)), value_t_size(sizeof(V)), ver{} {
+            std::strncpy(ver, g_scm_rev, sizeof(ver));
         }
 
         const u32 id;
@@ -163,5 +165,7 @@ private:
     } m_header;
 
     std::fstream m_file;
-    u32 m_num_entries;
+    u32 m_num_entries = 0;
 };
+
+} // namespace Common
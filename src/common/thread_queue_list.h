@@ -113,6 +113,11 @@ struct ThreadQueueList {
         first = nullptr;
     }
 
+    // Returns the queue of a priority level, in the order the threads will be popped.
+    const std::deque<T>& get(Priority priority) const {
+        return queues[priority].data;
+    }
+
     bool empty(Priority priority) const {
         const Queue* cur = &queues[priority];
         return cur->data.empty();
@@ -0,0 +1,77 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "common/thread_worker.h"
+
+namespace Common {
+
+ThreadWorker::ThreadWorker(std::size_t num_workers, const std::string& name) {
+    threads.reserve(num_workers);
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        threads.emplace_back(&ThreadWorker::WorkerLoop, this, name + std::to_string(i));
+    }
+}
+
+ThreadWorker::~ThreadWorker() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stop = true;
+    }
+    work_available.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadWorker::QueueWork(std::function<void()> work) {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        requests.emplace(std::move(work));
+        ++work_pending;
+    }
+    work_available.notify_one();
+}
+
+void ThreadWorker::WaitForRequests() {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    work_done.wait(lock, [this] { return work_pending == 0; });
+}
+
+void ThreadWorker::WorkerLoop(const std::string& thread_name) {
+    SetCurrentThreadName(thread_name.c_str());
+    MicroProfileOnThreadCreate(thread_name.c_str());
+
+    while (true) {
+        std::function<void()> work;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            work_available.wait(lock, [this] { return stop || !requests.empty(); });
+            if (stop && requests.empty()) {
+                break;
+            }
+            work = std::move(requests.front());
+            requests.pop();
+        }
+
+        work();
+
+        bool all_done;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            all_done = --work_pending == 0;
+        }
+        if (all_done) {
+            work_done.notify_all();
+        }
+    }
+
+#if MICROPROFILE_ENABLED
+    MicroProfileOnThreadExit();
+#endif
+}
+
+} // namespace Common
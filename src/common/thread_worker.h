@@ -0,0 +1,54 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Common {
+
+/**
+ * A fixed-size pool of worker threads. Queued work items are executed in FIFO order by whichever
+ * worker becomes available first, so work items must not depend on each other.
+ */
+class ThreadWorker {
+public:
+    /**
+     * @param num_workers Number of threads to spawn
+     * @param name Name given to the worker threads, for debugging purposes
+     */
+    ThreadWorker(std::size_t num_workers, const std::string& name);
+    ~ThreadWorker();
+
+    /// Queues a work item for execution on one of the workers
+    void QueueWork(std::function<void()> work);
+
+    /// Blocks until every queued work item has finished executing
+    void WaitForRequests();
+
+    std::size_t NumWorkers() const {
+        return threads.size();
+    }
+
+private:
+    void WorkerLoop(const std::string& thread_name);
+
+    std::vector<std::thread> threads;
+    std::queue<std::function<void()>> requests;
+    std::size_t work_pending = 0;
+    bool stop = false;
+
+    std::mutex queue_mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+};
+
+} // namespace Common
@@ -0,0 +1,52 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "core/arm/dyncom/arm_dyncom_block_cache.h"
+
+BlockCache::BlockCache() : pages(NUM_PAGES) {}
+
+BlockCache::~BlockCache() = default;
+
+void BlockCache::Insert(u32 addr, std::size_t block) {
+    const u32 page_index = addr >> PAGE_BITS;
+    auto& page = pages[page_index];
+    if (!page) {
+        page = std::make_unique<Page>();
+        page->fill(NO_BLOCK);
+        used_pages.push_back(page_index);
+    }
+    (*page)[(addr & PAGE_MASK) >> 1] = static_cast<u32>(block);
+}
+
+void BlockCache::Invalidate(u32 start, std::size_t length) {
+    if (length == 0) {
+        return;
+    }
+
+    const u64 end = std::min<u64>(static_cast<u64>(start) + length, u64{1} << 32);
+    const u32 first_page = start >> PAGE_BITS;
+    const u32 last_page = static_cast<u32>((end - 1) >> PAGE_BITS);
+    for (u32 page_index = first_page; page_index <= last_page; ++page_index) {
+        if (pages[page_index]) {
+            pages[page_index]->fill(NO_BLOCK);
+        }
+    }
+    NextGeneration();
+}
+
+void BlockCache::Clear() {
+    for (u32 page_index : used_pages) {
+        pages[page_index].reset();
+    }
+    used_pages.clear();
+    NextGeneration();
+}
+
+void BlockCache::NextGeneration() {
+    // Zero is skipped because that's what a link is initialized to
+    if (++generation == 0) {
+        generation = 1;
+    }
+}
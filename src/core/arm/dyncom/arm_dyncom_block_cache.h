@@ -0,0 +1,63 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include "common/common_types.h"
+
+/**
+ * Maps guest addresses to the translated basic blocks in trans_cache_buf.
+ *
+ * The lookup table is indexed by page, and every page that contains code has a direct-mapped
+ * array with a slot per halfword, so a lookup is two loads. Blocks never cross a page boundary
+ * (see TransExtData::END_OF_PAGE), which lets invalidation drop whole pages.
+ */
+class BlockCache {
+public:
+    /// Returned by Find if there is no block at an address
+    static constexpr u32 NO_BLOCK = 0xFFFFFFFF;
+
+    BlockCache();
+    ~BlockCache();
+
+    /// Returns the offset in trans_cache_buf of the block starting at addr, or NO_BLOCK
+    u32 Find(u32 addr) const {
+        const auto& page = pages[addr >> PAGE_BITS];
+        return page ? (*page)[(addr & PAGE_MASK) >> 1] : NO_BLOCK;
+    }
+
+    /// Records that the block starting at addr was translated to offset block in trans_cache_buf
+    void Insert(u32 addr, std::size_t block);
+
+    /// Forgets the blocks of every page overlapping [start, start + length)
+    void Invalidate(u32 start, std::size_t length);
+
+    /// Forgets all blocks
+    void Clear();
+
+    /**
+     * Changes whenever blocks are forgotten. Links between blocks (see BlockLink) are only
+     * followed if they were made in the current generation.
+     */
+    u32 Generation() const {
+        return generation;
+    }
+
+private:
+    static constexpr u32 PAGE_BITS = 12;
+    static constexpr u32 PAGE_MASK = (1 << PAGE_BITS) - 1;
+    static constexpr std::size_t NUM_PAGES = std::size_t{1} << (32 - PAGE_BITS);
+
+    using Page = std::array<u32, (PAGE_MASK + 1) / 2>;
+
+    void NextGeneration();
+
+    std::vector<std::unique_ptr<Page>> pages;
+    /// Indices of the allocated pages, so that clearing doesn't have to scan the whole table
+    std::vector<u32> used_pages;
+    u32 generation = 1;
+};
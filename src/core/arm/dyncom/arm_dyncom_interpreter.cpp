@@ -840,6 +840,14 @@ static unsigned int InterpreterTranslateInstruction(const ARMul_State* cpu, cons
     return inst_size;
 }
 
+// Blocks that were invalidated stay in the translation cache, so it is started over once it is full
+static void ReserveTranslationSpace(ARMul_State* cpu) {
+    if (trans_cache_buf_top > TRANS_CACHE_SIZE - TRANS_CACHE_BLOCK_RESERVE) {
+        cpu->instruction_cache.Clear();
+        trans_cache_buf_top = 0;
+    }
+}
+
 static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u32 addr) {
     MICROPROFILE_SCOPE(DynCom_Decode);
 
@@ -850,6 +858,7 @@ static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u3
     ARM_INST_PTR inst_base = nullptr;
     TransExtData ret = TransExtData::NON_BRANCH;
     int size = 0; // instruction size of basic block
+    ReserveTranslationSpace(cpu);
     bb_start = trans_cache_buf_top;
 
     u32 phys_addr = addr;
@@ -868,7 +877,7 @@ static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u3
         ret = inst_base->br;
     };
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    cpu->instruction_cache.Insert(pc_start, bb_start);
 
     return KEEP_GOING;
 }
@@ -877,6 +886,7 @@ static int InterpreterTranslateSingle(ARMul_State* cpu, std::size_t& bb_start, u
     MICROPROFILE_SCOPE(DynCom_Decode);
 
     ARM_INST_PTR inst_base = nullptr;
+    ReserveTranslationSpace(cpu);
     bb_start = trans_cache_buf_top;
 
     u32 phys_addr = addr;
@@ -888,7 +898,7 @@ static int InterpreterTranslateSingle(ARMul_State* cpu, std::size_t& bb_start, u
         inst_base->br = TransExtData::SINGLE_STEP;
     }
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    cpu->instruction_cache.Insert(pc_start, bb_start);
 
     return KEEP_GOING;
 }
@@ -950,6 +960,11 @@ unsigned InterpreterMainLoop(ARMul_State* cpu) {
         goto DISPATCH;                                                                             \
     inst_base = (arm_inst*)&trans_cache_buf[ptr]
 
+// Ends the block at a direct branch, which continues at the block it was linked to if possible
+#define GOTO_LINKED(block_link)                                                                    \
+    link = &(block_link);                                                                          \
+    goto LINKED_DISPATCH
+
 #define INC_PC(l) ptr += sizeof(arm_inst) + l
 #define INC_PC_STUB ptr += sizeof(arm_inst)
 
@@ -1626,6 +1641,7 @@ unsigned InterpreterMainLoop(ARMul_State* cpu) {
     unsigned int num_instrs = 0;
 
     std::size_t ptr;
+    BlockLink* link = nullptr;
 
     LOAD_NZCVT;
 DISPATCH : {
@@ -1641,9 +1657,10 @@ DISPATCH : {
         cpu->Reg[15] &= 0xfffffffc;
 
     // Find the cached instruction cream, otherwise translate it...
-    auto itr = cpu->instruction_cache.find(cpu->Reg[15]);
-    if (itr != cpu->instruction_cache.end()) {
-        ptr = itr->second;
+    const u32 generation = cpu->instruction_cache.Generation();
+    const u32 block = cpu->instruction_cache.Find(cpu->Reg[15]);
+    if (block != BlockCache::NO_BLOCK) {
+        ptr = block;
     } else if (cpu->NumInstrsToExecute != 1) {
         if (InterpreterTranslateBlock(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
             goto END;
@@ -1652,6 +1669,15 @@ DISPATCH : {
             goto END;
     }
 
+    // Link the branch we came from to this block, unless translating started the cache over and
+    // the link was overwritten
+    if (link != nullptr) {
+        if (cpu->instruction_cache.Generation() == generation) {
+            *link = {cpu->Reg[15], static_cast<u32>(ptr), generation};
+        }
+        link = nullptr;
+    }
+
     // Find breakpoint if one exists within the block
     if (GDBStub::IsConnected()) {
         breakpoint_data =
@@ -1661,6 +1687,18 @@ DISPATCH : {
     inst_base = (arm_inst*)&trans_cache_buf[ptr];
     GOTO_NEXT_INST;
 }
+LINKED_DISPATCH : {
+    // Skip the block lookup if the branch that ended the block was taken to the same address
+    // before. Interrupts and breakpoints are handled by DISPATCH.
+    if (link->generation == cpu->instruction_cache.Generation() && link->pc == cpu->Reg[15] &&
+        cpu->NirqSig && !GDBStub::IsConnected()) {
+        ptr = link->block;
+        link = nullptr;
+        inst_base = (arm_inst*)&trans_cache_buf[ptr];
+        GOTO_NEXT_INST;
+    }
+    goto DISPATCH;
+}
 ADC_INST : {
     if (inst_base->cond == ConditionCode::AL || CondPassed(cpu, inst_base->cond)) {
         adc_inst* const inst_cream = (adc_inst*)inst_base->component;
@@ -1761,18 +1799,18 @@ AND_INST : {
     GOTO_NEXT_INST;
 }
 BBL_INST : {
+    bbl_inst* inst_cream = (bbl_inst*)inst_base->component;
     if ((inst_base->cond == ConditionCode::AL) || CondPassed(cpu, inst_base->cond)) {
-        bbl_inst* inst_cream = (bbl_inst*)inst_base->component;
         if (inst_cream->L) {
             LINK_RTN_ADDR;
         }
         SET_PC;
         INC_PC(sizeof(bbl_inst));
-        goto DISPATCH;
+        GOTO_LINKED(inst_cream->taken);
     }
     cpu->Reg[15] += cpu->GetInstructionSize();
     INC_PC(sizeof(bbl_inst));
-    goto DISPATCH;
+    GOTO_LINKED(inst_cream->not_taken);
 }
 BIC_INST : {
     bic_inst* inst_cream = (bic_inst*)inst_base->component;
@@ -4323,18 +4361,19 @@ B_2_THUMB : {
     b_2_thumb* inst_cream = (b_2_thumb*)inst_base->component;
     cpu->Reg[15] = cpu->Reg[15] + 4 + inst_cream->imm;
     INC_PC(sizeof(b_2_thumb));
-    goto DISPATCH;
+    GOTO_LINKED(inst_cream->taken);
 }
 B_COND_THUMB : {
     b_cond_thumb* inst_cream = (b_cond_thumb*)inst_base->component;
 
-    if (CondPassed(cpu, inst_cream->cond))
+    if (CondPassed(cpu, inst_cream->cond)) {
         cpu->Reg[15] = cpu->Reg[15] + 4 + inst_cream->imm;
-    else
-        cpu->Reg[15] += 2;
-
+        INC_PC(sizeof(b_cond_thumb));
+        GOTO_LINKED(inst_cream->taken);
+    }
+    cpu->Reg[15] += 2;
     INC_PC(sizeof(b_cond_thumb));
-    goto DISPATCH;
+    GOTO_LINKED(inst_cream->not_taken);
 }
 BL_1_THUMB : {
     bl_1_thumb* inst_cream = (bl_1_thumb*)inst_base->component;
@@ -4350,7 +4389,7 @@ BL_2_THUMB : {
     cpu->Reg[15] = (cpu->Reg[14] + inst_cream->imm);
     cpu->Reg[14] = tmp;
     INC_PC(sizeof(bl_2_thumb));
-    goto DISPATCH;
+    GOTO_LINKED(inst_cream->taken);
 }
 BLX_1_THUMB : {
     // BLX 1 for armv5t and above
@@ -22,6 +22,16 @@ enum class TransExtData {
     SINGLE_STEP = (1 << 8)
 };
 
+/**
+ * Remembers the block a direct branch went to last time, so that the interpreter can continue there
+ * without looking it up in the BlockCache.
+ */
+struct BlockLink {
+    u32 pc;         // Guest address of the successor block
+    u32 block;      // Offset of the successor block in trans_cache_buf
+    u32 generation; // BlockCache generation the link was made in, zero if it was never made
+};
+
 struct arm_inst {
     unsigned int idx;
     unsigned int cond;
@@ -88,6 +98,8 @@ struct bbl_inst {
     int signed_immed_24;
     unsigned int next_addr;
     unsigned int jmp_addr;
+    BlockLink taken;
+    BlockLink not_taken;
 };
 
 struct bx_inst {
@@ -451,10 +463,13 @@ struct setend_inst {
 
 struct b_2_thumb {
     unsigned int imm;
+    BlockLink taken;
 };
 struct b_cond_thumb {
     unsigned int imm;
     unsigned int cond;
+    BlockLink taken;
+    BlockLink not_taken;
 };
 
 struct bl_1_thumb {
@@ -462,6 +477,7 @@ struct bl_1_thumb {
 };
 struct bl_2_thumb {
     unsigned int imm;
+    BlockLink taken;
 };
 struct blx_1_thumb {
     unsigned int imm;
@@ -494,5 +510,8 @@ extern const transop_fp_t arm_instruction_trans[];
 extern const std::size_t arm_instruction_trans_len;
 
 #define TRANS_CACHE_SIZE (64 * 1024 * 2000)
+// Space that must be free before translating a block. Blocks end at page boundaries, so a block has
+// at most 2048 (Thumb) instructions, and no translated instruction is larger than 256 bytes.
+#define TRANS_CACHE_BLOCK_RESERVE (2048 * 256)
 extern char trans_cache_buf[TRANS_CACHE_SIZE];
 extern std::size_t trans_cache_buf_top;
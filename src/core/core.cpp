@@ -28,6 +28,7 @@
 #include "core/loader/loader.h"
 #include "core/movie.h"
 #include "core/rpc/rpc_server.h"
+#include "core/savestate.h"
 #include "core/settings.h"
 #include "network/network.h"
 #include "video_core/video_core.h"
@@ -79,6 +80,14 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
     HW::Update();
     Reschedule();
 
+    // Saving is retried after the next slice while a thread waits for an HLE service
+    if (quick_save_requested && savestate_manager->QuickSave()) {
+        quick_save_requested = false;
+    }
+    if (quick_load_requested.exchange(false)) {
+        savestate_manager->QuickLoad();
+    }
+
     if (reset_requested.exchange(false)) {
         Reset();
     } else if (shutdown_requested.exchange(false)) {
@@ -143,6 +152,7 @@ System::ResultStatus System::Load(EmuWindow& emu_window, const std::string& file
     }
     memory->SetCurrentPageTable(&kernel->GetCurrentProcess()->vm_manager.page_table);
     cheat_engine = std::make_unique<Cheats::CheatEngine>(*this);
+    savestate_manager = std::make_unique<SaveStateManager>(*this);
     status = ResultStatus::Success;
     m_emu_window = &emu_window;
     m_filepath = filepath;
@@ -202,6 +212,7 @@ System::ResultStatus System::Init(EmuWindow& emu_window, u32 system_mode) {
 
     dsp_core->SetSink(Settings::values.sink_id, Settings::values.audio_device_id);
     dsp_core->EnableStretching(Settings::values.enable_audio_stretching);
+    dsp_core->SetPerfStats(&perf_stats);
 
     telemetry_session = std::make_unique<Core::TelemetrySession>();
 
@@ -276,6 +287,10 @@ const Cheats::CheatEngine& System::CheatEngine() const {
     return *cheat_engine;
 }
 
+SaveStateManager& System::SaveStates() {
+    return *savestate_manager;
+}
+
 void System::RegisterSoftwareKeyboard(std::shared_ptr<Frontend::SoftwareKeyboard> swkbd) {
     registered_swkbd = std::move(swkbd);
 }
@@ -296,6 +311,9 @@ void System::Shutdown() {
     HW::Shutdown();
     telemetry_session.reset();
     rpc_server.reset();
+    savestate_manager.reset();
+    quick_save_requested = false;
+    quick_load_requested = false;
     cheat_engine.reset();
     service_manager.reset();
     dsp_core.reset();
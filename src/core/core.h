@@ -47,6 +47,7 @@ class CheatEngine;
 
 namespace Core {
 
+class SaveStateManager;
 class Timing;
 
 class System {
@@ -113,6 +114,19 @@ public:
         shutdown_requested = true;
     }
 
+    /**
+     * Request a save state of the running program to be kept as the quick save of this session. The
+     * state is saved once no thread waits for an HLE service.
+     */
+    void RequestQuickSave() {
+        quick_save_requested = true;
+    }
+
+    /// Request the quick save of this session to be loaded
+    void RequestQuickLoad() {
+        quick_load_requested = true;
+    }
+
     /**
      * Load an executable application.
      * @param emu_window Reference to the host-system window used for video output and keyboard
@@ -202,6 +216,9 @@ public:
     /// Gets a const reference to the cheat engine
     const Cheats::CheatEngine& CheatEngine() const;
 
+    /// Gets a reference to the save state manager
+    SaveStateManager& SaveStates();
+
     PerfStats perf_stats;
     FrameLimiter frame_limiter;
 
@@ -268,6 +285,9 @@ private:
     /// RPC Server for scripting support
     std::unique_ptr<RPC::RPCServer> rpc_server;
 
+    /// Save state manager for the current emulation session
+    std::unique_ptr<SaveStateManager> savestate_manager;
+
     std::unique_ptr<Service::FS::ArchiveManager> archive_manager;
 
     std::unique_ptr<Memory::MemorySystem> memory;
@@ -285,6 +305,8 @@ private:
 
     std::atomic<bool> reset_requested;
     std::atomic<bool> shutdown_requested;
+    std::atomic<bool> quick_save_requested;
+    std::atomic<bool> quick_load_requested;
 };
 
 inline ARM_Interface& CPU() {
@@ -6,17 +6,18 @@
 #include <cinttypes>
 #include <tuple>
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "core/core_timing.h"
 
 namespace Core {
 
-// Sort by time, unless the times are the same, in which case sort by the order added to the queue
-bool Timing::Event::operator>(const Event& right) const {
-    return std::tie(time, fifo_order) > std::tie(right.time, right.fifo_order);
-}
+// Number of children of each heap node. A wider heap is shallower, and the children of a node share
+// a cache line.
+constexpr std::size_t HEAP_ARITY = 4;
 
-bool Timing::Event::operator<(const Event& right) const {
+// Sort by time, unless the times are the same, in which case sort by the order added to the queue
+bool Timing::HeapNode::operator<(const HeapNode& right) const {
     return std::tie(time, fifo_order) < std::tie(right.time, right.fifo_order);
 }
 
@@ -63,8 +64,7 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
     if (!is_global_timer_sane)
         ForceExceptionCheck(cycles_into_future);
 
-    event_queue.emplace_back(Event{timeout, event_fifo_id++, userdata, event_type});
-    std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    PushEvent(Event{timeout, event_fifo_id++, userdata, event_type});
 }
 
 void Timing::ScheduleEventThreadsafe(s64 cycles_into_future, const TimingEventType* event_type,
@@ -72,27 +72,60 @@ void Timing::ScheduleEventThreadsafe(s64 cycles_into_future, const TimingEventTy
     ts_queue.Push(Event{global_timer + cycles_into_future, 0, userdata, event_type});
 }
 
+void Timing::RescheduleEvent(s64 cycles_into_future, const TimingEventType* event_type,
+                             u64 userdata) {
+    ASSERT(event_type != nullptr);
+    auto& events = pending_events[event_type];
+    auto [begin, end] = events.equal_range(userdata);
+    if (begin == end) {
+        ScheduleEvent(cycles_into_future, event_type, userdata);
+        return;
+    }
+
+    // Move the first matching event and drop the others
+    for (auto itr = std::next(begin); itr != end; ++itr) {
+        EraseQueuedEvent(itr->second);
+    }
+    const u32 slot = begin->second;
+    events.erase(std::next(begin), end);
+
+    s64 timeout = GetTicks() + cycles_into_future;
+    if (!is_global_timer_sane)
+        ForceExceptionCheck(cycles_into_future);
+
+    QueuedEvent& queued = queued_events[slot];
+    queued.event.time = timeout;
+    queued.event.fifo_order = event_fifo_id++;
+
+    const std::size_t index = queued.heap_index;
+    SetHeapNode(index, HeapNode{timeout, queued.event.fifo_order, slot});
+    SiftUp(index);
+    SiftDown(queued_events[slot].heap_index);
+}
+
 void Timing::UnscheduleEvent(const TimingEventType* event_type, u64 userdata) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(), [&](const Event& e) {
-        return e.type == event_type && e.userdata == userdata;
-    });
+    auto type_events = pending_events.find(event_type);
+    if (type_events == pending_events.end()) {
+        return;
+    }
 
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    auto [begin, end] = type_events->second.equal_range(userdata);
+    for (auto itr = begin; itr != end; ++itr) {
+        EraseQueuedEvent(itr->second);
     }
+    type_events->second.erase(begin, end);
 }
 
 void Timing::RemoveEvent(const TimingEventType* event_type) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(),
-                              [&](const Event& e) { return e.type == event_type; });
+    auto type_events = pending_events.find(event_type);
+    if (type_events == pending_events.end()) {
+        return;
+    }
 
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    for (const auto& [userdata, slot] : type_events->second) {
+        EraseQueuedEvent(slot);
     }
+    type_events->second.clear();
 }
 
 void Timing::RemoveNormalAndThreadsafeEvent(const TimingEventType* event_type) {
@@ -111,11 +144,90 @@ void Timing::ForceExceptionCheck(s64 cycles) {
 void Timing::MoveEvents() {
     for (Event ev; ts_queue.Pop(ev);) {
         ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
-        std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+        PushEvent(ev);
     }
 }
 
+void Timing::PushEvent(const Event& event) {
+    u32 slot;
+    if (free_slots.empty()) {
+        slot = static_cast<u32>(queued_events.size());
+        queued_events.emplace_back();
+    } else {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    queued_events[slot].event = event;
+    pending_events[event.type].emplace(event.userdata, slot);
+
+    event_queue.push_back(HeapNode{event.time, event.fifo_order, slot});
+    queued_events[slot].heap_index = event_queue.size() - 1;
+    SiftUp(event_queue.size() - 1);
+}
+
+void Timing::EraseQueuedEvent(u32 slot) {
+    const std::size_t index = queued_events[slot].heap_index;
+    const HeapNode last = event_queue.back();
+    event_queue.pop_back();
+    free_slots.push_back(slot);
+
+    // Fill the hole with the last node, which may belong either above or below it
+    if (index != event_queue.size()) {
+        SetHeapNode(index, last);
+        SiftUp(index);
+        SiftDown(queued_events[last.slot].heap_index);
+    }
+}
+
+void Timing::ClearEvents() {
+    event_queue.clear();
+    queued_events.clear();
+    free_slots.clear();
+    pending_events.clear();
+}
+
+void Timing::SetHeapNode(std::size_t index, const HeapNode& node) {
+    event_queue[index] = node;
+    queued_events[node.slot].heap_index = index;
+}
+
+void Timing::SiftUp(std::size_t index) {
+    const HeapNode node = event_queue[index];
+    while (index > 0) {
+        const std::size_t parent = (index - 1) / HEAP_ARITY;
+        if (!(node < event_queue[parent])) {
+            break;
+        }
+        SetHeapNode(index, event_queue[parent]);
+        index = parent;
+    }
+    SetHeapNode(index, node);
+}
+
+void Timing::SiftDown(std::size_t index) {
+    const HeapNode node = event_queue[index];
+    const std::size_t size = event_queue.size();
+    while (true) {
+        const std::size_t first_child = index * HEAP_ARITY + 1;
+        if (first_child >= size) {
+            break;
+        }
+        const std::size_t last_child = std::min(first_child + HEAP_ARITY, size);
+        std::size_t smallest = first_child;
+        for (std::size_t child = first_child + 1; child < last_child; ++child) {
+            if (event_queue[child] < event_queue[smallest]) {
+                smallest = child;
+            }
+        }
+        if (!(event_queue[smallest] < node)) {
+            break;
+        }
+        SetHeapNode(index, event_queue[smallest]);
+        index = smallest;
+    }
+    SetHeapNode(index, node);
+}
+
 void Timing::Advance() {
     MoveEvents();
 
@@ -126,9 +238,16 @@ void Timing::Advance() {
     is_global_timer_sane = true;
 
     while (!event_queue.empty() && event_queue.front().time <= global_timer) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
-        event_queue.pop_back();
+        const u32 slot = event_queue.front().slot;
+        const Event evt = queued_events[slot].event;
+
+        auto& events = pending_events[evt.type];
+        auto [begin, end] = events.equal_range(evt.userdata);
+        events.erase(std::find_if(begin, end, [slot](const auto& entry) {
+            return entry.second == slot;
+        }));
+        EraseQueuedEvent(slot);
+
         evt.type->callback(evt.userdata, global_timer - evt.time);
     }
 
@@ -156,4 +275,69 @@ s64 Timing::GetDowncount() const {
     return downcount;
 }
 
+void Timing::Snapshot::DoState(PointerWrap& p) {
+    auto section = p.Section("CoreTiming", 1);
+    if (!section) {
+        return;
+    }
+
+    p.Do(global_timer);
+    p.Do(slice_length);
+    p.Do(downcount);
+    p.Do(idled_cycles);
+    p.Do(event_fifo_id);
+    p.Do(is_global_timer_sane);
+
+    u32 num_events = static_cast<u32>(events.size());
+    p.Do(num_events);
+    events.resize(num_events);
+    for (EventState& event : events) {
+        p.Do(event.time);
+        p.Do(event.fifo_order);
+        p.Do(event.userdata);
+        p.Do(event.type);
+    }
+}
+
+Timing::Snapshot Timing::TakeSnapshot() {
+    MoveEvents();
+
+    Snapshot snapshot{global_timer,  slice_length,         downcount, idled_cycles,
+                      event_fifo_id, is_global_timer_sane, {}};
+    snapshot.events.reserve(event_queue.size());
+    for (const HeapNode& node : event_queue) {
+        const Event& event = queued_events[node.slot].event;
+        snapshot.events.push_back(
+            {event.time, event.fifo_order, event.userdata, *event.type->name});
+    }
+    return snapshot;
+}
+
+bool Timing::CanRestoreSnapshot(const Snapshot& snapshot) const {
+    for (const auto& event : snapshot.events) {
+        // Callbacks can't be stored, so events are matched to their type by name
+        if (event_types.count(event.type) == 0) {
+            LOG_ERROR(Core_Timing, "Unknown event type \"{}\" in save state", event.type);
+            return false;
+        }
+    }
+    return true;
+}
+
+void Timing::RestoreSnapshot(const Snapshot& snapshot) {
+    // Events scheduled from other threads belong to the discarded timeline
+    MoveEvents();
+    ClearEvents();
+
+    global_timer = snapshot.global_timer;
+    slice_length = snapshot.slice_length;
+    downcount = snapshot.downcount;
+    idled_cycles = snapshot.idled_cycles;
+    event_fifo_id = snapshot.event_fifo_id;
+    is_global_timer_sane = snapshot.is_global_timer_sane;
+    for (const auto& event : snapshot.events) {
+        PushEvent({event.time, event.fifo_order, event.userdata, &event_types.at(event.type)});
+    }
+}
+
 } // namespace Core
@@ -123,6 +123,8 @@ inline u64 cyclesToMs(s64 cycles) {
     return cycles * 1000 / BASE_CLOCK_RATE_ARM11;
 }
 
+class PointerWrap;
+
 namespace Core {
 
 using TimedCallback = std::function<void(u64 userdata, int cycles_late)>;
@@ -165,6 +167,12 @@ public:
     void ScheduleEventThreadsafe(s64 cycles_into_future, const TimingEventType* event_type,
                                  u64 userdata);
 
+    /**
+     * Moves the pending event with the given type and userdata to a new time, as if it was
+     * unscheduled and scheduled again. Schedules it if there is no such event.
+     */
+    void RescheduleEvent(s64 cycles_into_future, const TimingEventType* event_type, u64 userdata);
+
     void UnscheduleEvent(const TimingEventType* event_type, u64 userdata);
 
     /// We only permit one event of each type in the queue at a time.
@@ -189,17 +197,67 @@ public:
 
     s64 GetDowncount() const;
 
+    /// Timer state and pending events as stored in save states. Events refer to their type by name.
+    struct Snapshot {
+        struct EventState {
+            s64 time;
+            u64 fifo_order;
+            u64 userdata;
+            std::string type;
+        };
+
+        s64 global_timer;
+        s64 slice_length;
+        s64 downcount;
+        s64 idled_cycles;
+        u64 event_fifo_id;
+        bool is_global_timer_sane;
+        std::vector<EventState> events;
+
+        void DoState(PointerWrap& p);
+    };
+
+    Snapshot TakeSnapshot();
+
+    /// Checks that every event in the snapshot has a registered type
+    bool CanRestoreSnapshot(const Snapshot& snapshot) const;
+
+    /// Replaces the timer state and the pending events with those of the snapshot
+    void RestoreSnapshot(const Snapshot& snapshot);
+
 private:
     struct Event {
         s64 time;
         u64 fifo_order;
         u64 userdata;
         const TimingEventType* type;
+    };
+
+    /// An event in the queue, along with its current position in the heap
+    struct QueuedEvent {
+        Event event;
+        std::size_t heap_index;
+    };
+
+    /// A node of the heap. Holds the sort keys of its event so that sifting doesn't need to look
+    /// the events up.
+    struct HeapNode {
+        s64 time;
+        u64 fifo_order;
+        u32 slot;
 
-        bool operator>(const Event& right) const;
-        bool operator<(const Event& right) const;
+        bool operator<(const HeapNode& right) const;
     };
 
+    void PushEvent(const Event& event);
+    /// Removes an event from the heap and frees its slot, without touching pending_events
+    void EraseQueuedEvent(u32 slot);
+    void ClearEvents();
+
+    void SetHeapNode(std::size_t index, const HeapNode& node);
+    void SiftUp(std::size_t index);
+    void SiftDown(std::size_t index);
+
     static constexpr int MAX_SLICE_LENGTH = 20000;
 
     s64 global_timer = 0;
@@ -210,11 +268,13 @@ private:
     // elements remain stable regardless of rehashes/resizing.
     std::unordered_map<std::string, TimingEventType> event_types;
 
-    // The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-    // We don't use std::priority_queue because we need to be able to serialize, unserialize and
-    // erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't
-    // accomodated by the standard adaptor class.
-    std::vector<Event> event_queue;
+    // The queue is a 4-ary min-heap of nodes pointing into queued_events. Each queued event knows
+    // its position in the heap, and pending_events finds the events by type and userdata, so that
+    // events can be unscheduled or rescheduled in O(log n) without searching the queue.
+    std::vector<HeapNode> event_queue;
+    std::vector<QueuedEvent> queued_events;
+    std::vector<u32> free_slots;
+    std::unordered_map<const TimingEventType*, std::unordered_multimap<u64, u32>> pending_events;
     u64 event_fifo_id = 0;
     // the queue for storing the events from other threads threadsafe until they will be added
     // to the event_queue by the emu thread
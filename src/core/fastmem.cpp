@@ -0,0 +1,93 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "core/fastmem.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Memory {
+
+#ifdef __linux__
+
+bool FastmemArena::IsSupported() {
+    return true;
+}
+
+FastmemArena::FastmemArena(std::size_t size) : size(size) {
+    fd = static_cast<int>(syscall(SYS_memfd_create, "citra-ram", 0));
+    ASSERT_MSG(fd >= 0, "Failed to create the fastmem backing file");
+    const int result = ftruncate(fd, static_cast<off_t>(size));
+    ASSERT_MSG(result == 0, "Failed to size the fastmem backing file");
+
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ASSERT_MSG(view != MAP_FAILED, "Failed to map the fastmem backing file");
+    data = static_cast<u8*>(view);
+}
+
+FastmemArena::~FastmemArena() {
+    for (u8* window : windows) {
+        munmap(window, WINDOW_SIZE);
+    }
+    munmap(data, size);
+    close(fd);
+}
+
+u8* FastmemArena::CreateWindow() {
+    void* window = mmap(nullptr, WINDOW_SIZE, PROT_NONE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    ASSERT_MSG(window != MAP_FAILED, "Failed to reserve a fastmem window");
+    windows.push_back(static_cast<u8*>(window));
+    return static_cast<u8*>(window);
+}
+
+void FastmemArena::DestroyWindow(u8* window) {
+    windows.erase(std::find(windows.begin(), windows.end(), window));
+    munmap(window, WINDOW_SIZE);
+}
+
+void FastmemArena::Map(u8* window, VAddr vaddr, const u8* backing, std::size_t length) {
+    DEBUG_ASSERT(Contains(backing) && backing + length <= data + size);
+    void* result = mmap(window + vaddr, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd,
+                        static_cast<off_t>(backing - data));
+    ASSERT_MSG(result != MAP_FAILED, "Failed to map {:08X} into a fastmem window", vaddr);
+}
+
+void FastmemArena::Unmap(u8* window, VAddr vaddr, std::size_t length) {
+    void* result = mmap(window + vaddr, length, PROT_NONE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+    ASSERT_MSG(result != MAP_FAILED, "Failed to unmap {:08X} from a fastmem window", vaddr);
+}
+
+#else
+
+bool FastmemArena::IsSupported() {
+    return false;
+}
+
+FastmemArena::FastmemArena(std::size_t size) : size(size) {
+    UNREACHABLE_MSG("Fastmem is not supported on this platform");
+}
+
+FastmemArena::~FastmemArena() = default;
+
+u8* FastmemArena::CreateWindow() {
+    return nullptr;
+}
+
+void FastmemArena::DestroyWindow(u8* window) {}
+
+void FastmemArena::Map(u8* window, VAddr vaddr, const u8* backing, std::size_t length) {}
+
+void FastmemArena::Unmap(u8* window, VAddr vaddr, std::size_t length) {}
+
+#endif
+
+} // namespace Memory
@@ -0,0 +1,63 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Memory {
+
+/**
+ * Emulated RAM backed by a shared memory file, so that it can be mapped more than once.
+ *
+ * Each guest address space gets a window of 4 GiB of host address space, in which the pages of
+ * the emulated RAM are mapped at their guest virtual addresses. A guest access is then a single
+ * host access at window + vaddr. Pages that need special handling are left inaccessible, so
+ * callers have to check the page type before going through the window.
+ */
+class FastmemArena {
+public:
+    static constexpr std::size_t WINDOW_SIZE = std::size_t{1} << 32;
+
+    /// Whether the host supports fastmem
+    static bool IsSupported();
+
+    explicit FastmemArena(std::size_t size);
+    ~FastmemArena();
+
+    FastmemArena(const FastmemArena&) = delete;
+    FastmemArena& operator=(const FastmemArena&) = delete;
+
+    /// The arena's own view of the backing memory, which is always accessible
+    u8* Data() const {
+        return data;
+    }
+
+    bool Contains(const u8* pointer) const {
+        return pointer >= data && pointer < data + size;
+    }
+
+    /// Reserves a window in which nothing is accessible
+    u8* CreateWindow();
+    void DestroyWindow(u8* window);
+
+    /**
+     * Maps backing memory into a window.
+     * @param backing Pointer into Data()
+     */
+    void Map(u8* window, VAddr vaddr, const u8* backing, std::size_t length);
+
+    /// Removes the backing memory from a range of a window
+    void Unmap(u8* window, VAddr vaddr, std::size_t length);
+
+private:
+    int fd = -1;
+    u8* data = nullptr;
+    std::size_t size;
+    std::vector<u8*> windows;
+};
+
+} // namespace Memory
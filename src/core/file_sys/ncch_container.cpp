@@ -5,14 +5,13 @@
 #include <cinttypes>
 #include <cstring>
 #include <memory>
-#include <cryptopp/aes.h>
-#include <cryptopp/modes.h>
 #include <cryptopp/sha.h>
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/file_sys/ncch_container.h"
 #include "core/file_sys/seed_db.h"
+#include "core/hw/aes/cipher.h"
 #include "core/hw/aes/key.h"
 #include "core/loader/loader.h"
 
@@ -337,10 +336,9 @@ Loader::ResultStatus NCCHContainer::Load() {
                         LOG_ERROR(Service_FS, "Failed to decrypt");
                         return Loader::ResultStatus::ErrorEncrypted;
                     }
-                    CryptoPP::byte* data = reinterpret_cast<CryptoPP::byte*>(&exheader_header);
-                    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption(
-                        primary_key.data(), primary_key.size(), exheader_ctr.data())
-                        .ProcessData(data, data, sizeof(exheader_header));
+                    u8* data = reinterpret_cast<u8*>(&exheader_header);
+                    HW::AES::CTRCipher(primary_key, exheader_ctr)
+                        .Process(data, sizeof(exheader_header));
                 }
             }
 
@@ -384,10 +382,8 @@ Loader::ResultStatus NCCHContainer::Load() {
                 return Loader::ResultStatus::Error;
 
             if (is_encrypted) {
-                CryptoPP::byte* data = reinterpret_cast<CryptoPP::byte*>(&exefs_header);
-                CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption(primary_key.data(),
-                                                              primary_key.size(), exefs_ctr.data())
-                    .ProcessData(data, data, sizeof(exefs_header));
+                u8* data = reinterpret_cast<u8*>(&exefs_header);
+                HW::AES::CTRCipher(primary_key, exefs_ctr).Process(data, sizeof(exefs_header));
             }
 
             exefs_file = FileUtil::IOFile(filepath, "rb");
@@ -496,8 +492,7 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
                 key = secondary_key;
             }
 
-            CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption dec(key.data(), key.size(),
-                                                              exefs_ctr.data());
+            HW::AES::CTRCipher dec(key, exefs_ctr);
             dec.Seek(section.offset + sizeof(ExeFs_Header));
 
             if (strcmp(section.name, ".code") == 0 && is_compressed) {
@@ -513,7 +508,7 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
                     return Loader::ResultStatus::Error;
 
                 if (is_encrypted) {
-                    dec.ProcessData(&temp_buffer[0], &temp_buffer[0], section.size);
+                    dec.Process(&temp_buffer[0], section.size);
                 }
 
                 // Decompress .code section...
@@ -527,7 +522,7 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
                 if (exefs_file.ReadBytes(&buffer[0], section.size) != section.size)
                     return Loader::ResultStatus::Error;
                 if (is_encrypted) {
-                    dec.ProcessData(&buffer[0], &buffer[0], section.size);
+                    dec.Process(&buffer[0], section.size);
                 }
             }
 
@@ -1,22 +1,209 @@
 #include <algorithm>
-#include <cryptopp/aes.h>
-#include <cryptopp/modes.h>
+#include <cstring>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+#include "common/logging/log.h"
+#include "common/thread_worker.h"
 #include "core/file_sys/romfs_reader.h"
+#include "core/hw/aes/cipher.h"
 
 namespace FileSys {
 
+/// Size of the blocks the RomFS is cached in
+constexpr std::size_t cache_block_size = 0x10000;
+/// Maximum number of blocks kept in the cache
+constexpr std::size_t max_cached_blocks = 64;
+/// Reads at least this large bypass the cache
+constexpr std::size_t uncached_read_size = cache_block_size * 4;
+/// Number of blocks read ahead of a sequential read
+constexpr std::size_t read_ahead_blocks = 2;
+
+RomFSReader::RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size)
+    : is_encrypted(false), file(std::move(file)), file_offset(file_offset), data_size(data_size) {
+    MapFile();
+}
+
+RomFSReader::RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size,
+                         const std::array<u8, 16>& key, const std::array<u8, 16>& ctr,
+                         std::size_t crypto_offset)
+    : is_encrypted(true), file(std::move(file)), key(key), ctr(ctr), file_offset(file_offset),
+      crypto_offset(crypto_offset), data_size(data_size),
+      decryptor(std::make_unique<HW::AES::CTRCipher>(key, ctr)) {
+    MapFile();
+}
+
+RomFSReader::~RomFSReader() {
+    // The background thread may still be reading from the file
+    read_ahead_worker.reset();
+    UnmapFile();
+
+    LOG_DEBUG(Service_FS,
+              "RomFS cache: {} reads, {} block hits, {} block misses, {} blocks read ahead, {} us "
+              "reading",
+              stats.reads, stats.block_hits, stats.block_misses, stats.blocks_read_ahead,
+              std::chrono::duration_cast<std::chrono::microseconds>(stats.read_time).count());
+}
+
+void RomFSReader::MapFile() {
+#ifndef _WIN32
+    const std::size_t size = file.GetSize();
+    if (!file.IsOpen() || size == 0)
+        return;
+
+    void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileno(file.GetHandle()), 0);
+    if (view == MAP_FAILED) {
+        LOG_WARNING(Service_FS, "Could not map RomFS file, falling back to reading it");
+        return;
+    }
+    file_view = static_cast<u8*>(view);
+    file_view_size = size;
+#endif
+}
+
+void RomFSReader::UnmapFile() {
+#ifndef _WIN32
+    if (file_view) {
+        munmap(file_view, file_view_size);
+        file_view = nullptr;
+    }
+#endif
+}
+
+std::size_t RomFSReader::ReadRaw(std::size_t offset, std::size_t length, u8* out) {
+    std::size_t read_length;
+    if (file_view) {
+        const std::size_t begin = std::min(file_offset + offset, file_view_size);
+        read_length = std::min(length, file_view_size - begin);
+        std::memcpy(out, file_view + begin, read_length);
+    } else {
+        file.Seek(file_offset + offset, SEEK_SET);
+        read_length = file.ReadBytes(out, length);
+    }
+
+    if (is_encrypted && read_length != 0) {
+        decryptor->Seek(crypto_offset + offset);
+        decryptor->Process(out, read_length);
+    }
+    return read_length;
+}
+
+std::shared_ptr<const RomFSReader::Block> RomFSReader::FindCachedBlock(std::size_t index) {
+    std::lock_guard lock(cache_mutex);
+    const auto it = cached_blocks.find(index);
+    if (it == cached_blocks.end())
+        return nullptr;
+
+    lru_blocks.splice(lru_blocks.begin(), lru_blocks, it->second.lru_entry);
+    return it->second.data;
+}
+
+std::shared_ptr<const RomFSReader::Block> RomFSReader::LoadBlock(std::size_t index) {
+    std::lock_guard io_lock(io_mutex);
+    // The block may have been read ahead while we waited for the lock
+    if (auto block = FindCachedBlock(index))
+        return block;
+
+    const std::size_t offset = index * cache_block_size;
+    auto block = std::make_shared<Block>(std::min(cache_block_size, data_size - offset));
+    block->resize(ReadRaw(offset, block->size(), block->data()));
+
+    std::lock_guard lock(cache_mutex);
+    if (cached_blocks.size() >= max_cached_blocks) {
+        cached_blocks.erase(lru_blocks.back());
+        lru_blocks.pop_back();
+    }
+    lru_blocks.push_front(index);
+    cached_blocks.emplace(index, CachedBlock{block, lru_blocks.begin()});
+    return block;
+}
+
+std::shared_ptr<const RomFSReader::Block> RomFSReader::GetBlock(std::size_t index) {
+    if (auto block = FindCachedBlock(index)) {
+        std::lock_guard lock(cache_mutex);
+        ++stats.block_hits;
+        return block;
+    }
+
+    {
+        std::lock_guard lock(cache_mutex);
+        ++stats.block_misses;
+    }
+    return LoadBlock(index);
+}
+
+void RomFSReader::QueueReadAhead(std::size_t last_index) {
+    const std::size_t num_blocks = (data_size + cache_block_size - 1) / cache_block_size;
+    const std::size_t end = std::min(last_index + 1 + read_ahead_blocks, num_blocks);
+
+    std::lock_guard lock(cache_mutex);
+    for (std::size_t index = last_index + 1; index < end; ++index) {
+        if (cached_blocks.count(index) != 0 || !pending_blocks.insert(index).second)
+            continue;
+
+        if (!read_ahead_worker) {
+            read_ahead_worker = std::make_unique<Common::ThreadWorker>(1, "RomFSReadAhead");
+        }
+        read_ahead_worker->QueueWork([this, index] {
+            LoadBlock(index);
+            // Also when the block was already loaded, so that it can be read ahead again once
+            // it is evicted
+            std::lock_guard lock(cache_mutex);
+            pending_blocks.erase(index);
+            ++stats.blocks_read_ahead;
+        });
+    }
+}
+
 std::size_t RomFSReader::ReadFile(std::size_t offset, std::size_t length, u8* buffer) {
-    if (length == 0)
-        return 0; // Crypto++ does not like zero size buffer
-    file.Seek(file_offset + offset, SEEK_SET);
+    if (length == 0 || offset >= data_size)
+        return 0;
+
+    const auto start_time = std::chrono::steady_clock::now();
     std::size_t read_length = std::min(length, data_size - offset);
-    read_length = file.ReadBytes(buffer, read_length);
-    if (is_encrypted) {
-        CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption d(key.data(), key.size(), ctr.data());
-        d.Seek(crypto_offset + offset);
-        d.ProcessData(buffer, buffer, read_length);
+
+    if ((file_view && !is_encrypted) || read_length >= uncached_read_size) {
+        // Either there is nothing to cache, or the read would just evict the whole cache
+        std::lock_guard io_lock(io_mutex);
+        read_length = ReadRaw(offset, read_length, buffer);
+    } else {
+        const std::size_t first_block = offset / cache_block_size;
+        const std::size_t last_block = (offset + read_length - 1) / cache_block_size;
+
+        std::size_t copied = 0;
+        for (std::size_t index = first_block; index <= last_block; ++index) {
+            const auto block = GetBlock(index);
+            const std::size_t block_offset = offset + copied - index * cache_block_size;
+            if (block_offset >= block->size())
+                break;
+
+            const std::size_t copy_size =
+                std::min(read_length - copied, block->size() - block_offset);
+            std::memcpy(buffer + copied, block->data() + block_offset, copy_size);
+            copied += copy_size;
+        }
+        read_length = copied;
+
+        bool sequential;
+        {
+            std::lock_guard lock(cache_mutex);
+            sequential = first_block == last_read_block || first_block == last_read_block + 1;
+            last_read_block = last_block;
+        }
+        if (sequential) {
+            QueueReadAhead(last_block);
+        }
     }
+
+    std::lock_guard lock(cache_mutex);
+    ++stats.reads;
+    stats.read_time += std::chrono::steady_clock::now() - start_time;
     return read_length;
 }
 
+RomFSReader::CacheStats RomFSReader::GetCacheStats() const {
+    std::lock_guard lock(cache_mutex);
+    return stats;
+}
+
 } // namespace FileSys
@@ -1,22 +1,37 @@
 #pragma once
 
 #include <array>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "common/common_types.h"
 #include "common/file_util.h"
 
+namespace Common {
+class ThreadWorker;
+}
+
+namespace HW::AES {
+class CTRCipher;
+}
+
 namespace FileSys {
 
+/**
+ * Reads (and decrypts, if needed) the RomFS of a title. Small reads are served from a cache of
+ * decrypted blocks, which is filled ahead of sequential reads on a background thread.
+ */
 class RomFSReader {
 public:
-    RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size)
-        : is_encrypted(false), file(std::move(file)), file_offset(file_offset),
-          data_size(data_size) {}
-
+    RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size);
     RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size,
                 const std::array<u8, 16>& key, const std::array<u8, 16>& ctr,
-                std::size_t crypto_offset)
-        : is_encrypted(true), file(std::move(file)), key(key), ctr(ctr), file_offset(file_offset),
-          crypto_offset(crypto_offset), data_size(data_size) {}
+                std::size_t crypto_offset);
+    ~RomFSReader();
 
     std::size_t GetSize() const {
         return data_size;
@@ -24,7 +39,43 @@ public:
 
     std::size_t ReadFile(std::size_t offset, std::size_t length, u8* buffer);
 
+    struct CacheStats {
+        /// Number of ReadFile calls
+        u64 reads;
+        /// Number of blocks found in the cache, including the ones that were read ahead
+        u64 block_hits;
+        /// Number of blocks that had to be read while the caller waited
+        u64 block_misses;
+        /// Number of blocks read ahead on the background thread
+        u64 blocks_read_ahead;
+        /// Total time spent in ReadFile
+        std::chrono::nanoseconds read_time;
+    };
+
+    CacheStats GetCacheStats() const;
+
 private:
+    using Block = std::vector<u8>;
+
+    struct CachedBlock {
+        std::shared_ptr<const Block> data;
+        std::list<std::size_t>::iterator lru_entry;
+    };
+
+    void MapFile();
+    void UnmapFile();
+
+    /// Reads the raw data at offset into out, decrypting it if needed. Requires io_mutex.
+    std::size_t ReadRaw(std::size_t offset, std::size_t length, u8* out);
+
+    /// Returns the block with the given index, reading it if it isn't cached
+    std::shared_ptr<const Block> GetBlock(std::size_t index);
+    std::shared_ptr<const Block> FindCachedBlock(std::size_t index);
+    std::shared_ptr<const Block> LoadBlock(std::size_t index);
+
+    /// Queues the blocks after last_index to be read on the background thread
+    void QueueReadAhead(std::size_t last_index);
+
     bool is_encrypted;
     FileUtil::IOFile file;
     std::array<u8, 16> key;
@@ -32,6 +83,27 @@ private:
     std::size_t file_offset;
     std::size_t crypto_offset;
     std::size_t data_size;
+
+    /// Read-only mapping of the whole file, or nullptr if it couldn't be mapped
+    u8* file_view = nullptr;
+    std::size_t file_view_size = 0;
+
+    /// Guards the file position and the decryptor
+    std::mutex io_mutex;
+    std::unique_ptr<HW::AES::CTRCipher> decryptor;
+
+    /// Guards the cache and the statistics
+    mutable std::mutex cache_mutex;
+    std::unordered_map<std::size_t, CachedBlock> cached_blocks;
+    /// Indices of the cached blocks, most recently used first
+    std::list<std::size_t> lru_blocks;
+    /// Blocks queued to be read ahead
+    std::unordered_set<std::size_t> pending_blocks;
+    /// Index of the block the previous read ended in
+    std::size_t last_read_block = ~std::size_t(0);
+    CacheStats stats{};
+
+    std::unique_ptr<Common::ThreadWorker> read_ahead_worker;
 };
 
 } // namespace FileSys
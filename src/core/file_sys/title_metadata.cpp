@@ -183,6 +183,10 @@ std::array<u8, 16> TitleMetadata::GetContentCTRByIndex(u16 index) const {
     return ctr;
 }
 
+const std::array<u8, 0x20>& TitleMetadata::GetContentHashByIndex(u16 index) const {
+    return tmd_chunks[index].hash;
+}
+
 void TitleMetadata::SetTitleID(u64 title_id) {
     tmd_body.title_id = title_id;
 }
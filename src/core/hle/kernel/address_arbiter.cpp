@@ -65,6 +65,17 @@ SharedPtr<Thread> AddressArbiter::ResumeHighestPriorityThread(VAddr address) {
     return thread;
 }
 
+void AddressArbiter::SetTimeoutCallback(Thread& thread) {
+    thread.wakeup_callback = [this](ThreadWakeupReason reason, SharedPtr<Thread> thread,
+                                    SharedPtr<WaitObject> object) {
+        ASSERT(reason == ThreadWakeupReason::Timeout);
+        // Remove the newly-awakened thread from the Arbiter's waiting list.
+        waiting_threads.erase(std::remove(waiting_threads.begin(), waiting_threads.end(), thread),
+                              waiting_threads.end());
+    };
+    thread.wakeup_callback_type = WakeupCallbackType::ArbitrationTimeout;
+}
+
 AddressArbiter::AddressArbiter(KernelSystem& kernel) : Object(kernel), kernel(kernel) {}
 AddressArbiter::~AddressArbiter() {}
 
@@ -79,14 +90,6 @@ SharedPtr<AddressArbiter> KernelSystem::CreateAddressArbiter(std::string name) {
 ResultCode AddressArbiter::ArbitrateAddress(SharedPtr<Thread> thread, ArbitrationType type,
                                             VAddr address, s32 value, u64 nanoseconds) {
 
-    auto timeout_callback = [this](ThreadWakeupReason reason, SharedPtr<Thread> thread,
-                                   SharedPtr<WaitObject> object) {
-        ASSERT(reason == ThreadWakeupReason::Timeout);
-        // Remove the newly-awakened thread from the Arbiter's waiting list.
-        waiting_threads.erase(std::remove(waiting_threads.begin(), waiting_threads.end(), thread),
-                              waiting_threads.end());
-    };
-
     switch (type) {
 
     // Signal thread(s) waiting for arbitrate address...
@@ -109,7 +112,7 @@ ResultCode AddressArbiter::ArbitrateAddress(SharedPtr<Thread> thread, Arbitratio
         break;
     case ArbitrationType::WaitIfLessThanWithTimeout:
         if ((s32)kernel.memory.Read32(address) < value) {
-            thread->wakeup_callback = timeout_callback;
+            SetTimeoutCallback(*thread);
             thread->WakeAfterDelay(nanoseconds);
             WaitThread(std::move(thread), address);
         }
@@ -128,7 +131,7 @@ ResultCode AddressArbiter::ArbitrateAddress(SharedPtr<Thread> thread, Arbitratio
         if (memory_value < value) {
             // Only change the memory value if the thread should wait
             kernel.memory.Write32(address, (s32)memory_value - 1);
-            thread->wakeup_callback = timeout_callback;
+            SetTimeoutCallback(*thread);
             thread->WakeAfterDelay(nanoseconds);
             WaitThread(std::move(thread), address);
         }
@@ -64,6 +64,9 @@ private:
     /// the resumed thread.
     SharedPtr<Thread> ResumeHighestPriorityThread(VAddr address);
 
+    /// Makes the thread leave the list of waiting threads when its wait times out
+    void SetTimeoutCallback(Thread& thread);
+
     /// Threads waiting for the address arbiter to be signaled.
     std::vector<SharedPtr<Thread>> waiting_threads;
 
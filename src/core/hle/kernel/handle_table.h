@@ -115,6 +115,8 @@ private:
     u16 next_free_slot;
 
     KernelSystem& kernel;
+
+    friend class KernelSystem;
 };
 
 } // namespace Kernel
@@ -7,6 +7,7 @@
 #include <array>
 #include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -38,6 +39,7 @@ class AddressArbiter;
 class Event;
 class Mutex;
 class CodeSet;
+class Object;
 class Process;
 class Thread;
 class Semaphore;
@@ -52,6 +54,7 @@ class ThreadManager;
 class TimerManager;
 class VMManager;
 struct AddressMapping;
+struct KernelSnapshot;
 
 enum class ResetType {
     OneShot,
@@ -204,6 +207,23 @@ public:
 
     u32 GenerateObjectID();
 
+    /**
+     * Captures the state of the kernel objects and threads for a save state. Must be called between
+     * two CPU time slices.
+     * @returns false if a thread waits for an HLE service or an emulated service is handling a
+     *          request with mapped buffers, which can't be saved. Try again later.
+     */
+    bool TakeSnapshot(KernelSnapshot& snapshot);
+
+    /**
+     * Checks that a snapshot is consistent and can be restored: the memory mappings are unchanged,
+     * and every object that can't be created again still exists.
+     */
+    bool CanRestoreSnapshot(const KernelSnapshot& snapshot) const;
+
+    /// Restores a snapshot that CanRestoreSnapshot accepted
+    void RestoreSnapshot(const KernelSnapshot& snapshot);
+
     /// Retrieves a process from the current list of processes.
     SharedPtr<Process> GetProcessById(u32 process_id) const;
 
@@ -244,6 +264,12 @@ public:
 private:
     void MemoryInit(u32 mem_type);
 
+    /// Returns every object reachable from the processes, threads, named ports and timers
+    std::map<u32, SharedPtr<Object>> CollectObjects() const;
+
+    /// Hashes the memory mappings of the processes and the state of the memory region allocators
+    u64 GetMemoryLayoutHash() const;
+
     std::function<void()> prepare_reschedule_callback;
 
     std::unique_ptr<ResourceLimitList> resource_limits;
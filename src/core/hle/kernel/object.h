@@ -64,6 +64,7 @@ public:
 private:
     friend void intrusive_ptr_add_ref(Object*);
     friend void intrusive_ptr_release(Object*);
+    friend class KernelSystem;
 
     std::atomic<u32> ref_count{0};
     std::atomic<u32> object_id;
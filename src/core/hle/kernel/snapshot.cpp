@@ -0,0 +1,895 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include "common/assert.h"
+#include "common/chunk_file.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "core/arm/arm_interface.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/address_arbiter.h"
+#include "core/hle/kernel/client_port.h"
+#include "core/hle/kernel/client_session.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/mutex.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/resource_limit.h"
+#include "core/hle/kernel/semaphore.h"
+#include "core/hle/kernel/server_port.h"
+#include "core/hle/kernel/server_session.h"
+#include "core/hle/kernel/session.h"
+#include "core/hle/kernel/snapshot.h"
+#include "core/hle/kernel/svc.h"
+#include "core/hle/kernel/thread.h"
+#include "core/hle/kernel/timer.h"
+#include "core/memory.h"
+
+namespace Kernel {
+
+void KernelSnapshot::ThreadState::DoState(PointerWrap& p) {
+    p.Do(object_id);
+    p.Do(thread_id);
+    p.Do(owner_process);
+    p.Do(name);
+    p.Do(entry_point);
+    p.Do(stack_top);
+    p.Do(tls_address);
+    p.Do(processor_id);
+    p.Do(status);
+    p.Do(nominal_priority);
+    p.Do(current_priority);
+    p.Do(last_running_ticks);
+    p.Do(wait_address);
+    p.Do(wakeup_callback);
+    p.Do(wait_objects);
+    p.Do(held_mutexes);
+    p.Do(pending_mutexes);
+    p.Do(context);
+}
+
+void KernelSnapshot::ProcessState::DoState(PointerWrap& p) {
+    p.Do(object_id);
+    p.Do(status);
+    p.Do(tls_slots);
+    p.Do(next_generation);
+    p.Do(next_free_slot);
+    p.Do(generations);
+    p.Do(handles);
+}
+
+void KernelSnapshot::ServerSessionState::DoState(PointerWrap& p) {
+    p.Do(object_id);
+    p.Do(currently_handling);
+    p.Do(pending_requesting_threads);
+}
+
+void KernelSnapshot::ServerPortState::DoState(PointerWrap& p) {
+    p.Do(object_id);
+    p.Do(pending_sessions);
+}
+
+void KernelSnapshot::WaitList::DoState(PointerWrap& p) {
+    p.Do(object_id);
+    p.Do(threads);
+}
+
+void KernelSnapshot::DoState(PointerWrap& p) {
+    p.Do(current_process);
+    p.Do(current_thread);
+    p.Do(next_thread_id);
+    p.Do(next_timer_callback_id);
+    p.Do(memory_layout_hash);
+    p.Do(objects);
+    p.Do(processes);
+    p.Do(threads);
+    p.Do(thread_list);
+    p.Do(ready_queue);
+    p.Do(events);
+    p.Do(mutexes);
+    p.Do(semaphores);
+    p.Do(timers);
+    p.Do(server_sessions);
+    p.Do(server_ports);
+    p.Do(client_ports);
+    p.Do(resource_limits);
+    p.Do(wait_lists);
+}
+
+namespace {
+
+constexpr std::size_t NUM_RESOURCE_LIMIT_CATEGORIES = 4;
+
+/// Resource types that ResourceLimit counts, in the order of ResourceLimitState::current_values
+constexpr std::array<ResourceTypes, 9> counted_resources{{
+    COMMIT,
+    THREAD,
+    EVENT,
+    MUTEX,
+    SEMAPHORE,
+    TIMER,
+    SHARED_MEMORY,
+    ADDRESS_ARBITER,
+    CPU_TIME,
+}};
+
+s32* GetCurrentValue(ResourceLimit& limit, ResourceTypes resource) {
+    switch (resource) {
+    case COMMIT:
+        return &limit.current_commit;
+    case THREAD:
+        return &limit.current_threads;
+    case EVENT:
+        return &limit.current_events;
+    case MUTEX:
+        return &limit.current_mutexes;
+    case SEMAPHORE:
+        return &limit.current_semaphores;
+    case TIMER:
+        return &limit.current_timers;
+    case SHARED_MEMORY:
+        return &limit.current_shared_mems;
+    case ADDRESS_ARBITER:
+        return &limit.current_address_arbiters;
+    case CPU_TIME:
+        return &limit.current_cpu_time;
+    default:
+        UNREACHABLE();
+        return nullptr;
+    }
+}
+
+/// Objects that don't hold host state and are created again if they were destroyed
+bool CanRecreate(HandleType type) {
+    switch (type) {
+    case HandleType::Thread:
+    case HandleType::Event:
+    case HandleType::Mutex:
+    case HandleType::Semaphore:
+    case HandleType::Timer:
+    case HandleType::AddressArbiter:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool IsWaitable(HandleType type) {
+    switch (type) {
+    case HandleType::Event:
+    case HandleType::Mutex:
+    case HandleType::Thread:
+    case HandleType::Semaphore:
+    case HandleType::Timer:
+    case HandleType::ServerPort:
+    case HandleType::ServerSession:
+        return true;
+    default:
+        return false;
+    }
+}
+
+u32 GetObjectId(const Object* object) {
+    return object != nullptr ? object->GetObjectId() : KernelSnapshot::NO_OBJECT;
+}
+
+template <typename T>
+std::vector<u32> GetObjectIds(const T& objects) {
+    std::vector<u32> ids;
+    ids.reserve(objects.size());
+    for (const auto& object : objects) {
+        ids.push_back(object->GetObjectId());
+    }
+    return ids;
+}
+
+KernelSnapshot::ContextState ReadContext(const ARM_Interface::ThreadContext& context) {
+    KernelSnapshot::ContextState state;
+    for (std::size_t i = 0; i < state.cpu_registers.size(); ++i) {
+        state.cpu_registers[i] = context.GetCpuRegister(i);
+    }
+    state.cpsr = context.GetCpsr();
+    for (std::size_t i = 0; i < state.fpu_registers.size(); ++i) {
+        state.fpu_registers[i] = context.GetFpuRegister(i);
+    }
+    state.fpscr = context.GetFpscr();
+    state.fpexc = context.GetFpexc();
+    return state;
+}
+
+void WriteContext(ARM_Interface::ThreadContext& context,
+                  const KernelSnapshot::ContextState& state) {
+    for (std::size_t i = 0; i < state.cpu_registers.size(); ++i) {
+        context.SetCpuRegister(i, state.cpu_registers[i]);
+    }
+    context.SetCpsr(state.cpsr);
+    for (std::size_t i = 0; i < state.fpu_registers.size(); ++i) {
+        context.SetFpuRegister(i, state.fpu_registers[i]);
+    }
+    context.SetFpscr(state.fpscr);
+    context.SetFpexc(state.fpexc);
+}
+
+/// Checks that the IDs a snapshot refers to name objects of the expected types
+class SnapshotValidator {
+public:
+    explicit SnapshotValidator(const KernelSnapshot& snapshot) {
+        for (const auto& info : snapshot.objects) {
+            types.emplace(info.object_id, info.type);
+        }
+    }
+
+    bool Is(u32 object_id, HandleType type) const {
+        const auto it = types.find(object_id);
+        return it != types.end() && it->second == type;
+    }
+
+    bool IsOrNone(u32 object_id, HandleType type) const {
+        return object_id == KernelSnapshot::NO_OBJECT || Is(object_id, type);
+    }
+
+    bool Exists(u32 object_id) const {
+        return types.count(object_id) != 0;
+    }
+
+    bool IsWaitObject(u32 object_id) const {
+        const auto it = types.find(object_id);
+        return it != types.end() && IsWaitable(it->second);
+    }
+
+    bool AreAll(const std::vector<u32>& object_ids, HandleType type) const {
+        return std::all_of(object_ids.begin(), object_ids.end(),
+                           [this, type](u32 object_id) { return Is(object_id, type); });
+    }
+
+private:
+    std::unordered_map<u32, HandleType> types;
+};
+
+bool IsConsistent(const KernelSnapshot& snapshot) {
+    const SnapshotValidator validator(snapshot);
+
+    if (!validator.IsOrNone(snapshot.current_process, HandleType::Process) ||
+        !validator.IsOrNone(snapshot.current_thread, HandleType::Thread) ||
+        !validator.AreAll(snapshot.thread_list, HandleType::Thread) ||
+        !validator.AreAll(snapshot.ready_queue, HandleType::Thread)) {
+        return false;
+    }
+
+    // Every thread, process and recreatable object needs its state
+    std::unordered_set<u32> with_state;
+    for (const auto& process : snapshot.processes) {
+        if (!validator.Is(process.object_id, HandleType::Process) ||
+            !std::all_of(process.handles.begin(), process.handles.end(),
+                         [&validator](const auto& handle) {
+                             return validator.Exists(handle.object_id);
+                         })) {
+            return false;
+        }
+        with_state.insert(process.object_id);
+    }
+
+    std::unordered_map<u32, const KernelSnapshot::ThreadState*> threads;
+    for (const auto& thread : snapshot.threads) {
+        if (!validator.Is(thread.object_id, HandleType::Thread) ||
+            !validator.Is(thread.owner_process, HandleType::Process) ||
+            thread.current_priority > ThreadPrioLowest ||
+            thread.nominal_priority > ThreadPrioLowest ||
+            thread.wakeup_callback == WakeupCallbackType::HLE ||
+            !validator.AreAll(thread.held_mutexes, HandleType::Mutex) ||
+            !validator.AreAll(thread.pending_mutexes, HandleType::Mutex) ||
+            !std::all_of(thread.wait_objects.begin(), thread.wait_objects.end(),
+                         [&validator](u32 id) { return validator.IsWaitObject(id); })) {
+            return false;
+        }
+        threads.emplace(thread.object_id, &thread);
+        with_state.insert(thread.object_id);
+    }
+    for (u32 object_id : snapshot.ready_queue) {
+        if (threads.count(object_id) == 0 ||
+            threads.at(object_id)->status != ThreadStatus::Ready) {
+            return false;
+        }
+    }
+
+    for (const auto& event : snapshot.events) {
+        if (!validator.Is(event.object_id, HandleType::Event))
+            return false;
+        with_state.insert(event.object_id);
+    }
+    for (const auto& mutex : snapshot.mutexes) {
+        if (!validator.Is(mutex.object_id, HandleType::Mutex) ||
+            !validator.IsOrNone(mutex.holding_thread, HandleType::Thread))
+            return false;
+        with_state.insert(mutex.object_id);
+    }
+    for (const auto& semaphore : snapshot.semaphores) {
+        if (!validator.Is(semaphore.object_id, HandleType::Semaphore))
+            return false;
+        with_state.insert(semaphore.object_id);
+    }
+    for (const auto& timer : snapshot.timers) {
+        if (!validator.Is(timer.object_id, HandleType::Timer))
+            return false;
+        with_state.insert(timer.object_id);
+    }
+    for (const auto& session : snapshot.server_sessions) {
+        if (!validator.Is(session.object_id, HandleType::ServerSession) ||
+            !validator.IsOrNone(session.currently_handling, HandleType::Thread) ||
+            !validator.AreAll(session.pending_requesting_threads, HandleType::Thread))
+            return false;
+    }
+    for (const auto& port : snapshot.server_ports) {
+        if (!validator.Is(port.object_id, HandleType::ServerPort) ||
+            !validator.AreAll(port.pending_sessions, HandleType::ServerSession))
+            return false;
+    }
+    for (const auto& port : snapshot.client_ports) {
+        if (!validator.Is(port.object_id, HandleType::ClientPort))
+            return false;
+    }
+    for (const auto& limit : snapshot.resource_limits) {
+        if (!validator.Is(limit.object_id, HandleType::ResourceLimit))
+            return false;
+    }
+    for (const auto& wait_list : snapshot.wait_lists) {
+        if ((!validator.IsWaitObject(wait_list.object_id) &&
+             !validator.Is(wait_list.object_id, HandleType::AddressArbiter)) ||
+            !validator.AreAll(wait_list.threads, HandleType::Thread))
+            return false;
+    }
+
+    for (const auto& info : snapshot.objects) {
+        // Address arbiters have no state besides their wait list
+        const bool needs_state =
+            info.type == HandleType::Process ||
+            (CanRecreate(info.type) && info.type != HandleType::AddressArbiter);
+        if (needs_state && with_state.count(info.object_id) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // Anonymous namespace
+
+std::map<u32, SharedPtr<Object>> KernelSystem::CollectObjects() const {
+    std::map<u32, SharedPtr<Object>> objects;
+    std::vector<Object*> pending;
+    const auto add = [&objects, &pending](Object* object) {
+        if (object != nullptr && objects.emplace(object->GetObjectId(), object).second) {
+            pending.push_back(object);
+        }
+    };
+    const auto add_all = [&add](const auto& list) {
+        for (const auto& object : list) {
+            add(object.get());
+        }
+    };
+
+    add_all(process_list);
+    add(current_process.get());
+    add_all(thread_manager->thread_list);
+    for (const auto& [name, port] : named_ports) {
+        add(port.get());
+    }
+    for (const auto& [callback_id, timer] : timer_manager->timer_callback_table) {
+        add(timer);
+    }
+    for (std::size_t category = 0; category < NUM_RESOURCE_LIMIT_CATEGORIES; ++category) {
+        add(resource_limits->GetForCategory(static_cast<ResourceLimitCategory>(category)).get());
+    }
+
+    while (!pending.empty()) {
+        Object* object = pending.back();
+        pending.pop_back();
+
+        if (object->IsWaitable()) {
+            add_all(static_cast<WaitObject*>(object)->waiting_threads);
+        }
+
+        switch (object->GetHandleType()) {
+        case HandleType::Process: {
+            auto* process = static_cast<Process*>(object);
+            add_all(process->handle_table.objects);
+            add(process->codeset.get());
+            add(process->resource_limit.get());
+            break;
+        }
+        case HandleType::Thread: {
+            auto* thread = static_cast<Thread*>(object);
+            add(thread->owner_process);
+            add_all(thread->wait_objects);
+            add_all(thread->held_mutexes);
+            add_all(thread->pending_mutexes);
+            break;
+        }
+        case HandleType::Mutex:
+            add(static_cast<Mutex*>(object)->holding_thread.get());
+            break;
+        case HandleType::AddressArbiter:
+            add_all(static_cast<AddressArbiter*>(object)->waiting_threads);
+            break;
+        case HandleType::ClientPort:
+            add(static_cast<ClientPort*>(object)->server_port.get());
+            break;
+        case HandleType::ServerPort:
+            add_all(static_cast<ServerPort*>(object)->pending_sessions);
+            break;
+        case HandleType::ClientSession: {
+            const auto& parent = static_cast<ClientSession*>(object)->parent;
+            if (parent != nullptr) {
+                add(parent->server);
+                add(parent->port.get());
+            }
+            break;
+        }
+        case HandleType::ServerSession: {
+            auto* session = static_cast<ServerSession*>(object);
+            if (session->parent != nullptr) {
+                add(session->parent->client);
+                add(session->parent->port.get());
+            }
+            add(session->currently_handling.get());
+            add_all(session->pending_requesting_threads);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return objects;
+}
+
+u64 KernelSystem::GetMemoryLayoutHash() const {
+    const u8* fcram = memory.GetFCRAMPointer(0);
+
+    std::vector<u64> values;
+    for (const auto& process : process_list) {
+        values.push_back(process->GetObjectId());
+        values.push_back(process->memory_used);
+        for (const auto& [base, vma] : process->vm_manager.vma_map) {
+            // Backing memory outside of FCRAM belongs to fixed mappings, which are identified by
+            // their address
+            u64 backing_offset = ~0ULL;
+            if (vma.backing_memory >= fcram &&
+                vma.backing_memory < fcram + Memory::FCRAM_N3DS_SIZE) {
+                backing_offset = static_cast<u64>(vma.backing_memory - fcram);
+            }
+            values.insert(values.end(), {vma.base, vma.size, static_cast<u64>(vma.type),
+                                         static_cast<u64>(vma.permissions),
+                                         static_cast<u64>(vma.meminfo_state), vma.paddr,
+                                         backing_offset});
+        }
+    }
+    for (const auto& region : memory_regions) {
+        values.insert(values.end(), {region.base, region.size, region.used});
+        for (const auto& interval : region.free_blocks) {
+            values.insert(values.end(), {interval.lower(), interval.upper()});
+        }
+    }
+    return Common::ComputeHash64(values.data(), values.size() * sizeof(u64));
+}
+
+bool KernelSystem::TakeSnapshot(KernelSnapshot& snapshot) {
+    const auto objects = CollectObjects();
+
+    // The registers of the running thread only live in the CPU
+    Thread* current_thread = thread_manager->GetCurrentThread();
+    if (current_thread != nullptr) {
+        thread_manager->cpu->SaveContext(current_thread->context);
+    }
+
+    snapshot = {};
+    snapshot.current_process = GetObjectId(current_process.get());
+    snapshot.current_thread = GetObjectId(current_thread);
+    snapshot.next_thread_id = thread_manager->next_thread_id;
+    snapshot.next_timer_callback_id = timer_manager->next_timer_callback_id;
+    snapshot.memory_layout_hash = GetMemoryLayoutHash();
+    snapshot.thread_list = GetObjectIds(thread_manager->thread_list);
+    for (u32 priority = ThreadPrioHighest; priority <= ThreadPrioLowest; ++priority) {
+        for (const Thread* thread : thread_manager->ready_queue.get(priority)) {
+            snapshot.ready_queue.push_back(thread->GetObjectId());
+        }
+    }
+
+    for (const auto& [object_id, object] : objects) {
+        snapshot.objects.push_back({object_id, object->GetHandleType()});
+
+        if (object->IsWaitable()) {
+            const auto& waiting_threads = static_cast<WaitObject*>(object.get())->waiting_threads;
+            if (!waiting_threads.empty()) {
+                snapshot.wait_lists.push_back({object_id, GetObjectIds(waiting_threads)});
+            }
+        }
+
+        switch (object->GetHandleType()) {
+        case HandleType::Process: {
+            const auto& process = static_cast<const Process&>(*object);
+            const HandleTable& handle_table = process.handle_table;
+
+            KernelSnapshot::ProcessState state;
+            state.object_id = object_id;
+            state.status = process.status;
+            for (const auto& slots : process.tls_slots) {
+                state.tls_slots.push_back(static_cast<u8>(slots.to_ulong()));
+            }
+            state.next_generation = handle_table.next_generation;
+            state.next_free_slot = handle_table.next_free_slot;
+            state.generations.assign(handle_table.generations.begin(),
+                                     handle_table.generations.end());
+            for (u16 slot = 0; slot < HandleTable::MAX_COUNT; ++slot) {
+                if (handle_table.objects[slot] != nullptr) {
+                    state.handles.push_back({slot, handle_table.objects[slot]->GetObjectId()});
+                }
+            }
+            snapshot.processes.push_back(std::move(state));
+            break;
+        }
+        case HandleType::Thread: {
+            const auto& thread = static_cast<const Thread&>(*object);
+            if (thread.status == ThreadStatus::WaitHleEvent ||
+                thread.wakeup_callback_type == WakeupCallbackType::HLE) {
+                LOG_WARNING(Kernel, "Thread {} is waiting for an HLE service", thread.GetName());
+                return false;
+            }
+
+            KernelSnapshot::ThreadState state;
+            state.object_id = object_id;
+            state.thread_id = thread.thread_id;
+            state.owner_process = GetObjectId(thread.owner_process);
+            state.name = thread.name;
+            state.entry_point = thread.entry_point;
+            state.stack_top = thread.stack_top;
+            state.tls_address = thread.tls_address;
+            state.processor_id = thread.processor_id;
+            state.status = thread.status;
+            state.nominal_priority = thread.nominal_priority;
+            state.current_priority = thread.current_priority;
+            state.last_running_ticks = thread.last_running_ticks;
+            state.wait_address = thread.wait_address;
+            state.wakeup_callback = thread.wakeup_callback_type;
+            state.wait_objects = GetObjectIds(thread.wait_objects);
+            state.held_mutexes = GetObjectIds(thread.held_mutexes);
+            state.pending_mutexes = GetObjectIds(thread.pending_mutexes);
+            state.context = ReadContext(*thread.context);
+            snapshot.threads.push_back(std::move(state));
+            break;
+        }
+        case HandleType::Event: {
+            const auto& event = static_cast<const Event&>(*object);
+            snapshot.events.push_back({object_id, event.reset_type, event.signaled});
+            break;
+        }
+        case HandleType::Mutex: {
+            const auto& mutex = static_cast<const Mutex&>(*object);
+            snapshot.mutexes.push_back({object_id, mutex.lock_count, mutex.priority,
+                                        GetObjectId(mutex.holding_thread.get())});
+            break;
+        }
+        case HandleType::Semaphore: {
+            const auto& semaphore = static_cast<const Semaphore&>(*object);
+            snapshot.semaphores.push_back(
+                {object_id, semaphore.max_count, semaphore.available_count});
+            break;
+        }
+        case HandleType::Timer: {
+            const auto& timer = static_cast<const Timer&>(*object);
+            snapshot.timers.push_back({object_id, timer.reset_type, timer.signaled,
+                                       timer.initial_delay, timer.interval_delay,
+                                       timer.callback_id});
+            break;
+        }
+        case HandleType::AddressArbiter: {
+            const auto& arbiter = static_cast<const AddressArbiter&>(*object);
+            if (!arbiter.waiting_threads.empty()) {
+                snapshot.wait_lists.push_back({object_id, GetObjectIds(arbiter.waiting_threads)});
+            }
+            break;
+        }
+        case HandleType::ServerSession: {
+            const auto& session = static_cast<const ServerSession&>(*object);
+            if (!session.mapped_buffer_context.empty()) {
+                LOG_WARNING(Kernel, "Session {} is handling a request with mapped buffers",
+                            session.GetName());
+                return false;
+            }
+            snapshot.server_sessions.push_back(
+                {object_id, GetObjectId(session.currently_handling.get()),
+                 GetObjectIds(session.pending_requesting_threads)});
+            break;
+        }
+        case HandleType::ServerPort: {
+            const auto& port = static_cast<const ServerPort&>(*object);
+            snapshot.server_ports.push_back({object_id, GetObjectIds(port.pending_sessions)});
+            break;
+        }
+        case HandleType::ClientPort: {
+            const auto& port = static_cast<const ClientPort&>(*object);
+            snapshot.client_ports.push_back({object_id, port.active_sessions});
+            break;
+        }
+        case HandleType::ResourceLimit: {
+            auto& limit = static_cast<Kernel::ResourceLimit&>(*object);
+            KernelSnapshot::ResourceLimitState state{object_id, {}};
+            for (std::size_t i = 0; i < counted_resources.size(); ++i) {
+                state.current_values[i] = *GetCurrentValue(limit, counted_resources[i]);
+            }
+            snapshot.resource_limits.push_back(state);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+bool KernelSystem::CanRestoreSnapshot(const KernelSnapshot& snapshot) const {
+    const bool handle_tables_fit =
+        std::all_of(snapshot.processes.begin(), snapshot.processes.end(), [](const auto& process) {
+            return process.generations.size() == HandleTable::MAX_COUNT &&
+                   std::all_of(process.handles.begin(), process.handles.end(),
+                               [](const auto& handle) {
+                                   return handle.slot < HandleTable::MAX_COUNT;
+                               });
+        });
+    if (!handle_tables_fit || !IsConsistent(snapshot)) {
+        LOG_ERROR(Kernel, "Kernel state is inconsistent");
+        return false;
+    }
+    if (snapshot.memory_layout_hash != GetMemoryLayoutHash()) {
+        LOG_ERROR(Kernel, "Memory was mapped or unmapped since the save state was made");
+        return false;
+    }
+
+    const auto objects = CollectObjects();
+    for (const auto& info : snapshot.objects) {
+        const auto it = objects.find(info.object_id);
+        if (it == objects.end()) {
+            if (!CanRecreate(info.type)) {
+                LOG_ERROR(Kernel,
+                          "Object {} of type {} was destroyed since the save state was made",
+                          info.object_id, static_cast<u32>(info.type));
+                return false;
+            }
+        } else if (it->second->GetHandleType() != info.type) {
+            LOG_ERROR(Kernel, "Object {} is a {}, expected type {}", info.object_id,
+                      it->second->GetTypeName(), static_cast<u32>(info.type));
+            return false;
+        }
+    }
+    return true;
+}
+
+void KernelSystem::RestoreSnapshot(const KernelSnapshot& snapshot) {
+    // Keeps the live objects alive until their references have been replaced
+    const auto live_objects = CollectObjects();
+
+    std::unordered_map<u32, SharedPtr<Object>> objects;
+    u32 max_object_id = 0;
+    for (const auto& info : snapshot.objects) {
+        max_object_id = std::max(max_object_id, info.object_id);
+
+        const auto it = live_objects.find(info.object_id);
+        if (it != live_objects.end()) {
+            objects.emplace(info.object_id, it->second);
+            continue;
+        }
+
+        SharedPtr<Object> object;
+        switch (info.type) {
+        case HandleType::Thread:
+            object = new Thread(*this);
+            break;
+        case HandleType::Event:
+            object = new Event(*this);
+            break;
+        case HandleType::Mutex:
+            object = new Mutex(*this);
+            break;
+        case HandleType::Semaphore:
+            object = new Semaphore(*this);
+            break;
+        case HandleType::Timer:
+            object = new Timer(*this);
+            break;
+        case HandleType::AddressArbiter:
+            object = new AddressArbiter(*this);
+            break;
+        default:
+            UNREACHABLE_MSG("Object type {} can't be created again", static_cast<u32>(info.type));
+        }
+        object->object_id = info.object_id;
+        objects.emplace(info.object_id, std::move(object));
+    }
+
+    const auto get = [&objects](u32 object_id) -> Object* {
+        return object_id != KernelSnapshot::NO_OBJECT ? objects.at(object_id).get() : nullptr;
+    };
+    const auto get_thread = [&get](u32 object_id) {
+        return SharedPtr<Thread>(static_cast<Thread*>(get(object_id)));
+    };
+
+    // Detach the threads and wait lists from the live state
+    for (const auto& thread : thread_manager->thread_list) {
+        thread_manager->ready_queue.remove(thread->current_priority, thread.get());
+        if (objects.count(thread->GetObjectId()) == 0) {
+            // The thread was created after the save state
+            timing.UnscheduleEvent(thread_manager->ThreadWakeupEventType, thread->thread_id);
+            thread->status = ThreadStatus::Dead;
+            thread->wait_objects.clear();
+            thread->held_mutexes.clear();
+            thread->pending_mutexes.clear();
+            thread->wakeup_callback = nullptr;
+            thread->wakeup_callback_type = WakeupCallbackType::None;
+        }
+    }
+    thread_manager->thread_list.clear();
+    thread_manager->wakeup_callback_table.clear();
+    for (const auto& [object_id, object] : live_objects) {
+        if (object->IsWaitable()) {
+            static_cast<WaitObject*>(object.get())->waiting_threads.clear();
+        } else if (object->GetHandleType() == HandleType::AddressArbiter) {
+            static_cast<AddressArbiter*>(object.get())->waiting_threads.clear();
+        }
+    }
+
+    for (const auto& state : snapshot.processes) {
+        auto& process = static_cast<Process&>(*get(state.object_id));
+        HandleTable& handle_table = process.handle_table;
+
+        process.status = state.status;
+        process.tls_slots.assign(state.tls_slots.begin(), state.tls_slots.end());
+        handle_table.next_generation = state.next_generation;
+        handle_table.next_free_slot = state.next_free_slot;
+        std::copy(state.generations.begin(), state.generations.end(),
+                  handle_table.generations.begin());
+        handle_table.objects.fill(nullptr);
+        for (const auto& handle : state.handles) {
+            handle_table.objects[handle.slot] = get(handle.object_id);
+        }
+    }
+
+    for (const auto& state : snapshot.threads) {
+        auto& thread = static_cast<Thread&>(*get(state.object_id));
+        thread.thread_id = state.thread_id;
+        thread.owner_process = static_cast<Process*>(get(state.owner_process));
+        thread.name = state.name;
+        thread.entry_point = state.entry_point;
+        thread.stack_top = state.stack_top;
+        thread.tls_address = state.tls_address;
+        thread.processor_id = state.processor_id;
+        thread.status = state.status;
+        thread.nominal_priority = state.nominal_priority;
+        thread.current_priority = state.current_priority;
+        thread.last_running_ticks = state.last_running_ticks;
+        thread.wait_address = state.wait_address;
+        thread.wait_objects.clear();
+        for (u32 object_id : state.wait_objects) {
+            thread.wait_objects.emplace_back(static_cast<WaitObject*>(get(object_id)));
+        }
+        thread.held_mutexes.clear();
+        for (u32 object_id : state.held_mutexes) {
+            thread.held_mutexes.emplace(static_cast<Mutex*>(get(object_id)));
+        }
+        thread.pending_mutexes.clear();
+        for (u32 object_id : state.pending_mutexes) {
+            thread.pending_mutexes.emplace(static_cast<Mutex*>(get(object_id)));
+        }
+        WriteContext(*thread.context, state.context);
+
+        // Address arbiter callbacks are set once the arbiters' wait lists have been restored
+        thread.wakeup_callback_type = state.wakeup_callback;
+        if (state.wakeup_callback == WakeupCallbackType::None ||
+            state.wakeup_callback == WakeupCallbackType::ArbitrationTimeout) {
+            thread.wakeup_callback = nullptr;
+        } else {
+            thread.wakeup_callback = GetSVCWakeupCallback(state.wakeup_callback, memory);
+        }
+    }
+    for (u32 object_id : snapshot.thread_list) {
+        SharedPtr<Thread> thread = get_thread(object_id);
+        thread_manager->wakeup_callback_table[thread->thread_id] = thread.get();
+        thread_manager->thread_list.push_back(std::move(thread));
+    }
+    for (u32 object_id : snapshot.ready_queue) {
+        Thread* thread = get_thread(object_id).get();
+        thread_manager->ready_queue.prepare(thread->current_priority);
+        thread_manager->ready_queue.push_back(thread->current_priority, thread);
+    }
+
+    for (const auto& state : snapshot.events) {
+        auto& event = static_cast<Event&>(*get(state.object_id));
+        event.reset_type = state.reset_type;
+        event.signaled = state.signaled;
+    }
+    for (const auto& state : snapshot.mutexes) {
+        auto& mutex = static_cast<Mutex&>(*get(state.object_id));
+        mutex.lock_count = state.lock_count;
+        mutex.priority = state.priority;
+        mutex.holding_thread = get_thread(state.holding_thread);
+    }
+    for (const auto& state : snapshot.semaphores) {
+        auto& semaphore = static_cast<Semaphore&>(*get(state.object_id));
+        semaphore.max_count = state.max_count;
+        semaphore.available_count = state.available_count;
+    }
+    for (const auto& state : snapshot.timers) {
+        auto& timer = static_cast<Timer&>(*get(state.object_id));
+        timer.reset_type = state.reset_type;
+        timer.signaled = state.signaled;
+        timer.initial_delay = state.initial_delay;
+        timer.interval_delay = state.interval_delay;
+        timer.callback_id = state.callback_id;
+        timer_manager->timer_callback_table[state.callback_id] = &timer;
+    }
+    for (const auto& state : snapshot.server_sessions) {
+        auto& session = static_cast<ServerSession&>(*get(state.object_id));
+        session.currently_handling = get_thread(state.currently_handling);
+        session.pending_requesting_threads.clear();
+        for (u32 object_id : state.pending_requesting_threads) {
+            session.pending_requesting_threads.push_back(get_thread(object_id));
+        }
+    }
+    for (const auto& state : snapshot.server_ports) {
+        auto& port = static_cast<ServerPort&>(*get(state.object_id));
+        port.pending_sessions.clear();
+        for (u32 object_id : state.pending_sessions) {
+            port.pending_sessions.emplace_back(static_cast<ServerSession*>(get(object_id)));
+        }
+    }
+    for (const auto& state : snapshot.client_ports) {
+        static_cast<ClientPort&>(*get(state.object_id)).active_sessions = state.active_sessions;
+    }
+    for (const auto& state : snapshot.resource_limits) {
+        auto& limit = static_cast<Kernel::ResourceLimit&>(*get(state.object_id));
+        for (std::size_t i = 0; i < counted_resources.size(); ++i) {
+            *GetCurrentValue(limit, counted_resources[i]) = state.current_values[i];
+        }
+    }
+
+    for (const auto& wait_list : snapshot.wait_lists) {
+        Object* object = get(wait_list.object_id);
+        if (object->GetHandleType() == HandleType::AddressArbiter) {
+            auto* arbiter = static_cast<AddressArbiter*>(object);
+            for (u32 object_id : wait_list.threads) {
+                SharedPtr<Thread> thread = get_thread(object_id);
+                if (thread->wakeup_callback_type == WakeupCallbackType::ArbitrationTimeout) {
+                    arbiter->SetTimeoutCallback(*thread);
+                }
+                arbiter->waiting_threads.push_back(std::move(thread));
+            }
+        } else {
+            auto* wait_object = static_cast<WaitObject*>(object);
+            for (u32 object_id : wait_list.threads) {
+                wait_object->waiting_threads.push_back(get_thread(object_id));
+            }
+        }
+    }
+
+    thread_manager->next_thread_id =
+        std::max(thread_manager->next_thread_id, snapshot.next_thread_id);
+    timer_manager->next_timer_callback_id =
+        std::max(timer_manager->next_timer_callback_id, snapshot.next_timer_callback_id);
+    if (!snapshot.objects.empty() && next_object_id <= max_object_id) {
+        next_object_id = max_object_id + 1;
+    }
+
+    current_process = static_cast<Process*>(get(snapshot.current_process));
+    if (current_process != nullptr) {
+        memory.SetCurrentPageTable(&current_process->vm_manager.page_table);
+    }
+    thread_manager->current_thread = get_thread(snapshot.current_thread);
+    if (Thread* thread = thread_manager->current_thread.get()) {
+        thread_manager->cpu->LoadContext(thread->context);
+        thread_manager->cpu->SetCP15Register(CP15_THREAD_URO, thread->GetTLSAddress());
+    }
+}
+
+} // namespace Kernel
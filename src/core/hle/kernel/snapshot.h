@@ -0,0 +1,176 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/object.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/thread.h"
+
+class PointerWrap;
+
+namespace Kernel {
+
+/**
+ * Kernel state as stored in save states. Objects refer to each other by object ID. When the state
+ * is restored, each object's state is written into the live object with the same ID. Threads,
+ * events, mutexes, semaphores, timers and address arbiters that were destroyed since are created
+ * again; the other objects hold host state (service handlers, memory mappings) and must still
+ * exist.
+ */
+struct KernelSnapshot {
+    /// Used in place of an object ID when there is no object
+    static constexpr u32 NO_OBJECT = 0xFFFFFFFF;
+
+    struct ObjectInfo {
+        u32 object_id;
+        HandleType type;
+    };
+
+    struct ContextState {
+        std::array<u32, 16> cpu_registers;
+        u32 cpsr;
+        std::array<u32, 64> fpu_registers;
+        u32 fpscr;
+        u32 fpexc;
+    };
+
+    struct ThreadState {
+        u32 object_id;
+        u32 thread_id;
+        u32 owner_process;
+        std::string name;
+        VAddr entry_point;
+        VAddr stack_top;
+        VAddr tls_address;
+        s32 processor_id;
+
+        ThreadStatus status;
+        u32 nominal_priority;
+        u32 current_priority;
+        u64 last_running_ticks;
+        VAddr wait_address;
+        WakeupCallbackType wakeup_callback;
+        std::vector<u32> wait_objects;
+        std::vector<u32> held_mutexes;
+        std::vector<u32> pending_mutexes;
+        ContextState context;
+
+        void DoState(PointerWrap& p);
+    };
+
+    struct HandleState {
+        u16 slot;
+        u32 object_id;
+    };
+
+    struct ProcessState {
+        u32 object_id;
+        ProcessStatus status;
+        std::vector<u8> tls_slots;
+
+        u16 next_generation;
+        u16 next_free_slot;
+        std::vector<u16> generations;
+        std::vector<HandleState> handles;
+
+        void DoState(PointerWrap& p);
+    };
+
+    struct EventState {
+        u32 object_id;
+        ResetType reset_type;
+        bool signaled;
+    };
+
+    struct MutexState {
+        u32 object_id;
+        s32 lock_count;
+        u32 priority;
+        u32 holding_thread;
+    };
+
+    struct SemaphoreState {
+        u32 object_id;
+        s32 max_count;
+        s32 available_count;
+    };
+
+    struct TimerState {
+        u32 object_id;
+        ResetType reset_type;
+        bool signaled;
+        u64 initial_delay;
+        u64 interval_delay;
+        /// Userdata of the timer's CoreTiming event
+        u64 callback_id;
+    };
+
+    struct ServerSessionState {
+        u32 object_id;
+        u32 currently_handling;
+        std::vector<u32> pending_requesting_threads;
+
+        void DoState(PointerWrap& p);
+    };
+
+    struct ServerPortState {
+        u32 object_id;
+        std::vector<u32> pending_sessions;
+
+        void DoState(PointerWrap& p);
+    };
+
+    struct ClientPortState {
+        u32 object_id;
+        u32 active_sessions;
+    };
+
+    struct ResourceLimitState {
+        u32 object_id;
+        std::array<s32, 9> current_values;
+    };
+
+    /// Threads waiting for a WaitObject or an AddressArbiter, in the order they started waiting
+    struct WaitList {
+        u32 object_id;
+        std::vector<u32> threads;
+
+        void DoState(PointerWrap& p);
+    };
+
+    u32 current_process;
+    u32 current_thread;
+    u32 next_thread_id;
+    u64 next_timer_callback_id;
+    /// Identifies the memory mappings, which aren't restored and must be unchanged
+    u64 memory_layout_hash;
+
+    std::vector<ObjectInfo> objects;
+    std::vector<ProcessState> processes;
+    std::vector<ThreadState> threads;
+    /// Object IDs of the threads that haven't exited, in the order of the thread list
+    std::vector<u32> thread_list;
+    /// Object IDs of the ready threads, in the order they will be scheduled
+    std::vector<u32> ready_queue;
+
+    std::vector<EventState> events;
+    std::vector<MutexState> mutexes;
+    std::vector<SemaphoreState> semaphores;
+    std::vector<TimerState> timers;
+    std::vector<ServerSessionState> server_sessions;
+    std::vector<ServerPortState> server_ports;
+    std::vector<ClientPortState> client_ports;
+    std::vector<ResourceLimitState> resource_limits;
+    std::vector<WaitList> wait_lists;
+
+    void DoState(PointerWrap& p);
+};
+
+} // namespace Kernel
@@ -395,6 +395,13 @@ ResultCode SVC::CloseHandle(Handle handle) {
     return kernel.GetCurrentProcess()->handle_table.Close(handle);
 }
 
+/// Gives a thread that is about to wait the wakeup callback of the given type
+static void SetWakeupCallback(Thread& thread, WakeupCallbackType type,
+                              Memory::MemorySystem& memory) {
+    thread.wakeup_callback = GetSVCWakeupCallback(type, memory);
+    thread.wakeup_callback_type = type;
+}
+
 /// Wait for a handle to synchronize, timeout after the specified nanoseconds
 ResultCode SVC::WaitSynchronization1(Handle handle, s64 nano_seconds) {
     auto object = kernel.GetCurrentProcess()->handle_table.Get<WaitObject>(handle);
@@ -418,21 +425,7 @@ ResultCode SVC::WaitSynchronization1(Handle handle, s64 nano_seconds) {
         // Create an event to wake the thread up after the specified nanosecond delay has passed
         thread->WakeAfterDelay(nano_seconds);
 
-        thread->wakeup_callback = [](ThreadWakeupReason reason, SharedPtr<Thread> thread,
-                                     SharedPtr<WaitObject> object) {
-            ASSERT(thread->status == ThreadStatus::WaitSynchAny);
-
-            if (reason == ThreadWakeupReason::Timeout) {
-                thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
-                return;
-            }
-
-            ASSERT(reason == ThreadWakeupReason::Signal);
-            thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
-
-            // WaitSynchronization1 doesn't have an output index like WaitSynchronizationN, so we
-            // don't have to do anything else here.
-        };
+        SetWakeupCallback(*thread, WakeupCallbackType::WaitSynchronization1, memory);
 
         system.PrepareReschedule();
 
@@ -507,20 +500,7 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
         // Create an event to wake the thread up after the specified nanosecond delay has passed
         thread->WakeAfterDelay(nano_seconds);
 
-        thread->wakeup_callback = [](ThreadWakeupReason reason, SharedPtr<Thread> thread,
-                                     SharedPtr<WaitObject> object) {
-            ASSERT(thread->status == ThreadStatus::WaitSynchAll);
-
-            if (reason == ThreadWakeupReason::Timeout) {
-                thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
-                return;
-            }
-
-            ASSERT(reason == ThreadWakeupReason::Signal);
-
-            thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
-            // The wait_all case does not update the output index.
-        };
+        SetWakeupCallback(*thread, WakeupCallbackType::WaitSynchronizationAll, memory);
 
         system.PrepareReschedule();
 
@@ -567,20 +547,7 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
         // Create an event to wake the thread up after the specified nanosecond delay has passed
         thread->WakeAfterDelay(nano_seconds);
 
-        thread->wakeup_callback = [](ThreadWakeupReason reason, SharedPtr<Thread> thread,
-                                     SharedPtr<WaitObject> object) {
-            ASSERT(thread->status == ThreadStatus::WaitSynchAny);
-
-            if (reason == ThreadWakeupReason::Timeout) {
-                thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
-                return;
-            }
-
-            ASSERT(reason == ThreadWakeupReason::Signal);
-
-            thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
-            thread->SetWaitSynchronizationOutput(thread->GetWaitObjectIndex(object.get()));
-        };
+        SetWakeupCallback(*thread, WakeupCallbackType::WaitSynchronizationAny, memory);
 
         system.PrepareReschedule();
 
@@ -621,6 +588,88 @@ static ResultCode ReceiveIPCRequest(Memory::MemorySystem& memory,
     return translation_result;
 }
 
+static void WaitSynchronization1Callback(ThreadWakeupReason reason, SharedPtr<Thread> thread,
+                                         SharedPtr<WaitObject> object) {
+    ASSERT(thread->status == ThreadStatus::WaitSynchAny);
+
+    if (reason == ThreadWakeupReason::Timeout) {
+        thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
+        return;
+    }
+
+    ASSERT(reason == ThreadWakeupReason::Signal);
+    thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
+
+    // WaitSynchronization1 doesn't have an output index like WaitSynchronizationN, so we
+    // don't have to do anything else here.
+}
+
+static void WaitSynchronizationAllCallback(ThreadWakeupReason reason, SharedPtr<Thread> thread,
+                                           SharedPtr<WaitObject> object) {
+    ASSERT(thread->status == ThreadStatus::WaitSynchAll);
+
+    if (reason == ThreadWakeupReason::Timeout) {
+        thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
+        return;
+    }
+
+    ASSERT(reason == ThreadWakeupReason::Signal);
+
+    thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
+    // The wait_all case does not update the output index.
+}
+
+static void WaitSynchronizationAnyCallback(ThreadWakeupReason reason, SharedPtr<Thread> thread,
+                                           SharedPtr<WaitObject> object) {
+    ASSERT(thread->status == ThreadStatus::WaitSynchAny);
+
+    if (reason == ThreadWakeupReason::Timeout) {
+        thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
+        return;
+    }
+
+    ASSERT(reason == ThreadWakeupReason::Signal);
+
+    thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
+    thread->SetWaitSynchronizationOutput(thread->GetWaitObjectIndex(object.get()));
+}
+
+static void ReplyAndReceiveCallback(Memory::MemorySystem& memory, ThreadWakeupReason reason,
+                                    SharedPtr<Thread> thread, SharedPtr<WaitObject> object) {
+    ASSERT(thread->status == ThreadStatus::WaitSynchAny);
+    ASSERT(reason == ThreadWakeupReason::Signal);
+
+    ResultCode result = RESULT_SUCCESS;
+
+    if (object->GetHandleType() == HandleType::ServerSession) {
+        auto server_session = DynamicObjectCast<ServerSession>(object);
+        result = ReceiveIPCRequest(memory, server_session, thread);
+    }
+
+    thread->SetWaitSynchronizationResult(result);
+    thread->SetWaitSynchronizationOutput(thread->GetWaitObjectIndex(object.get()));
+}
+
+std::function<Thread::WakeupCallback> GetSVCWakeupCallback(WakeupCallbackType type,
+                                                           Memory::MemorySystem& memory) {
+    switch (type) {
+    case WakeupCallbackType::WaitSynchronization1:
+        return WaitSynchronization1Callback;
+    case WakeupCallbackType::WaitSynchronizationAll:
+        return WaitSynchronizationAllCallback;
+    case WakeupCallbackType::WaitSynchronizationAny:
+        return WaitSynchronizationAnyCallback;
+    case WakeupCallbackType::ReplyAndReceive:
+        return [&memory](ThreadWakeupReason reason, SharedPtr<Thread> thread,
+                         SharedPtr<WaitObject> object) {
+            ReplyAndReceiveCallback(memory, reason, std::move(thread), std::move(object));
+        };
+    default:
+        UNREACHABLE_MSG("Wakeup callback type {} isn't set by an SVC", static_cast<u32>(type));
+        return nullptr;
+    }
+}
+
 /// In a single operation, sends a IPC reply and waits for a new request.
 ResultCode SVC::ReplyAndReceive(s32* index, VAddr handles_address, s32 handle_count,
                                 Handle reply_target) {
@@ -722,22 +771,7 @@ ResultCode SVC::ReplyAndReceive(s32* index, VAddr handles_address, s32 handle_co
 
     thread->wait_objects = std::move(objects);
 
-    thread->wakeup_callback = [& memory = this->memory](ThreadWakeupReason reason,
-                                                        SharedPtr<Thread> thread,
-                                                        SharedPtr<WaitObject> object) {
-        ASSERT(thread->status == ThreadStatus::WaitSynchAny);
-        ASSERT(reason == ThreadWakeupReason::Signal);
-
-        ResultCode result = RESULT_SUCCESS;
-
-        if (object->GetHandleType() == HandleType::ServerSession) {
-            auto server_session = DynamicObjectCast<ServerSession>(object);
-            result = ReceiveIPCRequest(memory, server_session, thread);
-        }
-
-        thread->SetWaitSynchronizationResult(result);
-        thread->SetWaitSynchronizationOutput(thread->GetWaitObjectIndex(object.get()));
-    };
+    SetWakeupCallback(*thread, WakeupCallbackType::ReplyAndReceive, memory);
 
     system.PrepareReschedule();
 
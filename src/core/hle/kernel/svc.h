@@ -4,13 +4,19 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include "common/common_types.h"
+#include "core/hle/kernel/thread.h"
 
 namespace Core {
 class System;
 } // namespace Core
 
+namespace Memory {
+class MemorySystem;
+} // namespace Memory
+
 namespace Kernel {
 
 class SVC;
@@ -25,4 +31,11 @@ private:
     std::unique_ptr<SVC> impl;
 };
 
+/**
+ * Returns the wakeup callback that the SVCs give threads that wait with the given callback type.
+ * Used to recreate the callbacks of waiting threads when a save state is loaded.
+ */
+std::function<Thread::WakeupCallback> GetSVCWakeupCallback(WakeupCallbackType type,
+                                                           Memory::MemorySystem& memory);
+
 } // namespace Kernel
@@ -221,6 +221,7 @@ void Thread::ResumeFromWait() {
     }
 
     wakeup_callback = nullptr;
+    wakeup_callback_type = WakeupCallbackType::None;
 
     thread_manager.ready_queue.push_back(current_priority, this);
     status = ThreadStatus::Ready;
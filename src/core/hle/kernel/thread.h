@@ -55,6 +55,17 @@ enum class ThreadWakeupReason {
     Timeout // The thread was woken up due to a wait timeout.
 };
 
+/// Identifies the wakeup callback of a waiting thread, which save states store in its place
+enum class WakeupCallbackType : u32 {
+    None,
+    WaitSynchronization1,
+    WaitSynchronizationAll,
+    WaitSynchronizationAny,
+    ReplyAndReceive,
+    ArbitrationTimeout,
+    HLE, ///< Set by an HLE service, can't be recreated
+};
+
 class ThreadManager {
 public:
     explicit ThreadManager(Kernel::KernelSystem& kernel);
@@ -299,6 +310,7 @@ public:
     // was waiting via WaitSynchronizationN then the object will be the last object that became
     // available. In case of a timeout, the object will be nullptr.
     std::function<WakeupCallback> wakeup_callback;
+    WakeupCallbackType wakeup_callback_type = WakeupCallbackType::None;
 
 private:
     explicit Thread(KernelSystem&);
@@ -47,18 +47,18 @@ void Timer::Acquire(Thread* thread) {
 }
 
 void Timer::Set(s64 initial, s64 interval) {
-    // Ensure we get rid of any previous scheduled event
-    Cancel();
-
     initial_delay = initial;
     interval_delay = interval;
 
     if (initial == 0) {
+        // Ensure we get rid of any previous scheduled event
+        Cancel();
         // Immediately invoke the callback
         Signal(0);
     } else {
-        kernel.timing.ScheduleEvent(nsToCycles(initial), timer_manager.timer_callback_event_type,
-                                    callback_id);
+        // Moves any previous scheduled event
+        kernel.timing.RescheduleEvent(nsToCycles(initial),
+                                      timer_manager.timer_callback_event_type, callback_id);
     }
 }
 
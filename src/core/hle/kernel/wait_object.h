@@ -62,6 +62,8 @@ private:
 
     /// Function to call when this object becomes available
     std::function<void()> hle_notifier;
+
+    friend class KernelSystem;
 };
 
 // Specialization of DynamicObjectCast for WaitObjects
@@ -3,15 +3,22 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <chrono>
 #include <cinttypes>
+#include <condition_variable>
 #include <cstddef>
 #include <cstring>
-#include <cryptopp/aes.h>
-#include <cryptopp/modes.h>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <cryptopp/sha.h>
 #include <fmt/format.h>
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
+#include "common/thread.h"
+#include "common/thread_worker.h"
 #include "core/core.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/ncch_container.h"
@@ -30,6 +37,7 @@
 #include "core/hle/service/am/am_sys.h"
 #include "core/hle/service/am/am_u.h"
 #include "core/hle/service/fs/archive.h"
+#include "core/hw/aes/cipher.h"
 #include "core/loader/loader.h"
 #include "core/loader/smdh.h"
 
@@ -76,9 +84,69 @@ struct TicketInfo {
 
 static_assert(sizeof(TicketInfo) == 0x18, "Ticket info structure size is wrong");
 
+namespace {
+
+/// Size of the chunks content is streamed in by InstallContents
+constexpr std::size_t install_chunk_size = 0x100000;
+/// Number of chunks buffered between two install stages
+constexpr std::size_t install_queue_depth = 4;
+/// Maximum number of contents installed at once
+constexpr std::size_t max_parallel_contents = 4;
+
+constexpr ResultCode ERROR_CONTENT_TRUNCATED(ErrorDescription::InvalidSize, ErrorModule::AM,
+                                             ErrorSummary::InvalidState, ErrorLevel::Permanent);
+constexpr ResultCode ERROR_CONTENT_HASH_MISMATCH(ErrorDescription::NotAuthorized, ErrorModule::AM,
+                                                 ErrorSummary::InvalidState,
+                                                 ErrorLevel::Permanent);
+
+/// Blocking queue between two install stages, which holds at most install_queue_depth items
+template <typename T>
+class StageQueue {
+public:
+    /// Waits for room and pushes the item. Returns false if the queue was closed.
+    bool Push(T item) {
+        std::unique_lock lock(mutex);
+        room_available.wait(lock, [this] { return closed || items.size() < install_queue_depth; });
+        if (closed)
+            return false;
+        items.push_back(std::move(item));
+        item_available.notify_one();
+        return true;
+    }
+
+    /// Waits for an item and pops it. Returns false once the queue is closed and empty.
+    bool Pop(T& item) {
+        std::unique_lock lock(mutex);
+        item_available.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty())
+            return false;
+        item = std::move(items.front());
+        items.pop_front();
+        room_available.notify_one();
+        return true;
+    }
+
+    /// Stops accepting items. The items already queued can still be popped.
+    void Close() {
+        std::lock_guard lock(mutex);
+        closed = true;
+        item_available.notify_all();
+        room_available.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable item_available;
+    std::condition_variable room_available;
+    std::deque<T> items;
+    bool closed = false;
+};
+
+} // Anonymous namespace
+
 class CIAFile::DecryptionState {
 public:
-    std::vector<CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption> content;
+    std::vector<HW::AES::CBCDecryptor> content;
 };
 
 CIAFile::CIAFile(Service::FS::MediaType media_type)
@@ -133,11 +201,10 @@ ResultCode CIAFile::WriteTitleMetadata() {
     content_written.resize(content_count);
 
     if (auto title_key = container.GetTicket().GetTitleKey()) {
-        decryption_state->content.resize(content_count);
+        decryption_state->content.clear();
+        decryption_state->content.reserve(content_count);
         for (std::size_t i = 0; i < content_count; ++i) {
-            auto ctr = tmd.GetContentCTRByIndex(i);
-            decryption_state->content[i].SetKeyWithIV(title_key->data(), title_key->size(),
-                                                      ctr.data());
+            decryption_state->content.emplace_back(*title_key, tmd.GetContentCTRByIndex(i));
         }
     }
 
@@ -180,7 +247,7 @@ ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length,
 
             if (tmd.GetContentTypeByIndex(static_cast<u16>(i)) &
                 FileSys::TMDContentTypeFlag::Encrypted) {
-                decryption_state->content[i].ProcessData(temp.data(), temp.data(), temp.size());
+                decryption_state->content[i].Process(temp.data(), temp.data(), temp.size());
             }
 
             file.WriteBytes(temp.data(), temp.size());
@@ -196,6 +263,124 @@ ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length,
     return MakeResult<std::size_t>(length);
 }
 
+ResultCode CIAFile::InstallContent(const std::string& path, u16 index,
+                                   std::atomic<u64>& progress) {
+    const FileSys::TitleMetadata& tmd = container.GetTitleMetadata();
+    const u64 size = container.GetContentSize(index);
+    const bool encrypted =
+        (tmd.GetContentTypeByIndex(index) & FileSys::TMDContentTypeFlag::Encrypted) != 0;
+
+    FileUtil::IOFile source(path, "rb");
+    if (!source.IsOpen() || !source.Seek(container.GetContentOffset(index), SEEK_SET))
+        return ERROR_CONTENT_TRUNCATED;
+
+    const std::string content_path =
+        GetTitleContentPath(media_type, tmd.GetTitleID(), index, is_update);
+    FileUtil::IOFile file(content_path, "wb");
+    if (!file.IsOpen())
+        return FileSys::ERROR_INSUFFICIENT_SPACE;
+
+    // The chunks are read on this thread, decrypted and hashed on another, and written on a third.
+    // Each stage closes the queue before it when it fails, which stops the stages feeding it.
+    StageQueue<std::vector<u8>> read_chunks;
+    StageQueue<std::vector<u8>> decrypted_chunks;
+    CryptoPP::SHA256 sha;
+    ResultCode result = RESULT_SUCCESS;
+
+    std::thread decrypt_thread([&] {
+        Common::SetCurrentThreadName("CIADecrypt");
+        std::vector<u8> chunk;
+        while (read_chunks.Pop(chunk)) {
+            if (encrypted) {
+                decryption_state->content[index].Process(chunk.data(), chunk.data(),
+                                                         chunk.size());
+            }
+            sha.Update(chunk.data(), chunk.size());
+            if (!decrypted_chunks.Push(std::move(chunk))) {
+                read_chunks.Close();
+                break;
+            }
+        }
+        decrypted_chunks.Close();
+    });
+
+    std::thread write_thread([&] {
+        Common::SetCurrentThreadName("CIAWrite");
+        std::vector<u8> chunk;
+        while (decrypted_chunks.Pop(chunk)) {
+            if (file.WriteBytes(chunk.data(), chunk.size()) != chunk.size()) {
+                result = FileSys::ERROR_INSUFFICIENT_SPACE;
+                decrypted_chunks.Close();
+                break;
+            }
+            progress += chunk.size();
+        }
+    });
+
+    bool truncated = false;
+    for (u64 offset = 0; offset < size; offset += install_chunk_size) {
+        std::vector<u8> chunk(std::min<u64>(install_chunk_size, size - offset));
+        if (source.ReadBytes(chunk.data(), chunk.size()) != chunk.size()) {
+            truncated = true;
+            break;
+        }
+        if (!read_chunks.Push(std::move(chunk)))
+            break;
+    }
+    read_chunks.Close();
+    decrypt_thread.join();
+    write_thread.join();
+
+    if (truncated) {
+        LOG_ERROR(Service_AM, "CIA is too short to contain content {}", index);
+        result = ERROR_CONTENT_TRUNCATED;
+    } else if (result.IsSuccess()) {
+        std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+        sha.Final(hash.data());
+        if (hash != tmd.GetContentHashByIndex(index)) {
+            LOG_ERROR(Service_AM, "Hash of content {} does not match the TMD", index);
+            result = ERROR_CONTENT_HASH_MISMATCH;
+        }
+    }
+
+    // Don't leave incomplete or corrupted content behind
+    if (result.IsError()) {
+        file.Close();
+        FileUtil::Delete(content_path);
+        return result;
+    }
+
+    content_written[index] = size;
+    return RESULT_SUCCESS;
+}
+
+ResultCode CIAFile::InstallContents(const std::string& path, std::atomic<u64>& progress) {
+    ASSERT(install_state == CIAInstallState::TMDLoaded);
+
+    const std::size_t content_count = container.GetTitleMetadata().GetContentCount();
+    std::vector<ResultCode> results(content_count, RESULT_SUCCESS);
+    {
+        Common::ThreadWorker workers(std::min(content_count, max_parallel_contents),
+                                     "CIAInstall");
+        for (std::size_t i = 0; i < content_count; i++) {
+            // Contents left out of the CIA, as is common for DLC and updates, are not installed
+            if (container.GetContentSize(static_cast<u16>(i)) == 0)
+                continue;
+            workers.QueueWork([this, &path, &progress, &results, i] {
+                results[i] = InstallContent(path, static_cast<u16>(i), progress);
+            });
+        }
+        workers.WaitForRequests();
+    }
+
+    for (const ResultCode& result : results) {
+        if (result.IsError())
+            return result;
+    }
+    install_state = CIAInstallState::ContentWritten;
+    return RESULT_SUCCESS;
+}
+
 ResultVal<std::size_t> CIAFile::Write(u64 offset, std::size_t length, bool flush,
                                       const u8* buffer) {
     written += length;
@@ -354,22 +539,41 @@ InstallStatus InstallCIA(const std::string& path,
         if (!file.IsOpen())
             return InstallStatus::ErrorFailedToOpenFile;
 
+        // Everything before the content is small, and is parsed as it is written
+        const u64 content_offset = container.GetContentOffset();
         std::array<u8, 0x10000> buffer;
         std::size_t total_bytes_read = 0;
-        while (total_bytes_read != file.GetSize()) {
-            std::size_t bytes_read = file.ReadBytes(buffer.data(), buffer.size());
+        while (total_bytes_read != content_offset) {
+            std::size_t bytes_read = file.ReadBytes(
+                buffer.data(), std::min<u64>(buffer.size(), content_offset - total_bytes_read));
             auto result = installFile.Write(static_cast<u64>(total_bytes_read), bytes_read, true,
                                             static_cast<u8*>(buffer.data()));
 
             if (update_callback)
                 update_callback(total_bytes_read, file.GetSize());
-            if (result.Failed()) {
+            if (result.Failed() || bytes_read == 0) {
                 LOG_ERROR(Service_AM, "CIA file installation aborted with error code {:08x}",
                           result.Code().raw);
                 return InstallStatus::ErrorAborted;
             }
             total_bytes_read += bytes_read;
         }
+
+        // The content is streamed straight from the file, reporting progress as it goes
+        std::atomic<u64> content_progress = 0;
+        auto install = std::async(std::launch::async, [&] {
+            return installFile.InstallContents(path, content_progress);
+        });
+        while (install.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready) {
+            if (update_callback)
+                update_callback(total_bytes_read + content_progress, file.GetSize());
+        }
+        const ResultCode result = install.get();
+        if (result.IsError()) {
+            LOG_ERROR(Service_AM, "CIA file installation aborted with error code {:08x}",
+                      result.raw);
+            return InstallStatus::ErrorAborted;
+        }
         installFile.Close();
 
         LOG_INFO(Service_AM, "Installed {} successfully.", path);
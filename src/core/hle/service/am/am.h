@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <string>
@@ -71,6 +72,16 @@ public:
     ResultCode WriteTicket();
     ResultCode WriteTitleMetadata();
     ResultVal<std::size_t> WriteContentData(u64 offset, std::size_t length, const u8* buffer);
+
+    /**
+     * Installs all the content of the CIA file at path, once its TMD has been written. Several
+     * contents are installed at once, each streamed through separate read, decrypt and verify, and
+     * write stages.
+     * @param path file path of the CIA file being installed
+     * @param progress incremented by the number of content bytes written
+     */
+    ResultCode InstallContents(const std::string& path, std::atomic<u64>& progress);
+
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override;
     u64 GetSize() const override;
@@ -79,6 +90,8 @@ public:
     void Flush() const override;
 
 private:
+    ResultCode InstallContent(const std::string& path, u16 index, std::atomic<u64>& progress);
+
     // Whether it's installing an update, and what step of installation it is at
     bool is_update = false;
     CIAInstallState install_state = CIAInstallState::InstallStarted;
@@ -20,8 +20,11 @@ FrameBufferUpdate* GetFrameBufferInfo(u32 thread_id, u32 screen_index) {
 
 void SignalInterrupt(InterruptId interrupt_id) {
     auto gpu = gsp_gpu.lock();
-    ASSERT(gpu != nullptr);
-    return gpu->SignalInterrupt(interrupt_id);
+    if (gpu == nullptr) {
+        // The GPU is driven without an emulated system (e.g. a CiTrace replay), nobody to notify
+        return;
+    }
+    gpu->SignalInterrupt(interrupt_id);
 }
 
 void InstallInterfaces(Core::System& system) {
@@ -2,13 +2,18 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/file_sys/archive_ncch.h"
 #include "core/file_sys/file_backend.h"
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/event.h"
 #include "core/hle/kernel/ipc.h"
+#include "core/hle/kernel/thread.h"
 #include "core/hle/romfs.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/hle/service/http_c.h"
@@ -21,12 +26,14 @@ enum {
     InvalidRequestState = 22,
     TooManyContexts = 26,
     InvalidRequestMethod = 32,
+    BufferTooSmall = 43,
     ContextNotFound = 100,
 
     /// This error is returned in multiple situations: when trying to initialize an
     /// already-initialized session, or when using the wrong context handle in a context-bound
     /// session
     SessionStateError = 102,
+    Timeout = 105,
     TooManyClientCerts = 203,
     NotImplemented = 1012,
 };
@@ -43,6 +50,43 @@ const ResultCode ERROR_TOO_MANY_CLIENT_CERTS = // 0xD8A0A0CB
                ErrorLevel::Permanent);
 const ResultCode ERROR_WRONG_CERT_ID = // 0xD8E0B839
     ResultCode(57, ErrorModule::SSL, ErrorSummary::InvalidArgument, ErrorLevel::Permanent);
+const ResultCode ERROR_CONTEXT_NOT_FOUND = // 0xD8A0A064
+    ResultCode(ErrCodes::ContextNotFound, ErrorModule::HTTP, ErrorSummary::InvalidState,
+               ErrorLevel::Permanent);
+const ResultCode ERROR_INVALID_REQUEST_STATE = // 0xD8A0A016
+    ResultCode(ErrCodes::InvalidRequestState, ErrorModule::HTTP, ErrorSummary::InvalidState,
+               ErrorLevel::Permanent);
+/// Returned by ReceiveData while there is more data to download than fits in the buffer
+const ResultCode ERROR_BUFFER_TOO_SMALL = // 0xD840A02B
+    ResultCode(ErrCodes::BufferTooSmall, ErrorModule::HTTP, ErrorSummary::WouldBlock,
+               ErrorLevel::Permanent);
+const ResultCode ERROR_TIMEOUT = // 0xD820A069
+    ResultCode(ErrCodes::Timeout, ErrorModule::HTTP, ErrorSummary::NothingHappened,
+               ErrorLevel::Permanent);
+// TODO: Find out what the real module returns when the connection fails.
+const ResultCode ERROR_REQUEST_FAILED =
+    ResultCode(ErrorDescription::NoData, ErrorModule::HTTP, ErrorSummary::Internal,
+               ErrorLevel::Permanent);
+
+static const char* GetMethodName(RequestMethod method) {
+    switch (method) {
+    case RequestMethod::Get:
+        return "GET";
+    case RequestMethod::Post:
+    case RequestMethod::PostEmpty:
+        return "POST";
+    case RequestMethod::Head:
+        return "HEAD";
+    case RequestMethod::Put:
+    case RequestMethod::PutEmpty:
+        return "PUT";
+    case RequestMethod::Delete:
+        return "DELETE";
+    default:
+        UNREACHABLE();
+        return "";
+    }
+}
 
 void HTTP_C::Initialize(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x1, 1, 4);
@@ -211,13 +255,16 @@ void HTTP_C::CloseContext(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    // TODO(Subv): What happens if you try to close a context that's currently being used?
-    ASSERT(itr->second.state == RequestState::NotStarted);
-
     // TODO(Subv): Make sure that only the session that created the context can close it.
 
+    // A request that is still in progress is cancelled, failing the calls waiting on it
+    const auto job = std::move(itr->second.job);
     contexts.erase(itr);
     session_data->num_http_contexts--;
+    if (job) {
+        job->Cancel();
+        RequestUpdated(context_handle);
+    }
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
@@ -529,6 +576,402 @@ void HTTP_C::Finalize(Kernel::HLERequestContext& ctx) {
     LOG_WARNING(Service_HTTP, "(STUBBED) called");
 }
 
+ResultCode HTTP_C::CheckBoundContext(const SessionData& session_data,
+                                     Context::Handle context_handle) const {
+    if (!session_data.initialized) {
+        LOG_ERROR(Service_HTTP, "Command called on an uninitialized session");
+        return ERROR_STATE_ERROR;
+    }
+
+    // These commands can only be called with a bound context
+    if (!session_data.current_http_context) {
+        LOG_ERROR(Service_HTTP, "Command called without a bound context");
+        return ResultCode(ErrorDescription::NotImplemented, ErrorModule::HTTP,
+                          ErrorSummary::Internal, ErrorLevel::Permanent);
+    }
+
+    if (*session_data.current_http_context != context_handle) {
+        LOG_ERROR(Service_HTTP, "Command called on a mismatched session input context={} session "
+                                "context={}",
+                  context_handle, *session_data.current_http_context);
+        return ERROR_STATE_ERROR;
+    }
+
+    if (contexts.find(context_handle) == contexts.end()) {
+        LOG_ERROR(Service_HTTP, "Context {} not found", context_handle);
+        return ERROR_CONTEXT_NOT_FOUND;
+    }
+    return RESULT_SUCCESS;
+}
+
+void HTTP_C::StartRequest(Context& context) {
+    RequestEngine::Request request;
+    request.method = GetMethodName(context.method);
+    request.url = context.url;
+    for (const auto& header : context.headers) {
+        request.headers.emplace_back(header.name, header.value);
+    }
+    if (context.method == RequestMethod::Post || context.method == RequestMethod::Put) {
+        for (const auto& field : context.post_data) {
+            request.post_data.emplace_back(field.name, field.value);
+        }
+    }
+
+    context.job = engine->Start(std::move(request), context.handle);
+    context.state = RequestState::InProgress;
+}
+
+void HTTP_C::UpdateRequestState(Context& context) {
+    if (!context.job)
+        return;
+
+    // Failed requests report their error once the guest tries to download the response
+    context.state = context.job->GetState() == RequestEngine::Job::State::Sending
+                        ? RequestState::InProgress
+                        : RequestState::ReadyToDownloadContent;
+}
+
+void HTTP_C::WaitForRequest(Kernel::HLERequestContext& ctx, const char* reason,
+                            Context::Handle context_handle, std::function<bool()> poll,
+                            Reply reply, std::chrono::nanoseconds timeout) {
+    if (poll()) {
+        reply(ctx, false);
+        return;
+    }
+
+    auto waiter = std::make_shared<Waiter>();
+    waiter->context_handle = context_handle;
+    waiter->poll = std::move(poll);
+    waiter->event = ctx.SleepClientThread(
+        system.Kernel().GetThreadManager().GetCurrentThread(), reason, timeout,
+        [this, waiter, reply](Kernel::SharedPtr<Kernel::Thread> thread,
+                              Kernel::HLERequestContext& ctx, Kernel::ThreadWakeupReason reason) {
+            // The waiter is still listed if the wait timed out
+            waiters.erase(std::remove(waiters.begin(), waiters.end(), waiter), waiters.end());
+            reply(ctx, reason == Kernel::ThreadWakeupReason::Timeout);
+        });
+    waiters.push_back(std::move(waiter));
+}
+
+void HTTP_C::RequestUpdated(Context::Handle context_handle) {
+    const auto itr = contexts.find(context_handle);
+    if (itr != contexts.end()) {
+        UpdateRequestState(itr->second);
+    }
+
+    // Signalling a waiter wakes it up immediately, which removes it from the list
+    const auto current_waiters = waiters;
+    for (const auto& waiter : current_waiters) {
+        if (waiter->context_handle == context_handle && waiter->poll()) {
+            waiter->event->Signal();
+        }
+    }
+}
+
+void HTTP_C::CancelConnection(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x4, 1, 0);
+    const Context::Handle context_handle = rp.Pop<u32>();
+
+    LOG_DEBUG(Service_HTTP, "called, context_handle={}", context_handle);
+
+    auto* session_data = GetSessionData(ctx.Session());
+    ASSERT(session_data);
+
+    const ResultCode result = CheckBoundContext(*session_data, context_handle);
+    if (result.IsSuccess()) {
+        const auto& job = contexts.at(context_handle).job;
+        if (job) {
+            job->Cancel();
+            RequestUpdated(context_handle);
+        }
+    }
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+    rb.Push(result);
+}
+
+void HTTP_C::GetRequestState(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x5, 1, 0);
+    const Context::Handle context_handle = rp.Pop<u32>();
+
+    auto* session_data = GetSessionData(ctx.Session());
+    ASSERT(session_data);
+
+    const ResultCode result = CheckBoundContext(*session_data, context_handle);
+    if (result.IsError()) {
+        IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+        rb.Push(result);
+        return;
+    }
+
+    Context& context = contexts.at(context_handle);
+    UpdateRequestState(context);
+
+    LOG_DEBUG(Service_HTTP, "called, context_handle={}, state={}", context_handle,
+              static_cast<u32>(context.state));
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
+    rb.Push(RESULT_SUCCESS);
+    rb.Push<u32>(static_cast<u32>(context.state));
+}
+
+void HTTP_C::GetDownloadSizeState(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x6, 1, 0);
+    const Context::Handle context_handle = rp.Pop<u32>();
+
+    auto* session_data = GetSessionData(ctx.Session());
+    ASSERT(session_data);
+
+    const ResultCode result = CheckBoundContext(*session_data, context_handle);
+    if (result.IsError()) {
+        IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+        rb.Push(result);
+        return;
+    }
+
+    const Context& context = contexts.at(context_handle);
+    const u64 content_length = context.job ? context.job->GetContentLength() : 0;
+
+    LOG_DEBUG(Service_HTTP, "called, context_handle={}, downloaded={}, content_length={}",
+              context_handle, context.current_copied_data, content_length);
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(3, 0);
+    rb.Push(RESULT_SUCCESS);
+    rb.Push<u32>(static_cast<u32>(context.current_copied_data));
+    rb.Push<u32>(static_cast<u32>(content_length));
+}
+
+void HTTP_C::BeginRequest(Kernel::HLERequestContext& ctx) {
+    BeginRequestImpl(ctx, false);
+}
+
+void HTTP_C::BeginRequestAsync(Kernel::HLERequestContext& ctx) {
+    BeginRequestImpl(ctx, true);
+}
+
+void HTTP_C::BeginRequestImpl(Kernel::HLERequestContext& ctx, bool async) {
+    const u32 command_id = async ? 0xA : 0x9;
+    IPC::RequestParser rp(ctx, command_id, 1, 0);
+    const Context::Handle context_handle = rp.Pop<u32>();
+
+    LOG_DEBUG(Service_HTTP, "called, context_handle={}, async={}", context_handle, async);
+
+    auto* session_data = GetSessionData(ctx.Session());
+    ASSERT(session_data);
+
+    ResultCode result = CheckBoundContext(*session_data, context_handle);
+    if (result.IsSuccess() && contexts.at(context_handle).state != RequestState::NotStarted) {
+        LOG_ERROR(Service_HTTP, "Tried to begin a request that has already been started");
+        result = ERROR_INVALID_REQUEST_STATE;
+    }
+    if (result.IsError()) {
+        IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+        rb.Push(result);
+        return;
+    }
+
+    Context& context = contexts.at(context_handle);
+    StartRequest(context);
+
+    const auto reply = [command_id](Kernel::HLERequestContext& ctx, bool timed_out) {
+        IPC::RequestBuilder rb(ctx, command_id, 1, 0);
+        rb.Push(RESULT_SUCCESS);
+    };
+    if (async) {
+        reply(ctx, false);
+        return;
+    }
+
+    // The synchronous version returns once the request has been sent and answered
+    const auto job = context.job;
+    WaitForRequest(
+        ctx, "http:C::BeginRequest", context_handle,
+        [job] { return job->GetState() != RequestEngine::Job::State::Sending; }, reply);
+}
+
+void HTTP_C::ReceiveData(Kernel::HLERequestContext& ctx) {
+    ReceiveDataImpl(ctx, false);
+}
+
+void HTTP_C::ReceiveDataTimeout(Kernel::HLERequestContext& ctx) {
+    ReceiveDataImpl(ctx, true);
+}
+
+void HTTP_C::ReceiveDataImpl(Kernel::HLERequestContext& ctx, bool timeout) {
+    const u32 command_id = timeout ? 0xC : 0xB;
+    IPC::RequestParser rp(ctx, command_id, timeout ? 4 : 2, 2);
+    const Context::Handle context_handle = rp.Pop<u32>();
+    const u32 buffer_size = rp.Pop<u32>();
+    const u64 timeout_nanos = timeout ? rp.Pop<u64>() : 0;
+    Kernel::MappedBuffer buffer = rp.PopMappedBuffer();
+
+    LOG_DEBUG(Service_HTTP, "called, context_handle={}, buffer_size={}, timeout={}",
+              context_handle, buffer_size, timeout_nanos);
+
+    auto* session_data = GetSessionData(ctx.Session());
+    ASSERT(session_data);
+
+    ResultCode result = CheckBoundContext(*session_data, context_handle);
+    if (result.IsSuccess() && !contexts.at(context_handle).job) {
+        LOG_ERROR(Service_HTTP, "Tried to receive data from a request that was not started");
+        result = ERROR_INVALID_REQUEST_STATE;
+    }
+    if (result.IsError()) {
+        IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
+        rb.Push(result);
+        rb.PushMappedBuffer(buffer);
+        return;
+    }
+
+    // The body is copied into the guest buffer as it arrives, and the guest is woken up once the
+    // buffer is full or the download is over
+    const auto job = contexts.at(context_handle).job;
+    auto written = std::make_shared<u32>(0);
+    auto poll = [this, job, buffer, buffer_size, written, context_handle]() mutable {
+        std::array<u8, 0x4000> chunk;
+        while (*written < buffer_size) {
+            const std::size_t size =
+                job->ReadBody(chunk.data(), std::min<std::size_t>(chunk.size(),
+                                                                  buffer_size - *written));
+            if (size == 0)
+                break;
+
+            buffer.Write(chunk.data(), *written, size);
+            *written += static_cast<u32>(size);
+            const auto itr = contexts.find(context_handle);
+            if (itr != contexts.end()) {
+                itr->second.current_copied_data += size;
+            }
+        }
+        return *written == buffer_size || job->IsBodyConsumed();
+    };
+    auto reply = [job, buffer, command_id](Kernel::HLERequestContext& ctx,
+                                           bool timed_out) mutable {
+        ResultCode result = RESULT_SUCCESS;
+        if (job->GetState() == RequestEngine::Job::State::Failed) {
+            result = ERROR_REQUEST_FAILED;
+        } else if (!job->IsBodyConsumed()) {
+            result = timed_out ? ERROR_TIMEOUT : ERROR_BUFFER_TOO_SMALL;
+        }
+
+        IPC::RequestBuilder rb(ctx, command_id, 1, 2);
+        rb.Push(result);
+        rb.PushMappedBuffer(buffer);
+    };
+    WaitForRequest(ctx, "http:C::ReceiveData", context_handle, std::move(poll), std::move(reply),
+                   std::chrono::nanoseconds(timeout_nanos));
+}
+
+void HTTP_C::GetResponseHeader(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x1E, 3, 4);
+    const Context::Handle context_handle = rp.Pop<u32>();
+    const u32 name_size = rp.Pop<u32>();
+    const u32 value_size = rp.Pop<u32>();
+    const std::vector<u8> name_buffer = rp.PopStaticBuffer();
+    Kernel::MappedBuffer value_buffer = rp.PopMappedBuffer();
+
+    // Copy the name_buffer into a string without the \0 at the end
+    const std::string name(name_buffer.begin(), name_buffer.end() - 1);
+
+    LOG_DEBUG(Service_HTTP, "called, context_handle={}, name={}", context_handle, name);
+
+    auto* session_data = GetSessionData(ctx.Session());
+    ASSERT(session_data);
+
+    ResultCode result = CheckBoundContext(*session_data, context_handle);
+    if (result.IsSuccess() && !contexts.at(context_handle).job) {
+        LOG_ERROR(Service_HTTP, "Tried to get a header of a request that was not started");
+        result = ERROR_INVALID_REQUEST_STATE;
+    }
+    if (result.IsError()) {
+        IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
+        rb.Push(result);
+        rb.PushMappedBuffer(value_buffer);
+        return;
+    }
+
+    const auto job = contexts.at(context_handle).job;
+    auto reply = [job, name, value_buffer, value_size](Kernel::HLERequestContext& ctx,
+                                                       bool timed_out) mutable {
+        IPC::RequestBuilder rb(ctx, 0x1E, 2, 2);
+        if (job->GetState() == RequestEngine::Job::State::Failed) {
+            rb.Push(ERROR_REQUEST_FAILED);
+            rb.Push<u32>(0);
+            rb.PushMappedBuffer(value_buffer);
+            return;
+        }
+
+        const auto value = job->GetHeader(name);
+        if (!value) {
+            LOG_WARNING(Service_HTTP, "Response header {} not found", name);
+        }
+        // Write the value with its \0, truncated to the size of the buffer
+        const std::string value_string = value.value_or("");
+        const u32 copy_size =
+            std::min(value_size, static_cast<u32>(value_string.size() + 1));
+        value_buffer.Write(value_string.c_str(), 0, copy_size);
+
+        rb.Push(RESULT_SUCCESS);
+        rb.Push<u32>(copy_size);
+        rb.PushMappedBuffer(value_buffer);
+    };
+    WaitForRequest(
+        ctx, "http:C::GetResponseHeader", context_handle,
+        [job] { return job->GetState() != RequestEngine::Job::State::Sending; },
+        std::move(reply));
+}
+
+void HTTP_C::GetResponseStatusCode(Kernel::HLERequestContext& ctx) {
+    GetResponseStatusCodeImpl(ctx, false);
+}
+
+void HTTP_C::GetResponseStatusCodeTimeout(Kernel::HLERequestContext& ctx) {
+    GetResponseStatusCodeImpl(ctx, true);
+}
+
+void HTTP_C::GetResponseStatusCodeImpl(Kernel::HLERequestContext& ctx, bool timeout) {
+    const u32 command_id = timeout ? 0x23 : 0x22;
+    IPC::RequestParser rp(ctx, command_id, timeout ? 3 : 1, 0);
+    const Context::Handle context_handle = rp.Pop<u32>();
+    const u64 timeout_nanos = timeout ? rp.Pop<u64>() : 0;
+
+    LOG_DEBUG(Service_HTTP, "called, context_handle={}, timeout={}", context_handle,
+              timeout_nanos);
+
+    auto* session_data = GetSessionData(ctx.Session());
+    ASSERT(session_data);
+
+    ResultCode result = CheckBoundContext(*session_data, context_handle);
+    if (result.IsSuccess() && !contexts.at(context_handle).job) {
+        LOG_ERROR(Service_HTTP, "Tried to get the status code of a request that was not started");
+        result = ERROR_INVALID_REQUEST_STATE;
+    }
+    if (result.IsError()) {
+        IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+        rb.Push(result);
+        return;
+    }
+
+    const auto job = contexts.at(context_handle).job;
+    auto reply = [job, command_id](Kernel::HLERequestContext& ctx, bool timed_out) {
+        IPC::RequestBuilder rb(ctx, command_id, 2, 0);
+        if (timed_out) {
+            rb.Push(ERROR_TIMEOUT);
+            rb.Push<u32>(0);
+        } else if (job->GetState() == RequestEngine::Job::State::Failed) {
+            rb.Push(ERROR_REQUEST_FAILED);
+            rb.Push<u32>(0);
+        } else {
+            rb.Push(RESULT_SUCCESS);
+            rb.Push<u32>(static_cast<u32>(job->GetStatusCode()));
+        }
+    };
+    WaitForRequest(
+        ctx, "http:C::GetResponseStatusCode", context_handle,
+        [job] { return job->GetState() != RequestEngine::Job::State::Sending; },
+        std::move(reply), std::chrono::nanoseconds(timeout_nanos));
+}
+
 void HTTP_C::DecryptClCertA() {
     static constexpr u32 iv_length = 16;
 
@@ -604,20 +1047,20 @@ void HTTP_C::DecryptClCertA() {
     ClCertA.init = true;
 }
 
-HTTP_C::HTTP_C() : ServiceFramework("http:C", 32) {
+HTTP_C::HTTP_C(Core::System& system) : ServiceFramework("http:C", 32), system(system) {
     static const FunctionInfo functions[] = {
         {0x00010044, &HTTP_C::Initialize, "Initialize"},
         {0x00020082, &HTTP_C::CreateContext, "CreateContext"},
         {0x00030040, &HTTP_C::CloseContext, "CloseContext"},
-        {0x00040040, nullptr, "CancelConnection"},
-        {0x00050040, nullptr, "GetRequestState"},
-        {0x00060040, nullptr, "GetDownloadSizeState"},
+        {0x00040040, &HTTP_C::CancelConnection, "CancelConnection"},
+        {0x00050040, &HTTP_C::GetRequestState, "GetRequestState"},
+        {0x00060040, &HTTP_C::GetDownloadSizeState, "GetDownloadSizeState"},
         {0x00070040, nullptr, "GetRequestError"},
         {0x00080042, &HTTP_C::InitializeConnectionSession, "InitializeConnectionSession"},
-        {0x00090040, nullptr, "BeginRequest"},
-        {0x000A0040, nullptr, "BeginRequestAsync"},
-        {0x000B0082, nullptr, "ReceiveData"},
-        {0x000C0102, nullptr, "ReceiveDataTimeout"},
+        {0x00090040, &HTTP_C::BeginRequest, "BeginRequest"},
+        {0x000A0040, &HTTP_C::BeginRequestAsync, "BeginRequestAsync"},
+        {0x000B0082, &HTTP_C::ReceiveData, "ReceiveData"},
+        {0x000C0102, &HTTP_C::ReceiveDataTimeout, "ReceiveDataTimeout"},
         {0x000D0146, nullptr, "SetProxy"},
         {0x000E0040, nullptr, "SetProxyDefault"},
         {0x000F00C4, nullptr, "SetBasicAuthorization"},
@@ -635,12 +1078,12 @@ HTTP_C::HTTP_C() : ServiceFramework("http:C", 32) {
         {0x001B0102, nullptr, "SendPOSTDataRawTimeout"},
         {0x001C0080, nullptr, "SetPostDataEncoding"},
         {0x001D0040, nullptr, "NotifyFinishSendPostData"},
-        {0x001E00C4, nullptr, "GetResponseHeader"},
+        {0x001E00C4, &HTTP_C::GetResponseHeader, "GetResponseHeader"},
         {0x001F0144, nullptr, "GetResponseHeaderTimeout"},
         {0x00200082, nullptr, "GetResponseData"},
         {0x00210102, nullptr, "GetResponseDataTimeout"},
-        {0x00220040, nullptr, "GetResponseStatusCode"},
-        {0x002300C0, nullptr, "GetResponseStatusCodeTimeout"},
+        {0x00220040, &HTTP_C::GetResponseStatusCode, "GetResponseStatusCode"},
+        {0x002300C0, &HTTP_C::GetResponseStatusCodeTimeout, "GetResponseStatusCodeTimeout"},
         {0x00240082, nullptr, "AddTrustedRootCA"},
         {0x00250080, nullptr, "AddDefaultCert"},
         {0x00260080, nullptr, "SelectRootCertChain"},
@@ -666,10 +1109,23 @@ HTTP_C::HTTP_C() : ServiceFramework("http:C", 32) {
     RegisterHandlers(functions);
 
     DecryptClCertA();
+
+    request_updated_event = system.CoreTiming().RegisterEvent(
+        "HTTP_C::RequestUpdated",
+        [this](u64 context_handle, int cycles_late) { RequestUpdated(context_handle); });
+    engine = std::make_unique<RequestEngine>([this](u64 context_handle) {
+        this->system.CoreTiming().ScheduleEventThreadsafe(0, request_updated_event,
+                                                          context_handle);
+    });
+}
+
+HTTP_C::~HTTP_C() {
+    engine.reset();
+    system.CoreTiming().RemoveNormalAndThreadsafeEvent(request_updated_event);
 }
 
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
-    std::make_shared<HTTP_C>()->InstallAsService(service_manager);
+    std::make_shared<HTTP_C>(system)->InstallAsService(service_manager);
 }
 } // namespace Service::HTTP
@@ -4,16 +4,24 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include "core/hle/kernel/shared_memory.h"
+#include "core/hle/service/http_engine.h"
 #include "core/hle/service/service.h"
 
 namespace Core {
 class System;
+struct TimingEventType;
+} // namespace Core
+
+namespace Kernel {
+class Event;
 }
 
 namespace Service::HTTP {
@@ -123,6 +131,11 @@ public:
     u32 socket_buffer_size;
     std::vector<RequestHeader> headers;
     std::vector<PostData> post_data;
+
+    /// The request executed for this context, once it has been started
+    std::shared_ptr<RequestEngine::Job> job;
+    /// Number of bytes of the response body that have been copied to the guest
+    u64 current_copied_data = 0;
 };
 
 struct SessionData : public Kernel::SessionRequestHandler::SessionDataBase {
@@ -144,7 +157,8 @@ struct SessionData : public Kernel::SessionRequestHandler::SessionDataBase {
 
 class HTTP_C final : public ServiceFramework<HTTP_C, SessionData> {
 public:
-    HTTP_C();
+    explicit HTTP_C(Core::System& system);
+    ~HTTP_C();
 
 private:
     /**
@@ -182,6 +196,36 @@ private:
      */
     void CloseContext(Kernel::HLERequestContext& ctx);
 
+    /**
+     * HTTP_C::CancelConnection service function
+     *  Inputs:
+     *      1 : Context handle
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     */
+    void CancelConnection(Kernel::HLERequestContext& ctx);
+
+    /**
+     * HTTP_C::GetRequestState service function
+     *  Inputs:
+     *      1 : Context handle
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     *      2 : RequestState
+     */
+    void GetRequestState(Kernel::HLERequestContext& ctx);
+
+    /**
+     * HTTP_C::GetDownloadSizeState service function
+     *  Inputs:
+     *      1 : Context handle
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     *      2 : Number of bytes of the response body received by the guest
+     *      3 : Size of the response body, or 0 if it is unknown
+     */
+    void GetDownloadSizeState(Kernel::HLERequestContext& ctx);
+
     /**
      * HTTP_C::InitializeConnectionSession service function
      *  Inputs:
@@ -193,6 +237,54 @@ private:
      */
     void InitializeConnectionSession(Kernel::HLERequestContext& ctx);
 
+    /**
+     * HTTP_C::BeginRequest service function. Blocks until the response headers are received.
+     *  Inputs:
+     *      1 : Context handle
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     */
+    void BeginRequest(Kernel::HLERequestContext& ctx);
+
+    /**
+     * HTTP_C::BeginRequestAsync service function
+     *  Inputs:
+     *      1 : Context handle
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     */
+    void BeginRequestAsync(Kernel::HLERequestContext& ctx);
+
+    void BeginRequestImpl(Kernel::HLERequestContext& ctx, bool async);
+
+    /**
+     * HTTP_C::ReceiveData service function. Blocks until the buffer is full or the whole response
+     * body has been received.
+     *  Inputs:
+     *      1 : Context handle
+     *      2 : Buffer size
+     *      3 : (OutSize<<4) | 12
+     *      4 : Output data pointer
+     *  Outputs:
+     *      1 : Result of function, 0 if the whole body was received, otherwise error code
+     */
+    void ReceiveData(Kernel::HLERequestContext& ctx);
+
+    /**
+     * HTTP_C::ReceiveDataTimeout service function
+     *  Inputs:
+     *      1 : Context handle
+     *      2 : Buffer size
+     *    3-4 : Timeout in nanoseconds
+     *      5 : (OutSize<<4) | 12
+     *      6 : Output data pointer
+     *  Outputs:
+     *      1 : Result of function, 0 if the whole body was received, otherwise error code
+     */
+    void ReceiveDataTimeout(Kernel::HLERequestContext& ctx);
+
+    void ReceiveDataImpl(Kernel::HLERequestContext& ctx, bool timeout);
+
     /**
      * HTTP_C::AddRequestHeader service function
      *  Inputs:
@@ -223,6 +315,46 @@ private:
      */
     void AddPostDataAscii(Kernel::HLERequestContext& ctx);
 
+    /**
+     * HTTP_C::GetResponseHeader service function. Blocks until the response headers are received.
+     *  Inputs:
+     *      1 : Context handle
+     *      2 : Header name buffer size, including null-terminator
+     *      3 : Header value buffer size
+     *      4 : (HeaderNameSize<<14) | 0xC02
+     *      5 : Header name data pointer
+     *      6 : (HeaderValueSize<<4) | 12
+     *      7 : Header value data pointer
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     *      2 : Size of the header value, including null-terminator
+     */
+    void GetResponseHeader(Kernel::HLERequestContext& ctx);
+
+    /**
+     * HTTP_C::GetResponseStatusCode service function. Blocks until the response headers are
+     * received.
+     *  Inputs:
+     *      1 : Context handle
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     *      2 : HTTP status code
+     */
+    void GetResponseStatusCode(Kernel::HLERequestContext& ctx);
+
+    /**
+     * HTTP_C::GetResponseStatusCodeTimeout service function
+     *  Inputs:
+     *      1 : Context handle
+     *    2-3 : Timeout in nanoseconds
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     *      2 : HTTP status code
+     */
+    void GetResponseStatusCodeTimeout(Kernel::HLERequestContext& ctx);
+
+    void GetResponseStatusCodeImpl(Kernel::HLERequestContext& ctx, bool timeout);
+
     /**
      * HTTP_C::OpenClientCertContext service function
      *  Inputs:
@@ -265,6 +397,40 @@ private:
 
     void DecryptClCertA();
 
+    /// Checks that the context can be used from the session, as the commands on a bound context
+    /// require
+    ResultCode CheckBoundContext(const SessionData& session_data,
+                                 Context::Handle context_handle) const;
+
+    /// Starts executing the request of a context
+    void StartRequest(Context& context);
+
+    /// Updates the state the guest sees for the request of a context
+    static void UpdateRequestState(Context& context);
+
+    /// A guest thread waiting for the request of a context to progress
+    struct Waiter {
+        Context::Handle context_handle;
+        /// Called whenever the request progresses. Returns true once the wait is over.
+        std::function<bool()> poll;
+        Kernel::SharedPtr<Kernel::Event> event;
+    };
+
+    using Reply = std::function<void(Kernel::HLERequestContext& ctx, bool timed_out)>;
+
+    /**
+     * Replies immediately if poll returns true, otherwise puts the calling guest thread to sleep
+     * until it does or the timeout expires. A timeout of 0 waits forever.
+     */
+    void WaitForRequest(Kernel::HLERequestContext& ctx, const char* reason,
+                        Context::Handle context_handle, std::function<bool()> poll, Reply reply,
+                        std::chrono::nanoseconds timeout = {});
+
+    /// Wakes up the waiters of a context whose request progressed. Runs on the emulation thread.
+    void RequestUpdated(Context::Handle context_handle);
+
+    Core::System& system;
+
     Kernel::SharedPtr<Kernel::SharedMemory> shared_memory = nullptr;
 
     /// The next number to use when a new HTTP session is initalized.
@@ -287,6 +453,14 @@ private:
         std::vector<u8> private_key;
         bool init = false;
     } ClCertA;
+
+    /// Guest threads waiting on requests
+    std::vector<std::shared_ptr<Waiter>> waiters;
+
+    Core::TimingEventType* request_updated_event = nullptr;
+
+    /// Declared last, so that the requests in flight finish before the rest is destroyed
+    std::unique_ptr<RequestEngine> engine;
 };
 
 void InstallInterfaces(Core::System& system);
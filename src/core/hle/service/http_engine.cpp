@@ -0,0 +1,265 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <unordered_map>
+#include <fmt/format.h>
+#ifdef ENABLE_WEB_SERVICE
+#include <LUrlParser.h>
+#include <httplib.h>
+#endif
+#include "common/logging/log.h"
+#include "common/thread_worker.h"
+#include "core/hle/service/http_engine.h"
+
+namespace Service::HTTP {
+
+/// Number of requests that can be executed at the same time
+constexpr std::size_t num_request_workers = 4;
+/// Clients kept around for reuse for each host
+constexpr std::size_t max_idle_clients = num_request_workers;
+constexpr std::size_t request_timeout_seconds = 30;
+
+RequestEngine::Job::State RequestEngine::Job::GetState() const {
+    std::lock_guard lock(mutex);
+    return state;
+}
+
+int RequestEngine::Job::GetStatusCode() const {
+    std::lock_guard lock(mutex);
+    return status_code;
+}
+
+std::optional<std::string> RequestEngine::Job::GetHeader(const std::string& name) const {
+    const auto equals = [](const std::string& a, const std::string& b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](char c1, char c2) {
+            return std::tolower(static_cast<unsigned char>(c1)) ==
+                   std::tolower(static_cast<unsigned char>(c2));
+        });
+    };
+
+    std::lock_guard lock(mutex);
+    const auto it = std::find_if(headers.begin(), headers.end(),
+                                 [&](const auto& header) { return equals(header.first, name); });
+    if (it == headers.end())
+        return std::nullopt;
+    return it->second;
+}
+
+u64 RequestEngine::Job::GetContentLength() const {
+    std::lock_guard lock(mutex);
+    return content_length;
+}
+
+std::size_t RequestEngine::Job::ReadBody(u8* out, std::size_t max_size) {
+    std::lock_guard lock(mutex);
+    const std::size_t size = std::min(max_size, body.size() - read_offset);
+    std::memcpy(out, body.data() + read_offset, size);
+    read_offset += size;
+    if (read_offset == body.size()) {
+        body.clear();
+        read_offset = 0;
+    }
+    return size;
+}
+
+bool RequestEngine::Job::IsBodyConsumed() const {
+    std::lock_guard lock(mutex);
+    return state == State::Failed || (state == State::Finished && body.empty());
+}
+
+void RequestEngine::Job::Cancel() {
+    std::lock_guard lock(mutex);
+    state = State::Failed;
+    body.clear();
+    read_offset = 0;
+}
+
+struct RequestEngine::Impl {
+    explicit Impl(UpdateCallback on_update) : on_update(std::move(on_update)) {}
+
+    /// Runs a request on a worker thread
+    void Execute(Job& job, const Request& request, u64 tag);
+
+#ifdef ENABLE_WEB_SERVICE
+    /// Takes an idle client for the host, or creates one
+    std::unique_ptr<httplib::Client> AcquireClient(const std::string& key,
+                                                   const std::string& scheme,
+                                                   const std::string& host, int port) {
+        {
+            std::lock_guard lock(clients_mutex);
+            auto& idle = idle_clients[key];
+            if (!idle.empty()) {
+                auto client = std::move(idle.back());
+                idle.pop_back();
+                return client;
+            }
+        }
+
+        if (scheme == "http") {
+            return std::make_unique<httplib::Client>(host.c_str(), port, request_timeout_seconds);
+        }
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+        if (scheme == "https") {
+            return std::make_unique<httplib::SSLClient>(host.c_str(), port,
+                                                        request_timeout_seconds);
+        }
+#endif
+        return nullptr;
+    }
+
+    void ReleaseClient(const std::string& key, std::unique_ptr<httplib::Client> client) {
+        std::lock_guard lock(clients_mutex);
+        auto& idle = idle_clients[key];
+        if (idle.size() < max_idle_clients) {
+            idle.push_back(std::move(client));
+        }
+    }
+
+    std::mutex clients_mutex;
+    std::unordered_map<std::string, std::vector<std::unique_ptr<httplib::Client>>> idle_clients;
+#endif
+
+    UpdateCallback on_update;
+    std::atomic<bool> stopping{false};
+    /// Declared last, so that the workers finish before the rest is destroyed
+    std::unique_ptr<Common::ThreadWorker> workers;
+};
+
+namespace {
+
+/// Encodes form fields as application/x-www-form-urlencoded
+std::string EncodeForm(const RequestEngine::HeaderList& fields) {
+    const auto encode = [](const std::string& value) {
+        std::string encoded;
+        for (const char c : value) {
+            if (std::isalnum(static_cast<unsigned char>(c)) || std::strchr("-_.~", c)) {
+                encoded += c;
+            } else if (c == ' ') {
+                encoded += '+';
+            } else {
+                encoded += fmt::format("%{:02X}", static_cast<u8>(c));
+            }
+        }
+        return encoded;
+    };
+
+    std::string form;
+    for (const auto& [name, value] : fields) {
+        if (!form.empty())
+            form += '&';
+        form += encode(name) + '=' + encode(value);
+    }
+    return form;
+}
+
+} // Anonymous namespace
+
+void RequestEngine::Impl::Execute(Job& job, const Request& request, u64 tag) {
+    const auto fail = [&] {
+        std::lock_guard lock(job.mutex);
+        job.state = Job::State::Failed;
+    };
+
+    if (stopping) {
+        fail();
+        return;
+    }
+
+#ifdef ENABLE_WEB_SERVICE
+    const auto url = LUrlParser::clParseURL::ParseURL(request.url);
+    int port;
+    if (!url.IsValid() || !url.GetPort(&port)) {
+        port = url.m_Scheme == "https" ? 443 : 80;
+    }
+    const std::string key = fmt::format("{}://{}:{}", url.m_Scheme, url.m_Host, port);
+    auto client = url.IsValid() ? AcquireClient(key, url.m_Scheme, url.m_Host, port) : nullptr;
+    if (!client) {
+        LOG_ERROR(Service_HTTP, "Unsupported URL {}", request.url);
+        fail();
+        on_update(tag);
+        return;
+    }
+
+    httplib::Request http_request;
+    http_request.method = request.method;
+    http_request.path = '/' + url.m_Path + (url.m_Query.empty() ? "" : '?' + url.m_Query);
+    for (const auto& [name, value] : request.headers) {
+        http_request.headers.emplace(name, value);
+    }
+    if (!request.post_data.empty()) {
+        http_request.body = EncodeForm(request.post_data);
+        if (!http_request.has_header("Content-Type")) {
+            http_request.set_header("Content-Type", "application/x-www-form-urlencoded");
+        }
+    }
+
+    httplib::Response response;
+    bool headers_published = false;
+    std::size_t published_size = 0;
+    // Hands the data received so far over to the job. Returns false if the job was cancelled.
+    const auto publish = [&](std::size_t received_size, Job::State state) {
+        std::lock_guard lock(job.mutex);
+        if (job.state == Job::State::Failed)
+            return false;
+
+        if (!headers_published) {
+            job.status_code = response.status;
+            job.headers.assign(response.headers.begin(), response.headers.end());
+            const std::string length = response.get_header_value("Content-Length");
+            job.content_length = length.empty() ? 0 : std::strtoull(length.c_str(), nullptr, 10);
+            headers_published = true;
+        }
+        job.body.insert(job.body.end(), response.body.data() + published_size,
+                        response.body.data() + received_size);
+        published_size = received_size;
+        job.state = state;
+        return true;
+    };
+
+    // The body is handed over as it is received when its length is known up front
+    http_request.progress = [&](u64 current, u64 total) {
+        if (publish(static_cast<std::size_t>(current), Job::State::ReceivingBody)) {
+            on_update(tag);
+        }
+    };
+
+    const bool success = client->send(http_request, response);
+    if (success) {
+        publish(response.body.size(), Job::State::Finished);
+        ReleaseClient(key, std::move(client));
+    } else {
+        LOG_ERROR(Service_HTTP, "Request to {} failed", request.url);
+        fail();
+    }
+    on_update(tag);
+#else
+    LOG_ERROR(Service_HTTP, "Cannot send request to {}, web services are disabled", request.url);
+    fail();
+    on_update(tag);
+#endif
+}
+
+RequestEngine::RequestEngine(UpdateCallback on_update)
+    : impl(std::make_unique<Impl>(std::move(on_update))) {
+    impl->workers = std::make_unique<Common::ThreadWorker>(num_request_workers, "HTTPRequest");
+}
+
+RequestEngine::~RequestEngine() {
+    impl->stopping = true;
+    impl->workers.reset();
+}
+
+std::shared_ptr<RequestEngine::Job> RequestEngine::Start(Request request, u64 tag) {
+    auto job = std::make_shared<Job>();
+    impl->workers->QueueWork([impl = impl.get(), job, request = std::move(request), tag] {
+        impl->Execute(*job, request, tag);
+    });
+    return job;
+}
+
+} // namespace Service::HTTP
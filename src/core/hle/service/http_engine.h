@@ -0,0 +1,102 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Service::HTTP {
+
+/**
+ * Executes the requests of HTTP:C contexts on a pool of worker threads. Response bodies are
+ * buffered as they arrive, so that the emulated module can hand them to the guest in pieces while
+ * the rest is still being downloaded.
+ */
+class RequestEngine {
+public:
+    using HeaderList = std::vector<std::pair<std::string, std::string>>;
+
+    struct Request {
+        std::string method;
+        std::string url;
+        HeaderList headers;
+        /// Form fields sent URL-encoded as the body of the request
+        HeaderList post_data;
+    };
+
+    /// A request being executed. Shared between the workers and the emulation thread.
+    class Job {
+    public:
+        enum class State {
+            /// Connecting, sending the request and waiting for the response headers
+            Sending,
+            /// The status code and headers are known, and the body is being received
+            ReceivingBody,
+            /// The whole response has been received
+            Finished,
+            /// The request failed or was cancelled
+            Failed,
+        };
+
+        State GetState() const;
+
+        /// Returns the response status code. Only valid once the state is past Sending.
+        int GetStatusCode() const;
+
+        /// Returns the value of a response header, compared case-insensitively
+        std::optional<std::string> GetHeader(const std::string& name) const;
+
+        /// Returns the size the server announced for the body, or 0 if it did not
+        u64 GetContentLength() const;
+
+        /**
+         * Moves up to max_size bytes of the body that were received but not read yet into out.
+         * @returns the number of bytes read
+         */
+        std::size_t ReadBody(u8* out, std::size_t max_size);
+
+        /// Returns whether the request is over and all of its body has been read
+        bool IsBodyConsumed() const;
+
+        /// Stops reporting progress for the request and marks it as failed
+        void Cancel();
+
+    private:
+        friend class RequestEngine;
+
+        mutable std::mutex mutex;
+        State state = State::Sending;
+        int status_code = 0;
+        HeaderList headers;
+        u64 content_length = 0;
+        /// Body data that has not been read yet, starting at read_offset
+        std::vector<u8> body;
+        std::size_t read_offset = 0;
+    };
+
+    /// Called on a worker thread whenever the job started with the given tag progresses
+    using UpdateCallback = std::function<void(u64 tag)>;
+
+    explicit RequestEngine(UpdateCallback on_update);
+
+    /// Waits for the requests in flight. Requests that have not started yet are failed.
+    ~RequestEngine();
+
+    /// Queues a request, whose progress is reported to the update callback with the given tag
+    std::shared_ptr<Job> Start(Request request, u64 tag);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // namespace Service::HTTP
@@ -0,0 +1,286 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/thread.h"
+#include "core/hle/service/soc_reactor.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#else
+#include <poll.h>
+#endif
+
+namespace Service::SOC {
+
+#if !defined(__linux__)
+/// How often the poll-based reactor picks up newly submitted operations
+constexpr int poll_interval_ms = 10;
+#endif
+
+struct SocketReactor::Impl {
+    struct PendingOperation {
+        std::vector<Watch> watches;
+        Operation operation;
+    };
+
+    explicit Impl(CompletionCallback on_complete) : on_complete(std::move(on_complete)) {
+#ifdef __linux__
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        ASSERT_MSG(epoll_fd != -1 && wakeup_fd != -1, "Could not create the socket reactor");
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = wakeup_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &event);
+#endif
+        thread = std::thread([this] { Loop(); });
+    }
+
+    ~Impl() {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+#ifdef __linux__
+        const u64 value = 1;
+        [[maybe_unused]] const auto written = write(wakeup_fd, &value, sizeof(value));
+#endif
+        thread.join();
+#ifdef __linux__
+        close(wakeup_fd);
+        close(epoll_fd);
+#endif
+    }
+
+    /**
+     * Attempts the operations waiting for fd, and removes the ones that completed. Requires mutex.
+     * @param completed receives the ids of the completed operations
+     * @param released receives the watches of the completed operations
+     */
+    void Attempt(u32 fd, bool readable, bool writable, std::vector<u64>& completed,
+                 std::vector<Watch>& released) {
+        for (auto it = operations.begin(); it != operations.end();) {
+            const auto& watches = it->second.watches;
+            const bool ready = std::any_of(watches.begin(), watches.end(), [&](const Watch& watch) {
+                return watch.fd == fd && ((watch.read && readable) || (watch.write && writable));
+            });
+            if (ready && it->second.operation()) {
+                completed.push_back(it->first);
+                released.insert(released.end(), watches.begin(), watches.end());
+                it = operations.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    /// Updates what is waited for on the sockets of operations that were removed. Requires mutex.
+    void Release(const std::vector<Watch>& released) {
+#ifdef __linux__
+        for (const Watch& watch : released) {
+            UpdateRegistration(watch.fd);
+        }
+#endif
+    }
+
+#ifdef __linux__
+    /// Registers the union of what the pending operations wait for on fd. Requires mutex.
+    void UpdateRegistration(u32 fd) {
+        u32 events = 0;
+        for (const auto& [id, pending] : operations) {
+            for (const Watch& watch : pending.watches) {
+                if (watch.fd == fd) {
+                    events |= (watch.read ? EPOLLIN : 0) | (watch.write ? EPOLLOUT : 0);
+                }
+            }
+        }
+
+        const auto it = registered_events.find(fd);
+        const u32 current = it == registered_events.end() ? 0 : it->second;
+        if (events == current)
+            return;
+
+        const int host_fd = static_cast<int>(fd);
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = host_fd;
+        if (events == 0) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, host_fd, &event);
+            registered_events.erase(it);
+            return;
+        }
+
+        int result = -1;
+        if (current != 0) {
+            result = epoll_ctl(epoll_fd, EPOLL_CTL_MOD, host_fd, &event);
+        }
+        // A descriptor that was closed and reused is no longer in the epoll set
+        if (result != 0) {
+            result = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, host_fd, &event);
+        }
+        if (result != 0) {
+            LOG_ERROR(Service_SOC, "Could not watch socket {}: {}", fd, errno);
+        }
+        registered_events[fd] = events;
+    }
+
+    void Loop() {
+        Common::SetCurrentThreadName("SocketReactor");
+        std::array<epoll_event, 64> events;
+        while (true) {
+            const int num_events =
+                epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), -1);
+            std::vector<u64> completed;
+            {
+                std::lock_guard lock(mutex);
+                if (stop)
+                    return;
+                std::vector<Watch> released;
+                for (int i = 0; i < num_events; ++i) {
+                    if (events[i].data.fd == wakeup_fd)
+                        continue;
+                    // Errors and hang-ups let every operation on the socket complete
+                    const bool failed = (events[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+                    Attempt(static_cast<u32>(events[i].data.fd),
+                            failed || (events[i].events & EPOLLIN),
+                            failed || (events[i].events & EPOLLOUT), completed, released);
+                }
+                Release(released);
+            }
+            for (const u64 id : completed) {
+                on_complete(id);
+            }
+        }
+    }
+#else
+    void Loop() {
+        Common::SetCurrentThreadName("SocketReactor");
+        std::vector<pollfd> fds;
+        while (true) {
+            fds.clear();
+            {
+                std::lock_guard lock(mutex);
+                if (stop)
+                    return;
+                for (const auto& [id, pending] : operations) {
+                    for (const Watch& watch : pending.watches) {
+                        pollfd fd{};
+                        fd.fd = watch.fd;
+                        fd.events = (watch.read ? POLLIN : 0) | (watch.write ? POLLOUT : 0);
+                        fds.push_back(fd);
+                    }
+                }
+            }
+
+            int num_ready;
+            if (fds.empty()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(poll_interval_ms));
+                continue;
+            }
+#ifdef _WIN32
+            num_ready = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), poll_interval_ms);
+#else
+            num_ready = poll(fds.data(), fds.size(), poll_interval_ms);
+#endif
+            if (num_ready <= 0)
+                continue;
+
+            std::vector<u64> completed;
+            {
+                std::lock_guard lock(mutex);
+                std::vector<Watch> released;
+                for (const pollfd& fd : fds) {
+                    const bool failed = (fd.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+                    if (fd.revents != 0) {
+                        Attempt(static_cast<u32>(fd.fd), failed || (fd.revents & POLLIN),
+                                failed || (fd.revents & POLLOUT), completed, released);
+                    }
+                }
+            }
+            for (const u64 id : completed) {
+                on_complete(id);
+            }
+        }
+    }
+#endif
+
+    CompletionCallback on_complete;
+
+    /// Guards the pending operations, and is held while they are attempted
+    std::mutex mutex;
+    std::unordered_map<u64, PendingOperation> operations;
+    u64 next_id = 1;
+    bool stop = false;
+
+#ifdef __linux__
+    int epoll_fd;
+    /// Wakes the reactor thread up when it needs to stop
+    int wakeup_fd;
+    /// Events registered with epoll for each watched socket
+    std::unordered_map<u32, u32> registered_events;
+#endif
+
+    std::thread thread;
+};
+
+SocketReactor::SocketReactor(CompletionCallback on_complete)
+    : impl(std::make_unique<Impl>(std::move(on_complete))) {}
+
+SocketReactor::~SocketReactor() = default;
+
+u64 SocketReactor::Submit(std::vector<Watch> watches, Operation operation) {
+    std::lock_guard lock(impl->mutex);
+    const u64 id = impl->next_id++;
+    // Registering the new watches is done the same way as releasing old ones
+    const std::vector<Watch> added = watches;
+    impl->operations.emplace(id, Impl::PendingOperation{std::move(watches), std::move(operation)});
+    impl->Release(added);
+    return id;
+}
+
+bool SocketReactor::Cancel(u64 id) {
+    std::lock_guard lock(impl->mutex);
+    const auto it = impl->operations.find(id);
+    if (it == impl->operations.end())
+        return false;
+
+    const std::vector<Watch> released = std::move(it->second.watches);
+    impl->operations.erase(it);
+    impl->Release(released);
+    return true;
+}
+
+std::vector<u64> SocketReactor::CancelSocket(u32 fd) {
+    std::lock_guard lock(impl->mutex);
+    std::vector<u64> cancelled;
+    std::vector<Watch> released;
+    for (auto it = impl->operations.begin(); it != impl->operations.end();) {
+        const auto& watches = it->second.watches;
+        if (std::any_of(watches.begin(), watches.end(),
+                        [fd](const Watch& watch) { return watch.fd == fd; })) {
+            cancelled.push_back(it->first);
+            released.insert(released.end(), watches.begin(), watches.end());
+            it = impl->operations.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    impl->Release(released);
+    return cancelled;
+}
+
+} // namespace Service::SOC
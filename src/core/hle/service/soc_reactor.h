@@ -0,0 +1,64 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Service::SOC {
+
+/**
+ * Waits for host sockets to become ready on a background thread, using epoll where it is
+ * available. This lets SOC:U put guest threads to sleep on blocking socket calls instead of
+ * blocking the emulation thread.
+ */
+class SocketReactor {
+public:
+    /// A socket an operation is waiting on, and what it is waiting for
+    struct Watch {
+        u32 fd;
+        bool read;
+        bool write;
+    };
+
+    /**
+     * Attempts a non-blocking operation. Returns true if it completed, or false if it would still
+     * block. Called on the reactor thread.
+     */
+    using Operation = std::function<bool()>;
+
+    /// Called on the reactor thread after an operation completes
+    using CompletionCallback = std::function<void(u64 id)>;
+
+    explicit SocketReactor(CompletionCallback on_complete);
+    ~SocketReactor();
+
+    /**
+     * Retries the operation whenever one of the watched sockets becomes ready, until it completes.
+     * @returns an id identifying the operation, which is passed to the completion callback
+     */
+    u64 Submit(std::vector<Watch> watches, Operation operation);
+
+    /**
+     * Drops a pending operation. Once this returns, the operation will not be attempted again.
+     * @returns false if the operation had already completed
+     */
+    bool Cancel(u64 id);
+
+    /**
+     * Drops all the pending operations watching the given socket. Must be called before the socket
+     * is closed, as its descriptor may be reused.
+     * @returns the ids of the dropped operations
+     */
+    std::vector<u64> CancelSocket(u32 fd);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // namespace Service::SOC
@@ -12,8 +12,11 @@
 #include "common/scope_exit.h"
 #include "common/swap.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/event.h"
 #include "core/hle/kernel/shared_memory.h"
+#include "core/hle/kernel/thread.h"
 #include "core/hle/result.h"
 #include "core/hle/service/soc_u.h"
 
@@ -350,9 +353,95 @@ struct CTRAddrInfo {
 
 static_assert(sizeof(CTRAddrInfo) == 0x130, "Size of CTRAddrInfo is not correct");
 
+struct SOC_U::BlockedCall {
+    /// Return value of the host call, or the translated error if it failed
+    s32 result = 0;
+    /// Data received or to be sent, or the resulting pollfds of a poll
+    std::vector<u8> data;
+    sockaddr addr{};
+    socklen_t addr_len = sizeof(sockaddr);
+    /// Whether the guest gave up waiting before the call completed
+    bool timed_out = false;
+    Kernel::SharedPtr<Kernel::Event> event;
+
+    /// Records the result of a non-blocking host call. Returns false if the call would block.
+    bool Finish(s32 ret) {
+        if (ret == SOCKET_ERROR_VALUE) {
+            const int error = GET_ERRNO;
+            if (error == ERRNO(EAGAIN) || error == ERRNO(EWOULDBLOCK))
+                return false;
+            result = TranslateError(error);
+        } else {
+            result = ret;
+        }
+        return true;
+    }
+};
+
+/// Makes a host socket non-blocking. Blocking guest calls wait on the socket reactor instead.
+static void SetHostNonBlocking(u32 socket_handle) {
+#ifdef _WIN32
+    unsigned long non_blocking = 1;
+    ioctlsocket(socket_handle, FIONBIO, &non_blocking);
+#else
+    const int flags = ::fcntl(socket_handle, F_GETFL, 0);
+    if (flags != SOCKET_ERROR_VALUE) {
+        ::fcntl(socket_handle, F_SETFL, flags | O_NONBLOCK);
+    }
+#endif
+}
+
+bool SOC_U::IsBlocking(u32 socket_handle) const {
+    const auto iter = open_sockets.find(socket_handle);
+    return iter != open_sockets.end() && iter->second.blocking;
+}
+
+void SOC_U::SleepUntilReady(Kernel::HLERequestContext& ctx, const char* reason,
+                            std::vector<SocketReactor::Watch> watches,
+                            SocketReactor::Operation operation, std::shared_ptr<BlockedCall> call,
+                            Reply reply, std::chrono::nanoseconds timeout) {
+    const u64 id = reactor->Submit(std::move(watches), std::move(operation));
+    call->event = ctx.SleepClientThread(
+        system.Kernel().GetThreadManager().GetCurrentThread(), reason, timeout,
+        [this, id, call, reply](Kernel::SharedPtr<Kernel::Thread> thread,
+                                Kernel::HLERequestContext& ctx, Kernel::ThreadWakeupReason reason) {
+            if (reason == Kernel::ThreadWakeupReason::Timeout && reactor->Cancel(id)) {
+                call->timed_out = true;
+            }
+            blocked_calls.erase(id);
+            reply(ctx);
+        });
+    blocked_calls.emplace(id, std::move(call));
+}
+
+void SOC_U::CallCompleted(u64 id) {
+    // The guest may have stopped waiting already
+    const auto iter = blocked_calls.find(id);
+    if (iter != blocked_calls.end()) {
+        iter->second->event->Signal();
+    }
+}
+
+void SOC_U::AbortCalls(u32 socket_handle) {
+    // The reactor is already stopped when the service shuts down, and nothing is left to wake up
+    if (!reactor)
+        return;
+
+    for (const u64 id : reactor->CancelSocket(socket_handle)) {
+        const auto iter = blocked_calls.find(id);
+        if (iter != blocked_calls.end()) {
+            iter->second->result = TranslateError(ERRNO(EBADF));
+            iter->second->data.clear();
+            iter->second->event->Signal();
+        }
+    }
+}
+
 void SOC_U::CleanupSockets() {
-    for (auto sock : open_sockets)
+    for (auto sock : open_sockets) {
+        AbortCalls(sock.second.socket_fd);
         closesocket(sock.second.socket_fd);
+    }
     open_sockets.clear();
 }
 
@@ -386,8 +475,10 @@ void SOC_U::Socket(Kernel::HLERequestContext& ctx) {
 
     u32 ret = static_cast<u32>(::socket(domain, type, protocol));
 
-    if ((s32)ret != SOCKET_ERROR_VALUE)
+    if ((s32)ret != SOCKET_ERROR_VALUE) {
         open_sockets[ret] = {ret, true};
+        SetHostNonBlocking(ret);
+    }
 
     if ((s32)ret == SOCKET_ERROR_VALUE)
         ret = TranslateError(GET_ERRNO);
@@ -432,50 +523,19 @@ void SOC_U::Fcntl(Kernel::HLERequestContext& ctx) {
         rb.Push(posix_ret);
     });
 
+    // Host sockets are always non-blocking, so only the flag the guest sees is changed
+    auto iter = open_sockets.find(socket_handle);
+    if (iter == open_sockets.end()) {
+        posix_ret = TranslateError(ERRNO(EBADF));
+        return;
+    }
+
     if (ctr_cmd == 3) { // F_GETFL
-#ifdef _WIN32
-        posix_ret = 0;
-        auto iter = open_sockets.find(socket_handle);
-        if (iter != open_sockets.end() && iter->second.blocking == false)
-            posix_ret |= 4; // O_NONBLOCK
-#else
-        int ret = ::fcntl(socket_handle, F_GETFL, 0);
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
         posix_ret = 0;
-        if (ret & O_NONBLOCK)
+        if (!iter->second.blocking)
             posix_ret |= 4; // O_NONBLOCK
-#endif
     } else if (ctr_cmd == 4) { // F_SETFL
-#ifdef _WIN32
-        unsigned long tmp = (ctr_arg & 4 /* O_NONBLOCK */) ? 1 : 0;
-        int ret = ioctlsocket(socket_handle, FIONBIO, &tmp);
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-        auto iter = open_sockets.find(socket_handle);
-        if (iter != open_sockets.end())
-            iter->second.blocking = (tmp == 0);
-#else
-        int flags = ::fcntl(socket_handle, F_GETFL, 0);
-        if (flags == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-
-        flags &= ~O_NONBLOCK;
-        if (ctr_arg & 4) // O_NONBLOCK
-            flags |= O_NONBLOCK;
-
-        int ret = ::fcntl(socket_handle, F_SETFL, flags);
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-#endif
+        iter->second.blocking = (ctr_arg & 4 /* O_NONBLOCK */) == 0;
     } else {
         LOG_ERROR(Service_SOC, "Unsupported command ({}) in fcntl call", ctr_cmd);
         posix_ret = TranslateError(EINVAL); // TODO: Find the correct error
@@ -499,33 +559,40 @@ void SOC_U::Listen(Kernel::HLERequestContext& ctx) {
 }
 
 void SOC_U::Accept(Kernel::HLERequestContext& ctx) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp(ctx, 0x04, 2, 2);
     u32 socket_handle = rp.Pop<u32>();
     socklen_t max_addr_len = static_cast<socklen_t>(rp.Pop<u32>());
     rp.PopPID();
-    sockaddr addr;
-    socklen_t addr_len = sizeof(addr);
-    u32 ret = static_cast<u32>(::accept(socket_handle, &addr, &addr_len));
 
-    if ((s32)ret != SOCKET_ERROR_VALUE)
-        open_sockets[ret] = {ret, true};
+    auto call = std::make_shared<BlockedCall>();
+    auto accept = [call, socket_handle] {
+        call->addr_len = sizeof(call->addr);
+        return call->Finish(
+            static_cast<s32>(::accept(socket_handle, &call->addr, &call->addr_len)));
+    };
+    auto reply = [this, call](Kernel::HLERequestContext& ctx) {
+        CTRSockAddr ctr_addr;
+        std::vector<u8> ctr_addr_buf(sizeof(ctr_addr));
+        if (call->result >= 0) {
+            const u32 ret = static_cast<u32>(call->result);
+            open_sockets[ret] = {ret, true};
+            SetHostNonBlocking(ret);
+            ctr_addr = CTRSockAddr::FromPlatform(call->addr);
+            std::memcpy(ctr_addr_buf.data(), &ctr_addr, sizeof(ctr_addr));
+        }
 
-    CTRSockAddr ctr_addr;
-    std::vector<u8> ctr_addr_buf(sizeof(ctr_addr));
-    if ((s32)ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(GET_ERRNO);
-    } else {
-        ctr_addr = CTRSockAddr::FromPlatform(addr);
-        std::memcpy(ctr_addr_buf.data(), &ctr_addr, sizeof(ctr_addr));
-    }
+        IPC::RequestBuilder rb(ctx, 0x04, 2, 2);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(call->result);
+        rb.PushStaticBuffer(ctr_addr_buf, 0);
+    };
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(ctr_addr_buf, 0);
+    if (accept() || !IsBlocking(socket_handle)) {
+        reply(ctx);
+        return;
+    }
+    SleepUntilReady(ctx, "soc:u::Accept", {{socket_handle, true, false}}, std::move(accept),
+                    std::move(call), std::move(reply));
 }
 
 void SOC_U::GetHostId(Kernel::HLERequestContext& ctx) {
@@ -555,6 +622,8 @@ void SOC_U::Close(Kernel::HLERequestContext& ctx) {
     s32 ret = 0;
     open_sockets.erase(socket_handle);
 
+    // Guest threads blocked on the socket fail, as they would when it is closed on hardware
+    AbortCalls(socket_handle);
     ret = closesocket(socket_handle);
 
     if (ret != 0)
@@ -575,24 +644,48 @@ void SOC_U::SendTo(Kernel::HLERequestContext& ctx) {
     auto input_buff = rp.PopStaticBuffer();
     auto dest_addr_buff = rp.PopStaticBuffer();
 
-    s32 ret = -1;
+    auto call = std::make_shared<BlockedCall>();
+    call->data = std::move(input_buff);
     if (addr_len > 0) {
         CTRSockAddr ctr_dest_addr;
         std::memcpy(&ctr_dest_addr, dest_addr_buff.data(), sizeof(ctr_dest_addr));
-        sockaddr dest_addr = CTRSockAddr::ToPlatform(ctr_dest_addr);
-        ret = ::sendto(socket_handle, reinterpret_cast<const char*>(input_buff.data()), len, flags,
-                       &dest_addr, sizeof(dest_addr));
-    } else {
-        ret = ::sendto(socket_handle, reinterpret_cast<const char*>(input_buff.data()), len, flags,
-                       nullptr, 0);
+        call->addr = CTRSockAddr::ToPlatform(ctr_dest_addr);
     }
 
-    if (ret == SOCKET_ERROR_VALUE)
-        ret = TranslateError(GET_ERRNO);
+    auto send = [call, socket_handle, len, flags, addr_len] {
+        const char* data = reinterpret_cast<const char*>(call->data.data());
+        if (addr_len > 0) {
+            return call->Finish(
+                ::sendto(socket_handle, data, len, flags, &call->addr, sizeof(call->addr)));
+        }
+        return call->Finish(::sendto(socket_handle, data, len, flags, nullptr, 0));
+    };
+    auto reply = [call](Kernel::HLERequestContext& ctx) {
+        IPC::RequestBuilder rb(ctx, 0x0A, 2, 0);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(call->result);
+    };
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
+    if (send() || !IsBlocking(socket_handle)) {
+        reply(ctx);
+        return;
+    }
+    SleepUntilReady(ctx, "soc:u::SendTo", {{socket_handle, false, true}}, std::move(send),
+                    std::move(call), std::move(reply));
+}
+
+/// Receives from a socket into call->data, and the source address into call->addr if requested
+template <typename Call>
+static bool Receive(Call& call, u32 socket_handle, u32 len, u32 flags, bool want_addr) {
+    char* data = reinterpret_cast<char*>(call.data.data());
+    if (want_addr) {
+        // Only get src adr if input adr available
+        call.addr_len = sizeof(call.addr);
+        return call.Finish(
+            ::recvfrom(socket_handle, data, len, flags, &call.addr, &call.addr_len));
+    }
+    call.addr_len = 0;
+    return call.Finish(::recvfrom(socket_handle, data, len, flags, nullptr, nullptr));
 }
 
 void SOC_U::RecvFromOther(Kernel::HLERequestContext& ctx) {
@@ -602,45 +695,40 @@ void SOC_U::RecvFromOther(Kernel::HLERequestContext& ctx) {
     u32 flags = rp.Pop<u32>();
     u32 addr_len = rp.Pop<u32>();
     rp.PopPID();
-    auto& buffer = rp.PopMappedBuffer();
-
-    CTRSockAddr ctr_src_addr;
-    std::vector<u8> output_buff(len);
-    std::vector<u8> addr_buff(sizeof(ctr_src_addr));
-    sockaddr src_addr;
-    socklen_t src_addr_len = sizeof(src_addr);
+    Kernel::MappedBuffer buffer = rp.PopMappedBuffer();
 
-    s32 ret = -1;
-    if (addr_len > 0) {
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         &src_addr, &src_addr_len);
-        if (ret >= 0 && src_addr_len > 0) {
-            ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
-            std::memcpy(addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
+    auto call = std::make_shared<BlockedCall>();
+    call->data.resize(len);
+    auto receive = [call, socket_handle, len, flags, addr_len] {
+        return Receive(*call, socket_handle, len, flags, addr_len > 0);
+    };
+    auto reply = [call, buffer, addr_len](Kernel::HLERequestContext& ctx) mutable {
+        CTRSockAddr ctr_src_addr;
+        std::vector<u8> addr_buff(addr_len > 0 ? sizeof(ctr_src_addr) : 0);
+        if (call->result >= 0) {
+            if (addr_len > 0 && call->addr_len > 0) {
+                ctr_src_addr = CTRSockAddr::FromPlatform(call->addr);
+                std::memcpy(addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
+            }
+            buffer.Write(call->data.data(), 0, call->result);
         }
-    } else {
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         NULL, 0);
-        addr_buff.resize(0);
-    }
 
-    if (ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(GET_ERRNO);
-    } else {
-        buffer.Write(output_buff.data(), 0, ret);
-    }
+        IPC::RequestBuilder rb(ctx, 0x07, 2, 4);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(call->result);
+        rb.PushStaticBuffer(addr_buff, 0);
+        rb.PushMappedBuffer(buffer);
+    };
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 4);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(addr_buff, 0);
-    rb.PushMappedBuffer(buffer);
+    if (receive() || !IsBlocking(socket_handle)) {
+        reply(ctx);
+        return;
+    }
+    SleepUntilReady(ctx, "soc:u::RecvFromOther", {{socket_handle, true, false}},
+                    std::move(receive), std::move(call), std::move(reply));
 }
 
 void SOC_U::RecvFrom(Kernel::HLERequestContext& ctx) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp(ctx, 0x08, 4, 2);
     u32 socket_handle = rp.Pop<u32>();
     u32 len = rp.Pop<u32>();
@@ -648,42 +736,40 @@ void SOC_U::RecvFrom(Kernel::HLERequestContext& ctx) {
     u32 addr_len = rp.Pop<u32>();
     rp.PopPID();
 
-    CTRSockAddr ctr_src_addr;
-    std::vector<u8> output_buff(len);
-    std::vector<u8> addr_buff(sizeof(ctr_src_addr));
-    sockaddr src_addr;
-    socklen_t src_addr_len = sizeof(src_addr);
-
-    s32 ret = -1;
-    if (addr_len > 0) {
-        // Only get src adr if input adr available
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         &src_addr, &src_addr_len);
-        if (ret >= 0 && src_addr_len > 0) {
-            ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
-            std::memcpy(addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
+    auto call = std::make_shared<BlockedCall>();
+    call->data.resize(len);
+    auto receive = [call, socket_handle, len, flags, addr_len] {
+        return Receive(*call, socket_handle, len, flags, addr_len > 0);
+    };
+    auto reply = [call, addr_len](Kernel::HLERequestContext& ctx) {
+        CTRSockAddr ctr_src_addr;
+        std::vector<u8> addr_buff(addr_len > 0 ? sizeof(ctr_src_addr) : 0);
+        s32 total_received = 0;
+        if (call->result >= 0) {
+            if (addr_len > 0 && call->addr_len > 0) {
+                ctr_src_addr = CTRSockAddr::FromPlatform(call->addr);
+                std::memcpy(addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
+            }
+            total_received = call->result;
         }
-    } else {
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         NULL, 0);
-        addr_buff.resize(0);
-    }
 
-    s32 total_received = ret;
-    if (ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(GET_ERRNO);
-        total_received = 0;
-    }
+        // Write only the data we received to avoid overwriting parts of the buffer with zeros
+        call->data.resize(total_received);
 
-    // Write only the data we received to avoid overwriting parts of the buffer with zeros
-    output_buff.resize(total_received);
+        IPC::RequestBuilder rb(ctx, 0x08, 3, 4);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(call->result);
+        rb.Push(total_received);
+        rb.PushStaticBuffer(call->data, 0);
+        rb.PushStaticBuffer(addr_buff, 1);
+    };
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(3, 4);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.Push(total_received);
-    rb.PushStaticBuffer(output_buff, 0);
-    rb.PushStaticBuffer(addr_buff, 1);
+    if (receive() || !IsBlocking(socket_handle)) {
+        reply(ctx);
+        return;
+    }
+    SleepUntilReady(ctx, "soc:u::RecvFrom", {{socket_handle, true, false}}, std::move(receive),
+                    std::move(call), std::move(reply));
 }
 
 void SOC_U::Poll(Kernel::HLERequestContext& ctx) {
@@ -702,22 +788,47 @@ void SOC_U::Poll(Kernel::HLERequestContext& ctx) {
     std::vector<pollfd> platform_pollfd(nfds);
     std::transform(ctr_fds.begin(), ctr_fds.end(), platform_pollfd.begin(), CTRPollFD::ToPlatform);
 
-    s32 ret = ::poll(platform_pollfd.data(), nfds, timeout);
-
-    // Now update the output pollfd structure
-    std::transform(platform_pollfd.begin(), platform_pollfd.end(), ctr_fds.begin(),
-                   CTRPollFD::FromPlatform);
-
-    std::vector<u8> output_fds(nfds * sizeof(CTRPollFD));
-    std::memcpy(output_fds.data(), ctr_fds.data(), nfds * sizeof(CTRPollFD));
+    // Polls without waiting. The wait itself is left to the reactor, or to the guest's timeout.
+    auto call = std::make_shared<BlockedCall>();
+    auto poll_now = [call, platform_pollfd, nfds]() mutable {
+        s32 ret = poll(platform_pollfd.data(), nfds, 0);
+        if (ret == SOCKET_ERROR_VALUE)
+            ret = TranslateError(GET_ERRNO);
+        call->result = ret;
+
+        // Now update the output pollfd structure
+        std::vector<CTRPollFD> ctr_fds(nfds);
+        std::transform(platform_pollfd.begin(), platform_pollfd.end(), ctr_fds.begin(),
+                       CTRPollFD::FromPlatform);
+        call->data.resize(nfds * sizeof(CTRPollFD));
+        std::memcpy(call->data.data(), ctr_fds.data(), nfds * sizeof(CTRPollFD));
+        return ret != 0;
+    };
+    auto reply = [call, poll_now](Kernel::HLERequestContext& ctx) mutable {
+        if (call->timed_out) {
+            poll_now();
+        }
+        IPC::RequestBuilder rb(ctx, 0x14, 2, 2);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(call->result);
+        rb.PushStaticBuffer(call->data, 0);
+    };
 
-    if (ret == SOCKET_ERROR_VALUE)
-        ret = TranslateError(GET_ERRNO);
+    if (poll_now() || timeout == 0) {
+        reply(ctx);
+        return;
+    }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(output_fds, 0);
+    std::vector<SocketReactor::Watch> watches;
+    for (const pollfd& fd : platform_pollfd) {
+        watches.push_back({static_cast<u32>(fd.fd), (fd.events & (POLLIN | POLLPRI)) != 0,
+                           (fd.events & POLLOUT) != 0});
+    }
+    // A negative timeout waits forever
+    const std::chrono::nanoseconds timeout_ns =
+        timeout > 0 ? std::chrono::milliseconds(timeout) : std::chrono::nanoseconds(0);
+    SleepUntilReady(ctx, "soc:u::Poll", std::move(watches), poll_now, std::move(call),
+                    std::move(reply), timeout_ns);
 }
 
 void SOC_U::GetSockName(Kernel::HLERequestContext& ctx) {
@@ -782,9 +893,6 @@ void SOC_U::GetPeerName(Kernel::HLERequestContext& ctx) {
 }
 
 void SOC_U::Connect(Kernel::HLERequestContext& ctx) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp(ctx, 0x06, 2, 4);
     u32 socket_handle = rp.Pop<u32>();
     u32 input_addr_len = rp.Pop<u32>();
@@ -795,13 +903,38 @@ void SOC_U::Connect(Kernel::HLERequestContext& ctx) {
     std::memcpy(&ctr_input_addr, input_addr_buf.data(), sizeof(ctr_input_addr));
 
     sockaddr input_addr = CTRSockAddr::ToPlatform(ctr_input_addr);
+    auto call = std::make_shared<BlockedCall>();
+    auto reply = [call](Kernel::HLERequestContext& ctx) {
+        IPC::RequestBuilder rb(ctx, 0x06, 2, 0);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(call->result);
+    };
+
     s32 ret = ::connect(socket_handle, &input_addr, sizeof(input_addr));
-    if (ret != 0)
-        ret = TranslateError(GET_ERRNO);
+    if (ret == 0) {
+        reply(ctx);
+        return;
+    }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
+    const int error = GET_ERRNO;
+    if ((error != ERRNO(EINPROGRESS) && error != ERRNO(EWOULDBLOCK)) ||
+        !IsBlocking(socket_handle)) {
+        call->result = TranslateError(error);
+        reply(ctx);
+        return;
+    }
+
+    // The connection completes once the socket becomes writable, successfully or not
+    auto finish_connect = [call, socket_handle] {
+        int connect_error = 0;
+        socklen_t error_len = sizeof(connect_error);
+        ::getsockopt(socket_handle, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&connect_error),
+                     &error_len);
+        call->result = connect_error == 0 ? 0 : TranslateError(connect_error);
+        return true;
+    };
+    SleepUntilReady(ctx, "soc:u::Connect", {{socket_handle, false, true}},
+                    std::move(finish_connect), std::move(call), std::move(reply));
 }
 
 void SOC_U::InitializeSockets(Kernel::HLERequestContext& ctx) {
@@ -977,7 +1110,7 @@ void SOC_U::GetNameInfoImpl(Kernel::HLERequestContext& ctx) {
     rb.PushStaticBuffer(serv, 1);
 }
 
-SOC_U::SOC_U() : ServiceFramework("soc:U") {
+SOC_U::SOC_U(Core::System& system) : ServiceFramework("soc:U"), system(system) {
     static const FunctionInfo functions[] = {
         {0x00010044, &SOC_U::InitializeSockets, "InitializeSockets"},
         {0x000200C2, &SOC_U::Socket, "Socket"},
@@ -1016,6 +1149,12 @@ SOC_U::SOC_U() : ServiceFramework("soc:U") {
 
     RegisterHandlers(functions);
 
+    call_completed_event = system.CoreTiming().RegisterEvent(
+        "SOC_U::CallCompleted", [this](u64 id, int cycles_late) { CallCompleted(id); });
+    reactor = std::make_unique<SocketReactor>([this](u64 id) {
+        this->system.CoreTiming().ScheduleEventThreadsafe(0, call_completed_event, id);
+    });
+
 #ifdef _WIN32
     WSADATA data;
     WSAStartup(MAKEWORD(2, 2), &data);
@@ -1023,6 +1162,9 @@ SOC_U::SOC_U() : ServiceFramework("soc:U") {
 }
 
 SOC_U::~SOC_U() {
+    // Stops the reactor thread before the sockets it watches are closed
+    reactor.reset();
+    system.CoreTiming().RemoveNormalAndThreadsafeEvent(call_completed_event);
     CleanupSockets();
 #ifdef _WIN32
     WSACleanup();
@@ -1031,7 +1173,7 @@ SOC_U::~SOC_U() {
 
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
-    std::make_shared<SOC_U>()->InstallAsService(service_manager);
+    std::make_shared<SOC_U>(system)->InstallAsService(service_manager);
 }
 
 } // namespace Service::SOC
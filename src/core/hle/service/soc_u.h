@@ -4,27 +4,37 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 #include "core/hle/service/service.h"
+#include "core/hle/service/soc_reactor.h"
 
 namespace Core {
 class System;
-}
+struct TimingEventType;
+} // namespace Core
 
 namespace Service::SOC {
 
 /// Holds information about a particular socket
 struct SocketHolder {
     u32 socket_fd; ///< The socket descriptor
-    bool blocking; ///< Whether the socket is blocking or not, it is only read on Windows.
+    bool blocking; ///< Whether the socket is blocking for the guest. Host sockets never block.
 };
 
 class SOC_U final : public ServiceFramework<SOC_U> {
 public:
-    SOC_U();
+    explicit SOC_U(Core::System& system);
     ~SOC_U();
 
 private:
+    /// State of a guest call that may have to wait for its socket to become ready
+    struct BlockedCall;
+    using Reply = std::function<void(Kernel::HLERequestContext& ctx)>;
+
     void Socket(Kernel::HLERequestContext& ctx);
     void Bind(Kernel::HLERequestContext& ctx);
     void Fcntl(Kernel::HLERequestContext& ctx);
@@ -53,8 +63,36 @@ private:
     /// Close all open sockets
     void CleanupSockets();
 
+    /// Returns whether calls on the socket should wait until they can complete
+    bool IsBlocking(u32 socket_handle) const;
+
+    /**
+     * Puts the guest thread to sleep until the reactor completes the operation, then calls reply
+     * to write the response.
+     * @param timeout time after which the call is given up on, or 0 to wait forever
+     */
+    void SleepUntilReady(Kernel::HLERequestContext& ctx, const char* reason,
+                         std::vector<SocketReactor::Watch> watches,
+                         SocketReactor::Operation operation, std::shared_ptr<BlockedCall> call,
+                         Reply reply, std::chrono::nanoseconds timeout = {});
+
+    /// Wakes up the guest thread waiting for the given reactor operation
+    void CallCompleted(u64 id);
+
+    /// Wakes up the guest threads waiting on a socket that is being closed
+    void AbortCalls(u32 socket_handle);
+
+    Core::System& system;
+
     /// Holds info about the currently open sockets
     std::unordered_map<u32, SocketHolder> open_sockets;
+
+    /// Guest calls waiting for the reactor, by operation id
+    std::unordered_map<u64, std::shared_ptr<BlockedCall>> blocked_calls;
+    Core::TimingEventType* call_completed_event;
+
+    /// Destroyed first, so that it stops calling back into the service
+    std::unique_ptr<SocketReactor> reactor;
 };
 
 void InstallInterfaces(Core::System& system);
@@ -3,42 +3,58 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
-#include <cryptopp/aes.h>
-#include <cryptopp/ccm.h>
-#include <cryptopp/cryptlib.h>
-#include <cryptopp/filters.h>
+#include <cstring>
 #include "common/alignment.h"
 #include "common/logging/log.h"
 #include "core/hw/aes/ccm.h"
+#include "core/hw/aes/cipher.h"
 #include "core/hw/aes/key.h"
 
 namespace HW::AES {
 
 namespace {
 
-// 3DS uses a non-standard AES-CCM algorithm, so we need to derive a sub class from the standard one
-// and override with the non-standard part.
-using CryptoPP::AES;
-using CryptoPP::CCM_Base;
-using CryptoPP::CCM_Final;
-using CryptoPP::lword;
-template <bool T_IsEncryption>
-class CCM_3DSVariant_Final : public CCM_Final<AES, CCM_MAC_SIZE, T_IsEncryption> {
-public:
-    void UncheckedSpecifyDataLengths(lword header_length, lword message_length,
-                                     lword footer_length) override {
-        // 3DS uses the aligned size to generate B0 for authentication, instead of the original size
-        lword aligned_message_length = Common::AlignUp(message_length, AES_BLOCK_SIZE);
-        CCM_Base::UncheckedSpecifyDataLengths(header_length, aligned_message_length, footer_length);
-        CCM_Base::m_messageLength = message_length; // restore the actual message size
+// The counter size that goes with a 12-byte nonce
+constexpr std::size_t CCM_LENGTH_SIZE = AES_BLOCK_SIZE - 1 - CCM_NONCE_SIZE;
+
+/**
+ * Computes the CCM MAC of the given plain text. 3DS uses a non-standard AES-CCM variant, which
+ * puts the size aligned to the block size in B0, instead of the original size.
+ */
+AESKey ComputeCCMMAC(const AESKey& key, const CCMNonce& nonce, const u8* pdata, std::size_t size) {
+    const std::size_t aligned_size = Common::AlignUp(size, AES_BLOCK_SIZE);
+
+    AESKey b0;
+    b0[0] = ((CCM_MAC_SIZE - 2) / 2) << 3 | (CCM_LENGTH_SIZE - 1);
+    std::copy(nonce.begin(), nonce.end(), b0.begin() + 1);
+    for (std::size_t i = 0; i < CCM_LENGTH_SIZE; ++i) {
+        b0[AES_BLOCK_SIZE - 1 - i] = static_cast<u8>(aligned_size >> (8 * i));
+    }
+
+    CBCEncryptor mac(key, {});
+    AESKey block;
+    mac.Process(b0.data(), block.data(), AES_BLOCK_SIZE);
+
+    // The MAC is just the last encrypted block, so the data is encrypted a block at a time
+    const std::size_t whole_size = size - size % AES_BLOCK_SIZE;
+    for (std::size_t offset = 0; offset < whole_size; offset += AES_BLOCK_SIZE) {
+        mac.Process(pdata + offset, block.data(), AES_BLOCK_SIZE);
+    }
+    if (whole_size != size) {
+        block = {};
+        std::memcpy(block.data(), pdata + whole_size, size - whole_size);
+        mac.Process(block.data(), block.data(), AES_BLOCK_SIZE);
     }
-};
+    return mac.GetChain();
+}
 
-class CCM_3DSVariant {
-public:
-    using Encryption = CCM_3DSVariant_Final<true>;
-    using Decryption = CCM_3DSVariant_Final<false>;
-};
+/// Returns the counter block A0. The payload is encrypted starting from A1.
+AESKey GetCCMCounter(const CCMNonce& nonce) {
+    AESKey ctr{};
+    ctr[0] = CCM_LENGTH_SIZE - 1;
+    std::copy(nonce.begin(), nonce.end(), ctr.begin() + 1);
+    return ctr;
+}
 
 } // namespace
 
@@ -50,16 +66,11 @@ std::vector<u8> EncryptSignCCM(const std::vector<u8>& pdata, const CCMNonce& non
     const AESKey normal = GetNormalKey(slot_id);
     std::vector<u8> cipher(pdata.size() + CCM_MAC_SIZE);
 
-    try {
-        CCM_3DSVariant::Encryption e;
-        e.SetKeyWithIV(normal.data(), AES_BLOCK_SIZE, nonce.data(), CCM_NONCE_SIZE);
-        e.SpecifyDataLengths(0, pdata.size(), 0);
-        CryptoPP::ArraySource as(pdata.data(), pdata.size(), true,
-                                 new CryptoPP::AuthenticatedEncryptionFilter(
-                                     e, new CryptoPP::ArraySink(cipher.data(), cipher.size())));
-    } catch (const CryptoPP::Exception& e) {
-        LOG_ERROR(HW_AES, "FAILED with: {}", e.what());
-    }
+    AESKey mac = ComputeCCMMAC(normal, nonce, pdata.data(), pdata.size());
+    CTRCipher ctr(normal, GetCCMCounter(nonce));
+    ctr.Process(mac.data(), AES_BLOCK_SIZE);
+    ctr.Process(pdata.data(), cipher.data(), pdata.size());
+    std::copy(mac.begin(), mac.end(), cipher.begin() + pdata.size());
     return cipher;
 }
 
@@ -69,22 +80,21 @@ std::vector<u8> DecryptVerifyCCM(const std::vector<u8>& cipher, const CCMNonce&
         LOG_ERROR(HW_AES, "Key slot {} not available. Will use zero key.", slot_id);
     }
     const AESKey normal = GetNormalKey(slot_id);
+    if (cipher.size() < CCM_MAC_SIZE) {
+        LOG_ERROR(HW_AES, "FAILED");
+        return {};
+    }
     const std::size_t pdata_size = cipher.size() - CCM_MAC_SIZE;
     std::vector<u8> pdata(pdata_size);
 
-    try {
-        CCM_3DSVariant::Decryption d;
-        d.SetKeyWithIV(normal.data(), AES_BLOCK_SIZE, nonce.data(), CCM_NONCE_SIZE);
-        d.SpecifyDataLengths(0, pdata_size, 0);
-        CryptoPP::AuthenticatedDecryptionFilter df(
-            d, new CryptoPP::ArraySink(pdata.data(), pdata_size));
-        CryptoPP::ArraySource as(cipher.data(), cipher.size(), true, new CryptoPP::Redirector(df));
-        if (!df.GetLastResult()) {
-            LOG_ERROR(HW_AES, "FAILED");
-            return {};
-        }
-    } catch (const CryptoPP::Exception& e) {
-        LOG_ERROR(HW_AES, "FAILED with: {}", e.what());
+    AESKey mac;
+    std::copy(cipher.begin() + pdata_size, cipher.end(), mac.begin());
+    CTRCipher ctr(normal, GetCCMCounter(nonce));
+    ctr.Process(mac.data(), AES_BLOCK_SIZE);
+    ctr.Process(cipher.data(), pdata.data(), pdata_size);
+
+    if (mac != ComputeCCMMAC(normal, nonce, pdata.data(), pdata_size)) {
+        LOG_ERROR(HW_AES, "FAILED");
         return {};
     }
     return pdata;
@@ -0,0 +1,465 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+#ifdef ARCHITECTURE_x86_64
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#include "common/x64/cpu_detect.h"
+#endif
+#include "common/swap.h"
+#include "common/thread_worker.h"
+#include "core/hw/aes/cipher.h"
+
+namespace HW::AES {
+
+namespace {
+
+/// Buffers at least this large are split across threads
+constexpr std::size_t parallel_size = 4 * 1024 * 1024;
+/// Maximum number of worker threads used for a single buffer
+constexpr std::size_t max_workers = 8;
+
+/**
+ * Calls func(begin, end) for chunks of [0, num_blocks) in parallel, and waits for all of them to
+ * finish.
+ */
+void ParallelForBlocks(std::size_t num_blocks,
+                       const std::function<void(std::size_t, std::size_t)>& func) {
+    static const std::size_t num_workers =
+        std::min<std::size_t>(std::thread::hardware_concurrency(), max_workers);
+    if (num_workers <= 1) {
+        func(0, num_blocks);
+        return;
+    }
+
+    // The pool is shared by all ciphers, so only one buffer is split across it at a time
+    static std::mutex pool_mutex;
+    static Common::ThreadWorker pool(num_workers - 1, "AES");
+    std::lock_guard lock(pool_mutex);
+
+    const std::size_t chunk_blocks = (num_blocks + num_workers - 1) / num_workers;
+    for (std::size_t begin = chunk_blocks; begin < num_blocks; begin += chunk_blocks) {
+        const std::size_t end = std::min(begin + chunk_blocks, num_blocks);
+        pool.QueueWork([&func, begin, end] { func(begin, end); });
+    }
+    func(0, std::min(chunk_blocks, num_blocks));
+    pool.WaitForRequests();
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+// The AES-NI kernels are selected at runtime, so they are compiled for it regardless of the flags
+// the rest of the file is compiled with.
+#ifdef _MSC_VER
+#define TARGET_AES
+#else
+#define TARGET_AES __attribute__((target("aes,ssse3")))
+#endif
+
+/// Number of blocks processed at once, to keep the AES unit's pipeline busy
+constexpr std::size_t interleave = 8;
+
+/// Round keys loaded into registers. (std::array would drop the vector type's alignment.)
+struct KeySchedule {
+    __m128i keys[11];
+
+    const __m128i& operator[](std::size_t round) const {
+        return keys[round];
+    }
+    __m128i& operator[](std::size_t round) {
+        return keys[round];
+    }
+};
+
+bool HasAESNI() {
+    static const bool has_aesni = Common::GetCPUCaps().aes;
+    return has_aesni;
+}
+
+template <int rcon>
+TARGET_AES __m128i ExpandKeyStep(__m128i key) {
+    const __m128i assist = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(key, rcon), 0xFF);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+
+TARGET_AES void ExpandKey(const AESKey& key, RoundKeys& round_keys) {
+    KeySchedule rk;
+    rk[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key.data()));
+    rk[1] = ExpandKeyStep<0x01>(rk[0]);
+    rk[2] = ExpandKeyStep<0x02>(rk[1]);
+    rk[3] = ExpandKeyStep<0x04>(rk[2]);
+    rk[4] = ExpandKeyStep<0x08>(rk[3]);
+    rk[5] = ExpandKeyStep<0x10>(rk[4]);
+    rk[6] = ExpandKeyStep<0x20>(rk[5]);
+    rk[7] = ExpandKeyStep<0x40>(rk[6]);
+    rk[8] = ExpandKeyStep<0x80>(rk[7]);
+    rk[9] = ExpandKeyStep<0x1B>(rk[8]);
+    rk[10] = ExpandKeyStep<0x36>(rk[9]);
+    std::memcpy(round_keys.data(), rk.keys, sizeof(rk.keys));
+}
+
+/// Turns an encryption key schedule into one for the equivalent inverse cipher
+TARGET_AES void InvertRoundKeys(RoundKeys& round_keys) {
+    KeySchedule rk;
+    std::memcpy(rk.keys, round_keys.data(), sizeof(rk.keys));
+    KeySchedule inverse;
+    inverse[0] = rk[10];
+    for (std::size_t i = 1; i < 10; ++i) {
+        inverse[i] = _mm_aesimc_si128(rk[10 - i]);
+    }
+    inverse[10] = rk[0];
+    std::memcpy(round_keys.data(), inverse.keys, sizeof(inverse.keys));
+}
+
+TARGET_AES KeySchedule LoadRoundKeys(const RoundKeys& round_keys) {
+    KeySchedule rk;
+    std::memcpy(rk.keys, round_keys.data(), sizeof(rk.keys));
+    return rk;
+}
+
+// The blocks are processed a round at a time, so that the rounds of independent blocks overlap.
+// The expansion over the blocks is spelled out so it doesn't depend on the optimizer unrolling it.
+template <std::size_t... I>
+TARGET_AES void EncryptBlocks(const KeySchedule& rk, __m128i* blocks, std::index_sequence<I...>) {
+    ((blocks[I] = _mm_xor_si128(blocks[I], rk[0])), ...);
+    for (std::size_t round = 1; round < 10; ++round) {
+        ((blocks[I] = _mm_aesenc_si128(blocks[I], rk[round])), ...);
+    }
+    ((blocks[I] = _mm_aesenclast_si128(blocks[I], rk[10])), ...);
+}
+
+template <std::size_t... I>
+TARGET_AES void DecryptBlocks(const KeySchedule& rk, __m128i* blocks, std::index_sequence<I...>) {
+    ((blocks[I] = _mm_xor_si128(blocks[I], rk[0])), ...);
+    for (std::size_t round = 1; round < 10; ++round) {
+        ((blocks[I] = _mm_aesdec_si128(blocks[I], rk[round])), ...);
+    }
+    ((blocks[I] = _mm_aesdeclast_si128(blocks[I], rk[10])), ...);
+}
+
+template <std::size_t N>
+TARGET_AES void EncryptBlocks(const KeySchedule& rk, __m128i (&blocks)[N]) {
+    EncryptBlocks(rk, blocks, std::make_index_sequence<N>());
+}
+
+template <std::size_t N>
+TARGET_AES void DecryptBlocks(const KeySchedule& rk, __m128i (&blocks)[N]) {
+    DecryptBlocks(rk, blocks, std::make_index_sequence<N>());
+}
+
+TARGET_AES __m128i LoadBlock(const u8* data) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+TARGET_AES void StoreBlock(u8* data, __m128i block) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(data), block);
+}
+
+/// Generates the counter blocks for CTR mode: ctr + block index, as a 128-bit big-endian integer
+class CounterGenerator {
+public:
+    TARGET_AES CounterGenerator(const AESKey& ctr, u64 block) {
+        u64 ctr_high, ctr_low;
+        std::memcpy(&ctr_high, ctr.data(), sizeof(u64));
+        std::memcpy(&ctr_low, ctr.data() + sizeof(u64), sizeof(u64));
+        ctr_high = Common::swap64(ctr_high);
+        ctr_low = Common::swap64(ctr_low);
+        low = ctr_low + block;
+        const u64 high = ctr_high + (low < ctr_low ? 1 : 0);
+        counter = _mm_set_epi64x(static_cast<s64>(high), static_cast<s64>(low));
+    }
+
+    /// Returns the next N counter blocks
+    template <std::size_t N>
+    TARGET_AES void Next(__m128i (&blocks)[N]) {
+        if (low > ~u64(0) - N) {
+            // The low half wraps around somewhere in these blocks
+            for (auto& block : blocks) {
+                block = Next();
+            }
+            return;
+        }
+        for (std::size_t i = 0; i < N; ++i) {
+            blocks[i] = _mm_shuffle_epi8(_mm_add_epi64(counter, _mm_set_epi64x(0, i)), ByteSwap());
+        }
+        counter = _mm_add_epi64(counter, _mm_set_epi64x(0, N));
+        low += N;
+    }
+
+    TARGET_AES __m128i Next() {
+        const __m128i block = _mm_shuffle_epi8(counter, ByteSwap());
+        // Carry into the high half when the low half wraps around
+        counter = _mm_add_epi64(counter, _mm_set_epi64x(++low == 0 ? 1 : 0, 1));
+        return block;
+    }
+
+private:
+    /// Shuffle that turns the little-endian counter into a big-endian block
+    static TARGET_AES __m128i ByteSwap() {
+        return _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    }
+
+    /// The counter, with the low half in the low lane
+    __m128i counter;
+    u64 low;
+};
+
+/// XORs length bytes of the keystream block, starting at skip, into out
+TARGET_AES void XorPartialBlock(__m128i keystream, std::size_t skip, std::size_t length,
+                                const u8* in, u8* out) {
+    alignas(16) std::array<u8, AES_BLOCK_SIZE> bytes;
+    StoreBlock(bytes.data(), keystream);
+    for (std::size_t i = 0; i < length; ++i) {
+        out[i] = in[i] ^ bytes[skip + i];
+    }
+}
+
+TARGET_AES void CTRProcessAESNI(const RoundKeys& round_keys, const AESKey& ctr, u64 offset,
+                                const u8* in, u8* out, std::size_t size) {
+    const auto rk = LoadRoundKeys(round_keys);
+    CounterGenerator counter(ctr, offset / AES_BLOCK_SIZE);
+
+    // Finish the block the offset is in the middle of
+    const std::size_t skip = offset % AES_BLOCK_SIZE;
+    if (skip != 0) {
+        const std::size_t length = std::min(size, AES_BLOCK_SIZE - skip);
+        __m128i keystream[1] = {counter.Next()};
+        EncryptBlocks(rk, keystream);
+        XorPartialBlock(keystream[0], skip, length, in, out);
+        in += length;
+        out += length;
+        size -= length;
+    }
+
+    while (size >= AES_BLOCK_SIZE * interleave) {
+        __m128i keystream[interleave];
+        counter.Next(keystream);
+        EncryptBlocks(rk, keystream);
+        for (std::size_t i = 0; i < interleave; ++i) {
+            StoreBlock(out + i * AES_BLOCK_SIZE,
+                       _mm_xor_si128(keystream[i], LoadBlock(in + i * AES_BLOCK_SIZE)));
+        }
+        in += AES_BLOCK_SIZE * interleave;
+        out += AES_BLOCK_SIZE * interleave;
+        size -= AES_BLOCK_SIZE * interleave;
+    }
+
+    while (size != 0) {
+        __m128i keystream[1] = {counter.Next()};
+        EncryptBlocks(rk, keystream);
+        const std::size_t length = std::min(size, AES_BLOCK_SIZE);
+        if (length == AES_BLOCK_SIZE) {
+            StoreBlock(out, _mm_xor_si128(keystream[0], LoadBlock(in)));
+        } else {
+            XorPartialBlock(keystream[0], 0, length, in, out);
+        }
+        in += length;
+        out += length;
+        size -= length;
+    }
+}
+
+TARGET_AES void CBCDecryptAESNI(const RoundKeys& round_keys, const AESKey& iv, const u8* in,
+                                u8* out, std::size_t num_blocks) {
+    const auto rk = LoadRoundKeys(round_keys);
+    __m128i chain = LoadBlock(iv.data());
+
+    // Each block only depends on the previous cipher text, so the blocks are decrypted in
+    // parallel. The cipher text is loaded before anything is stored, for in-place decryption.
+    while (num_blocks >= interleave) {
+        __m128i cipher[interleave];
+        __m128i blocks[interleave];
+        for (std::size_t i = 0; i < interleave; ++i) {
+            cipher[i] = blocks[i] = LoadBlock(in + i * AES_BLOCK_SIZE);
+        }
+        DecryptBlocks(rk, blocks);
+        StoreBlock(out, _mm_xor_si128(blocks[0], chain));
+        for (std::size_t i = 1; i < interleave; ++i) {
+            StoreBlock(out + i * AES_BLOCK_SIZE, _mm_xor_si128(blocks[i], cipher[i - 1]));
+        }
+        chain = cipher[interleave - 1];
+        in += AES_BLOCK_SIZE * interleave;
+        out += AES_BLOCK_SIZE * interleave;
+        num_blocks -= interleave;
+    }
+
+    for (; num_blocks != 0; --num_blocks) {
+        const __m128i cipher = LoadBlock(in);
+        __m128i block[1] = {cipher};
+        DecryptBlocks(rk, block);
+        StoreBlock(out, _mm_xor_si128(block[0], chain));
+        chain = cipher;
+        in += AES_BLOCK_SIZE;
+        out += AES_BLOCK_SIZE;
+    }
+}
+
+TARGET_AES void CBCEncryptAESNI(const RoundKeys& round_keys, AESKey& iv, const u8* in, u8* out,
+                                std::size_t num_blocks) {
+    const auto rk = LoadRoundKeys(round_keys);
+    __m128i block[1] = {LoadBlock(iv.data())};
+    for (; num_blocks != 0; --num_blocks) {
+        block[0] = _mm_xor_si128(block[0], LoadBlock(in));
+        EncryptBlocks(rk, block);
+        StoreBlock(out, block[0]);
+        in += AES_BLOCK_SIZE;
+        out += AES_BLOCK_SIZE;
+    }
+    StoreBlock(iv.data(), block[0]);
+}
+
+#else
+
+bool HasAESNI() {
+    return false;
+}
+
+#endif // ARCHITECTURE_x86_64
+
+} // Anonymous namespace
+
+bool IsHardwareAccelerated() {
+    return HasAESNI();
+}
+
+CTRCipher::CTRCipher(const AESKey& key, const AESKey& ctr) : key(key), ctr(ctr) {
+#ifdef ARCHITECTURE_x86_64
+    if (HasAESNI()) {
+        ExpandKey(key, round_keys);
+    }
+#endif
+}
+
+void CTRCipher::Seek(u64 offset) {
+    position = offset;
+}
+
+void CTRCipher::Process(const u8* in, u8* out, std::size_t size) {
+    if (size >= parallel_size) {
+        // Chunks start on block boundaries, except for the first one
+        const u64 first_size = AES_BLOCK_SIZE - position % AES_BLOCK_SIZE;
+        const std::size_t num_blocks = (size - first_size + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE;
+        ProcessAt(position, in, out, first_size);
+        ParallelForBlocks(num_blocks, [&](std::size_t begin, std::size_t end) {
+            const std::size_t chunk_offset = first_size + begin * AES_BLOCK_SIZE;
+            const std::size_t chunk_size =
+                std::min(end * AES_BLOCK_SIZE, size - first_size) - begin * AES_BLOCK_SIZE;
+            ProcessAt(position + chunk_offset, in + chunk_offset, out + chunk_offset, chunk_size);
+        });
+    } else {
+        ProcessAt(position, in, out, size);
+    }
+    position += size;
+}
+
+void CTRCipher::ProcessAt(u64 offset, const u8* in, u8* out, std::size_t size) const {
+#ifdef ARCHITECTURE_x86_64
+    if (HasAESNI()) {
+        CTRProcessAESNI(round_keys, ctr, offset, in, out, size);
+        return;
+    }
+#endif
+    CryptoPP::CTR_Mode<CryptoPP::AES>::Encryption e(key.data(), key.size(), ctr.data());
+    e.Seek(offset);
+    e.ProcessData(out, in, size);
+}
+
+CBCDecryptor::CBCDecryptor(const AESKey& key, const AESKey& iv) : key(key), iv(iv) {
+#ifdef ARCHITECTURE_x86_64
+    if (HasAESNI()) {
+        ExpandKey(key, round_keys);
+        InvertRoundKeys(round_keys);
+    }
+#endif
+}
+
+void CBCDecryptor::Process(const u8* in, u8* out, std::size_t size) {
+    const std::size_t num_blocks = size / AES_BLOCK_SIZE;
+    if (num_blocks == 0)
+        return;
+
+    // The last cipher text block chains into the next call. Save it before it is overwritten.
+    AESKey next_iv;
+    std::memcpy(next_iv.data(), in + (num_blocks - 1) * AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+
+    if (size >= parallel_size) {
+        // Each chunk starts from the cipher text block before it, which has to be saved before
+        // other chunks decrypt it in place.
+        constexpr std::size_t max_chunks = max_workers;
+        const std::size_t chunk_blocks = (num_blocks + max_chunks - 1) / max_chunks;
+        std::vector<AESKey> chains;
+        for (std::size_t begin = 0; begin < num_blocks; begin += chunk_blocks) {
+            AESKey& chain = chains.emplace_back();
+            if (begin == 0) {
+                chain = iv;
+            } else {
+                std::memcpy(chain.data(), in + (begin - 1) * AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+            }
+        }
+        ParallelForBlocks(chains.size(), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t chunk = begin; chunk < end; ++chunk) {
+                const std::size_t first_block = chunk * chunk_blocks;
+                const std::size_t chunk_size =
+                    (std::min(first_block + chunk_blocks, num_blocks) - first_block) *
+                    AES_BLOCK_SIZE;
+                ProcessBlocks(chains[chunk], in + first_block * AES_BLOCK_SIZE,
+                              out + first_block * AES_BLOCK_SIZE, chunk_size);
+            }
+        });
+    } else {
+        ProcessBlocks(iv, in, out, num_blocks * AES_BLOCK_SIZE);
+    }
+    iv = next_iv;
+}
+
+void CBCDecryptor::ProcessBlocks(const AESKey& chain, const u8* in, u8* out,
+                                 std::size_t size) const {
+#ifdef ARCHITECTURE_x86_64
+    if (HasAESNI()) {
+        CBCDecryptAESNI(round_keys, chain, in, out, size / AES_BLOCK_SIZE);
+        return;
+    }
+#endif
+    CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption d(key.data(), key.size(), chain.data());
+    d.ProcessData(out, in, size);
+}
+
+CBCEncryptor::CBCEncryptor(const AESKey& key, const AESKey& iv) : key(key), iv(iv) {
+#ifdef ARCHITECTURE_x86_64
+    if (HasAESNI()) {
+        ExpandKey(key, round_keys);
+    }
+#endif
+}
+
+void CBCEncryptor::Process(const u8* in, u8* out, std::size_t size) {
+    const std::size_t num_blocks = size / AES_BLOCK_SIZE;
+    if (num_blocks == 0)
+        return;
+
+#ifdef ARCHITECTURE_x86_64
+    if (HasAESNI()) {
+        CBCEncryptAESNI(round_keys, iv, in, out, num_blocks);
+        return;
+    }
+#endif
+    CryptoPP::CBC_Mode<CryptoPP::AES>::Encryption e(key.data(), key.size(), iv.data());
+    e.ProcessData(out, in, num_blocks * AES_BLOCK_SIZE);
+    std::memcpy(iv.data(), out + (num_blocks - 1) * AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+}
+
+} // namespace HW::AES
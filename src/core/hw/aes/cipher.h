@@ -0,0 +1,90 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "common/common_types.h"
+#include "core/hw/aes/key.h"
+
+namespace HW::AES {
+
+/**
+ * Expanded AES-128 key schedule. When the host supports AES-NI, the ciphers below run on it using
+ * this schedule; otherwise they fall back to Crypto++. Unlike the Crypto++ modes, these are cheap
+ * to create, and split large buffers across threads where the mode allows it.
+ */
+using RoundKeys = std::array<u8, AES_BLOCK_SIZE * 11>;
+
+/// AES-128 in counter mode, with a 128-bit big-endian counter. Encryption and decryption are the
+/// same operation.
+class CTRCipher {
+public:
+    CTRCipher(const AESKey& key, const AESKey& ctr);
+
+    /// Moves to the given byte offset into the keystream
+    void Seek(u64 offset);
+
+    /// Encrypts or decrypts size bytes from in to out (which may be the same buffer)
+    void Process(const u8* in, u8* out, std::size_t size);
+
+    void Process(u8* data, std::size_t size) {
+        Process(data, data, size);
+    }
+
+private:
+    void ProcessAt(u64 offset, const u8* in, u8* out, std::size_t size) const;
+
+    AESKey key;
+    AESKey ctr;
+    RoundKeys round_keys{};
+    u64 position = 0;
+};
+
+/// AES-128 in CBC mode, decrypting. The chain continues across calls.
+class CBCDecryptor {
+public:
+    CBCDecryptor(const AESKey& key, const AESKey& iv);
+
+    /**
+     * Decrypts size bytes from in to out (which may be the same buffer). Trailing bytes that don't
+     * fill a whole block are left as they are.
+     */
+    void Process(const u8* in, u8* out, std::size_t size);
+
+private:
+    void ProcessBlocks(const AESKey& chain, const u8* in, u8* out, std::size_t size) const;
+
+    AESKey key;
+    AESKey iv;
+    RoundKeys round_keys{};
+};
+
+/// AES-128 in CBC mode, encrypting. The chain continues across calls.
+class CBCEncryptor {
+public:
+    CBCEncryptor(const AESKey& key, const AESKey& iv);
+
+    /**
+     * Encrypts size bytes from in to out (which may be the same buffer). Trailing bytes that don't
+     * fill a whole block are left as they are.
+     */
+    void Process(const u8* in, u8* out, std::size_t size);
+
+    /// Returns the last encrypted block, which is the CBC-MAC of the data processed so far
+    const AESKey& GetChain() const {
+        return iv;
+    }
+
+private:
+    AESKey key;
+    AESKey iv;
+    RoundKeys round_keys{};
+};
+
+/// Returns whether the ciphers run on AES-NI
+bool IsHardwareAccelerated();
+
+} // namespace HW::AES
@@ -5,6 +5,7 @@
 #include <cstring>
 #include <numeric>
 #include <type_traits>
+#include <vector>
 #include "common/alignment.h"
 #include "common/color.h"
 #include "common/common_types.h"
@@ -15,10 +16,12 @@
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
 #include "core/hw/hw.h"
+#include "core/hw/lcd.h"
 #include "core/memory.h"
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/utils.h"
@@ -33,6 +36,26 @@ Memory::MemorySystem* g_memory;
 const u64 frame_ticks = static_cast<u64>(BASE_CLOCK_RATE_ARM11 / SCREEN_REFRESH_RATE);
 /// Event id for CoreTiming
 static Core::TimingEventType* vblank_event;
+/// Event id for interrupts raised on the GPU thread
+static Core::TimingEventType* interrupt_event;
+/// Event ids for the completion of memory fills and display transfers queued on the GPU thread
+static Core::TimingEventType* memory_fill_finished_event;
+static Core::TimingEventType* display_transfer_finished_event;
+/// Fence of the last buffer swap queued on the GPU thread
+static u64 last_swap_fence;
+
+/**
+ * Runs the completion of a memory fill or display transfer on the emulation thread, once the
+ * GPU is done with it. The guest polls the trigger and finished flags to know when it can use the
+ * memory, so they must not be updated before the work has been executed.
+ */
+static void FinishOnEmulationThread(Core::TimingEventType* event, u64 userdata) {
+    if (VideoCore::g_gpu_thread && VideoCore::g_gpu_thread->IsGPUThread()) {
+        Core::System::GetInstance().CoreTiming().ScheduleEventThreadsafe(0, event, userdata);
+        return;
+    }
+    event->callback(userdata, 0);
+}
 
 template <typename T>
 inline void Read(T& var, const u32 raw_addr) {
@@ -407,24 +430,18 @@ inline void Write(u32 addr, const T data) {
         auto& config = g_regs.memory_fill_config[is_second_filler];
 
         if (config.trigger) {
-            MemoryFill(config);
             LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}", config.GetStartAddress(),
                       config.GetEndAddress());
 
-            // It seems that it won't signal interrupt if "address_start" is zero.
-            // TODO: hwtest this
-            if (config.GetStartAddress() != 0) {
-                if (!is_second_filler) {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
-                } else {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
-                }
-            }
+            VideoCore::RunGPUCommand([config = Regs::MemoryFillConfig(config), is_second_filler] {
+                MemoryFill(config);
 
-            // Reset "trigger" flag and set the "finish" flag
-            // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
-            config.trigger.Assign(0);
-            config.finished.Assign(1);
+                // It seems that it won't signal interrupt if "address_start" is zero.
+                // TODO: hwtest this
+                const bool signal_interrupt = config.GetStartAddress() != 0;
+                FinishOnEmulationThread(memory_fill_finished_event,
+                                        (is_second_filler ? 1 : 0) | (signal_interrupt ? 2 : 0));
+            });
         }
         break;
     }
@@ -440,7 +457,10 @@ inline void Write(u32 addr, const T data) {
                                                nullptr);
 
             if (config.is_texture_copy) {
-                TextureCopy(config);
+                VideoCore::RunGPUCommand([config = Regs::DisplayTransferConfig(config)] {
+                    TextureCopy(config);
+                    FinishOnEmulationThread(display_transfer_finished_event, 0);
+                });
                 LOG_TRACE(HW_GPU,
                           "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
                           "{:#010X}({}+{}), flags {:#010X}",
@@ -449,7 +469,10 @@ inline void Write(u32 addr, const T data) {
                           config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
                           config.texture_copy.output_gap * 16, config.flags);
             } else {
-                DisplayTransfer(config);
+                VideoCore::RunGPUCommand([config = Regs::DisplayTransferConfig(config)] {
+                    DisplayTransfer(config);
+                    FinishOnEmulationThread(display_transfer_finished_event, 0);
+                });
                 LOG_TRACE(HW_GPU,
                           "DisplayTransfer: {:#010X}({}x{})-> "
                           "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
@@ -458,9 +481,6 @@ inline void Write(u32 addr, const T data) {
                           config.output_width.Value(), config.output_height.Value(),
                           static_cast<u32>(config.output_format.Value()), config.flags);
             }
-
-            g_regs.display_transfer_config.trigger = 0;
-            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
         }
         break;
     }
@@ -478,7 +498,18 @@ inline void Write(u32 addr, const T data) {
                                                                 config.GetPhysicalAddress());
             }
 
-            Pica::CommandProcessor::ProcessCommandList(buffer, config.size);
+            if (VideoCore::g_gpu_thread) {
+                // Copy the list, so that the guest can't modify it while it is still queued
+                std::vector<u32> list(buffer, buffer + config.size / sizeof(u32));
+                VideoCore::g_gpu_thread->PushCommand([list = std::move(list)] {
+                    MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
+                    Pica::CommandProcessor::ProcessCommandList(list.data(),
+                                                               static_cast<u32>(list.size() *
+                                                                                sizeof(u32)));
+                });
+            } else {
+                Pica::CommandProcessor::ProcessCommandList(buffer, config.size);
+            }
 
             g_regs.command_processor_config.trigger = 0;
         }
@@ -510,9 +541,54 @@ template void Write<u32>(u32 addr, const u32 data);
 template void Write<u16>(u32 addr, const u16 data);
 template void Write<u8>(u32 addr, const u8 data);
 
+void SignalInterrupt(Service::GSP::InterruptId interrupt_id) {
+    if (VideoCore::g_gpu_thread && VideoCore::g_gpu_thread->IsGPUThread()) {
+        Core::System::GetInstance().CoreTiming().ScheduleEventThreadsafe(
+            0, interrupt_event, static_cast<u64>(interrupt_id));
+        return;
+    }
+    Service::GSP::SignalInterrupt(interrupt_id);
+}
+
+static void InterruptCallback(u64 userdata, s64 cycles_late) {
+    Service::GSP::SignalInterrupt(static_cast<Service::GSP::InterruptId>(userdata));
+}
+
+/// userdata bit 0 selects the filler, bit 1 is set if the fill raises an interrupt
+static void MemoryFillFinishedCallback(u64 userdata, s64 cycles_late) {
+    const bool is_second_filler = (userdata & 1) != 0;
+    auto& config = g_regs.memory_fill_config[is_second_filler];
+
+    // Reset "trigger" flag and set the "finish" flag
+    // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
+    config.trigger.Assign(0);
+    config.finished.Assign(1);
+
+    if (userdata & 2) {
+        Service::GSP::SignalInterrupt(is_second_filler ? Service::GSP::InterruptId::PSC1
+                                                       : Service::GSP::InterruptId::PSC0);
+    }
+}
+
+static void DisplayTransferFinishedCallback(u64 userdata, s64 cycles_late) {
+    g_regs.display_transfer_config.trigger = 0;
+    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
+}
+
 /// Update hardware
 static void VBlankCallback(u64 userdata, s64 cycles_late) {
-    VideoCore::g_renderer->SwapBuffers();
+    RendererBase::FrameRegs frame_regs;
+    frame_regs.framebuffer_config = {g_regs.framebuffer_config[0], g_regs.framebuffer_config[1]};
+    frame_regs.color_fill = {LCD::g_regs.color_fill_top, LCD::g_regs.color_fill_bottom};
+
+    if (VideoCore::g_gpu_thread) {
+        // Let the GPU thread fall behind the emulated CPU by at most one frame
+        VideoCore::g_gpu_thread->WaitForFence(last_swap_fence);
+        last_swap_fence = VideoCore::g_gpu_thread->PushCommand(
+            [frame_regs] { VideoCore::g_renderer->SwapBuffers(frame_regs); });
+    } else {
+        VideoCore::g_renderer->SwapBuffers(frame_regs);
+    }
 
     // Signal to GSP that GPU interrupt has occurred
     // TODO(yuriks): hwtest to determine if PDC0 is for the Top screen and PDC1 for the Sub
@@ -528,6 +604,22 @@ static void VBlankCallback(u64 userdata, s64 cycles_late) {
 
 /// Initialize hardware
 void Init(Memory::MemorySystem& memory) {
+    InitRegisters(memory);
+
+    Core::Timing& timing = Core::System::GetInstance().CoreTiming();
+    vblank_event = timing.RegisterEvent("GPU::VBlankCallback", VBlankCallback);
+    interrupt_event = timing.RegisterEvent("GPU::InterruptCallback", InterruptCallback);
+    memory_fill_finished_event =
+        timing.RegisterEvent("GPU::MemoryFillFinishedCallback", MemoryFillFinishedCallback);
+    display_transfer_finished_event = timing.RegisterEvent("GPU::DisplayTransferFinishedCallback",
+                                                           DisplayTransferFinishedCallback);
+    last_swap_fence = 0;
+    timing.ScheduleEvent(frame_ticks, vblank_event);
+
+    LOG_DEBUG(HW_GPU, "initialized OK");
+}
+
+void InitRegisters(Memory::MemorySystem& memory) {
     g_memory = &memory;
     memset(&g_regs, 0, sizeof(g_regs));
 
@@ -556,12 +648,6 @@ void Init(Memory::MemorySystem& memory) {
     framebuffer_sub.stride = 3 * 240;
     framebuffer_sub.color_format.Assign(Regs::PixelFormat::RGB8);
     framebuffer_sub.active_fb = 0;
-
-    Core::Timing& timing = Core::System::GetInstance().CoreTiming();
-    vblank_event = timing.RegisterEvent("GPU::VBlankCallback", VBlankCallback);
-    timing.ScheduleEvent(frame_ticks, vblank_event);
-
-    LOG_DEBUG(HW_GPU, "initialized OK");
 }
 
 /// Shutdown hardware
@@ -15,6 +15,10 @@ namespace Memory {
 class MemorySystem;
 }
 
+namespace Service::GSP {
+enum class InterruptId : u8;
+}
+
 namespace GPU {
 
 constexpr float SCREEN_REFRESH_RATE = 60;
@@ -329,9 +333,23 @@ void Read(T& var, const u32 addr);
 template <typename T>
 void Write(u32 addr, const T data);
 
+/**
+ * Signals a GSP interrupt raised by the emulated GPU. When called from the GPU thread, the
+ * interrupt is forwarded to the emulation thread through CoreTiming, since kernel objects must only
+ * be touched by the emulation thread.
+ * @param interrupt_id ID of interrupt that is being signalled
+ */
+void SignalInterrupt(Service::GSP::InterruptId interrupt_id);
+
 /// Initialize hardware
 void Init(Memory::MemorySystem& memory);
 
+/**
+ * Resets the registers to their boot values, without scheduling the VBlank event. Used on its own
+ * when the GPU is driven without an emulated system, e.g. when replaying a CiTrace.
+ */
+void InitRegisters(Memory::MemorySystem& memory);
+
 /// Shutdown hardware
 void Shutdown();
 
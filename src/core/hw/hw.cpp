@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "core/hw/aes/key.h"
@@ -99,4 +101,29 @@ void Shutdown() {
     LCD::Shutdown();
     LOG_DEBUG(HW, "shutdown OK");
 }
+
+void Snapshot::DoState(PointerWrap& p) {
+    auto section = p.Section("HW", 1);
+    if (!section) {
+        return;
+    }
+    gpu_regs.resize(sizeof(GPU::Regs));
+    lcd_regs.resize(sizeof(LCD::Regs));
+    p.DoVoid(gpu_regs.data(), gpu_regs.size());
+    p.DoVoid(lcd_regs.data(), lcd_regs.size());
+}
+
+Snapshot TakeSnapshot() {
+    Snapshot snapshot;
+    snapshot.gpu_regs.resize(sizeof(GPU::g_regs));
+    snapshot.lcd_regs.resize(sizeof(LCD::g_regs));
+    std::memcpy(snapshot.gpu_regs.data(), &GPU::g_regs, sizeof(GPU::g_regs));
+    std::memcpy(snapshot.lcd_regs.data(), &LCD::g_regs, sizeof(LCD::g_regs));
+    return snapshot;
+}
+
+void RestoreSnapshot(const Snapshot& snapshot) {
+    std::memcpy(&GPU::g_regs, snapshot.gpu_regs.data(), sizeof(GPU::g_regs));
+    std::memcpy(&LCD::g_regs, snapshot.lcd_regs.data(), sizeof(LCD::g_regs));
+}
 } // namespace HW
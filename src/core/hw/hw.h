@@ -4,8 +4,11 @@
 
 #pragma once
 
+#include <vector>
 #include "common/common_types.h"
 
+class PointerWrap;
+
 namespace Memory {
 class MemorySystem;
 }
@@ -51,4 +54,18 @@ void Init(Memory::MemorySystem& memory);
 /// Shutdown hardware
 void Shutdown();
 
+/// GPU and LCD registers as stored in save states
+struct Snapshot {
+    std::vector<u8> gpu_regs;
+    std::vector<u8> lcd_regs;
+
+    void DoState(PointerWrap& p);
+};
+
+/// Copies the GPU and LCD registers
+Snapshot TakeSnapshot();
+
+/// Restores the GPU and LCD registers
+void RestoreSnapshot(const Snapshot& snapshot);
+
 } // namespace HW
@@ -3,7 +3,10 @@
 // Refer to the license.txt file included.
 
 #include <array>
+#include <atomic>
 #include <cstring>
+#include <functional>
+#include <mutex>
 #include "audio_core/dsp_interface.h"
 #include "common/assert.h"
 #include "common/common_types.h"
@@ -11,10 +14,13 @@
 #include "common/swap.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
+#include "core/fastmem.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/lock.h"
 #include "core/memory.h"
+#include "core/settings.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -22,21 +28,29 @@ namespace Memory {
 
 class RasterizerCacheMarker {
 public:
-    void Mark(VAddr addr, bool cached) {
-        bool* p = At(addr);
+    enum class State : u8 {
+        Uncached,
+        /// Accesses trap, so that the rasterizer cache can be kept coherent
+        Cached,
+        /// Written by the CPU since the rasterizer cache last looked at it. Accesses don't trap.
+        Written,
+    };
+
+    void Mark(VAddr addr, State state) {
+        State* p = At(addr);
         if (p)
-            *p = cached;
+            *p = state;
     }
 
-    bool IsCached(VAddr addr) {
-        bool* p = At(addr);
+    State GetState(VAddr addr) {
+        State* p = At(addr);
         if (p)
             return *p;
-        return false;
+        return State::Uncached;
     }
 
 private:
-    bool* At(VAddr addr) {
+    State* At(VAddr addr) {
         if (addr >= VRAM_VADDR && addr < VRAM_VADDR_END) {
             return &vram[(addr - VRAM_VADDR) / PAGE_SIZE];
         }
@@ -49,28 +63,53 @@ private:
         return nullptr;
     }
 
-    std::array<bool, VRAM_SIZE / PAGE_SIZE> vram{};
-    std::array<bool, LINEAR_HEAP_SIZE / PAGE_SIZE> linear_heap{};
-    std::array<bool, NEW_LINEAR_HEAP_SIZE / PAGE_SIZE> new_linear_heap{};
+    std::array<State, VRAM_SIZE / PAGE_SIZE> vram{};
+    std::array<State, LINEAR_HEAP_SIZE / PAGE_SIZE> linear_heap{};
+    std::array<State, NEW_LINEAR_HEAP_SIZE / PAGE_SIZE> new_linear_heap{};
 };
 
 class MemorySystem::Impl {
 public:
-    // Visual Studio would try to allocate these on compile time if they are std::array, which would
+    static constexpr std::size_t RAM_SIZE =
+        Memory::FCRAM_N3DS_SIZE + Memory::VRAM_SIZE + Memory::N3DS_EXTRA_RAM_SIZE;
+
+    Impl() {
+        if (Settings::values.use_fastmem && FastmemArena::IsSupported()) {
+            fastmem = std::make_unique<FastmemArena>(RAM_SIZE);
+            fcram = fastmem->Data();
+        } else {
+            ram = std::make_unique<u8[]>(RAM_SIZE);
+            fcram = ram.get();
+        }
+        vram = fcram + Memory::FCRAM_N3DS_SIZE;
+        n3ds_extra_ram = vram + Memory::VRAM_SIZE;
+    }
+
+    // Visual Studio would try to allocate this on compile time if it was a std::array, which would
     // exceed the memory limit.
-    std::unique_ptr<u8[]> fcram = std::make_unique<u8[]>(Memory::FCRAM_N3DS_SIZE);
-    std::unique_ptr<u8[]> vram = std::make_unique<u8[]>(Memory::VRAM_SIZE);
-    std::unique_ptr<u8[]> n3ds_extra_ram = std::make_unique<u8[]>(Memory::N3DS_EXTRA_RAM_SIZE);
+    std::unique_ptr<u8[]> ram;
+    std::unique_ptr<FastmemArena> fastmem;
+
+    u8* fcram;
+    u8* vram;
+    u8* n3ds_extra_ram;
 
     PageTable* current_page_table = nullptr;
     RasterizerCacheMarker cache_marker;
     std::vector<PageTable*> page_table_list;
 
+    // The CPU marks pages as written and the rasterizer takes them back. The page tables are only
+    // changed on the emulation thread, but the GPU thread checks has_written_pages.
+    std::mutex cache_marker_mutex;
+    std::vector<VAddr> written_pages;
+    std::atomic<bool> has_written_pages{false};
+
     ARM_Interface* cpu = nullptr;
     AudioCore::DspInterface* dsp = nullptr;
 };
 
 MemorySystem::MemorySystem() : impl(std::make_unique<Impl>()) {}
+
 MemorySystem::~MemorySystem() = default;
 
 void MemorySystem::SetCPU(ARM_Interface& cpu) {
@@ -103,7 +142,8 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, u8* memor
         page_table.pointers[base] = memory;
 
         // If the memory to map is already rasterizer-cached, mark the page
-        if (type == PageType::Memory && impl->cache_marker.IsCached(base * PAGE_SIZE)) {
+        if (type == PageType::Memory && impl->cache_marker.GetState(base * PAGE_SIZE) ==
+                                            RasterizerCacheMarker::State::Cached) {
             page_table.attributes[base] = PageType::RasterizerCachedMemory;
             page_table.pointers[base] = nullptr;
         }
@@ -112,6 +152,68 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, u8* memor
         if (memory != nullptr)
             memory += PAGE_SIZE;
     }
+
+    UpdateFastmem(page_table, end - size, size);
+}
+
+void MemorySystem::UpdateFastmem(PageTable& page_table, u32 base, u32 size) {
+    if (page_table.fastmem_base == nullptr) {
+        return;
+    }
+
+    FastmemArena& arena = *impl->fastmem;
+
+    // Consecutive pages backed by consecutive memory are mapped together
+    u32 run_start = base;
+    const u8* run_backing = nullptr;
+    auto map_run = [&](u32 run_end) {
+        if (run_end == run_start) {
+            return;
+        }
+        const VAddr vaddr = run_start << PAGE_BITS;
+        const std::size_t length = std::size_t{run_end - run_start} * PAGE_SIZE;
+        if (run_backing != nullptr) {
+            arena.Map(page_table.fastmem_base, vaddr, run_backing, length);
+        } else {
+            arena.Unmap(page_table.fastmem_base, vaddr, length);
+        }
+    };
+
+    for (u32 page = base; page < base + size; ++page) {
+        // Rasterizer-cached and MMIO pages stay unmapped, their accesses go through the page table
+        const u8* backing = nullptr;
+        if (page_table.attributes[page] == PageType::Memory &&
+            arena.Contains(page_table.pointers[page])) {
+            backing = page_table.pointers[page];
+        }
+
+        const bool continues_run =
+            (backing == nullptr && run_backing == nullptr) ||
+            (backing != nullptr && run_backing != nullptr &&
+             backing == run_backing + (page - run_start) * PAGE_SIZE);
+        if (!continues_run) {
+            map_run(page);
+            run_start = page;
+            run_backing = backing;
+        }
+    }
+    map_run(base + size);
+}
+
+u8* MemorySystem::GetFastmemPointer(const PageTable& page_table, VAddr vaddr, std::size_t size) {
+    if (page_table.fastmem_base == nullptr || size == 0 ||
+        static_cast<u64>(vaddr) + size > FastmemArena::WINDOW_SIZE) {
+        return nullptr;
+    }
+
+    const std::size_t last_page = (static_cast<std::size_t>(vaddr) + size - 1) >> PAGE_BITS;
+    for (std::size_t page = vaddr >> PAGE_BITS; page <= last_page; ++page) {
+        if (page_table.attributes[page] != PageType::Memory ||
+            !impl->fastmem->Contains(page_table.pointers[page])) {
+            return nullptr;
+        }
+    }
+    return page_table.fastmem_base + vaddr;
 }
 
 void MemorySystem::MapMemoryRegion(PageTable& page_table, VAddr base, u32 size, u8* target) {
@@ -137,24 +239,34 @@ void MemorySystem::UnmapRegion(PageTable& page_table, VAddr base, u32 size) {
 
 u8* MemorySystem::GetPointerForRasterizerCache(VAddr addr) {
     if (addr >= LINEAR_HEAP_VADDR && addr < LINEAR_HEAP_VADDR_END) {
-        return impl->fcram.get() + (addr - LINEAR_HEAP_VADDR);
+        return impl->fcram + (addr - LINEAR_HEAP_VADDR);
     }
     if (addr >= NEW_LINEAR_HEAP_VADDR && addr < NEW_LINEAR_HEAP_VADDR_END) {
-        return impl->fcram.get() + (addr - NEW_LINEAR_HEAP_VADDR);
+        return impl->fcram + (addr - NEW_LINEAR_HEAP_VADDR);
     }
     if (addr >= VRAM_VADDR && addr < VRAM_VADDR_END) {
-        return impl->vram.get() + (addr - VRAM_VADDR);
+        return impl->vram + (addr - VRAM_VADDR);
     }
     UNREACHABLE();
 }
 
 void MemorySystem::RegisterPageTable(PageTable* page_table) {
     impl->page_table_list.push_back(page_table);
+
+    if (impl->fastmem) {
+        page_table->fastmem_base = impl->fastmem->CreateWindow();
+        UpdateFastmem(*page_table, 0, PAGE_TABLE_NUM_ENTRIES);
+    }
 }
 
 void MemorySystem::UnregisterPageTable(PageTable* page_table) {
     impl->page_table_list.erase(
         std::find(impl->page_table_list.begin(), impl->page_table_list.end(), page_table));
+
+    if (page_table->fastmem_base != nullptr) {
+        impl->fastmem->DestroyWindow(page_table->fastmem_base);
+        page_table->fastmem_base = nullptr;
+    }
 }
 
 /**
@@ -227,7 +339,7 @@ void MemorySystem::Write(const VAddr vaddr, const T data) {
         ASSERT_MSG(false, "Mapped memory page without a pointer @ {:08X}", vaddr);
         break;
     case PageType::RasterizerCachedMemory: {
-        RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Invalidate);
+        RasterizerTrackWrite(vaddr);
         std::memcpy(GetPointerForRasterizerCache(vaddr), &data, sizeof(T));
         break;
     }
@@ -323,16 +435,16 @@ u8* MemorySystem::GetPhysicalPointer(PAddr address) {
     u8* target_pointer = nullptr;
     switch (area->paddr_base) {
     case VRAM_PADDR:
-        target_pointer = impl->vram.get() + offset_into_region;
+        target_pointer = impl->vram + offset_into_region;
         break;
     case DSP_RAM_PADDR:
         target_pointer = impl->dsp->GetDspMemory().data() + offset_into_region;
         break;
     case FCRAM_PADDR:
-        target_pointer = impl->fcram.get() + offset_into_region;
+        target_pointer = impl->fcram + offset_into_region;
         break;
     case N3DS_EXTRA_RAM_PADDR:
-        target_pointer = impl->n3ds_extra_ram.get() + offset_into_region;
+        target_pointer = impl->n3ds_extra_ram + offset_into_region;
         break;
     default:
         UNREACHABLE();
@@ -360,17 +472,53 @@ static std::vector<VAddr> PhysicalToVirtualAddressForRasterizer(PAddr addr) {
     return {};
 }
 
+/// Inverse of PhysicalToVirtualAddressForRasterizer
+static PAddr VirtualToPhysicalAddressForRasterizer(VAddr addr) {
+    if (addr >= LINEAR_HEAP_VADDR && addr < LINEAR_HEAP_VADDR_END) {
+        return addr - LINEAR_HEAP_VADDR + FCRAM_PADDR;
+    }
+    if (addr >= NEW_LINEAR_HEAP_VADDR && addr < NEW_LINEAR_HEAP_VADDR_END) {
+        return addr - NEW_LINEAR_HEAP_VADDR + FCRAM_PADDR;
+    }
+    if (addr >= VRAM_VADDR && addr < VRAM_VADDR_END) {
+        return addr - VRAM_VADDR + VRAM_PADDR;
+    }
+    UNREACHABLE();
+    return 0;
+}
+
+/**
+ * The CPU reads the page tables without locking, so the rasterizer must not change them from the
+ * GPU thread. Runs the change on the emulation thread instead, while the GPU thread waits.
+ */
+static void RunOnEmulationThread(std::function<void()> change) {
+    if (VideoCore::g_gpu_thread && VideoCore::g_gpu_thread->IsGPUThread()) {
+        VideoCore::g_gpu_thread->RunOnEmulationThread(std::move(change));
+    } else {
+        change();
+    }
+}
+
 void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached) {
     if (start == 0) {
         return;
     }
 
+    // Once this returns, every CPU access to the region traps, so the caller can load it safely
+    RunOnEmulationThread([this, start, size, cached] {
+        MarkRegionCached(start, size, cached);
+    });
+}
+
+void MemorySystem::MarkRegionCached(PAddr start, u32 size, bool cached) {
     u32 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
     PAddr paddr = start;
 
+    std::lock_guard lock{impl->cache_marker_mutex};
     for (unsigned i = 0; i < num_pages; ++i, paddr += PAGE_SIZE) {
         for (VAddr vaddr : PhysicalToVirtualAddressForRasterizer(paddr)) {
-            impl->cache_marker.Mark(vaddr, cached);
+            impl->cache_marker.Mark(vaddr, cached ? RasterizerCacheMarker::State::Cached
+                                                  : RasterizerCacheMarker::State::Uncached);
             for (PageTable* page_table : impl->page_table_list) {
                 PageType& page_type = page_table->attributes[vaddr >> PAGE_BITS];
 
@@ -384,6 +532,7 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
                     case PageType::Memory:
                         page_type = PageType::RasterizerCachedMemory;
                         page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
+                        UpdateFastmem(*page_table, vaddr >> PAGE_BITS, 1);
                         break;
                     default:
                         UNREACHABLE();
@@ -395,10 +544,14 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
                         // It is not necessary for a process to have this region mapped into its
                         // address space, for example, a system module need not have a VRAM mapping.
                         break;
+                    case PageType::Memory:
+                        // Written since the rasterizer last checked the page, so already untrapped
+                        break;
                     case PageType::RasterizerCachedMemory: {
                         page_type = PageType::Memory;
                         page_table->pointers[vaddr >> PAGE_BITS] =
                             GetPointerForRasterizerCache(vaddr & ~PAGE_MASK);
+                        UpdateFastmem(*page_table, vaddr >> PAGE_BITS, 1);
                         break;
                     }
                     default:
@@ -410,12 +563,78 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
     }
 }
 
+void MemorySystem::RasterizerTrackWrite(VAddr vaddr) {
+    const VAddr page = vaddr & ~PAGE_MASK;
+
+    // Once whatever the GPU rendered to the page is in memory, memory holds the only up-to-date
+    // copy of the page, and the CPU can keep accessing it without trapping until the rasterizer
+    // takes the page back.
+    RasterizerFlushVirtualRegion(page, PAGE_SIZE, FlushMode::Flush);
+
+    {
+        std::lock_guard lock{impl->cache_marker_mutex};
+        if (impl->cache_marker.GetState(page) == RasterizerCacheMarker::State::Cached) {
+            impl->cache_marker.Mark(page, RasterizerCacheMarker::State::Written);
+            impl->written_pages.push_back(page);
+            impl->has_written_pages = true;
+            for (PageTable* page_table : impl->page_table_list) {
+                PageType& page_type = page_table->attributes[page >> PAGE_BITS];
+                if (page_type == PageType::RasterizerCachedMemory) {
+                    page_type = PageType::Memory;
+                    page_table->pointers[page >> PAGE_BITS] = GetPointerForRasterizerCache(page);
+                    UpdateFastmem(*page_table, page >> PAGE_BITS, 1);
+                }
+            }
+            return;
+        }
+    }
+
+    // Not a page the rasterizer cache knows about, invalidate right away
+    RasterizerFlushVirtualRegion(page, PAGE_SIZE, FlushMode::Invalidate);
+}
+
+std::vector<PAddr> MemorySystem::RasterizerTakeWrittenPages() {
+    if (!impl->has_written_pages) {
+        return {};
+    }
+
+    // Trapping the pages again changes the page tables, see RunOnEmulationThread
+    std::vector<PAddr> pages;
+    RunOnEmulationThread([this, &pages] { pages = TakeWrittenPages(); });
+    return pages;
+}
+
+std::vector<PAddr> MemorySystem::TakeWrittenPages() {
+    std::lock_guard lock{impl->cache_marker_mutex};
+    std::vector<PAddr> pages;
+    pages.reserve(impl->written_pages.size());
+    for (VAddr vaddr : impl->written_pages) {
+        // The page may have stopped being cached in the meantime
+        if (impl->cache_marker.GetState(vaddr) == RasterizerCacheMarker::State::Written) {
+            impl->cache_marker.Mark(vaddr, RasterizerCacheMarker::State::Cached);
+            for (PageTable* page_table : impl->page_table_list) {
+                PageType& page_type = page_table->attributes[vaddr >> PAGE_BITS];
+                if (page_type == PageType::Memory) {
+                    page_type = PageType::RasterizerCachedMemory;
+                    page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
+                    UpdateFastmem(*page_table, vaddr >> PAGE_BITS, 1);
+                }
+            }
+        }
+        pages.push_back(VirtualToPhysicalAddressForRasterizer(vaddr));
+    }
+    impl->written_pages.clear();
+    impl->has_written_pages = false;
+    return pages;
+}
+
 void RasterizerFlushRegion(PAddr start, u32 size) {
     if (VideoCore::g_renderer == nullptr) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
+    VideoCore::RunGPUCommandAndWait(
+        [start, size] { VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size); });
 }
 
 void RasterizerInvalidateRegion(PAddr start, u32 size) {
@@ -423,7 +642,8 @@ void RasterizerInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size);
+    VideoCore::RunGPUCommandAndWait(
+        [start, size] { VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size); });
 }
 
 void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
@@ -433,7 +653,9 @@ void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
+    VideoCore::RunGPUCommandAndWait([start, size] {
+        VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
+    });
 }
 
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
@@ -456,16 +678,15 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
         PAddr physical_start = paddr_region_start + (overlap_start - region_start);
         u32 overlap_size = overlap_end - overlap_start;
 
-        auto* rasterizer = VideoCore::g_renderer->Rasterizer();
         switch (mode) {
         case FlushMode::Flush:
-            rasterizer->FlushRegion(physical_start, overlap_size);
+            RasterizerFlushRegion(physical_start, overlap_size);
             break;
         case FlushMode::Invalidate:
-            rasterizer->InvalidateRegion(physical_start, overlap_size);
+            RasterizerInvalidateRegion(physical_start, overlap_size);
             break;
         case FlushMode::FlushAndInvalidate:
-            rasterizer->FlushAndInvalidateRegion(physical_start, overlap_size);
+            RasterizerFlushAndInvalidateRegion(physical_start, overlap_size);
             break;
         }
     };
@@ -495,6 +716,11 @@ void MemorySystem::ReadBlock(const Kernel::Process& process, const VAddr src_add
                              void* dest_buffer, const std::size_t size) {
     auto& page_table = process.vm_manager.page_table;
 
+    if (const u8* src_ptr = GetFastmemPointer(page_table, src_addr, size)) {
+        std::memcpy(dest_buffer, src_ptr, size);
+        return;
+    }
+
     std::size_t remaining_size = size;
     std::size_t page_index = src_addr >> PAGE_BITS;
     std::size_t page_offset = src_addr & PAGE_MASK;
@@ -560,6 +786,12 @@ void MemorySystem::Write64(const VAddr addr, const u64 data) {
 void MemorySystem::WriteBlock(const Kernel::Process& process, const VAddr dest_addr,
                               const void* src_buffer, const std::size_t size) {
     auto& page_table = process.vm_manager.page_table;
+
+    if (u8* dest_ptr = GetFastmemPointer(page_table, dest_addr, size)) {
+        std::memcpy(dest_ptr, src_buffer, size);
+        return;
+    }
+
     std::size_t remaining_size = size;
     std::size_t page_index = dest_addr >> PAGE_BITS;
     std::size_t page_offset = dest_addr & PAGE_MASK;
@@ -589,8 +821,7 @@ void MemorySystem::WriteBlock(const Kernel::Process& process, const VAddr dest_a
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Invalidate);
+            RasterizerTrackWrite(current_vaddr);
             std::memcpy(GetPointerForRasterizerCache(current_vaddr), src_buffer, copy_amount);
             break;
         }
@@ -608,6 +839,12 @@ void MemorySystem::WriteBlock(const Kernel::Process& process, const VAddr dest_a
 void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_addr,
                              const std::size_t size) {
     auto& page_table = process.vm_manager.page_table;
+
+    if (u8* dest_ptr = GetFastmemPointer(page_table, dest_addr, size)) {
+        std::memset(dest_ptr, 0, size);
+        return;
+    }
+
     std::size_t remaining_size = size;
     std::size_t page_index = dest_addr >> PAGE_BITS;
     std::size_t page_offset = dest_addr & PAGE_MASK;
@@ -639,8 +876,7 @@ void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_ad
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Invalidate);
+            RasterizerTrackWrite(current_vaddr);
             std::memset(GetPointerForRasterizerCache(current_vaddr), 0, copy_amount);
             break;
         }
@@ -800,13 +1036,13 @@ void WriteMMIO<u64>(MMIORegionPointer mmio_handler, VAddr addr, const u64 data)
 }
 
 u32 MemorySystem::GetFCRAMOffset(u8* pointer) {
-    ASSERT(pointer >= impl->fcram.get() && pointer <= impl->fcram.get() + Memory::FCRAM_N3DS_SIZE);
-    return pointer - impl->fcram.get();
+    ASSERT(pointer >= impl->fcram && pointer <= impl->fcram + Memory::FCRAM_N3DS_SIZE);
+    return pointer - impl->fcram;
 }
 
 u8* MemorySystem::GetFCRAMPointer(u32 offset) {
     ASSERT(offset <= Memory::FCRAM_N3DS_SIZE);
-    return impl->fcram.get() + offset;
+    return impl->fcram + offset;
 }
 
 void MemorySystem::SetDSP(AudioCore::DspInterface& dsp) {
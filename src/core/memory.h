@@ -78,6 +78,12 @@ struct PageTable {
      * the corresponding entry in `pointers` MUST be set to null.
      */
     std::array<PageType, PAGE_TABLE_NUM_ENTRIES> attributes;
+
+    /**
+     * Host mirror of the address space when fastmem is enabled, see FastmemArena. Only pages of
+     * type `Memory` that are backed by emulated RAM are mapped in it.
+     */
+    u8* fastmem_base = nullptr;
 };
 
 /// Physical memory regions as seen from the ARM11
@@ -286,10 +292,21 @@ public:
     u8* GetFCRAMPointer(u32 offset);
 
     /**
-     * Mark each page touching the region as cached.
+     * Mark each page touching the region as cached. The page tables are only changed on the
+     * emulation thread: when called from the GPU thread, this blocks until the emulation thread
+     * has applied the change.
      */
     void RasterizerMarkRegionCached(PAddr start, u32 size, bool cached);
 
+    /**
+     * CPU writes don't invalidate the rasterizer cache one by one. The first write to a cached page
+     * stops trapping accesses to it, and the rasterizer later takes the page back with this
+     * function and invalidates what it caches of it. Like RasterizerMarkRegionCached, this changes
+     * the page tables on the emulation thread.
+     * @returns The physical addresses of the pages written since the last call
+     */
+    std::vector<PAddr> RasterizerTakeWrittenPages();
+
     /// Registers page table for rasterizer cache marking
     void RegisterPageTable(PageTable* page_table);
 
@@ -313,8 +330,26 @@ private:
      */
     u8* GetPointerForRasterizerCache(VAddr addr);
 
+    /// Implements RasterizerMarkRegionCached, on the emulation thread
+    void MarkRegionCached(PAddr start, u32 size, bool cached);
+
+    /// Implements RasterizerTakeWrittenPages, on the emulation thread
+    std::vector<PAddr> TakeWrittenPages();
+
+    /// Called before the CPU writes to a page marked as RasterizerCachedMemory
+    void RasterizerTrackWrite(VAddr vaddr);
+
     void MapPages(PageTable& page_table, u32 base, u32 size, u8* memory, PageType type);
 
+    /// Mirrors the given pages of a page table in its fastmem window
+    void UpdateFastmem(PageTable& page_table, u32 base, u32 size);
+
+    /**
+     * Gets a pointer to a range of the fastmem window of a page table, if every page of the range
+     * is mapped in it. Otherwise returns nullptr.
+     */
+    u8* GetFastmemPointer(const PageTable& page_table, VAddr vaddr, std::size_t size);
+
     class Impl;
 
     std::unique_ptr<Impl> impl;
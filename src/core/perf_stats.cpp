@@ -40,6 +40,15 @@ void PerfStats::EndGameFrame() {
     game_frames += 1;
 }
 
+void PerfStats::AddAudioOutput(microseconds latency, bool underrun) {
+    accumulated_audio_latency_us.fetch_add(static_cast<u64>(latency.count()),
+                                           std::memory_order_relaxed);
+    audio_callbacks.fetch_add(1, std::memory_order_relaxed);
+    if (underrun) {
+        audio_underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
 PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_us) {
     std::lock_guard<std::mutex> lock(object_mutex);
 
@@ -56,6 +65,13 @@ PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_
                         static_cast<double>(system_frames);
     results.emulation_speed = system_us_per_second.count() / 1'000'000.0;
 
+    const u32 callbacks = audio_callbacks.exchange(0, std::memory_order_relaxed);
+    const u64 audio_latency_us =
+        accumulated_audio_latency_us.exchange(0, std::memory_order_relaxed);
+    results.audio_latency =
+        callbacks == 0 ? 0.0 : static_cast<double>(audio_latency_us) / callbacks / 1'000'000.0;
+    results.audio_underruns = audio_underruns.exchange(0, std::memory_order_relaxed);
+
     // Reset counters
     reset_point = now;
     reset_point_system_us = current_system_time_us;
@@ -29,12 +29,24 @@ public:
         double frametime;
         /// Ratio of walltime / emulated time elapsed
         double emulation_speed;
+        /// Average amount of audio queued ahead of the audio output, in seconds
+        double audio_latency;
+        /// Number of times the audio output ran out of samples
+        u32 audio_underruns;
     };
 
     void BeginSystemFrame();
     void EndSystemFrame();
     void EndGameFrame();
 
+    /**
+     * Records the audio latency observed by one audio output callback. Unlike the other functions
+     * of this class this doesn't lock, as it is called from the audio output thread.
+     * @param latency amount of audio queued ahead of the output when the callback was made
+     * @param underrun whether the output ran out of samples since the previous callback
+     */
+    void AddAudioOutput(std::chrono::microseconds latency, bool underrun);
+
     Results GetAndResetStats(std::chrono::microseconds current_system_time_us);
 
     /**
@@ -64,6 +76,13 @@ private:
     Clock::time_point frame_begin = reset_point;
     /// Total visible duration (including frame-limiting, etc.) of the previous system frame
     Clock::duration previous_frame_length = Clock::duration::zero();
+
+    /// Cumulative audio latency (in microseconds) of the audio callbacks since last reset
+    std::atomic<u64> accumulated_audio_latency_us{0};
+    /// Cumulative number of audio callbacks since last reset
+    std::atomic<u32> audio_callbacks{0};
+    /// Cumulative number of audio underruns since last reset
+    std::atomic<u32> audio_underruns{0};
 };
 
 class FrameLimiter {
@@ -0,0 +1,437 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <random>
+#include "common/chunk_file.h"
+#include "common/compression.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/swap.h"
+#include "core/arm/arm_interface.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/snapshot.h"
+#include "core/hw/hw.h"
+#include "core/loader/loader.h"
+#include "core/memory.h"
+#include "core/savestate.h"
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/video_core.h"
+
+namespace Core {
+
+namespace {
+
+constexpr std::array<u8, 4> header_magic_bytes{{'C', 'S', 'S', 0x1B}};
+/// Increase whenever the payload layout changes in a way the section versions can't express
+constexpr u32 SAVESTATE_FORMAT_VERSION = 4;
+
+#pragma pack(push, 1)
+struct SaveStateHeader {
+    std::array<u8, 4> filetype;    /// Unique identifier to check the file type (always "CSS"0x1B)
+    u32_le format_version;         /// SAVESTATE_FORMAT_VERSION of the emulator that saved it
+    std::array<char, 40> revision; /// Git revision the state was created with
+    u64_le program_id;             /// ID of the ROM being executed
+    u32_le type;                   /// SaveStateType
+    u32_le sequence;               /// Position of this state in its chain, starting at 1
+    u64_le chain_id;               /// Identifies the full state this state is based on
+    u64_le payload_size;           /// Size of the compressed data following the header
+    u64_le payload_hash;           /// Common::ComputeHash64 of the compressed data
+    u64_le uncompressed_size;      /// Size of the payload before compression
+    u64_le session_id;             /// Identifies the emulation session the state was created in
+    std::array<u8, 24> reserved;   /// Make the header 128 bytes so it has a consistent size
+};
+static_assert(sizeof(SaveStateHeader) == 128, "SaveStateHeader should be 128 bytes");
+#pragma pack(pop)
+
+std::array<char, 40> GetRevision() {
+    std::array<char, 40> revision{};
+    std::strncpy(revision.data(), Common::g_scm_rev, revision.size());
+    return revision;
+}
+
+u64 GetProgramId(System& system) {
+    u64 program_id = 0;
+    system.GetAppLoader().ReadProgramId(program_id);
+    return program_id;
+}
+
+const std::array<u8, Memory::PAGE_SIZE> zero_page{};
+
+/// Returns a random non-zero ID
+u64 GenerateId() {
+    std::random_device device;
+    u64 id;
+    do {
+        id = (static_cast<u64>(device()) << 32) | device();
+    } while (id == 0);
+    return id;
+}
+
+} // Anonymous namespace
+
+SaveStateManager::SaveStateManager(System& system)
+    : system(system), session_id(GenerateId()) {
+    // Only the part of FCRAM that the kernel manages can be in use
+    u32 fcram_size = 0;
+    for (const auto& region : system.Kernel().memory_regions) {
+        fcram_size = std::max(fcram_size, region.base + region.size);
+    }
+
+    regions = {
+        {Memory::FCRAM_PADDR, fcram_size, {}},
+        {Memory::VRAM_PADDR, Memory::VRAM_SIZE, {}},
+        {Memory::DSP_RAM_PADDR, Memory::DSP_RAM_SIZE, {}},
+        {Memory::N3DS_EXTRA_RAM_PADDR, Memory::N3DS_EXTRA_RAM_SIZE, {}},
+    };
+}
+
+SaveStateManager::~SaveStateManager() = default;
+
+std::vector<u32> SaveStateManager::CollectPages(const MemoryRegion& region, SaveStateType type,
+                                                std::vector<u64>& new_hashes) const {
+    static const u64 zero_page_hash = Common::ComputeHash64(zero_page.data(), zero_page.size());
+
+    const u8* data = system.Memory().GetPhysicalPointer(region.paddr);
+    const u32 num_pages = region.size / Memory::PAGE_SIZE;
+    new_hashes.resize(num_pages);
+
+    std::vector<u32> pages;
+    for (u32 page = 0; page < num_pages; ++page) {
+        const u8* page_data = data + page * Memory::PAGE_SIZE;
+        const u64 hash = Common::ComputeHash64(page_data, Memory::PAGE_SIZE);
+        new_hashes[page] = hash;
+
+        if (type == SaveStateType::Delta) {
+            if (hash != region.page_hashes[page]) {
+                pages.push_back(page);
+            }
+        } else if (hash != zero_page_hash ||
+                   std::memcmp(page_data, zero_page.data(), Memory::PAGE_SIZE) != 0) {
+            pages.push_back(page);
+        }
+    }
+    return pages;
+}
+
+struct SaveStateManager::Payload {
+    /// Pages of a memory region stored in the state
+    struct MemoryPages {
+        u32 size;
+        std::vector<u32> pages;
+        /// Contents of each page, in emulated memory when saving and in the state when loading
+        std::vector<const u8*> data;
+    };
+
+    Kernel::KernelSnapshot kernel;
+    Timing::Snapshot timing;
+    HW::Snapshot hw;
+    Pica::StateSnapshot pica;
+    std::vector<MemoryPages> memory;
+
+    void DoMemory(PointerWrap& p) {
+        auto section = p.Section("Memory", 1);
+        if (!section) {
+            return;
+        }
+
+        const bool loading = p.GetMode() == PointerWrap::MODE_READ;
+        for (MemoryPages& region : memory) {
+            p.Do(region.size);
+            p.Do(region.pages);
+            if (loading) {
+                // The page contents stay in the state until it is applied
+                region.data.resize(region.pages.size());
+                for (const u8*& data : region.data) {
+                    data = *p.GetPPtr();
+                    *p.GetPPtr() += Memory::PAGE_SIZE;
+                }
+            } else {
+                for (const u8* data : region.data) {
+                    p.DoVoid(const_cast<u8*>(data), Memory::PAGE_SIZE);
+                }
+            }
+        }
+    }
+
+    void DoState(PointerWrap& p) {
+        // The kernel goes first, because it is the section that is refused most often
+        kernel.DoState(p);
+        timing.DoState(p);
+        hw.DoState(p);
+        pica.DoState(p);
+        DoMemory(p);
+    }
+};
+
+bool SaveStateManager::CanApplyPayload(const Payload& payload) const {
+    for (std::size_t i = 0; i < regions.size(); ++i) {
+        const MemoryRegion& region = regions[i];
+        const Payload::MemoryPages& pages = payload.memory[i];
+        if (pages.size != region.size) {
+            LOG_ERROR(Core, "Memory region {:08X} has size {:#X}, expected {:#X}", region.paddr,
+                      pages.size, region.size);
+            return false;
+        }
+        for (u32 page : pages.pages) {
+            if (page >= region.size / Memory::PAGE_SIZE) {
+                LOG_ERROR(Core, "Invalid page {:#X} in memory region {:08X}", page, region.paddr);
+                return false;
+            }
+        }
+    }
+
+    if (!system.Kernel().CanRestoreSnapshot(payload.kernel)) {
+        LOG_ERROR(Core, "Save state kernel objects don't match the running kernel");
+        return false;
+    }
+    if (!system.CoreTiming().CanRestoreSnapshot(payload.timing)) {
+        LOG_ERROR(Core, "Save state has events that aren't registered with core timing");
+        return false;
+    }
+    return true;
+}
+
+void SaveStateManager::ApplyPayload(const Payload& payload, SaveStateType type) {
+    // Cached surfaces would be written back over the restored memory
+    Memory::RasterizerFlushAndInvalidateRegion(Memory::FCRAM_PADDR, regions[0].size);
+    Memory::RasterizerFlushAndInvalidateRegion(Memory::VRAM_PADDR, Memory::VRAM_SIZE);
+
+    for (std::size_t i = 0; i < regions.size(); ++i) {
+        const Payload::MemoryPages& pages = payload.memory[i];
+        u8* data = system.Memory().GetPhysicalPointer(regions[i].paddr);
+        if (type == SaveStateType::Full) {
+            // Zero-filled pages aren't stored
+            std::memset(data, 0, regions[i].size);
+        }
+        for (std::size_t j = 0; j < pages.pages.size(); ++j) {
+            std::memcpy(data + pages.pages[j] * Memory::PAGE_SIZE, pages.data[j],
+                        Memory::PAGE_SIZE);
+        }
+    }
+
+    system.Kernel().RestoreSnapshot(payload.kernel);
+    system.CoreTiming().RestoreSnapshot(payload.timing);
+    HW::RestoreSnapshot(payload.hw);
+    VideoCore::RunGPUCommandAndWait([&payload] { Pica::RestoreSnapshot(payload.pica); });
+
+    // Code may have changed in restored memory
+    system.CPU().ClearInstructionCache();
+}
+
+std::vector<u8> SaveStateManager::Save(SaveStateType type) {
+    if (type == SaveStateType::Delta && chain_id == 0) {
+        LOG_INFO(Core, "No previous save state, creating a full state");
+        type = SaveStateType::Full;
+    }
+
+    auto payload = std::make_unique<Payload>();
+    if (!system.Kernel().TakeSnapshot(payload->kernel)) {
+        LOG_WARNING(Core, "A thread is waiting for an HLE service, the state can't be saved now");
+        return {};
+    }
+    payload->timing = system.CoreTiming().TakeSnapshot();
+    payload->hw = HW::TakeSnapshot();
+    VideoCore::RunGPUCommandAndWait([&payload] { Pica::TakeSnapshot(payload->pica); });
+
+    // Write back the memory that the rasterizer has cached in host GPU resources
+    Memory::RasterizerFlushRegion(Memory::FCRAM_PADDR, regions[0].size);
+    Memory::RasterizerFlushRegion(Memory::VRAM_PADDR, Memory::VRAM_SIZE);
+
+    payload->memory.resize(regions.size());
+    std::vector<std::vector<u64>> new_hashes(regions.size());
+    for (std::size_t i = 0; i < regions.size(); ++i) {
+        Payload::MemoryPages& pages = payload->memory[i];
+        const u8* data = system.Memory().GetPhysicalPointer(regions[i].paddr);
+        pages.size = regions[i].size;
+        pages.pages = CollectPages(regions[i], type, new_hashes[i]);
+        for (u32 page : pages.pages) {
+            pages.data.push_back(data + page * Memory::PAGE_SIZE);
+        }
+    }
+
+    u8* measure_ptr = nullptr;
+    PointerWrap measure(&measure_ptr, PointerWrap::MODE_MEASURE);
+    payload->DoState(measure);
+    const std::size_t payload_size = reinterpret_cast<std::size_t>(measure_ptr);
+
+    std::vector<u8> uncompressed(payload_size);
+    u8* ptr = uncompressed.data();
+    PointerWrap p(&ptr, PointerWrap::MODE_WRITE);
+    payload->DoState(p);
+    if (p.error == PointerWrap::ERROR_FAILURE) {
+        LOG_ERROR(Core, "Failed to create save state");
+        return {};
+    }
+
+    std::vector<u8> state = Common::Compression::CompressBlock(uncompressed.data(), payload_size);
+    state.insert(state.begin(), sizeof(SaveStateHeader), 0);
+
+    if (type == SaveStateType::Full) {
+        chain_id = GenerateId();
+        sequence = 0;
+    }
+    ++sequence;
+    for (std::size_t i = 0; i < regions.size(); ++i) {
+        regions[i].page_hashes = std::move(new_hashes[i]);
+    }
+
+    SaveStateHeader header{};
+    header.filetype = header_magic_bytes;
+    header.format_version = SAVESTATE_FORMAT_VERSION;
+    header.revision = GetRevision();
+    header.program_id = GetProgramId(system);
+    header.type = static_cast<u32>(type);
+    header.sequence = sequence;
+    header.chain_id = chain_id;
+    header.payload_size = state.size() - sizeof(SaveStateHeader);
+    header.payload_hash = Common::ComputeHash64(state.data() + sizeof(SaveStateHeader),
+                                                state.size() - sizeof(SaveStateHeader));
+    header.uncompressed_size = payload_size;
+    header.session_id = session_id;
+    std::memcpy(state.data(), &header, sizeof(header));
+
+    LOG_DEBUG(Core, "Created {} save state {} ({} bytes)",
+              type == SaveStateType::Full ? "full" : "delta", sequence, state.size());
+    return state;
+}
+
+bool SaveStateManager::Load(const std::vector<u8>& state) {
+    SaveStateHeader header;
+    if (state.size() < sizeof(header)) {
+        LOG_ERROR(Core, "Save state is too small");
+        return false;
+    }
+    std::memcpy(&header, state.data(), sizeof(header));
+
+    if (header.filetype != header_magic_bytes ||
+        header.format_version != SAVESTATE_FORMAT_VERSION) {
+        LOG_ERROR(Core, "Save state has an unsupported format");
+        return false;
+    }
+    if (header.revision != GetRevision()) {
+        LOG_ERROR(Core, "Save state was created with a different emulator revision");
+        return false;
+    }
+    if (header.program_id != GetProgramId(system)) {
+        LOG_ERROR(Core, "Save state was created with a different program: {:016X}",
+                  static_cast<u64>(header.program_id));
+        return false;
+    }
+    if (header.session_id != session_id) {
+        // HLE services and the DSP would be left in the state of the running session
+        LOG_ERROR(Core, "Save state was created in another emulation session, HLE service and "
+                        "audio state isn't saved so it can only be loaded into the same session");
+        return false;
+    }
+    if (header.payload_size != state.size() - sizeof(header)) {
+        LOG_ERROR(Core, "Save state is truncated");
+        return false;
+    }
+
+    const auto type = static_cast<SaveStateType>(static_cast<u32>(header.type));
+    if (type == SaveStateType::Delta &&
+        (header.chain_id != chain_id || header.sequence != sequence + 1)) {
+        LOG_ERROR(Core, "Delta save state {} doesn't apply to the current state", header.sequence);
+        return false;
+    }
+
+    const u8* payload_data = state.data() + sizeof(header);
+    if (header.payload_hash != Common::ComputeHash64(payload_data, header.payload_size)) {
+        LOG_ERROR(Core, "Save state is corrupted");
+        return false;
+    }
+
+    std::vector<u8> uncompressed(header.uncompressed_size);
+    if (!Common::Compression::DecompressBlock(payload_data, header.payload_size,
+                                              uncompressed.data(), uncompressed.size())) {
+        LOG_ERROR(Core, "Failed to decompress save state");
+        return false;
+    }
+
+    // Parse and check every section before applying any, so that a refused state changes nothing
+    auto payload = std::make_unique<Payload>();
+    payload->memory.resize(regions.size());
+    u8* ptr = uncompressed.data();
+    PointerWrap p(&ptr, PointerWrap::MODE_READ);
+    payload->DoState(p);
+    if (p.error == PointerWrap::ERROR_FAILURE ||
+        static_cast<std::size_t>(ptr - uncompressed.data()) != uncompressed.size()) {
+        LOG_ERROR(Core, "Failed to parse save state");
+        return false;
+    }
+    if (!CanApplyPayload(*payload)) {
+        return false;
+    }
+
+    ApplyPayload(*payload, type);
+
+    chain_id = header.chain_id;
+    sequence = header.sequence;
+    RehashMemory();
+    return true;
+}
+
+void SaveStateManager::RehashMemory() {
+    for (MemoryRegion& region : regions) {
+        const u8* data = system.Memory().GetPhysicalPointer(region.paddr);
+        region.page_hashes.resize(region.size / Memory::PAGE_SIZE);
+        for (std::size_t page = 0; page < region.page_hashes.size(); ++page) {
+            region.page_hashes[page] =
+                Common::ComputeHash64(data + page * Memory::PAGE_SIZE, Memory::PAGE_SIZE);
+        }
+    }
+}
+
+bool SaveStateManager::SaveToFile(const std::string& path, SaveStateType type) {
+    const std::vector<u8> state = Save(type);
+    if (state.empty()) {
+        return false;
+    }
+
+    FileUtil::IOFile file(path, "wb");
+    if (file.WriteBytes(state.data(), state.size()) != state.size()) {
+        LOG_ERROR(Core, "Failed to write save state to {}", path);
+        return false;
+    }
+    return true;
+}
+
+bool SaveStateManager::LoadFromFile(const std::string& path) {
+    FileUtil::IOFile file(path, "rb");
+    std::vector<u8> state(file.GetSize());
+    if (!file.IsOpen() || file.ReadBytes(state.data(), state.size()) != state.size()) {
+        LOG_ERROR(Core, "Failed to read save state from {}", path);
+        return false;
+    }
+    return Load(state);
+}
+
+bool SaveStateManager::QuickSave() {
+    std::vector<u8> state = Save(SaveStateType::Full);
+    if (state.empty()) {
+        return false;
+    }
+    quick_save = std::move(state);
+    return true;
+}
+
+bool SaveStateManager::QuickLoad() {
+    if (quick_save.empty()) {
+        LOG_WARNING(Core, "There is no quick save to load");
+        return false;
+    }
+    return Load(quick_save);
+}
+
+} // namespace Core
@@ -0,0 +1,110 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+
+class System;
+
+enum class SaveStateType : u32 {
+    /// Contains the whole machine state. Zero-filled memory pages are omitted.
+    Full,
+    /// Only contains the memory pages that changed since the previous state saved or loaded by the
+    /// same SaveStateManager, and can only be loaded on top of that state.
+    Delta,
+};
+
+/**
+ * Saves and loads snapshots of the emulated machine.
+ *
+ * A save state is a fixed-size header, which records the format version, emulator revision,
+ * program ID and emulation session the state was made with, followed by a compressed PointerWrap
+ * payload of versioned sections: kernel, core timing, GPU/LCD registers, Pica state and memory
+ * (FCRAM, VRAM, DSP RAM and the New 3DS extra RAM, stored page by page).
+ *
+ * Saving and loading must happen on the emulation thread, between two System::RunLoop calls.
+ * Loading parses and checks every section before any of them is applied, so a state that is
+ * refused leaves the running system untouched.
+ *
+ * The kernel section stores the threads with their scheduling and wait state, and the kernel
+ * objects they refer to (see Kernel::KernelSnapshot). HLE services and the DSP keep their state in
+ * host objects that aren't saved, so states are refused outside of the session that created them,
+ * and can't be saved while a thread waits for an HLE service to reply. The quick save is only kept
+ * in memory for the same reason.
+ */
+class SaveStateManager {
+public:
+    explicit SaveStateManager(System& system);
+    ~SaveStateManager();
+
+    /**
+     * Creates a save state. A delta state is created as a full state if there is no previous state
+     * to base it on.
+     * @returns an empty vector if the state can't be saved right now, because a thread waits for
+     *          an HLE service.
+     */
+    std::vector<u8> Save(SaveStateType type);
+
+    /**
+     * Restores a save state.
+     * @returns false if the state is invalid, was made by another emulator revision, program or
+     *          emulation session, is a delta state that doesn't apply to the current state, or
+     *          refers to kernel objects that no longer exist.
+     */
+    bool Load(const std::vector<u8>& state);
+
+    bool SaveToFile(const std::string& path, SaveStateType type);
+    bool LoadFromFile(const std::string& path);
+
+    /**
+     * Replaces the quick save with a full state of the running system.
+     * @returns false if the state can't be saved right now, see Save.
+     */
+    bool QuickSave();
+
+    /// Restores the quick save. Returns false if there is none or it can't be loaded.
+    bool QuickLoad();
+
+private:
+    struct MemoryRegion {
+        PAddr paddr;
+        u32 size;
+        /// Hash of every page at the time of the last state saved or loaded
+        std::vector<u64> page_hashes;
+    };
+
+    /// Returns the pages of region that must be stored, and fills new_hashes with all page hashes
+    std::vector<u32> CollectPages(const MemoryRegion& region, SaveStateType type,
+                                  std::vector<u64>& new_hashes) const;
+
+    /// The sections of a save state
+    struct Payload;
+
+    /// Returns false if a parsed payload can't be applied to the running system
+    bool CanApplyPayload(const Payload& payload) const;
+    void ApplyPayload(const Payload& payload, SaveStateType type);
+
+    /// Recomputes the page hashes after a state was loaded
+    void RehashMemory();
+
+    System& system;
+    std::vector<MemoryRegion> regions;
+
+    /// Identifies the emulation session, states created in other sessions can't be loaded
+    const u64 session_id;
+    /// The last quick save of this session
+    std::vector<u8> quick_save;
+
+    /// Identifies a chain of states starting with a full state. Zero if there is no previous state.
+    u64 chain_id = 0;
+    /// Position of the last state saved or loaded in its chain
+    u32 sequence = 0;
+};
+
+} // namespace Core
@@ -126,6 +126,7 @@ struct Values {
 
     // Core
     bool use_cpu_jit;
+    bool use_fastmem;
 
     // Data Storage
     bool use_virtual_sd;
@@ -142,10 +143,13 @@ struct Values {
     bool shaders_accurate_gs;
     bool shaders_accurate_mul;
     bool use_shader_jit;
+    bool use_disk_shader_cache;
+    bool use_texture_dedup;
     u16 resolution_factor;
     bool vsync_enabled;
     bool use_frame_limit;
     u16 frame_limit;
+    bool use_asynchronous_gpu_emulation;
 
     LayoutOption layout_option;
     bool swap_screen;
@@ -0,0 +1,183 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/hw/gpu.h"
+#include "core/hw/hw.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/tracer/player.h"
+#include "video_core/pica_state.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace CiTrace {
+
+namespace {
+
+// Register writes are recorded with their physical address, but HW::Write takes the virtual one
+constexpr u32 IO_PADDR = 0x10100000;
+constexpr u32 IO_VADDR = 0x1EC00000;
+
+/// Copies a register section over a register struct, ignoring the words that don't fit
+template <typename T>
+void CopyRegisters(T& regs, const std::vector<u32>& words) {
+    std::memcpy(&regs, words.data(), std::min(sizeof(T), words.size() * sizeof(u32)));
+}
+
+/// Decodes float24 values stored four per entry. Only the first three components are recorded.
+template <typename T>
+void CopyFloat24Vectors(T* vectors, std::size_t count, const std::vector<u32>& words) {
+    count = std::min(count, words.size() / 4);
+    for (std::size_t i = 0; i < count; ++i) {
+        for (std::size_t comp = 0; comp < 3; ++comp) {
+            vectors[i][comp] = Pica::float24::FromRaw(words[4 * i + comp]);
+        }
+    }
+}
+
+} // Anonymous namespace
+
+Player::Player(Memory::MemorySystem& memory) : memory(memory) {}
+
+bool Player::Load(const std::string& filename) {
+    FileUtil::IOFile file(filename, "rb");
+    data.resize(file.GetSize());
+    if (!file.IsOpen() || file.ReadBytes(data.data(), data.size()) != data.size()) {
+        LOG_ERROR(HW_GPU, "Failed to read CiTrace file {}", filename);
+        return false;
+    }
+
+    if (data.size() < sizeof(header)) {
+        LOG_ERROR(HW_GPU, "CiTrace file is too small");
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, CTHeader::ExpectedMagicWord(), 4) != 0 ||
+        header.version != CTHeader::ExpectedVersion()) {
+        LOG_ERROR(HW_GPU, "{} is not a CiTrace file of a supported version", filename);
+        return false;
+    }
+
+    const u64 stream_end =
+        header.stream_offset + static_cast<u64>(header.stream_size) * sizeof(CTStreamElement);
+    if (stream_end > data.size()) {
+        LOG_ERROR(HW_GPU, "CiTrace command stream is truncated");
+        return false;
+    }
+    stream.resize(header.stream_size);
+    std::memcpy(stream.data(), data.data() + header.stream_offset,
+                stream.size() * sizeof(CTStreamElement));
+
+    num_frames = static_cast<u32>(
+        std::count_if(stream.begin(), stream.end(), [](const CTStreamElement& element) {
+            return element.type == FrameMarker;
+        }));
+    position = 0;
+    return true;
+}
+
+std::vector<u32> Player::ReadSection(u32 offset, u32 size) const {
+    if (offset + static_cast<u64>(size) * sizeof(u32) > data.size()) {
+        LOG_ERROR(HW_GPU, "CiTrace section at {:#X} is out of bounds", offset);
+        return {};
+    }
+    std::vector<u32> words(size);
+    std::memcpy(words.data(), data.data() + offset, size * sizeof(u32));
+    return words;
+}
+
+void Player::Reset() {
+    const auto& initial = header.initial_state_offsets;
+
+    CopyRegisters(GPU::g_regs, ReadSection(initial.gpu_registers, initial.gpu_registers_size));
+    CopyRegisters(LCD::g_regs, ReadSection(initial.lcd_registers, initial.lcd_registers_size));
+
+    auto& state = Pica::g_state;
+    CopyRegisters(state.regs, ReadSection(initial.pica_registers, initial.pica_registers_size));
+    CopyFloat24Vectors(state.input_default_attributes.attr, 16,
+                       ReadSection(initial.default_attributes, initial.default_attributes_size));
+    CopyFloat24Vectors(state.vs.uniforms.f, 96,
+                       ReadSection(initial.vs_float_uniforms, initial.vs_float_uniforms_size));
+
+    const auto program = ReadSection(initial.vs_program_binary, initial.vs_program_binary_size);
+    std::copy_n(program.begin(), std::min(program.size(), state.vs.program_code.size()),
+                state.vs.program_code.begin());
+    const auto swizzle = ReadSection(initial.vs_swizzle_data, initial.vs_swizzle_data_size);
+    std::copy_n(swizzle.begin(), std::min(swizzle.size(), state.vs.swizzle_data.size()),
+                state.vs.swizzle_data.begin());
+    state.vs.MarkProgramCodeDirty();
+    state.vs.MarkSwizzleDataDirty();
+    state.vs.engine_data.cached_shader = nullptr;
+    // The recorder doesn't store the geometry shader state yet
+
+    state.primitive_assembler.Reconfigure(state.regs.pipeline.triangle_topology);
+    state.immediate.reset_geometry_pipeline = true;
+    for (u32 id = 0; id < Pica::Regs::NUM_REGS; ++id) {
+        VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
+    }
+
+    position = 0;
+}
+
+void Player::ApplyMemoryLoad(const CTMemoryLoad& load) {
+    if (load.file_offset + static_cast<u64>(load.size) > data.size() ||
+        !memory.IsValidPhysicalAddress(load.physical_address) ||
+        !memory.IsValidPhysicalAddress(load.physical_address + load.size - 1)) {
+        LOG_ERROR(HW_GPU, "Skipping invalid memory load of {:#X} bytes at {:08X}", load.size,
+                  load.physical_address);
+        return;
+    }
+    std::memcpy(memory.GetPhysicalPointer(load.physical_address), data.data() + load.file_offset,
+                load.size);
+}
+
+void Player::ApplyRegisterWrite(const CTRegisterWrite& write) {
+    const u32 addr = write.physical_address - IO_PADDR + IO_VADDR;
+    switch (write.size) {
+    case CTRegisterWrite::SIZE_8:
+        HW::Write<u8>(addr, static_cast<u8>(write.value));
+        break;
+    case CTRegisterWrite::SIZE_16:
+        HW::Write<u16>(addr, static_cast<u16>(write.value));
+        break;
+    case CTRegisterWrite::SIZE_32:
+        HW::Write<u32>(addr, static_cast<u32>(write.value));
+        break;
+    case CTRegisterWrite::SIZE_64:
+        HW::Write<u64>(addr, write.value);
+        break;
+    default:
+        LOG_ERROR(HW_GPU, "Skipping register write with unknown size {:#X}",
+                  static_cast<u32>(write.size));
+        break;
+    }
+}
+
+bool Player::ReplayFrame() {
+    while (position < stream.size()) {
+        const CTStreamElement& element = stream[position++];
+        switch (element.type) {
+        case FrameMarker:
+            return true;
+        case MemoryLoad:
+            ApplyMemoryLoad(element.memory_load);
+            break;
+        case RegisterWrite:
+            ApplyRegisterWrite(element.register_write);
+            break;
+        default:
+            LOG_ERROR(HW_GPU, "Skipping unknown stream element type {:#X}",
+                      static_cast<u32>(element.type));
+            break;
+        }
+    }
+    return false;
+}
+
+} // namespace CiTrace
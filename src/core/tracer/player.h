@@ -0,0 +1,63 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "core/tracer/citrace.h"
+
+namespace Memory {
+class MemorySystem;
+}
+
+namespace CiTrace {
+
+/**
+ * Replays a CiTrace recorded by CiTrace::Recorder. The trace drives the emulated GPU through the
+ * same register writes as the recorded application, so VideoCore must be initialized with a
+ * renderer, but no emulated system is needed.
+ */
+class Player {
+public:
+    explicit Player(Memory::MemorySystem& memory);
+
+    /**
+     * Loads a trace file.
+     * @returns false if the file can't be read or isn't a valid CiTrace
+     */
+    bool Load(const std::string& filename);
+
+    /// Restores the GPU state at the beginning of the trace and rewinds the command stream
+    void Reset();
+
+    /**
+     * Replays the command stream up to the end of the next frame.
+     * @returns false if the end of the trace was reached instead
+     */
+    bool ReplayFrame();
+
+    /// Number of frames in the trace
+    u32 NumFrames() const {
+        return num_frames;
+    }
+
+private:
+    /// Returns the words of an initial state section, or an empty vector if it is out of bounds
+    std::vector<u32> ReadSection(u32 offset, u32 size) const;
+
+    void ApplyMemoryLoad(const CTMemoryLoad& load);
+    void ApplyRegisterWrite(const CTRegisterWrite& write);
+
+    Memory::MemorySystem& memory;
+
+    std::vector<u8> data;
+    CTHeader header;
+    std::vector<CTStreamElement> stream;
+    std::size_t position = 0;
+    u32 num_frames = 0;
+};
+
+} // namespace CiTrace
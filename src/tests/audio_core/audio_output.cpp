@@ -0,0 +1,154 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "audio_core/dsp_interface.h"
+#include "audio_core/null_sink.h"
+#include "core/perf_stats.h"
+#include "core/settings.h"
+
+namespace {
+
+/// DSP that does nothing but output the frames it is given
+class TestDsp final : public AudioCore::DspInterface {
+public:
+    u16 RecvData(u32) override {
+        return 0;
+    }
+    bool RecvDataIsReady(u32) const override {
+        return true;
+    }
+    void SetSemaphore(u16) override {}
+    std::vector<u8> PipeRead(AudioCore::DspPipe, u32) override {
+        return {};
+    }
+    std::size_t GetPipeReadableSize(AudioCore::DspPipe) const override {
+        return 0;
+    }
+    void PipeWrite(AudioCore::DspPipe, const std::vector<u8>&) override {}
+    std::array<u8, Memory::DSP_RAM_SIZE>& GetDspMemory() override {
+        return dsp_memory;
+    }
+    void SetServiceToInterrupt(std::weak_ptr<Service::DSP::DSP_DSP>) override {}
+    void LoadComponent(const std::vector<u8>&) override {}
+    void UnloadComponent() override {}
+
+    using DspInterface::OutputFrame;
+
+private:
+    std::array<u8, Memory::DSP_RAM_SIZE> dsp_memory{};
+};
+
+/**
+ * Runs the output for the given number of sink callbacks. The DSP produces a frame every
+ * samples_per_frame frames of time, while the sink requests frames_per_pull frames every
+ * frames_per_pull frames of time. Each request comes up to max_jitter frames early, like a sink
+ * catching up after its audio thread was delayed.
+ */
+struct OutputSimulation {
+    TestDsp dsp;
+    Core::PerfStats perf_stats;
+    std::mt19937 rng{1234};
+    std::size_t frames_per_pull = 512;
+    std::size_t produced_frames = 0;
+    std::size_t pulls = 0;
+    s16 next_sample = 0;
+    std::vector<s16> pull_buffer;
+
+    OutputSimulation() {
+        Settings::values.volume = 1.0f;
+        dsp.SetSink("null", "null");
+        dsp.SetPerfStats(&perf_stats);
+        pull_buffer.resize(frames_per_pull * 2);
+    }
+
+    Core::PerfStats::Results Run(std::size_t num_pulls, std::size_t max_jitter) {
+        auto& sink = static_cast<AudioCore::NullSink&>(dsp.GetSink());
+        std::uniform_int_distribution<std::size_t> jitter(0, max_jitter);
+        for (std::size_t i = 0; i < num_pulls; i++, pulls++) {
+            const std::size_t pull_time =
+                pulls * frames_per_pull - std::min(jitter(rng), pulls * frames_per_pull);
+            while (produced_frames + AudioCore::samples_per_frame <= pull_time) {
+                AudioCore::StereoFrame16 frame;
+                for (auto& sample : frame) {
+                    sample = {next_sample, next_sample};
+                    next_sample++;
+                }
+                dsp.OutputFrame(frame);
+                produced_frames += AudioCore::samples_per_frame;
+            }
+            sink.Pull(pull_buffer.data(), frames_per_pull);
+        }
+        return perf_stats.GetAndResetStats(std::chrono::microseconds(0));
+    }
+};
+
+// Number of sink callbacks per second of audio
+constexpr std::size_t pulls_per_second = AudioCore::native_sample_rate / 512;
+
+} // Anonymous namespace
+
+TEST_CASE("DspInterface output: steady sink", "[audio_core]") {
+    OutputSimulation sim;
+    sim.Run(pulls_per_second, 0);
+
+    const auto results = sim.Run(10 * pulls_per_second, 0);
+    REQUIRE(results.audio_underruns == 0);
+    REQUIRE(results.audio_latency > 0.0);
+    REQUIRE(results.audio_latency < 0.050);
+}
+
+TEST_CASE("DspInterface output: samples are played in order", "[audio_core]") {
+    OutputSimulation sim;
+    auto& sink = static_cast<AudioCore::NullSink&>(sim.dsp.GetSink());
+    sim.Run(pulls_per_second, 0);
+
+    // Samples may be skipped while catching up, but never repeated or reordered
+    std::vector<s16> buffer(AudioCore::samples_per_frame * 2);
+    sink.Pull(buffer.data(), 1);
+    s16 previous = buffer[0];
+    for (int i = 0; i < 100; i++) {
+        AudioCore::StereoFrame16 frame;
+        for (auto& sample : frame) {
+            sample = {sim.next_sample, sim.next_sample};
+            sim.next_sample++;
+        }
+        sim.dsp.OutputFrame(frame);
+        sink.Pull(buffer.data(), AudioCore::samples_per_frame);
+        for (std::size_t j = 0; j < buffer.size(); j += 2) {
+            REQUIRE(buffer[j] == buffer[j + 1]);
+            const s16 delta = static_cast<s16>(buffer[j] - previous);
+            REQUIRE(delta >= 1);
+            REQUIRE(delta <= 2);
+            previous = buffer[j];
+        }
+    }
+}
+
+TEST_CASE("DspInterface output: adapts to jittery sink", "[audio_core]") {
+    OutputSimulation sim;
+    sim.Run(pulls_per_second, 0);
+    const auto steady = sim.Run(5 * pulls_per_second, 0);
+
+    // The sink sometimes runs up to 60ms early, which the initial latency can't absorb
+    constexpr std::size_t max_jitter = AudioCore::native_sample_rate * 60 / 1000;
+    const auto settling = sim.Run(5 * pulls_per_second, max_jitter);
+    REQUIRE(settling.audio_underruns > 0);
+
+    // Once adapted, the output keeps enough audio queued to ride out the jitter
+    const auto adapted = sim.Run(20 * pulls_per_second, max_jitter);
+    REQUIRE(adapted.audio_underruns == 0);
+    REQUIRE(adapted.audio_latency > steady.audio_latency);
+
+    // Once the sink is steady again, the latency is slowly brought back down
+    sim.Run(60 * pulls_per_second, 0);
+    const auto recovered = sim.Run(5 * pulls_per_second, 0);
+    REQUIRE(recovered.audio_underruns == 0);
+    REQUIRE(recovered.audio_latency < adapted.audio_latency);
+}
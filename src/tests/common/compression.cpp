@@ -0,0 +1,88 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/compression.h"
+
+namespace Common::Compression {
+
+static std::vector<u8> RoundTrip(const std::vector<u8>& data) {
+    const std::vector<u8> compressed = CompressBlock(data.data(), data.size());
+    std::vector<u8> decompressed(data.size());
+    REQUIRE(DecompressBlock(compressed.data(), compressed.size(), decompressed.data(),
+                            decompressed.size()));
+    return decompressed;
+}
+
+TEST_CASE("Compression round trips", "[common]") {
+    std::mt19937 rng(0x5a7e);
+
+    SECTION("short and empty blocks") {
+        for (std::size_t size = 0; size < 40; ++size) {
+            std::vector<u8> data(size);
+            for (std::size_t i = 0; i < size; ++i) {
+                data[i] = static_cast<u8>(i % 3);
+            }
+            REQUIRE(RoundTrip(data) == data);
+        }
+    }
+
+    SECTION("zero-filled memory") {
+        const std::vector<u8> data(0x10000, 0);
+        REQUIRE(RoundTrip(data) == data);
+        // Long runs need length extension bytes and overlapping matches
+        REQUIRE(CompressBlock(data.data(), data.size()).size() < 0x200);
+    }
+
+    SECTION("random data") {
+        std::vector<u8> data(0x4000);
+        for (u8& byte : data) {
+            byte = static_cast<u8>(rng());
+        }
+        REQUIRE(RoundTrip(data) == data);
+    }
+
+    SECTION("repeated structures with random gaps") {
+        std::vector<u8> data;
+        std::uniform_int_distribution<int> gap(0, 300);
+        while (data.size() < 0x20000) {
+            for (u32 i = 0; i < 64; ++i) {
+                data.push_back(static_cast<u8>(i * 7));
+            }
+            for (int i = gap(rng); i > 0; --i) {
+                data.push_back(static_cast<u8>(rng()));
+            }
+        }
+        REQUIRE(RoundTrip(data) == data);
+        REQUIRE(CompressBlock(data.data(), data.size()).size() < data.size());
+    }
+}
+
+TEST_CASE("Decompression rejects malformed blocks", "[common]") {
+    std::vector<u8> data(0x1000);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<u8>(i / 16);
+    }
+    const std::vector<u8> compressed = CompressBlock(data.data(), data.size());
+    std::vector<u8> out(data.size());
+
+    // Wrong decompressed size
+    REQUIRE_FALSE(DecompressBlock(compressed.data(), compressed.size(), out.data(), out.size() - 1));
+    std::vector<u8> larger(data.size() + 1);
+    REQUIRE_FALSE(
+        DecompressBlock(compressed.data(), compressed.size(), larger.data(), larger.size()));
+
+    // Truncated input
+    for (std::size_t size = 0; size < compressed.size(); ++size) {
+        REQUIRE_FALSE(DecompressBlock(compressed.data(), size, out.data(), out.size()));
+    }
+
+    // A match that points before the start of the output
+    const std::vector<u8> bad_offset{0x10, 'a', 0x02, 0x00, 0x00};
+    REQUIRE_FALSE(DecompressBlock(bad_offset.data(), bad_offset.size(), out.data(), 5));
+}
+
+} // namespace Common::Compression
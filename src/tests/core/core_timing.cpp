@@ -4,9 +4,13 @@
 
 #include <catch2/catch.hpp>
 
+#include <algorithm>
 #include <array>
 #include <bitset>
+#include <chrono>
 #include <string>
+#include <vector>
+#include "common/chunk_file.h"
 #include "common/file_util.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -226,3 +230,164 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
     REQUIRE(0 == reschedules);
     REQUIRE(MAX_SLICE_LENGTH == timing.GetDowncount());
 }
+
+TEST_CASE("CoreTiming[Reschedule]", "[core]") {
+    Core::Timing timing;
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+    Core::TimingEventType* cb_b = timing.RegisterEvent("callbackB", CallbackTemplate<1>);
+    Core::TimingEventType* cb_c = timing.RegisterEvent("callbackC", CallbackTemplate<2>);
+
+    // Enter slice 0
+    timing.Advance();
+
+    timing.ScheduleEvent(100, cb_a, CB_IDS[0]);
+    timing.ScheduleEvent(200, cb_b, CB_IDS[1]);
+    timing.ScheduleEvent(300, cb_c, CB_IDS[2]);
+    timing.ScheduleEvent(400, cb_c, CB_IDS[2]);
+
+    // B -> A, C is gone
+    timing.RescheduleEvent(500, cb_a, CB_IDS[0]);
+    timing.UnscheduleEvent(cb_c, CB_IDS[2]);
+    // Userdata must match too
+    timing.UnscheduleEvent(cb_b, CB_IDS[0]);
+
+    // The slice still ends where A was first scheduled
+    REQUIRE(100 == timing.GetDowncount());
+    timing.AddTicks(timing.GetDowncount());
+    timing.Advance();
+    REQUIRE(100 == timing.GetDowncount());
+
+    AdvanceAndCheck(timing, 1, 300);
+    AdvanceAndCheck(timing, 0, MAX_SLICE_LENGTH);
+}
+
+TEST_CASE("CoreTiming[Snapshot]", "[core]") {
+    Core::Timing timing;
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+    Core::TimingEventType* cb_b = timing.RegisterEvent("callbackB", CallbackTemplate<1>);
+    Core::TimingEventType* cb_c = timing.RegisterEvent("callbackC", CallbackTemplate<2>);
+
+    // Enter slice 0
+    timing.Advance();
+
+    timing.ScheduleEvent(100, cb_a, CB_IDS[0]);
+    timing.ScheduleEvent(300, cb_b, CB_IDS[1]);
+    timing.ScheduleEvent(600, cb_c, CB_IDS[2]);
+    Core::Timing::Snapshot snapshot = timing.TakeSnapshot();
+
+    // Write the snapshot the way save states do and parse it back
+    u8* measure_ptr = nullptr;
+    PointerWrap measure(&measure_ptr, PointerWrap::MODE_MEASURE);
+    snapshot.DoState(measure);
+    std::vector<u8> buffer(reinterpret_cast<std::size_t>(measure_ptr));
+    u8* ptr = buffer.data();
+    PointerWrap write(&ptr, PointerWrap::MODE_WRITE);
+    snapshot.DoState(write);
+    Core::Timing::Snapshot parsed;
+    ptr = buffer.data();
+    PointerWrap read(&ptr, PointerWrap::MODE_READ);
+    parsed.DoState(read);
+    REQUIRE(read.error != PointerWrap::ERROR_FAILURE);
+
+    // Run A, drop B and schedule C again, then go back to the saved state
+    AdvanceAndCheck(timing, 0, 200);
+    timing.UnscheduleEvent(cb_b, CB_IDS[1]);
+    timing.RescheduleEvent(50, cb_c, CB_IDS[2]);
+    const u64 ticks = timing.GetTicks();
+
+    REQUIRE(timing.CanRestoreSnapshot(parsed));
+    timing.RestoreSnapshot(parsed);
+    REQUIRE(timing.GetTicks() < ticks);
+    REQUIRE(100 == timing.GetDowncount());
+
+    AdvanceAndCheck(timing, 0, 200);
+    AdvanceAndCheck(timing, 1, 300);
+    AdvanceAndCheck(timing, 2, MAX_SLICE_LENGTH);
+
+    // The events can't be restored without their types
+    Core::Timing other;
+    other.RegisterEvent("callbackA", CallbackTemplate<0>);
+    REQUIRE_FALSE(other.CanRestoreSnapshot(parsed));
+}
+
+namespace ManyEventsTest {
+static std::vector<u64> fired;
+
+static void Callback(u64 userdata, s64 cycles_late) {
+    fired.push_back(userdata);
+}
+} // namespace ManyEventsTest
+
+TEST_CASE("CoreTiming[ManyEvents]", "[core]") {
+    using namespace ManyEventsTest;
+
+    Core::Timing timing;
+    Core::TimingEventType* cb = timing.RegisterEvent("callback", Callback);
+
+    // Enter slice 0
+    timing.Advance();
+
+    // Scatter the events over a few slices, then move or cancel some of them
+    constexpr u64 num_events = 4000;
+    std::vector<s64> times(num_events);
+    for (u64 i = 0; i < num_events; ++i) {
+        times[i] = static_cast<s64>((i * 7919) % 50000) + 1;
+        timing.ScheduleEvent(times[i], cb, i);
+    }
+    for (u64 i = 0; i < num_events; i += 3) {
+        times[i] = static_cast<s64>((i * 104729) % 50000) + 1;
+        timing.RescheduleEvent(times[i], cb, i);
+    }
+    for (u64 i = 1; i < num_events; i += 5) {
+        times[i] = -1;
+        timing.UnscheduleEvent(cb, i);
+    }
+
+    std::vector<u64> expected;
+    for (u64 i = 0; i < num_events; ++i) {
+        if (times[i] != -1) {
+            expected.push_back(i);
+        }
+    }
+    // Events due at the same time run in the order they were (re)scheduled
+    std::stable_sort(expected.begin(), expected.end(), [&times](u64 a, u64 b) {
+        return times[a] < times[b] || (times[a] == times[b] && a % 3 != 0 && b % 3 == 0);
+    });
+
+    fired.clear();
+    while (fired.size() < expected.size()) {
+        timing.AddTicks(timing.GetDowncount());
+        timing.Advance();
+    }
+    REQUIRE(fired == expected);
+}
+
+TEST_CASE("CoreTiming[Benchmark]", "[.][benchmark]") {
+    Core::Timing timing;
+    Core::TimingEventType* cb = timing.RegisterEvent("callback", [](u64, s64) {});
+    timing.Advance();
+
+    for (const u64 num_events : {1000, 10000, 100000}) {
+        for (u64 i = 0; i < num_events; ++i) {
+            timing.ScheduleEvent(static_cast<s64>(i * 7919 % 1000000) + 1000000, cb, i);
+        }
+
+        // Mimics timers being re-armed and threads being woken up early
+        constexpr int iterations = 100000;
+        const auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            const u64 userdata = static_cast<u64>(i) * 104729 % num_events;
+            timing.RescheduleEvent(static_cast<s64>(i * 31 % 1000000) + 1000000, cb, userdata);
+            timing.UnscheduleEvent(cb, userdata);
+            timing.ScheduleEvent(static_cast<s64>(i * 17 % 1000000) + 1000000, cb, userdata);
+        }
+        const std::chrono::duration<double, std::nano> duration =
+            std::chrono::steady_clock::now() - begin;
+        WARN(num_events << " pending events: " << duration.count() / iterations
+                        << " ns per reschedule, unschedule and schedule");
+
+        timing.RemoveEvent(cb);
+    }
+}
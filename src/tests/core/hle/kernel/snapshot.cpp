@@ -0,0 +1,181 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include "common/chunk_file.h"
+#include "core/arm/dyncom/arm_dyncom.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/client_port.h"
+#include "core/hle/kernel/client_session.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/semaphore.h"
+#include "core/hle/kernel/server_session.h"
+#include "core/hle/kernel/snapshot.h"
+#include "core/hle/kernel/svc.h"
+#include "core/hle/kernel/thread.h"
+#include "core/memory.h"
+
+namespace Kernel {
+
+static constexpr VAddr ENTRY_POINT = 0x00100000;
+
+/// Writes the snapshot the way save states do and parses it back
+static KernelSnapshot Serialize(KernelSnapshot& snapshot) {
+    u8* measure_ptr = nullptr;
+    PointerWrap measure(&measure_ptr, PointerWrap::MODE_MEASURE);
+    snapshot.DoState(measure);
+    std::vector<u8> buffer(reinterpret_cast<std::size_t>(measure_ptr));
+
+    u8* ptr = buffer.data();
+    PointerWrap write(&ptr, PointerWrap::MODE_WRITE);
+    snapshot.DoState(write);
+
+    KernelSnapshot parsed;
+    ptr = buffer.data();
+    PointerWrap read(&ptr, PointerWrap::MODE_READ);
+    parsed.DoState(read);
+    REQUIRE(read.error != PointerWrap::ERROR_FAILURE);
+    REQUIRE(ptr == buffer.data() + buffer.size());
+    return parsed;
+}
+
+/// Makes the thread wait for the object, as svcWaitSynchronization1 does
+static void WaitFor(Thread& thread, SharedPtr<WaitObject> object, Memory::MemorySystem& memory) {
+    thread.status = ThreadStatus::WaitSynchAny;
+    thread.wait_objects = {object};
+    object->AddWaitingThread(&thread);
+    thread.wakeup_callback =
+        GetSVCWakeupCallback(WakeupCallbackType::WaitSynchronization1, memory);
+    thread.wakeup_callback_type = WakeupCallbackType::WaitSynchronization1;
+}
+
+TEST_CASE("KernelSystem::RestoreSnapshot", "[core][kernel]") {
+    Core::Timing timing;
+    Memory::MemorySystem memory;
+    KernelSystem kernel(memory, timing, [] {}, 0);
+    ARM_DynCom cpu(nullptr, memory, USER32MODE);
+    kernel.GetThreadManager().SetCPU(cpu);
+    ThreadManager& thread_manager = kernel.GetThreadManager();
+
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    kernel.SetCurrentProcess(process);
+    process->vm_manager
+        .MapBackingMemory(ENTRY_POINT, memory.GetFCRAMPointer(0), Memory::PAGE_SIZE,
+                          MemoryState::Private)
+        .Unwrap();
+
+    const auto create_thread = [&](const std::string& name, u32 priority) {
+        auto thread =
+            kernel.CreateThread(name, ENTRY_POINT, priority, 0, 0, 0x10000000, *process).Unwrap();
+        thread->ResumeFromWait();
+        return thread;
+    };
+    auto high = create_thread("high", 0x30);
+    auto low = create_thread("low", 0x31);
+
+    auto event = kernel.CreateEvent(ResetType::OneShot);
+    const Handle event_handle = process->handle_table.Create(event).Unwrap();
+    auto semaphore = kernel.CreateSemaphore(1, 4).Unwrap();
+    process->handle_table.Create(semaphore).Unwrap();
+
+    // The high priority thread runs first and waits for the event, then the low priority one runs
+    thread_manager.Reschedule();
+    REQUIRE(thread_manager.GetCurrentThread() == high.get());
+    WaitFor(*high, event, memory);
+    thread_manager.Reschedule();
+    REQUIRE(thread_manager.GetCurrentThread() == low.get());
+
+    KernelSnapshot snapshot;
+    REQUIRE(kernel.TakeSnapshot(snapshot));
+
+    SECTION("restores scheduling, waits and objects") {
+        // Wake the waiting thread, which preempts the running one
+        event->Signal();
+        thread_manager.Reschedule();
+        REQUIRE(thread_manager.GetCurrentThread() == high.get());
+        REQUIRE(low->status == ThreadStatus::Ready);
+        low->SetPriority(0x20);
+
+        // Change and destroy objects
+        semaphore->Release(2).Unwrap();
+        const u32 event_id = event->GetObjectId();
+        REQUIRE(process->handle_table.Close(event_handle) == RESULT_SUCCESS);
+        event = nullptr;
+
+        const KernelSnapshot parsed = Serialize(snapshot);
+        REQUIRE(kernel.CanRestoreSnapshot(parsed));
+        kernel.RestoreSnapshot(parsed);
+
+        REQUIRE(thread_manager.GetCurrentThread() == low.get());
+        REQUIRE(low->status == ThreadStatus::Running);
+        REQUIRE(low->current_priority == 0x31);
+        REQUIRE(semaphore->available_count == 1);
+
+        // The event was created again, with the high priority thread waiting for it
+        event = process->handle_table.Get<Event>(event_handle);
+        REQUIRE(event != nullptr);
+        REQUIRE(event->GetObjectId() == event_id);
+        REQUIRE(event->ShouldWait(high.get()));
+        REQUIRE(high->status == ThreadStatus::WaitSynchAny);
+        REQUIRE(high->wait_objects.size() == 1);
+        REQUIRE(high->wait_objects[0] == event);
+        REQUIRE(event->GetWaitingThreads().size() == 1);
+        REQUIRE(event->GetWaitingThreads()[0] == high);
+
+        // The restored wait behaves like the original one
+        REQUIRE(high->wakeup_callback != nullptr);
+        event->Signal();
+        REQUIRE(high->status == ThreadStatus::Ready);
+        REQUIRE(high->wait_objects.empty());
+        thread_manager.Reschedule();
+        REQUIRE(thread_manager.GetCurrentThread() == high.get());
+    }
+
+    SECTION("stops threads created after the save") {
+        auto later = create_thread("later", 0x20);
+        const VAddr later_tls = later->GetTLSAddress();
+
+        REQUIRE(kernel.CanRestoreSnapshot(snapshot));
+        kernel.RestoreSnapshot(snapshot);
+
+        REQUIRE(later->status == ThreadStatus::Dead);
+        const auto& threads = thread_manager.GetThreadList();
+        REQUIRE(std::find(threads.begin(), threads.end(), later) == threads.end());
+        REQUIRE(threads.size() == 2);
+
+        // Its thread local storage is free again
+        REQUIRE(create_thread("again", 0x20)->GetTLSAddress() == later_tls);
+    }
+
+    SECTION("refuses states that need destroyed host objects") {
+        auto [server, client] = kernel.CreateSessionPair();
+        const Handle server_handle = process->handle_table.Create(server).Unwrap();
+        KernelSnapshot with_session;
+        REQUIRE(kernel.TakeSnapshot(with_session));
+
+        REQUIRE(process->handle_table.Close(server_handle) == RESULT_SUCCESS);
+        server = nullptr;
+        client = nullptr;
+        REQUIRE_FALSE(kernel.CanRestoreSnapshot(with_session));
+    }
+
+    SECTION("refuses states made with other memory mappings") {
+        process->vm_manager
+            .MapBackingMemory(ENTRY_POINT + Memory::PAGE_SIZE, memory.GetFCRAMPointer(0),
+                              Memory::PAGE_SIZE, MemoryState::Private)
+            .Unwrap();
+        REQUIRE_FALSE(kernel.CanRestoreSnapshot(snapshot));
+    }
+
+    SECTION("refuses inconsistent states") {
+        snapshot.ready_queue.push_back(high->GetObjectId());
+        REQUIRE_FALSE(kernel.CanRestoreSnapshot(snapshot));
+    }
+}
+
+} // namespace Kernel
@@ -0,0 +1,150 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <cryptopp/sha.h>
+#include "common/alignment.h"
+#include "common/file_util.h"
+#include "common/swap.h"
+#include "core/file_sys/cia_common.h"
+#include "core/file_sys/cia_container.h"
+#include "core/file_sys/ticket.h"
+#include "core/file_sys/title_metadata.h"
+#include "core/hle/service/am/am.h"
+#include "core/hle/service/fs/archive.h"
+
+namespace Service::AM {
+
+namespace {
+
+/// A title in the range used by homebrew, which is installed to the SD card
+constexpr u64 TITLE_ID = 0x000400000FF3FF00;
+constexpr char CIA_PATH[] = "./test.cia";
+
+constexpr u32 SECTION_ALIGNMENT = 0x40;
+/// Where the body of a ticket or TMD starts, after an RSA-2048 signature
+constexpr std::size_t BODY_OFFSET = 0x140;
+
+struct TestContent {
+    std::vector<u8> data;
+    /// Whether the content is included in the CIA, or only listed in the TMD
+    bool present;
+};
+
+void Put32(std::vector<u8>& cia, std::size_t offset, u32 value) {
+    std::memcpy(cia.data() + offset, &value, sizeof(value));
+}
+
+/// Builds an unencrypted CIA holding the given contents
+std::vector<u8> BuildCIA(const std::vector<TestContent>& contents) {
+    const u32_be signature_type = FileSys::TMDSignatureType::Rsa2048Sha256;
+    const u32 ticket_size = static_cast<u32>(BODY_OFFSET + sizeof(FileSys::Ticket::Body));
+    const u32 tmd_size = static_cast<u32>(BODY_OFFSET + sizeof(FileSys::TitleMetadata::Body) +
+                                          contents.size() *
+                                              sizeof(FileSys::TitleMetadata::ContentChunk));
+
+    const std::size_t ticket_offset = Common::AlignUp(FileSys::CIA_HEADER_SIZE, SECTION_ALIGNMENT);
+    const std::size_t tmd_offset = Common::AlignUp(ticket_offset + ticket_size, SECTION_ALIGNMENT);
+    const std::size_t content_offset = Common::AlignUp(tmd_offset + tmd_size, SECTION_ALIGNMENT);
+    std::vector<u8> cia(content_offset);
+
+    // Header, without certificates or metadata
+    Put32(cia, 0x00, static_cast<u32>(FileSys::CIA_HEADER_SIZE));
+    Put32(cia, 0x0C, ticket_size);
+    Put32(cia, 0x10, tmd_size);
+    u64 content_size = 0;
+    for (std::size_t i = 0; i < contents.size(); ++i) {
+        if (contents[i].present) {
+            cia[0x20 + i / 8] |= static_cast<u8>(0x80 >> (i % 8));
+            content_size += contents[i].data.size();
+        }
+    }
+    std::memcpy(cia.data() + 0x18, &content_size, sizeof(content_size));
+
+    std::memcpy(cia.data() + ticket_offset, &signature_type, sizeof(signature_type));
+
+    std::memcpy(cia.data() + tmd_offset, &signature_type, sizeof(signature_type));
+    FileSys::TitleMetadata::Body tmd{};
+    tmd.title_id = TITLE_ID;
+    tmd.content_count = static_cast<u16>(contents.size());
+    std::memcpy(cia.data() + tmd_offset + BODY_OFFSET, &tmd, sizeof(tmd));
+    for (std::size_t i = 0; i < contents.size(); ++i) {
+        FileSys::TitleMetadata::ContentChunk chunk{};
+        chunk.id = static_cast<u32>(i);
+        chunk.index = static_cast<u16>(i);
+        chunk.size = contents[i].data.size();
+        CryptoPP::SHA256().CalculateDigest(chunk.hash.data(), contents[i].data.data(),
+                                           contents[i].data.size());
+        std::memcpy(cia.data() + tmd_offset + BODY_OFFSET + sizeof(tmd) + i * sizeof(chunk),
+                    &chunk, sizeof(chunk));
+    }
+
+    for (const TestContent& content : contents) {
+        if (content.present) {
+            cia.insert(cia.end(), content.data.begin(), content.data.end());
+        }
+    }
+    return cia;
+}
+
+std::vector<u8> MakeData(std::size_t size, u8 seed) {
+    std::vector<u8> data(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<u8>(i * 31 + seed);
+    }
+    return data;
+}
+
+InstallStatus Install(const std::vector<u8>& cia) {
+    REQUIRE(FileUtil::IOFile(CIA_PATH, "wb").WriteBytes(cia.data(), cia.size()) == cia.size());
+    return InstallCIA(CIA_PATH);
+}
+
+std::vector<u8> ReadInstalledContent(u16 index) {
+    FileUtil::IOFile file(GetTitleContentPath(FS::MediaType::SDMC, TITLE_ID, index), "rb");
+    std::vector<u8> data(file.IsOpen() ? file.GetSize() : 0);
+    file.ReadBytes(data.data(), data.size());
+    return data;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("InstallCIA streams and verifies contents", "[core][am]") {
+    const std::string title_path = GetTitlePath(FS::MediaType::SDMC, TITLE_ID);
+    FileUtil::DeleteDirRecursively(title_path);
+
+    // Larger than a chunk of the install pipeline, so each content takes several chunks
+    const std::vector<TestContent> contents{
+        {MakeData(0x240000, 1), true},
+        {MakeData(0x1000, 2), false},
+        {MakeData(0x180123, 3), true},
+    };
+    std::vector<u8> cia = BuildCIA(contents);
+
+    SECTION("skips contents left out of the CIA") {
+        REQUIRE(Install(cia) == InstallStatus::Success);
+        REQUIRE(ReadInstalledContent(0) == contents[0].data);
+        REQUIRE(ReadInstalledContent(2) == contents[2].data);
+        REQUIRE_FALSE(FileUtil::Exists(GetTitleContentPath(FS::MediaType::SDMC, TITLE_ID, 1)));
+    }
+
+    SECTION("rejects contents that don't match the TMD") {
+        cia[cia.size() - 0x1000] ^= 0xFF;
+        REQUIRE(Install(cia) == InstallStatus::ErrorAborted);
+        REQUIRE_FALSE(FileUtil::Exists(GetTitleContentPath(FS::MediaType::SDMC, TITLE_ID, 2)));
+    }
+
+    SECTION("rejects truncated files") {
+        cia.resize(cia.size() - 0x1000);
+        REQUIRE(Install(cia) == InstallStatus::ErrorAborted);
+        REQUIRE_FALSE(FileUtil::Exists(GetTitleContentPath(FS::MediaType::SDMC, TITLE_ID, 2)));
+    }
+
+    FileUtil::DeleteDirRecursively(title_path);
+    FileUtil::Delete(CIA_PATH);
+}
+
+} // namespace Service::AM
@@ -0,0 +1,167 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+#include <httplib.h>
+#include "core/hle/service/http_engine.h"
+
+namespace Service::HTTP {
+
+namespace {
+
+/// An HTTP server on a loopback port, running for the lifetime of the object
+class TestServer {
+public:
+    TestServer() {
+        server.Get("/data", [this](const httplib::Request&, httplib::Response& response) {
+            response.set_content(body, "application/octet-stream");
+        });
+        server.Get("/headers", [](const httplib::Request& request, httplib::Response& response) {
+            response.status = 201;
+            response.set_header("X-Echo", request.get_header_value("X-Test").c_str());
+            response.set_content("ok", "text/plain");
+        });
+        server.Post("/form", [](const httplib::Request& request, httplib::Response& response) {
+            response.set_content(request.body, "text/plain");
+        });
+
+        for (std::size_t i = 0; i < body.size(); ++i) {
+            body[i] = static_cast<char>(i * 7 + i / 251);
+        }
+        port = server.bind_to_any_port("127.0.0.1");
+        thread = std::thread([this] { server.listen_after_bind(); });
+        // Stopping the server before it starts listening would not stop it
+        while (!server.is_running()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    ~TestServer() {
+        server.stop();
+        thread.join();
+    }
+
+    std::string Url(const char* path) const {
+        return fmt::format("http://127.0.0.1:{}{}", port, path);
+    }
+
+    std::string body = std::string(4 * 1024 * 1024, '\0');
+
+private:
+    httplib::Server server;
+    int port;
+    std::thread thread;
+};
+
+/// Waits for the engine to report progress
+class Updates {
+public:
+    RequestEngine::UpdateCallback Callback() {
+        return [this](u64 tag) {
+            std::lock_guard lock(mutex);
+            ++count;
+            cv.notify_all();
+        };
+    }
+
+    template <typename Predicate>
+    bool WaitUntil(Predicate predicate) {
+        std::unique_lock lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(10), predicate);
+    }
+
+    /// Waits for an update that came after the previous call
+    void WaitForNext() {
+        std::unique_lock lock(mutex);
+        cv.wait_for(lock, std::chrono::seconds(10), [this] { return count > seen; });
+        seen = count;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t count = 0;
+    std::size_t seen = 0;
+};
+
+RequestEngine::Job::State WaitForResponse(Updates& updates, RequestEngine::Job& job) {
+    updates.WaitUntil([&] { return job.GetState() != RequestEngine::Job::State::Sending; });
+    return job.GetState();
+}
+
+} // Anonymous namespace
+
+TEST_CASE("RequestEngine streams response bodies", "[core][http]") {
+    TestServer server;
+    Updates updates;
+    RequestEngine engine(updates.Callback());
+
+    for (int i = 0; i < 2; ++i) {
+        const auto job = engine.Start({"GET", server.Url("/data"), {}, {}}, 1);
+        REQUIRE(WaitForResponse(updates, *job) != RequestEngine::Job::State::Failed);
+        REQUIRE(job->GetStatusCode() == 200);
+        REQUIRE(job->GetContentLength() == server.body.size());
+
+        // Read in small pieces, like a guest with a small buffer would
+        std::string received;
+        std::vector<u8> buffer(0x1000);
+        while (!job->IsBodyConsumed()) {
+            const std::size_t size = job->ReadBody(buffer.data(), buffer.size());
+            received.append(buffer.begin(), buffer.begin() + size);
+            if (size == 0) {
+                updates.WaitForNext();
+            }
+        }
+        REQUIRE(job->GetState() == RequestEngine::Job::State::Finished);
+        REQUIRE(received == server.body);
+    }
+}
+
+TEST_CASE("RequestEngine sends headers and form data", "[core][http]") {
+    TestServer server;
+    Updates updates;
+    RequestEngine engine(updates.Callback());
+
+    const auto headers_job =
+        engine.Start({"GET", server.Url("/headers"), {{"X-Test", "value"}}, {}}, 1);
+    REQUIRE(WaitForResponse(updates, *headers_job) != RequestEngine::Job::State::Failed);
+    REQUIRE(headers_job->GetStatusCode() == 201);
+    REQUIRE(headers_job->GetHeader("x-echo") == "value");
+    REQUIRE_FALSE(headers_job->GetHeader("X-Missing"));
+
+    const auto form_job =
+        engine.Start({"POST", server.Url("/form"), {}, {{"name", "a b&c"}, {"id", "3"}}}, 2);
+    REQUIRE(updates.WaitUntil(
+        [&] { return form_job->GetState() == RequestEngine::Job::State::Finished; }));
+    std::string form(64, '\0');
+    form.resize(form_job->ReadBody(reinterpret_cast<u8*>(form.data()), form.size()));
+    REQUIRE(form == "name=a+b%26c&id=3");
+}
+
+TEST_CASE("RequestEngine reports failed requests", "[core][http]") {
+    std::string url;
+    {
+        TestServer server;
+        url = server.Url("/data");
+    }
+
+    Updates updates;
+    RequestEngine engine(updates.Callback());
+    const auto job = engine.Start({"GET", url, {}, {}}, 1);
+    REQUIRE(WaitForResponse(updates, *job) == RequestEngine::Job::State::Failed);
+    REQUIRE(job->IsBodyConsumed());
+
+    const auto bad_scheme = engine.Start({"GET", "ftp://127.0.0.1/file", {}, {}}, 2);
+    REQUIRE(WaitForResponse(updates, *bad_scheme) == RequestEngine::Job::State::Failed);
+}
+
+} // namespace Service::HTTP
@@ -0,0 +1,173 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#ifndef _WIN32
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "core/hle/service/soc_reactor.h"
+
+namespace Service::SOC {
+
+namespace {
+
+/// Records the operations the reactor completed
+struct Completions {
+    void Add(u64 id) {
+        std::lock_guard lock(mutex);
+        ids.push_back(id);
+        cv.notify_all();
+    }
+
+    bool WaitFor(std::size_t count) {
+        std::unique_lock lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(5), [&] { return ids.size() >= count; });
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<u64> ids;
+};
+
+int MakeNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+/// Opens a non-blocking loopback listener, and returns its address through addr
+int Listen(sockaddr_in& addr) {
+    const int fd = MakeNonBlocking(socket(AF_INET, SOCK_STREAM, 0));
+    addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    REQUIRE(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    socklen_t addr_len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &addr_len);
+    REQUIRE(listen(fd, 4) == 0);
+    return fd;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("SocketReactor completes operations once sockets are ready", "[core][soc]") {
+    Completions completions;
+    SocketReactor reactor([&](u64 id) { completions.Add(id); });
+
+    sockaddr_in addr;
+    const int listener = Listen(addr);
+
+    int accepted = -1;
+    const u64 accept_id =
+        reactor.Submit({{static_cast<u32>(listener), true, false}}, [&] {
+            accepted = accept(listener, nullptr, nullptr);
+            return accepted != -1;
+        });
+
+    const int client = socket(AF_INET, SOCK_STREAM, 0);
+    REQUIRE(connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    REQUIRE(completions.WaitFor(1));
+    REQUIRE(completions.ids[0] == accept_id);
+    REQUIRE(accepted != -1);
+    MakeNonBlocking(accepted);
+
+    // A receive only completes once data arrives, and not on the spurious attempts before it
+    char received = 0;
+    int attempts = 0;
+    const u64 recv_id = reactor.Submit({{static_cast<u32>(accepted), true, false}}, [&] {
+        ++attempts;
+        return recv(accepted, &received, 1, 0) == 1;
+    });
+    REQUIRE(send(client, "x", 1, 0) == 1);
+    REQUIRE(completions.WaitFor(2));
+    REQUIRE(completions.ids[1] == recv_id);
+    REQUIRE(received == 'x');
+    REQUIRE(attempts >= 1);
+
+    // Completed operations can no longer be cancelled
+    REQUIRE_FALSE(reactor.Cancel(recv_id));
+
+    close(client);
+    close(accepted);
+    close(listener);
+}
+
+TEST_CASE("SocketReactor drops cancelled operations", "[core][soc]") {
+    Completions completions;
+    SocketReactor reactor([&](u64 id) { completions.Add(id); });
+
+    sockaddr_in addr;
+    const int listener = Listen(addr);
+    const auto never_completes = [] { return false; };
+
+    const u64 first = reactor.Submit({{static_cast<u32>(listener), true, false}}, never_completes);
+    const u64 second = reactor.Submit({{static_cast<u32>(listener), true, false}}, never_completes);
+    REQUIRE(reactor.Cancel(first));
+    REQUIRE_FALSE(reactor.Cancel(first));
+
+    const std::vector<u64> cancelled = reactor.CancelSocket(static_cast<u32>(listener));
+    REQUIRE(cancelled == std::vector<u64>{second});
+    REQUIRE(reactor.CancelSocket(static_cast<u32>(listener)).empty());
+
+    close(listener);
+    REQUIRE(completions.ids.empty());
+}
+
+TEST_CASE("SocketReactor handles sockets closed while a call is blocked", "[core][soc]") {
+    Completions completions;
+    auto reactor = std::make_unique<SocketReactor>([&](u64 id) { completions.Add(id); });
+
+    sockaddr_in addr;
+    const int listener = Listen(addr);
+    const int client = socket(AF_INET, SOCK_STREAM, 0);
+    REQUIRE(connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    const int accepted = MakeNonBlocking(accept(listener, nullptr, nullptr));
+    REQUIRE(accepted != -1);
+
+    // Blocked in a receive, as SOC:U does when the guest closes the socket from another thread
+    int stale_attempts = 0;
+    const u64 blocked = reactor->Submit({{static_cast<u32>(accepted), true, false}}, [&] {
+        ++stale_attempts;
+        return false;
+    });
+    const int reused_client = socket(AF_INET, SOCK_STREAM, 0);
+    REQUIRE(connect(reused_client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    REQUIRE(reactor->CancelSocket(static_cast<u32>(accepted)) == std::vector<u64>{blocked});
+    close(accepted);
+
+    // The descriptor is reused by the next socket, which must not run the dropped operation
+    const int reused = MakeNonBlocking(accept(listener, nullptr, nullptr));
+    REQUIRE(reused == accepted);
+
+    char received = 0;
+    const u64 recv_id = reactor->Submit({{static_cast<u32>(reused), true, false}},
+                                        [&] { return recv(reused, &received, 1, 0) == 1; });
+    REQUIRE(send(reused_client, "y", 1, 0) == 1);
+    REQUIRE(completions.WaitFor(1));
+    REQUIRE(completions.ids == std::vector<u64>{recv_id});
+    REQUIRE(received == 'y');
+    REQUIRE(stale_attempts == 0);
+
+    // Stopping the reactor with a call still blocked, as on shutdown, drops it without completing
+    reactor->Submit({{static_cast<u32>(reused), true, false}}, [] { return false; });
+    reactor.reset();
+    close(reused);
+    close(reused_client);
+    close(client);
+    close(listener);
+    REQUIRE(completions.ids.size() == 1);
+}
+
+} // namespace Service::SOC
+
+#endif
@@ -0,0 +1,257 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/hw/aes/ccm.h"
+#include "core/hw/aes/cipher.h"
+#include "core/hw/aes/key.h"
+
+using namespace HW::AES;
+
+namespace {
+
+// Test vectors from NIST SP 800-38A, appendix F
+constexpr AESKey key{0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                     0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+
+constexpr std::array<u8, 64> plain_text{
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73,
+    0x93, 0x17, 0x2a, 0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7,
+    0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51, 0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4,
+    0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef, 0xf6, 0x9f, 0x24, 0x45,
+    0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10};
+
+constexpr AESKey ctr{0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+                     0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
+
+constexpr std::array<u8, 64> ctr_cipher_text{
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99,
+    0x0d, 0xb6, 0xce, 0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff, 0x86, 0x17,
+    0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff, 0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3,
+    0x5e, 0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab, 0x1e, 0x03, 0x1d, 0xda,
+    0x2f, 0xbe, 0x03, 0xd1, 0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee};
+
+constexpr AESKey iv{0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+
+constexpr std::array<u8, 64> cbc_cipher_text{
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12,
+    0xe9, 0x19, 0x7d, 0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb,
+    0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2, 0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74,
+    0x3b, 0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16, 0x3f, 0xf1, 0xca, 0xa1,
+    0x68, 0x1f, 0xac, 0x09, 0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7};
+
+// Key and 12-byte nonce of NIST SP 800-38C, example 3. The 3DS variant of CCM has no associated
+// data and a 16-byte MAC, so the MACs below were computed with OpenSSL's AES-128-CCM using that
+// setup (the same harness reproduces examples 1 to 3 of SP 800-38C). The counter blocks only
+// depend on the key and nonce, so the first 24 bytes of cipher text are those of example 3.
+constexpr AESKey ccm_key{0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
+                         0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f};
+
+constexpr CCMNonce ccm_nonce{0x10, 0x11, 0x12, 0x13, 0x14, 0x15,
+                             0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b};
+
+/// Payload of SP 800-38C, example 4
+constexpr std::array<u8, 32> ccm_plain_text{
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f};
+
+/// Cipher text and MAC of the whole payload
+constexpr std::array<u8, 48> ccm_cipher_text{
+    0xe3, 0xb2, 0x01, 0xa9, 0xf5, 0xb7, 0x1a, 0x7a, 0x9b, 0x1c, 0xea, 0xec, 0xcd, 0x97, 0xe7, 0x0b,
+    0x61, 0x76, 0xaa, 0xd9, 0xa4, 0x42, 0x8a, 0xa5, 0x54, 0x1b, 0xd1, 0xd4, 0x16, 0xfa, 0x0c, 0xe3,
+    0x01, 0xc8, 0x51, 0x68, 0x11, 0x17, 0x33, 0x00, 0x58, 0x35, 0xc1, 0x71, 0x52, 0xd1, 0x9b, 0x4e};
+
+/**
+ * Cipher text and MAC of the first 24 bytes of the payload. 3DS puts the size aligned to the block
+ * size in B0, so the MAC is the standard one of the payload padded with zeros to 32 bytes.
+ */
+constexpr std::array<u8, 40> ccm_unaligned_cipher_text{
+    0xe3, 0xb2, 0x01, 0xa9, 0xf5, 0xb7, 0x1a, 0x7a, 0x9b, 0x1c, 0xea, 0xec, 0xcd, 0x97,
+    0xe7, 0x0b, 0x61, 0x76, 0xaa, 0xd9, 0xa4, 0x42, 0x8a, 0xa5, 0x6b, 0x49, 0x01, 0x30,
+    0x2f, 0xf8, 0xec, 0xdf, 0xa5, 0x72, 0x05, 0x09, 0xb5, 0x90, 0x00, 0x61};
+
+/// Large enough to be split across threads
+std::vector<u8> MakeLargeBuffer() {
+    std::vector<u8> data(5 * 1024 * 1024 + 7);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<u8>(i * 7 + (i >> 11));
+    }
+    return data;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("CTRCipher: known answer", "[core][aes]") {
+    std::array<u8, 64> data = plain_text;
+    CTRCipher(key, ctr).Process(data.data(), data.size());
+    REQUIRE(data == ctr_cipher_text);
+
+    // Unaligned seeks and splits give the same keystream
+    CTRCipher cipher(key, ctr);
+    cipher.Seek(5);
+    cipher.Process(ctr_cipher_text.data() + 5, data.data() + 5, 30);
+    cipher.Process(ctr_cipher_text.data() + 35, data.data() + 35, 29);
+    cipher.Seek(0);
+    cipher.Process(ctr_cipher_text.data(), data.data(), 5);
+    REQUIRE(data == plain_text);
+}
+
+TEST_CASE("CTRCipher: counter carries across 64 bits", "[core][aes]") {
+    AESKey low_ctr = ctr;
+    for (std::size_t i = 8; i < 16; ++i) {
+        low_ctr[i] = 0xFF;
+    }
+    std::array<u8, 32> data{};
+    CTRCipher(key, low_ctr).Process(data.data(), data.size());
+
+    AESKey next_ctr = low_ctr;
+    for (std::size_t i = 8; i < 16; ++i) {
+        next_ctr[i] = 0;
+    }
+    next_ctr[7]++;
+    std::array<u8, 16> next{};
+    CTRCipher(key, next_ctr).Process(next.data(), next.size());
+    REQUIRE(std::equal(next.begin(), next.end(), data.begin() + 16));
+}
+
+TEST_CASE("CTRCipher: large buffers match small ones", "[core][aes]") {
+    const std::vector<u8> source = MakeLargeBuffer();
+    std::vector<u8> whole = source;
+    CTRCipher cipher(key, ctr);
+    cipher.Seek(3);
+    cipher.Process(whole.data(), whole.size());
+
+    std::vector<u8> pieces = source;
+    CTRCipher piece_cipher(key, ctr);
+    piece_cipher.Seek(3);
+    for (std::size_t offset = 0; offset < pieces.size(); offset += 0x1001) {
+        const std::size_t size = std::min<std::size_t>(0x1001, pieces.size() - offset);
+        piece_cipher.Process(pieces.data() + offset, size);
+    }
+    REQUIRE(whole == pieces);
+}
+
+TEST_CASE("CBCDecryptor: known answer", "[core][aes]") {
+    std::array<u8, 64> data;
+    CBCDecryptor(key, iv).Process(cbc_cipher_text.data(), data.data(), data.size());
+    REQUIRE(data == plain_text);
+
+    // The chain continues across calls, and decrypting in place works
+    data = cbc_cipher_text;
+    CBCDecryptor decryptor(key, iv);
+    decryptor.Process(data.data(), data.data(), 16);
+    decryptor.Process(data.data() + 16, data.data() + 16, 48);
+    REQUIRE(data == plain_text);
+}
+
+TEST_CASE("CBCEncryptor: known answer", "[core][aes]") {
+    std::array<u8, 64> data;
+    CBCEncryptor encryptor(key, iv);
+    encryptor.Process(plain_text.data(), data.data(), 32);
+    encryptor.Process(plain_text.data() + 32, data.data() + 32, 32);
+    REQUIRE(data == cbc_cipher_text);
+    REQUIRE(std::equal(data.end() - 16, data.end(), encryptor.GetChain().begin()));
+}
+
+TEST_CASE("CBCDecryptor: large buffers match small ones", "[core][aes]") {
+    std::vector<u8> source = MakeLargeBuffer();
+    source.resize(source.size() / AES_BLOCK_SIZE * AES_BLOCK_SIZE);
+    std::vector<u8> encrypted(source.size());
+    CBCEncryptor(key, iv).Process(source.data(), encrypted.data(), source.size());
+
+    std::vector<u8> whole = encrypted;
+    CBCDecryptor(key, iv).Process(whole.data(), whole.data(), whole.size());
+    REQUIRE(whole == source);
+
+    std::vector<u8> pieces = encrypted;
+    CBCDecryptor decryptor(key, iv);
+    for (std::size_t offset = 0; offset < pieces.size(); offset += 0x1000) {
+        decryptor.Process(pieces.data() + offset, pieces.data() + offset, 0x1000);
+    }
+    REQUIRE(pieces == source);
+}
+
+TEST_CASE("CCM: known answer", "[core][aes]") {
+    SetNormalKey(KeySlotID::APTWrap, ccm_key);
+
+    SECTION("block aligned payload") {
+        const std::vector<u8> plain(ccm_plain_text.begin(), ccm_plain_text.end());
+        const std::vector<u8> cipher(ccm_cipher_text.begin(), ccm_cipher_text.end());
+        REQUIRE(EncryptSignCCM(plain, ccm_nonce, KeySlotID::APTWrap) == cipher);
+        REQUIRE(DecryptVerifyCCM(cipher, ccm_nonce, KeySlotID::APTWrap) == plain);
+    }
+
+    SECTION("unaligned payload") {
+        const std::vector<u8> plain(ccm_plain_text.begin(), ccm_plain_text.begin() + 24);
+        const std::vector<u8> cipher(ccm_unaligned_cipher_text.begin(),
+                                     ccm_unaligned_cipher_text.end());
+        REQUIRE(EncryptSignCCM(plain, ccm_nonce, KeySlotID::APTWrap) == cipher);
+        REQUIRE(DecryptVerifyCCM(cipher, ccm_nonce, KeySlotID::APTWrap) == plain);
+    }
+}
+
+TEST_CASE("CCM: tampered data is rejected", "[core][aes]") {
+    SetNormalKey(KeySlotID::APTWrap, ccm_key);
+    std::vector<u8> cipher(ccm_cipher_text.begin(), ccm_cipher_text.end());
+
+    SECTION("tampered MAC") {
+        cipher.back() ^= 0x01;
+        REQUIRE(DecryptVerifyCCM(cipher, ccm_nonce, KeySlotID::APTWrap).empty());
+    }
+
+    SECTION("tampered cipher text") {
+        cipher[5] ^= 0x80;
+        REQUIRE(DecryptVerifyCCM(cipher, ccm_nonce, KeySlotID::APTWrap).empty());
+    }
+
+    SECTION("wrong nonce") {
+        CCMNonce nonce = ccm_nonce;
+        nonce[0] ^= 0x01;
+        REQUIRE(DecryptVerifyCCM(cipher, nonce, KeySlotID::APTWrap).empty());
+    }
+
+    SECTION("shorter than a MAC") {
+        cipher.resize(CCM_MAC_SIZE - 1);
+        REQUIRE(DecryptVerifyCCM(cipher, ccm_nonce, KeySlotID::APTWrap).empty());
+    }
+}
+
+TEST_CASE("CBCDecryptor[Benchmark]", "[.][benchmark]") {
+    // Installing a 1 GiB CIA, which is written to AM in 1 MiB chunks
+    constexpr std::size_t chunk_size = 1024 * 1024;
+    constexpr std::size_t total_size = 1024 * chunk_size;
+    std::vector<u8> chunk(chunk_size);
+    CBCDecryptor decryptor(key, iv);
+
+    const auto begin = std::chrono::steady_clock::now();
+    for (std::size_t written = 0; written < total_size; written += chunk_size) {
+        decryptor.Process(chunk.data(), chunk.data(), chunk.size());
+    }
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+    WARN("CIA install (hardware: " << IsHardwareAccelerated() << "): "
+                                   << total_size / duration.count() / (1024 * 1024) << " MiB/s");
+}
+
+TEST_CASE("CTRCipher[Benchmark]", "[.][benchmark]") {
+    // Loading a full 32 MiB ExeFS, whose .code section is decrypted in one go
+    constexpr std::size_t exefs_size = 32 * 1024 * 1024;
+    constexpr int iterations = 20;
+    std::vector<u8> exefs(exefs_size);
+
+    const auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        CTRCipher cipher(key, ctr);
+        cipher.Seek(0x200);
+        cipher.Process(exefs.data(), exefs.size());
+    }
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+    WARN("ExeFS load (hardware: " << IsHardwareAccelerated() << "): "
+                                  << exefs_size * iterations / duration.count() / (1024 * 1024)
+                                  << " MiB/s");
+}
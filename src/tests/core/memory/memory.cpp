@@ -2,13 +2,17 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <memory>
+#include <vector>
 #include <catch2/catch.hpp>
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/fastmem.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/shared_page.h"
 #include "core/memory.h"
+#include "core/settings.h"
 
 TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
     Core::Timing timing;
@@ -54,3 +58,103 @@ TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
         CHECK(Memory::IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+TEST_CASE("Memory::RasterizerTakeWrittenPages", "[core][memory]") {
+    Memory::MemorySystem memory;
+    auto page_table = std::make_unique<Memory::PageTable>();
+    page_table->pointers.fill(nullptr);
+    page_table->attributes.fill(Memory::PageType::Unmapped);
+    memory.RegisterPageTable(page_table.get());
+    memory.MapMemoryRegion(*page_table, Memory::VRAM_VADDR, Memory::VRAM_SIZE,
+                           memory.GetPhysicalPointer(Memory::VRAM_PADDR));
+    memory.SetCurrentPageTable(page_table.get());
+
+    constexpr VAddr first_page = Memory::VRAM_VADDR;
+    constexpr VAddr second_page = Memory::VRAM_VADDR + Memory::PAGE_SIZE;
+    memory.RasterizerMarkRegionCached(Memory::VRAM_PADDR, 2 * Memory::PAGE_SIZE, true);
+    REQUIRE(page_table->attributes[first_page >> Memory::PAGE_BITS] ==
+            Memory::PageType::RasterizerCachedMemory);
+    REQUIRE(page_table->attributes[second_page >> Memory::PAGE_BITS] ==
+            Memory::PageType::RasterizerCachedMemory);
+
+    SECTION("untouched pages are not reported") {
+        CHECK(memory.RasterizerTakeWrittenPages().empty());
+
+        // Reads don't count as writes
+        memory.Read32(first_page);
+        memory.Read8(second_page + 3);
+        CHECK(memory.RasterizerTakeWrittenPages().empty());
+
+        memory.Write16(second_page, 0x1234);
+        CHECK(memory.RasterizerTakeWrittenPages() ==
+              std::vector<PAddr>{Memory::VRAM_PADDR + Memory::PAGE_SIZE});
+    }
+
+    SECTION("the first write stops trapping the page") {
+        memory.Write32(first_page, 0x12345678);
+        CHECK(page_table->attributes[first_page >> Memory::PAGE_BITS] == Memory::PageType::Memory);
+        CHECK(page_table->attributes[second_page >> Memory::PAGE_BITS] ==
+              Memory::PageType::RasterizerCachedMemory);
+
+        memory.Write32(first_page + 4, 0x9ABCDEF0);
+        CHECK(memory.RasterizerTakeWrittenPages() == std::vector<PAddr>{Memory::VRAM_PADDR});
+        CHECK(memory.Read32(first_page) == 0x12345678);
+    }
+
+    SECTION("a write after the pages were taken is recorded") {
+        memory.Write8(first_page, 1);
+        CHECK(memory.RasterizerTakeWrittenPages() == std::vector<PAddr>{Memory::VRAM_PADDR});
+        CHECK(page_table->attributes[first_page >> Memory::PAGE_BITS] ==
+              Memory::PageType::RasterizerCachedMemory);
+        CHECK(memory.RasterizerTakeWrittenPages().empty());
+
+        memory.Write8(first_page + 1, 2);
+        CHECK(memory.RasterizerTakeWrittenPages() == std::vector<PAddr>{Memory::VRAM_PADDR});
+    }
+
+    SECTION("uncached pages are not reported") {
+        memory.Write8(first_page, 1);
+        memory.RasterizerMarkRegionCached(Memory::VRAM_PADDR, Memory::PAGE_SIZE, false);
+        memory.Write8(first_page, 2);
+        CHECK(page_table->attributes[first_page >> Memory::PAGE_BITS] == Memory::PageType::Memory);
+        memory.RasterizerTakeWrittenPages();
+        memory.Write8(first_page, 3);
+        CHECK(memory.RasterizerTakeWrittenPages().empty());
+    }
+
+    memory.UnregisterPageTable(page_table.get());
+}
+
+TEST_CASE("Memory::WriteBlock through the fastmem window", "[core][memory]") {
+    if (!Memory::FastmemArena::IsSupported()) {
+        return;
+    }
+
+    Settings::values.use_fastmem = true;
+    Core::Timing timing;
+    Memory::MemorySystem memory;
+    Settings::values.use_fastmem = false;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    Memory::PageTable& page_table = process->vm_manager.page_table;
+    memory.MapMemoryRegion(page_table, Memory::VRAM_VADDR, Memory::VRAM_SIZE,
+                           memory.GetPhysicalPointer(Memory::VRAM_PADDR));
+    memory.SetCurrentPageTable(&page_table);
+
+    constexpr VAddr second_page = Memory::VRAM_VADDR + Memory::PAGE_SIZE;
+    memory.RasterizerMarkRegionCached(Memory::VRAM_PADDR + Memory::PAGE_SIZE, Memory::PAGE_SIZE,
+                                      true);
+
+    // Spans an uncached page and a cached one, so it can't go through the window
+    const std::vector<u8> data(Memory::PAGE_SIZE, 0xAB);
+    memory.WriteBlock(*process, second_page - 0x10, data.data(), data.size());
+    CHECK(page_table.attributes[second_page >> Memory::PAGE_BITS] == Memory::PageType::Memory);
+    CHECK(memory.RasterizerTakeWrittenPages() ==
+          std::vector<PAddr>{Memory::VRAM_PADDR + Memory::PAGE_SIZE});
+
+    std::vector<u8> read(data.size());
+    memory.ReadBlock(*process, second_page - 0x10, read.data(), read.size());
+    CHECK(read == data);
+    CHECK(page_table.attributes[second_page >> Memory::PAGE_BITS] ==
+          Memory::PageType::RasterizerCachedMemory);
+}
@@ -0,0 +1,141 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/core_timing.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/gpu_thread.h"
+
+namespace VideoCore {
+
+namespace {
+
+/// Window that records which thread its GL context is current on
+class TestWindow : public EmuWindow {
+public:
+    TestWindow() {
+        MakeCurrent();
+    }
+
+    void SwapBuffers() override {}
+    void PollEvents() override {}
+
+    void MakeCurrent() override {
+        std::lock_guard lock(mutex);
+        misused = misused || current_thread != std::thread::id{};
+        current_thread = std::this_thread::get_id();
+    }
+
+    void DoneCurrent() override {
+        std::lock_guard lock(mutex);
+        misused = misused || current_thread != std::this_thread::get_id();
+        current_thread = {};
+    }
+
+    std::thread::id CurrentThread() {
+        std::lock_guard lock(mutex);
+        return current_thread;
+    }
+
+    /// Whether the context was made current on two threads at once, or released by another one
+    bool Misused() {
+        std::lock_guard lock(mutex);
+        return misused;
+    }
+
+private:
+    std::mutex mutex;
+    std::thread::id current_thread;
+    bool misused = false;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("GPUThread executes commands in order", "[video_core]") {
+    Core::Timing timing;
+    TestWindow window;
+    auto gpu_thread = std::make_unique<GPUThread>(window, timing);
+    REQUIRE_FALSE(gpu_thread->IsGPUThread());
+
+    // Only touched on the GPU thread, and read here once the fences say it's done
+    std::vector<int> executed;
+    std::atomic<bool> on_gpu_thread{true};
+    std::atomic<bool> has_context{true};
+
+    std::vector<u64> fences;
+    for (int i = 0; i < 100; ++i) {
+        fences.push_back(gpu_thread->PushCommand([&, i] {
+            executed.push_back(i);
+            on_gpu_thread = on_gpu_thread && gpu_thread->IsGPUThread();
+            has_context = has_context && window.CurrentThread() == std::this_thread::get_id();
+        }));
+    }
+    for (std::size_t i = 1; i < fences.size(); ++i) {
+        REQUIRE(fences[i] > fences[i - 1]);
+    }
+
+    // Waiting for a fence waits for everything queued before it
+    gpu_thread->WaitForFence(fences[49]);
+    REQUIRE(executed.size() >= 50);
+
+    int value = 0;
+    gpu_thread->PushCommandAndWait([&] { value = 1; });
+    REQUIRE(value == 1);
+    REQUIRE(executed.size() == 100);
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(executed[i] == i);
+    }
+    REQUIRE(on_gpu_thread);
+    REQUIRE(has_context);
+
+    SECTION("the destructor runs pending commands and takes the context back") {
+        for (int i = 100; i < 200; ++i) {
+            gpu_thread->PushCommand([&, i] { executed.push_back(i); });
+        }
+        gpu_thread.reset();
+        REQUIRE(executed.size() == 200);
+        REQUIRE(window.CurrentThread() == std::this_thread::get_id());
+        REQUIRE_FALSE(window.Misused());
+    }
+}
+
+TEST_CASE("GPUThread runs commands on the emulation thread", "[video_core]") {
+    Core::Timing timing;
+    TestWindow window;
+    GPUThread gpu_thread(window, timing);
+    const std::thread::id emulation_thread = std::this_thread::get_id();
+
+    std::atomic<int> ran_on_emulation_thread{0};
+    const auto send_to_emulation_thread = [&] {
+        gpu_thread.RunOnEmulationThread([&] {
+            if (std::this_thread::get_id() == emulation_thread) {
+                ++ran_on_emulation_thread;
+            }
+        });
+    };
+
+    SECTION("while the emulation thread waits for a fence") {
+        // This would deadlock if the wait didn't serve the command
+        gpu_thread.PushCommandAndWait(send_to_emulation_thread);
+        REQUIRE(ran_on_emulation_thread == 1);
+    }
+
+    SECTION("when the emulation thread picks it up") {
+        const u64 fence = gpu_thread.PushCommand(send_to_emulation_thread);
+        // CoreTiming executes it this way from the scheduled event
+        while (ran_on_emulation_thread == 0) {
+            gpu_thread.ExecuteEmulationThreadCommand();
+            std::this_thread::yield();
+        }
+        gpu_thread.WaitForFence(fence);
+        REQUIRE(ran_on_emulation_thread == 1);
+    }
+}
+
+} // namespace VideoCore
@@ -0,0 +1,125 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/renderer_opengl/gl_morton.h"
+#include "video_core/renderer_opengl/gl_vars.h"
+
+using OpenGL::MortonKernel;
+using PixelFormat = OpenGL::SurfaceParams::PixelFormat;
+
+static constexpr std::array<PixelFormat, 8> formats{{
+    PixelFormat::RGBA8,
+    PixelFormat::RGB8,
+    PixelFormat::RGB5A1,
+    PixelFormat::RGB565,
+    PixelFormat::RGBA4,
+    PixelFormat::D16,
+    PixelFormat::D24,
+    PixelFormat::D24S8,
+}};
+
+/// Width of the test surfaces in pixels
+static constexpr u32 stride = 16;
+
+static std::vector<MortonKernel> GetVectorKernels() {
+    std::vector<MortonKernel> kernels;
+    switch (OpenGL::GetHostMortonKernel()) {
+    case MortonKernel::AVX2:
+        kernels.push_back(MortonKernel::AVX2);
+        // fallthrough
+    case MortonKernel::SSSE3:
+        kernels.push_back(MortonKernel::SSSE3);
+        break;
+    default:
+        break;
+    }
+    return kernels;
+}
+
+static std::vector<u8> RandomBytes(std::size_t size, std::mt19937& rng) {
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<u8> bytes(size);
+    for (u8& byte : bytes) {
+        byte = static_cast<u8>(dist(rng));
+    }
+    return bytes;
+}
+
+static void CheckKernel(MortonKernel kernel, PixelFormat format) {
+    const u32 tile_size = OpenGL::SurfaceParams::GetFormatBpp(format) * 8;
+    const u32 gl_bytes_per_pixel = OpenGL::CachedSurface::GetGLBytesPerPixel(format);
+    const u32 gl_size = 8 * stride * gl_bytes_per_pixel;
+    std::mt19937 rng(static_cast<u32>(format));
+
+    // Convert the second tile of a row of tiles, so that the stride matters
+    const u32 gl_offset = 8 * gl_bytes_per_pixel;
+
+    std::vector<u8> tile = RandomBytes(tile_size, rng);
+    std::vector<u8> expected_gl(gl_size), gl(gl_size);
+    OpenGL::GetMortonTileFn(true, format, MortonKernel::Scalar)(stride, tile.data(),
+                                                                 &expected_gl[gl_offset]);
+    OpenGL::GetMortonTileFn(true, format, kernel)(stride, tile.data(), &gl[gl_offset]);
+    REQUIRE(gl == expected_gl);
+
+    const std::vector<u8> source_gl = RandomBytes(gl_size, rng);
+    std::vector<u8> expected_tile(tile_size);
+    OpenGL::GetMortonTileFn(false, format, MortonKernel::Scalar)(
+        stride, expected_tile.data(), const_cast<u8*>(&source_gl[gl_offset]));
+    OpenGL::GetMortonTileFn(false, format, kernel)(stride, tile.data(),
+                                                    const_cast<u8*>(&source_gl[gl_offset]));
+    REQUIRE(tile == expected_tile);
+}
+
+TEST_CASE("MortonCopyTile[VectorKernels]", "[video_core][renderer_opengl]") {
+    for (const bool gles : {false, true}) {
+        OpenGL::GLES = gles;
+        for (const MortonKernel kernel : GetVectorKernels()) {
+            for (const PixelFormat format : formats) {
+                INFO("kernel " << static_cast<int>(kernel) << ", format "
+                               << static_cast<int>(format) << ", GLES " << gles);
+                CheckKernel(kernel, format);
+            }
+        }
+    }
+    OpenGL::GLES = false;
+}
+
+TEST_CASE("MortonCopyTile[Benchmark]", "[.][benchmark]") {
+    constexpr u32 width = 512;
+    constexpr u32 height = 256;
+    constexpr int iterations = 20;
+
+    for (const PixelFormat format : formats) {
+        const u32 tile_size = OpenGL::SurfaceParams::GetFormatBpp(format) * 8;
+        const u32 gl_bytes_per_pixel = OpenGL::CachedSurface::GetGLBytesPerPixel(format);
+        std::vector<u8> tiled(width * height / 64 * tile_size);
+        std::vector<u8> gl(width * height * gl_bytes_per_pixel);
+
+        std::vector<MortonKernel> kernels = GetVectorKernels();
+        kernels.push_back(MortonKernel::Scalar);
+        for (const MortonKernel kernel : kernels) {
+            const auto to_gl = OpenGL::GetMortonTileFn(true, format, kernel);
+            const auto to_morton = OpenGL::GetMortonTileFn(false, format, kernel);
+
+            const auto begin = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                for (u32 tile = 0; tile < width * height / 64; ++tile) {
+                    const u32 x = tile % (width / 8) * 8;
+                    const u32 y = tile / (width / 8) * 8;
+                    u8* gl_tile = &gl[((height - 8 - y) * width + x) * gl_bytes_per_pixel];
+                    to_gl(width, &tiled[tile * tile_size], gl_tile);
+                    to_morton(width, &tiled[tile * tile_size], gl_tile);
+                }
+            }
+            const std::chrono::duration<double, std::micro> duration =
+                std::chrono::steady_clock::now() - begin;
+            WARN("format " << static_cast<int>(format) << ", kernel " << static_cast<int>(kernel)
+                           << ": " << duration.count() / iterations << " us per round trip");
+        }
+    }
+}
@@ -0,0 +1,213 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <nihstro/shader_bytecode.h>
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_interpreter.h"
+
+using float24 = Pica::float24;
+using Instruction = nihstro::Instruction;
+using OpCode = nihstro::OpCode;
+using CompareOp = Instruction::Common::CompareOpType::Op;
+using ConditionOp = Instruction::FlowControlType::Op;
+
+namespace {
+
+// Register indices as encoded in instructions
+constexpr u32 v0 = 0x00;
+constexpr u32 r0 = 0x10;
+constexpr u32 r1 = 0x11;
+constexpr u32 o0 = 0x00;
+constexpr u32 o1 = 0x01;
+constexpr u32 c(u32 index) {
+    return 0x20 + index;
+}
+
+/// Operand descriptor 0 writes xyzw and reads src1 and src2 unswizzled
+constexpr u32 IDENTITY_SWIZZLE = 0xF | (0x1B << 5) | (0x1B << 14);
+
+constexpr u32 Encode(OpCode::Id opcode) {
+    return static_cast<u32>(opcode) << 26;
+}
+
+/// src1 can be any register, src2 only an input or temporary register
+constexpr u32 Arithmetic(OpCode::Id opcode, u32 dest, u32 src1, u32 src2 = 0) {
+    return Encode(opcode) | dest << 21 | src1 << 12 | src2 << 7;
+}
+
+constexpr u32 Compare(u32 src1, CompareOp x, u32 src2, CompareOp y) {
+    return Encode(OpCode::Id::CMP) | static_cast<u32>(x) << 24 | static_cast<u32>(y) << 21 |
+           src1 << 12 | src2 << 7;
+}
+
+constexpr u32 FlowControl(OpCode::Id opcode, u32 dest_offset, u32 num_instructions = 0) {
+    return Encode(opcode) | dest_offset << 10 | num_instructions;
+}
+
+constexpr u32 Conditional(OpCode::Id opcode, ConditionOp op, bool refx, bool refy, u32 dest_offset,
+                          u32 num_instructions = 0) {
+    return FlowControl(opcode, dest_offset, num_instructions) | refx << 25 | refy << 24 |
+           static_cast<u32>(op) << 22;
+}
+
+constexpr u32 Uniform(OpCode::Id opcode, u32 uniform_id, u32 dest_offset,
+                      u32 num_instructions = 0) {
+    return FlowControl(opcode, dest_offset, num_instructions) | uniform_id << 22;
+}
+
+/**
+ * Uniform loops and IFU first, then an IFC on cmp.x and a JMPC on cmp.y inside a loop, which
+ * diverge when the vertices compare differently against c1.
+ */
+const std::vector<u32> program{
+    /* 0 */ Arithmetic(OpCode::Id::MOV, r0, v0),
+    /* 1 */ Arithmetic(OpCode::Id::MOV, r1, c(0)),
+    /* 2 */ Compare(c(1), CompareOp::LessThan, v0, CompareOp::GreaterThan),
+    /* 3 */ Uniform(OpCode::Id::LOOP, 0, 6),
+    /* 4 */ Arithmetic(OpCode::Id::ADD, r1, c(2), r1),
+    /* 5 */ Arithmetic(OpCode::Id::MUL, r0, c(3), r0),
+    /* 6 */ Arithmetic(OpCode::Id::ADD, r0, r1, r0),
+    /* 7 */ Uniform(OpCode::Id::IFU, 0, 10, 1),
+    /* 8 */ Arithmetic(OpCode::Id::ADD, r0, c(4), r0),
+    /* 9 */ Encode(OpCode::Id::NOP),
+    /* 10 */ Arithmetic(OpCode::Id::MUL, r0, c(5), r0),
+    /* 11 */ Conditional(OpCode::Id::IFC, ConditionOp::JustX, true, false, 14, 1),
+    /* 12 */ Arithmetic(OpCode::Id::ADD, r0, c(6), r0),
+    /* 13 */ Encode(OpCode::Id::NOP),
+    /* 14 */ Arithmetic(OpCode::Id::MUL, r1, c(7), r1),
+    /* 15 */ Uniform(OpCode::Id::LOOP, 1, 18),
+    /* 16 */ Conditional(OpCode::Id::JMPC, ConditionOp::JustY, false, true, 18),
+    /* 17 */ Arithmetic(OpCode::Id::ADD, r0, c(6), r0),
+    /* 18 */ Arithmetic(OpCode::Id::ADD, r1, c(2), r1),
+    /* 19 */ Arithmetic(OpCode::Id::MOV, o0, r0),
+    /* 20 */ Arithmetic(OpCode::Id::MOV, o1, r1),
+    /* 21 */ Encode(OpCode::Id::END),
+};
+
+Common::Vec4<float24> MakeVec(float x, float y, float z, float w) {
+    return {float24::FromFloat32(x), float24::FromFloat32(y), float24::FromFloat32(z),
+            float24::FromFloat32(w)};
+}
+
+std::unique_ptr<Pica::Shader::ShaderSetup> MakeSetup(bool b0) {
+    auto setup = std::make_unique<Pica::Shader::ShaderSetup>();
+    setup->program_code.fill(0);
+    setup->swizzle_data.fill(0);
+    std::copy(program.begin(), program.end(), setup->program_code.begin());
+    setup->swizzle_data[0] = IDENTITY_SWIZZLE;
+
+    auto& uniforms = setup->uniforms;
+    for (auto& f : uniforms.f) {
+        f = MakeVec(0.f, 0.f, 0.f, 0.f);
+    }
+    uniforms.f[1] = MakeVec(0.5f, 0.5f, 0.f, 0.f);
+    uniforms.f[2] = MakeVec(1.f, 2.f, 3.f, 4.f);
+    uniforms.f[3] = MakeVec(0.5f, 0.75f, 1.25f, -1.f);
+    uniforms.f[4] = MakeVec(10.f, 20.f, 30.f, 40.f);
+    uniforms.f[5] = MakeVec(2.f, 3.f, 4.f, 5.f);
+    uniforms.f[6] = MakeVec(-1.f, 0.25f, 8.f, -3.f);
+    uniforms.f[7] = MakeVec(3.f, 0.5f, -2.f, 1.5f);
+    uniforms.b.fill(false);
+    uniforms.b[0] = b0;
+    // LOOP repeats x + 1 times, with aL starting at y and incremented by z
+    uniforms.i[0] = {2, 0, 1, 0};
+    uniforms.i[1] = {3, 0, 1, 0};
+
+    Pica::Shader::InterpreterEngine().SetupBatch(*setup, 0);
+    return setup;
+}
+
+Pica::Shader::UnitState MakeState(float x, float y, float z) {
+    Pica::Shader::UnitState state;
+    for (int i = 0; i < 16; ++i) {
+        state.registers.input[i] = MakeVec(0.f, 0.f, 0.f, 0.f);
+        state.registers.temporary[i] = MakeVec(0.f, 0.f, 0.f, 0.f);
+        state.registers.output[i] = MakeVec(0.f, 0.f, 0.f, 0.f);
+    }
+    state.registers.input[0] = MakeVec(x, y, z, 1.f);
+    state.conditional_code[0] = state.conditional_code[1] = false;
+    state.address_registers[0] = state.address_registers[1] = state.address_registers[2] = 0;
+    return state;
+}
+
+/// Runs the states through RunBatch and, one at a time, through Run, and compares the results
+void CheckBatchMatchesScalar(const Pica::Shader::ShaderSetup& setup,
+                             const std::vector<Pica::Shader::UnitState>& inputs) {
+    Pica::Shader::InterpreterEngine engine;
+
+    std::vector<Pica::Shader::UnitState> batch = inputs;
+    engine.RunBatch(setup, batch.data(), batch.size());
+
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        Pica::Shader::UnitState scalar = inputs[i];
+        engine.Run(setup, scalar);
+
+        INFO("vertex " << i);
+        for (int reg = 0; reg < 2; ++reg) {
+            for (int comp = 0; comp < 4; ++comp) {
+                REQUIRE(batch[i].registers.output[reg][comp].ToFloat32() ==
+                        scalar.registers.output[reg][comp].ToFloat32());
+                REQUIRE(batch[i].registers.temporary[reg][comp].ToFloat32() ==
+                        scalar.registers.temporary[reg][comp].ToFloat32());
+            }
+        }
+        REQUIRE(batch[i].conditional_code[0] == scalar.conditional_code[0]);
+        REQUIRE(batch[i].conditional_code[1] == scalar.conditional_code[1]);
+        REQUIRE(batch[i].address_registers[2] == scalar.address_registers[2]);
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("InterpreterEngine::RunBatch matches Run", "[video_core][shader]") {
+    // One full batch of 8 vertices and a partial one
+    constexpr std::size_t count = 11;
+
+    SECTION("all vertices take the same branches") {
+        std::vector<Pica::Shader::UnitState> states;
+        for (std::size_t i = 0; i < count; ++i) {
+            states.push_back(MakeState(0.75f + i * 0.125f, 0.25f - i * 0.0625f, i * 0.5f));
+        }
+        for (bool b0 : {false, true}) {
+            CheckBatchMatchesScalar(*MakeSetup(b0), states);
+        }
+    }
+
+    SECTION("vertices diverge at IFC and at JMPC inside a loop") {
+        std::vector<Pica::Shader::UnitState> states;
+        for (std::size_t i = 0; i < count; ++i) {
+            states.push_back(MakeState((i % 3) * 0.375f, (i % 2) * 0.75f, i * 0.5f));
+        }
+        for (bool b0 : {false, true}) {
+            CheckBatchMatchesScalar(*MakeSetup(b0), states);
+        }
+
+        // The vertices really compare differently
+        const auto setup = MakeSetup(false);
+        Pica::Shader::InterpreterEngine engine;
+        Pica::Shader::UnitState taken = states[2];
+        Pica::Shader::UnitState not_taken = states[0];
+        engine.Run(*setup, taken);
+        engine.Run(*setup, not_taken);
+        REQUIRE(taken.conditional_code[0] != not_taken.conditional_code[0]);
+    }
+
+    SECTION("vertices diverge only at JMPC") {
+        std::vector<Pica::Shader::UnitState> states;
+        for (std::size_t i = 0; i < count; ++i) {
+            states.push_back(MakeState(1.f, (i % 4) * 0.25f, 0.f));
+        }
+        for (bool b0 : {false, true}) {
+            CheckBatchMatchesScalar(*MakeSetup(b0), states);
+        }
+    }
+
+    SECTION("single vertex") {
+        CheckBatchMatchesScalar(*MakeSetup(true), {MakeState(0.25f, 0.75f, 2.f)});
+    }
+}
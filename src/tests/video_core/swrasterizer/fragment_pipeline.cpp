@@ -0,0 +1,149 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <memory>
+#include <catch2/catch.hpp>
+#include "video_core/regs.h"
+#include "video_core/swrasterizer/fragment_pipeline.h"
+
+namespace Pica::Rasterizer {
+
+using TevStageConfig = TexturingRegs::TevStageConfig;
+using Source = TevStageConfig::Source;
+
+namespace {
+
+/// Registers for which every texture environment stage passes the previous stage through
+std::unique_ptr<Regs> MakePassthroughRegs() {
+    auto regs = std::make_unique<Regs>();
+    auto& texturing = regs->texturing;
+    for (TevStageConfig* stage : {&texturing.tev_stage0, &texturing.tev_stage1,
+                                  &texturing.tev_stage2, &texturing.tev_stage3,
+                                  &texturing.tev_stage4, &texturing.tev_stage5}) {
+        stage->color_source1.Assign(Source::Previous);
+        stage->alpha_source1.Assign(Source::Previous);
+    }
+    texturing.tev_combiner_buffer_color.r.Assign(10);
+    texturing.tev_combiner_buffer_color.g.Assign(20);
+    texturing.tev_combiner_buffer_color.b.Assign(30);
+    texturing.tev_combiner_buffer_color.a.Assign(40);
+    return regs;
+}
+
+using Color = std::array<u8, 4>;
+
+Color ToColor(const Common::Vec4<u8>& color) {
+    return {color.r(), color.g(), color.b(), color.a()};
+}
+
+Color CombineTev(const Regs& regs) {
+    const FragmentPipeline pipeline(FragmentConfig::BuildFromRegs(regs));
+    FragmentPipeline::TevSources sources{};
+    return ToColor(pipeline.CombineTev(sources, FragmentConstants::BuildFromRegs(regs)));
+}
+
+} // Anonymous namespace
+
+TEST_CASE("FragmentPipeline keeps the combiner buffer of dropped stages", "[video_core]") {
+    auto regs = MakePassthroughRegs();
+    auto& texturing = regs->texturing;
+
+    SECTION("Buffer color read after a dropped first stage") {
+        texturing.tev_stage1.color_source1.Assign(Source::PreviousBuffer);
+        texturing.tev_stage1.alpha_source1.Assign(Source::PreviousBuffer);
+        REQUIRE(CombineTev(*regs) == Color{10, 20, 30, 40});
+    }
+
+    SECTION("Buffer updated before a dropped stage") {
+        texturing.tev_stage0.color_source1.Assign(Source::Constant);
+        texturing.tev_stage0.alpha_source1.Assign(Source::Constant);
+        texturing.tev_stage0.const_color = 0x827A6E64; // (100, 110, 122, 130)
+        texturing.tev_combiner_buffer_input.update_mask_rgb.Assign(1);
+        texturing.tev_combiner_buffer_input.update_mask_a.Assign(1);
+
+        texturing.tev_stage2.color_op.Assign(TevStageConfig::Operation::Add);
+        texturing.tev_stage2.alpha_op.Assign(TevStageConfig::Operation::Add);
+        texturing.tev_stage2.color_source2.Assign(Source::PreviousBuffer);
+        texturing.tev_stage2.alpha_source2.Assign(Source::PreviousBuffer);
+        REQUIRE(CombineTev(*regs) == Color{200, 220, 244, 255});
+    }
+}
+
+TEST_CASE("FragmentPipeline blends with specialized factors", "[video_core]") {
+    auto regs = MakePassthroughRegs();
+    auto& output_merger = regs->framebuffer.output_merger;
+    output_merger.red_enable.Assign(1);
+    output_merger.green_enable.Assign(1);
+    output_merger.blue_enable.Assign(1);
+    output_merger.alpha_enable.Assign(1);
+    output_merger.alphablend_enable.Assign(1);
+
+    const Common::Vec4<u8> src{200, 100, 50, 128};
+    const Common::Vec4<u8> dest{0, 50, 100, 255};
+    auto& params = output_merger.alpha_blending;
+
+    SECTION("Alpha blending") {
+        params.factor_source_rgb.Assign(FramebufferRegs::BlendFactor::SourceAlpha);
+        params.factor_source_a.Assign(FramebufferRegs::BlendFactor::SourceAlpha);
+        params.factor_dest_rgb.Assign(FramebufferRegs::BlendFactor::OneMinusSourceAlpha);
+        params.factor_dest_a.Assign(FramebufferRegs::BlendFactor::OneMinusSourceAlpha);
+
+        const FragmentPipeline pipeline(FragmentConfig::BuildFromRegs(*regs));
+        REQUIRE(pipeline.ReadsDestColor());
+        const auto output = pipeline.Blend(src, dest, FragmentConstants::BuildFromRegs(*regs));
+        REQUIRE(ToColor(output) == Color{100, 75, 74, 191});
+    }
+
+    SECTION("Replacing blend does not read the framebuffer") {
+        params.factor_source_rgb.Assign(FramebufferRegs::BlendFactor::One);
+        params.factor_source_a.Assign(FramebufferRegs::BlendFactor::One);
+
+        const FragmentPipeline pipeline(FragmentConfig::BuildFromRegs(*regs));
+        REQUIRE_FALSE(pipeline.ReadsDestColor());
+        const auto output = pipeline.Blend(src, dest, FragmentConstants::BuildFromRegs(*regs));
+        REQUIRE(ToColor(output) == ToColor(src));
+    }
+}
+
+TEST_CASE("FragmentPipeline runs depth and stencil tests early when possible", "[video_core]") {
+    auto regs = MakePassthroughRegs();
+    auto& output_merger = regs->framebuffer.output_merger;
+    output_merger.depth_test_enable.Assign(1);
+    output_merger.depth_test_func.Assign(FramebufferRegs::CompareFunc::LessThan);
+    REQUIRE(FragmentPipeline(FragmentConfig::BuildFromRegs(*regs)).HasEarlyFragmentTests());
+
+    SECTION("Alpha testing discards fragments before the depth test") {
+        output_merger.alpha_test.enable.Assign(1);
+        output_merger.alpha_test.func.Assign(FramebufferRegs::CompareFunc::GreaterThan);
+        REQUIRE_FALSE(
+            FragmentPipeline(FragmentConfig::BuildFromRegs(*regs)).HasEarlyFragmentTests());
+    }
+
+    SECTION("Shadow rendering bypasses the depth test") {
+        output_merger.fragment_operation_mode.Assign(
+            FramebufferRegs::FragmentOperationMode::Shadow);
+        REQUIRE_FALSE(
+            FragmentPipeline(FragmentConfig::BuildFromRegs(*regs)).HasEarlyFragmentTests());
+    }
+}
+
+TEST_CASE("FragmentPipelineCache reuses pipelines across constant changes", "[video_core]") {
+    auto regs = MakePassthroughRegs();
+    FragmentPipelineCache cache;
+
+    const FragmentPipeline& pipeline = cache.Get(*regs);
+    regs->texturing.tev_stage0.const_color = 0x12345678;
+    regs->framebuffer.output_merger.alpha_test.ref.Assign(0x80);
+    REQUIRE(&cache.Get(*regs) == &pipeline);
+
+    regs->framebuffer.output_merger.alpha_test.enable.Assign(1);
+    regs->framebuffer.output_merger.alpha_test.func.Assign(FramebufferRegs::CompareFunc::Equal);
+    const FragmentPipeline& alpha_tested = cache.Get(*regs);
+    REQUIRE(&alpha_tested != &pipeline);
+    REQUIRE(alpha_tested.PassesAlphaTest(0x80, FragmentConstants::BuildFromRegs(*regs)));
+    REQUIRE_FALSE(alpha_tested.PassesAlphaTest(0x7F, FragmentConstants::BuildFromRegs(*regs)));
+}
+
+} // namespace Pica::Rasterizer
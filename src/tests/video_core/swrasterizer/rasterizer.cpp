@@ -0,0 +1,171 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <tuple>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/swrasterizer/coverage.h"
+
+namespace Pica::Rasterizer {
+
+namespace {
+
+using Fragment = std::tuple<u16, u16, int, int, int>;
+using Triangle = std::array<Common::Vec2<Fix12P4>, 3>;
+
+struct Bounds {
+    u16 min_x;
+    u16 min_y;
+    u16 max_x;
+    u16 max_y;
+};
+
+/// Pixel aligned bounding box of the triangle, as computed by the rasterizer
+Bounds GetBounds(const Triangle& vtxpos) {
+    u16 min_x = std::min({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
+    u16 min_y = std::min({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
+    u16 max_x = std::max({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
+    u16 max_y = std::max({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
+    return {static_cast<u16>(min_x & Fix12P4::IntMask()),
+            static_cast<u16>(min_y & Fix12P4::IntMask()),
+            static_cast<u16>((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask()),
+            static_cast<u16>((max_y + Fix12P4::FracMask()) & Fix12P4::IntMask())};
+}
+
+/// Bounds of the triangle intersected with a scissor rectangle given in pixels
+Bounds Scissor(const Bounds& bounds, u16 x1, u16 y1, u16 x2, u16 y2) {
+    return {std::max<u16>(bounds.min_x, x1 << 4), std::max<u16>(bounds.min_y, y1 << 4),
+            std::min<u16>(bounds.max_x, x2 << 4), std::min<u16>(bounds.max_y, y2 << 4)};
+}
+
+/// The per-pixel edge test the rasterizer used before walking the bounding box in blocks
+std::vector<Fragment> RasterizeReference(const Triangle& vtxpos, const Bounds& bounds) {
+    const int bias0 = GetFillRuleBias(vtxpos[0], vtxpos[1], vtxpos[2]);
+    const int bias1 = GetFillRuleBias(vtxpos[1], vtxpos[2], vtxpos[0]);
+    const int bias2 = GetFillRuleBias(vtxpos[2], vtxpos[0], vtxpos[1]);
+
+    std::vector<Fragment> fragments;
+    for (u16 y = bounds.min_y + 8; y < bounds.max_y; y += 0x10) {
+        for (u16 x = bounds.min_x + 8; x < bounds.max_x; x += 0x10) {
+            int w0 = bias0 + SignedArea(vtxpos[1], vtxpos[2], {x, y});
+            int w1 = bias1 + SignedArea(vtxpos[2], vtxpos[0], {x, y});
+            int w2 = bias2 + SignedArea(vtxpos[0], vtxpos[1], {x, y});
+            if (w0 < 0 || w1 < 0 || w2 < 0)
+                continue;
+            fragments.emplace_back(x, y, w0, w1, w2);
+        }
+    }
+    return fragments;
+}
+
+std::vector<Fragment> Rasterize(const Triangle& vtxpos, const Bounds& bounds) {
+    std::vector<Fragment> fragments;
+    WalkTriangle(vtxpos, bounds.min_x, bounds.min_y, bounds.max_x, bounds.max_y,
+                 [&](u16 x, u16 y, int w0, int w1, int w2) {
+                     fragments.emplace_back(x, y, w0, w1, w2);
+                 });
+    return fragments;
+}
+
+void CheckMatchesReference(const Triangle& vtxpos, const Bounds& bounds) {
+    std::vector<Fragment> expected = RasterizeReference(vtxpos, bounds);
+    std::vector<Fragment> actual = Rasterize(vtxpos, bounds);
+
+    // Each pixel must be visited once, but blocks are walked in a different order
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    REQUIRE(std::adjacent_find(actual.begin(), actual.end()) == actual.end());
+    REQUIRE(actual == expected);
+}
+
+void CheckMatchesReference(const Triangle& vtxpos) {
+    CheckMatchesReference(vtxpos, GetBounds(vtxpos));
+}
+
+/// Vertex at the given pixel position plus a fraction of a pixel in 1/16 units
+Common::Vec2<Fix12P4> Vertex(u16 x, u16 y, u16 frac_x = 0, u16 frac_y = 0) {
+    return {Fix12P4(static_cast<u16>((x << 4) + frac_x)),
+            Fix12P4(static_cast<u16>((y << 4) + frac_y))};
+}
+
+} // Anonymous namespace
+
+TEST_CASE("WalkTriangle matches the per-pixel edge test", "[video_core][swrasterizer]") {
+    SECTION("fill rule on edges through pixel centers") {
+        // Two triangles sharing the diagonal of a square, and a flat top and bottom edge
+        const Triangle lower{{Vertex(2, 2, 8, 8), Vertex(30, 2, 8, 8), Vertex(30, 30, 8, 8)}};
+        const Triangle upper{{Vertex(2, 2, 8, 8), Vertex(30, 30, 8, 8), Vertex(2, 30, 8, 8)}};
+        CheckMatchesReference(lower);
+        CheckMatchesReference(upper);
+
+        // The shared edge is drawn by exactly one of them
+        std::vector<Fragment> both = Rasterize(lower, GetBounds(lower));
+        const std::vector<Fragment> other = Rasterize(upper, GetBounds(upper));
+        both.insert(both.end(), other.begin(), other.end());
+        std::vector<std::pair<u16, u16>> pixels;
+        for (const auto& fragment : both) {
+            pixels.emplace_back(std::get<0>(fragment), std::get<1>(fragment));
+        }
+        std::sort(pixels.begin(), pixels.end());
+        REQUIRE(std::adjacent_find(pixels.begin(), pixels.end()) == pixels.end());
+
+        // Vertical and horizontal edges on pixel centers
+        CheckMatchesReference({{Vertex(4, 4, 8, 8), Vertex(20, 4, 8, 8), Vertex(4, 13, 8, 8)}});
+        CheckMatchesReference({{Vertex(20, 4, 8, 8), Vertex(20, 13, 8, 8), Vertex(4, 13, 8, 8)}});
+    }
+
+    SECTION("degenerate triangles") {
+        // All vertices on one point, and on one line through pixel centers
+        CheckMatchesReference({{Vertex(5, 5, 8, 8), Vertex(5, 5, 8, 8), Vertex(5, 5, 8, 8)}});
+        CheckMatchesReference({{Vertex(1, 3, 8, 8), Vertex(9, 3, 8, 8), Vertex(17, 3, 8, 8)}});
+        CheckMatchesReference({{Vertex(3, 1, 8, 8), Vertex(3, 17, 8, 8), Vertex(3, 9, 8, 8)}});
+        CheckMatchesReference({{Vertex(0, 0, 8, 8), Vertex(20, 20, 8, 8), Vertex(10, 10, 8, 8)}});
+    }
+
+    SECTION("very thin triangles") {
+        // Slivers a fraction of a pixel wide, crossing many blocks
+        CheckMatchesReference({{Vertex(3, 1, 7), Vertex(3, 60, 9), Vertex(3, 1, 9)}});
+        CheckMatchesReference({{Vertex(1, 7, 0, 8), Vertex(63, 7, 0, 9), Vertex(1, 7, 0, 9)}});
+        CheckMatchesReference({{Vertex(0, 0), Vertex(63, 62, 0, 15), Vertex(63, 63)}});
+        CheckMatchesReference({{Vertex(0, 0), Vertex(1, 63, 1), Vertex(0, 63)}});
+    }
+
+    SECTION("triangles clipped by the scissor") {
+        const Triangle triangle{{Vertex(1, 2, 3, 5), Vertex(60, 9, 11, 2), Vertex(21, 57, 6, 13)}};
+        const Bounds bounds = GetBounds(triangle);
+
+        // Scissor rectangles that are not aligned to blocks or quads
+        CheckMatchesReference(triangle, Scissor(bounds, 5, 7, 41, 30));
+        CheckMatchesReference(triangle, Scissor(bounds, 0, 0, 13, 11));
+        CheckMatchesReference(triangle, Scissor(bounds, 17, 16, 18, 17));
+        CheckMatchesReference(triangle, Scissor(bounds, 30, 3, 63, 63));
+
+        // An empty scissor rectangle leaves nothing to walk
+        REQUIRE(Rasterize(triangle, Scissor(bounds, 50, 50, 40, 40)).empty());
+    }
+
+    SECTION("random triangles") {
+        std::mt19937 rng(0x3d5);
+        std::uniform_int_distribution<int> coordinate(0, 128 * 16);
+        for (int i = 0; i < 500; ++i) {
+            Triangle triangle;
+            for (auto& vertex : triangle) {
+                vertex = {Fix12P4(static_cast<u16>(coordinate(rng))),
+                          Fix12P4(static_cast<u16>(coordinate(rng)))};
+            }
+            // The rasterizer only walks counter-clockwise triangles
+            if (SignedArea(triangle[0], triangle[1], triangle[2]) < 0)
+                std::swap(triangle[1], triangle[2]);
+
+            INFO("triangle " << i);
+            CheckMatchesReference(triangle);
+            CheckMatchesReference(triangle, Scissor(GetBounds(triangle), 20, 9, 101, 77));
+        }
+    }
+}
+
+} // namespace Pica::Rasterizer
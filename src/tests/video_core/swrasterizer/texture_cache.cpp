@@ -0,0 +1,70 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <catch2/catch.hpp>
+#include "core/memory.h"
+#include "video_core/regs.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/texture/texture_decode.h"
+#include "video_core/video_core.h"
+
+namespace Pica::Rasterizer {
+
+TEST_CASE("TextureCache decodes textures and follows invalidations", "[video_core]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+
+    constexpr PAddr address = Memory::VRAM_PADDR + 0x1000;
+    u8* source = memory.GetPhysicalPointer(address);
+    for (u32 i = 0; i < 16 * 8 * 2; ++i) {
+        source[i] = static_cast<u8>(i * 13);
+    }
+
+    auto regs = std::make_unique<Regs>();
+    auto& texturing = regs->texturing;
+    texturing.main_config.texture0_enable.Assign(1);
+    texturing.texture0.address.Assign(address / 8);
+    texturing.texture0.width.Assign(16);
+    texturing.texture0.height.Assign(8);
+    texturing.texture0_format.Assign(TexturingRegs::TextureFormat::RGB565);
+
+    auto info = Texture::TextureInfo::FromPicaRegister(texturing.texture0,
+                                                       texturing.texture0_format);
+    auto IsDecoded = [&](const DecodedTexture& texture) {
+        for (u32 y = 0; y < info.height; ++y) {
+            for (u32 x = 0; x < info.width; ++x) {
+                const auto texel = texture.LookupTexel(x, y);
+                const auto expected = Texture::LookupTexture(source, x, y, info);
+                if (texel.r() != expected.r() || texel.g() != expected.g() ||
+                    texel.b() != expected.b() || texel.a() != expected.a()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    {
+        TextureCache cache;
+        const DecodedTexture* texture = cache.GetTextures(*regs).textures[0];
+        REQUIRE(texture != nullptr);
+        REQUIRE(IsDecoded(*texture));
+
+        // Without an invalidation, the cached texels are kept
+        source[0] ^= 0xFF;
+        REQUIRE(cache.GetTextures(*regs).textures[0] == texture);
+        REQUIRE_FALSE(IsDecoded(*texture));
+
+        cache.InvalidateRegion(address, 1);
+        REQUIRE(cache.GetTextures(*regs).textures[0] == texture);
+        REQUIRE(IsDecoded(*texture));
+
+        REQUIRE(cache.GetTextures(*regs).textures[1] == nullptr);
+    }
+
+    VideoCore::g_memory = nullptr;
+}
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,164 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/texture/texture_decode.h"
+#include "video_core/texture/tile_decoder.h"
+
+using Pica::Texture::DecodeKernel;
+using TextureFormat = Pica::TexturingRegs::TextureFormat;
+
+static constexpr std::array<TextureFormat, 14> formats{{
+    TextureFormat::RGBA8,
+    TextureFormat::RGB8,
+    TextureFormat::RGB5A1,
+    TextureFormat::RGB565,
+    TextureFormat::RGBA4,
+    TextureFormat::IA8,
+    TextureFormat::RG8,
+    TextureFormat::I8,
+    TextureFormat::A8,
+    TextureFormat::IA4,
+    TextureFormat::I4,
+    TextureFormat::A4,
+    TextureFormat::ETC1,
+    TextureFormat::ETC1A4,
+}};
+
+static std::vector<DecodeKernel> GetKernels() {
+    std::vector<DecodeKernel> kernels{DecodeKernel::Scalar};
+    switch (Pica::Texture::GetHostDecodeKernel()) {
+    case DecodeKernel::AVX2:
+        kernels.push_back(DecodeKernel::AVX2);
+        // fallthrough
+    case DecodeKernel::SSSE3:
+        kernels.push_back(DecodeKernel::SSSE3);
+        break;
+    default:
+        break;
+    }
+    return kernels;
+}
+
+static std::vector<u8> RandomBytes(std::size_t size, std::mt19937& rng) {
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<u8> bytes(size);
+    for (u8& byte : bytes) {
+        byte = static_cast<u8>(dist(rng));
+    }
+    return bytes;
+}
+
+static Pica::Texture::TextureInfo MakeInfo(TextureFormat format, u32 width, u32 height) {
+    Pica::Texture::TextureInfo info{};
+    info.width = width;
+    info.height = height;
+    info.format = format;
+    info.SetDefaultStride();
+    return info;
+}
+
+TEST_CASE("DecodeTile[Kernels]", "[video_core][texture]") {
+    for (const DecodeKernel kernel : GetKernels()) {
+        for (const TextureFormat format : formats) {
+            INFO("kernel " << static_cast<int>(kernel) << ", format "
+                           << static_cast<int>(format));
+            std::mt19937 rng(static_cast<u32>(format));
+            const auto info = MakeInfo(format, 8, 8);
+            const std::vector<u8> tile = RandomBytes(Pica::Texture::CalculateTileSize(format), rng);
+
+            // Store the rows bottom to top in a wider buffer, so that the stride matters
+            constexpr std::ptrdiff_t stride = 16 * 4;
+            std::vector<u8> decoded(8 * stride);
+            const auto decode_tile = Pica::Texture::GetDecodeTileFn(format, kernel);
+            REQUIRE(decode_tile != nullptr);
+            decode_tile(tile.data(), &decoded[7 * stride + 4], -stride);
+
+            for (u32 y = 0; y < 8; ++y) {
+                for (u32 x = 0; x < 8; ++x) {
+                    auto expected =
+                        Pica::Texture::LookupTexelInTile(tile.data(), x, y, info, false);
+                    REQUIRE(std::memcmp(&decoded[(7 - y) * stride + 4 + x * 4],
+                                        expected.AsArray(), 4) == 0);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("DecodeTexture", "[video_core][texture]") {
+    // Neither dimension is a multiple of the tile size
+    constexpr u32 width = 21;
+    constexpr u32 height = 13;
+
+    for (const TextureFormat format : formats) {
+        for (const bool disable_alpha : {false, true}) {
+            INFO("format " << static_cast<int>(format) << ", disable_alpha " << disable_alpha);
+            std::mt19937 rng(static_cast<u32>(format));
+            auto info = MakeInfo(format, 24, 16);
+            const std::vector<u8> source = RandomBytes(info.stride * 2, rng);
+            info.width = width;
+            info.height = height;
+
+            // Guard bytes after each row check that partial tiles are not written past the end
+            constexpr std::ptrdiff_t stride = (width + 1) * 4;
+            std::vector<u8> decoded(height * stride, 0xCD);
+            Pica::Texture::DecodeTexture(source.data(), info, decoded.data(), stride,
+                                         disable_alpha);
+
+            for (u32 y = 0; y < height; ++y) {
+                for (u32 x = 0; x < width; ++x) {
+                    auto expected =
+                        Pica::Texture::LookupTexture(source.data(), x, y, info, disable_alpha);
+                    REQUIRE(std::memcmp(&decoded[y * stride + x * 4], expected.AsArray(), 4) ==
+                            0);
+                }
+                for (u32 i = 0; i < 4; ++i) {
+                    REQUIRE(decoded[y * stride + width * 4 + i] == 0xCD);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("DecodeTexture[Benchmark]", "[.][benchmark]") {
+    constexpr u32 width = 512;
+    constexpr u32 height = 256;
+    constexpr int iterations = 20;
+
+    for (const TextureFormat format : formats) {
+        std::mt19937 rng(static_cast<u32>(format));
+        const auto info = MakeInfo(format, width, height);
+        const std::vector<u8> source = RandomBytes(info.stride * height / 8, rng);
+        std::vector<u8> decoded(width * height * 4);
+
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            for (u32 y = 0; y < height; ++y) {
+                for (u32 x = 0; x < width; ++x) {
+                    auto texel = Pica::Texture::LookupTexture(source.data(), x, y, info);
+                    std::memcpy(&decoded[(y * width + x) * 4], texel.AsArray(), 4);
+                }
+            }
+        }
+        const std::chrono::duration<double, std::micro> lookup_duration =
+            std::chrono::steady_clock::now() - begin;
+
+        begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            Pica::Texture::DecodeTexture(source.data(), info, decoded.data(), width * 4);
+        }
+        const std::chrono::duration<double, std::micro> decode_duration =
+            std::chrono::steady_clock::now() - begin;
+
+        WARN("format " << static_cast<int>(format) << ": LookupTexture "
+                       << lookup_duration.count() / iterations << " us, DecodeTexture "
+                       << decode_duration.count() / iterations << " us");
+    }
+}
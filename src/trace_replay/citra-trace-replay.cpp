@@ -0,0 +1,261 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <getopt.h>
+#else
+#include <getopt.h>
+#include <unistd.h>
+#endif
+
+#include "common/common_types.h"
+#include "common/hash.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "core/frontend/emu_window.h"
+#include "core/hw/gpu.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/tracer/player.h"
+#include "video_core/pica.h"
+#include "video_core/renderer_base.h"
+#include "video_core/swrasterizer/swrasterizer.h"
+#include "video_core/video_core.h"
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <filename>\n"
+                 "Replays a CiTrace file without a window and reports per-frame timings\n"
+                 "-j, --jit           Use the shader JIT instead of the interpreter\n"
+                 "-H, --hash          Print a hash of the displayed framebuffers after every frame\n"
+                 "-l, --loops         Number of times to replay the trace (default: 1)\n"
+                 "-h, --help          Display this help and exit\n"
+                 "-v, --version       Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "Citra trace replay " << Common::g_scm_branch << " " << Common::g_scm_desc
+              << std::endl;
+}
+
+static void InitializeLogging() {
+    Log::Filter log_filter(Log::Level::Info);
+    Log::SetGlobalFilter(log_filter);
+
+    Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
+}
+
+namespace {
+
+/// Window that is never shown, the trace is only rendered to emulated memory
+class NullWindow : public EmuWindow {
+public:
+    void SwapBuffers() override {}
+    void PollEvents() override {}
+    void MakeCurrent() override {}
+    void DoneCurrent() override {}
+};
+
+/// Forwards to the software rasterizer, counting the work submitted to it
+class CountingRasterizer : public VideoCore::RasterizerInterface {
+public:
+    void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
+                     const Pica::Shader::OutputVertex& v2) override {
+        ++triangles;
+        rasterizer.AddTriangle(v0, v1, v2);
+    }
+    void DrawTriangles() override {
+        ++draws;
+        rasterizer.DrawTriangles();
+    }
+    void NotifyPicaRegisterChanged(u32 id) override {
+        rasterizer.NotifyPicaRegisterChanged(id);
+    }
+    void FlushAll() override {
+        rasterizer.FlushAll();
+    }
+    void FlushRegion(PAddr addr, u32 size) override {
+        rasterizer.FlushRegion(addr, size);
+    }
+    void InvalidateRegion(PAddr addr, u32 size) override {
+        rasterizer.InvalidateRegion(addr, size);
+    }
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {
+        rasterizer.FlushAndInvalidateRegion(addr, size);
+    }
+
+    u32 draws = 0;
+    u32 triangles = 0;
+
+private:
+    VideoCore::SWRasterizer rasterizer;
+};
+
+/// Renderer that leaves the frames in emulated memory instead of presenting them
+class NullRenderer : public RendererBase {
+public:
+    explicit NullRenderer(EmuWindow& window) : RendererBase(window) {
+        auto counting_rasterizer = std::make_unique<CountingRasterizer>();
+        counter = counting_rasterizer.get();
+        rasterizer = std::move(counting_rasterizer);
+    }
+
+    void SwapBuffers(const FrameRegs& regs) override {}
+    Core::System::ResultStatus Init() override {
+        return Core::System::ResultStatus::Success;
+    }
+    void ShutDown() override {}
+
+    CountingRasterizer* counter;
+};
+
+u64 HashFramebuffer(Memory::MemorySystem& memory, const GPU::Regs::FramebufferConfig& config) {
+    const PAddr addr = config.active_fb == 0 ? config.address_left1 : config.address_left2;
+    const u32 size = config.stride * config.height;
+    if (size == 0 || !memory.IsValidPhysicalAddress(addr) ||
+        !memory.IsValidPhysicalAddress(addr + size - 1)) {
+        return 0;
+    }
+    // Let the rasterizer write back what it still holds
+    VideoCore::g_renderer->Rasterizer()->FlushRegion(addr, size);
+    return Common::ComputeHash64(memory.GetPhysicalPointer(addr), size);
+}
+
+} // Anonymous namespace
+
+/// Application entry point
+int main(int argc, char** argv) {
+    InitializeLogging();
+
+    char* endarg;
+    int option_index = 0;
+    bool use_jit = false;
+    bool print_hashes = false;
+    u32 loops = 1;
+
+    static struct option long_options[] = {
+        {"jit", no_argument, 0, 'j'},
+        {"hash", no_argument, 0, 'H'},
+        {"loops", required_argument, 0, 'l'},
+        {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'v'},
+        {0, 0, 0, 0},
+    };
+
+    std::string filepath;
+    while (optind < argc) {
+        int arg = getopt_long(argc, argv, "jHl:hv", long_options, &option_index);
+        if (arg != -1) {
+            switch (static_cast<char>(arg)) {
+            case 'j':
+                use_jit = true;
+                break;
+            case 'H':
+                print_hashes = true;
+                break;
+            case 'l':
+                loops = strtoul(optarg, &endarg, 0);
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                PrintVersion();
+                return 0;
+            }
+        } else {
+            filepath = argv[optind];
+            optind++;
+        }
+    }
+
+    if (filepath.empty()) {
+        std::cout << "No trace file specified!\n\n";
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    if (loops == 0) {
+        std::cout << "loops needs to be at least 1!\n\n";
+        PrintHelp(argv[0]);
+        return -1;
+    }
+
+    Memory::MemorySystem memory;
+    NullWindow window;
+
+    // Only the parts of the system the trace talks to are brought up: the GPU and LCD registers
+    // and the Pica state, rendered by the software rasterizer
+    VideoCore::g_memory = &memory;
+    VideoCore::g_hw_renderer_enabled = false;
+    VideoCore::g_shader_jit_enabled = use_jit;
+    auto renderer = std::make_unique<NullRenderer>(window);
+    CountingRasterizer& counter = *renderer->counter;
+    VideoCore::g_renderer = std::move(renderer);
+    Pica::Init();
+    GPU::InitRegisters(memory);
+    LCD::Init();
+
+    CiTrace::Player player(memory);
+    if (!player.Load(filepath)) {
+        return -1;
+    }
+    std::cout << "Replaying " << player.NumFrames() << " frames from " << filepath << " using the "
+              << (use_jit ? "shader JIT" : "shader interpreter") << "\n";
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> frame_times;
+    for (u32 loop = 0; loop < loops; ++loop) {
+        player.Reset();
+        for (u32 frame = 0;; ++frame) {
+            counter.draws = 0;
+            counter.triangles = 0;
+
+            const auto start = Clock::now();
+            const bool frame_complete = player.ReplayFrame();
+            const auto end = Clock::now();
+            if (!frame_complete) {
+                break;
+            }
+
+            const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+            frame_times.push_back(ms);
+            std::printf("loop %u frame %u: %.3f ms, %u draws, %u triangles", loop, frame, ms,
+                        counter.draws, counter.triangles);
+            if (print_hashes) {
+                std::printf(", top %016llx, bottom %016llx",
+                            static_cast<unsigned long long>(
+                                HashFramebuffer(memory, GPU::g_regs.framebuffer_config[0])),
+                            static_cast<unsigned long long>(
+                                HashFramebuffer(memory, GPU::g_regs.framebuffer_config[1])));
+            }
+            std::printf("\n");
+        }
+    }
+
+    if (frame_times.empty()) {
+        std::cout << "The trace contains no complete frame\n";
+    } else {
+        double total = 0.0;
+        for (double ms : frame_times) {
+            total += ms;
+        }
+        const auto [min, max] = std::minmax_element(frame_times.begin(), frame_times.end());
+        std::printf("%zu frames: total %.3f ms, avg %.3f ms, min %.3f ms, max %.3f ms\n",
+                    frame_times.size(), total, total / frame_times.size(), *min, *max);
+    }
+
+    Pica::Shutdown();
+    VideoCore::g_renderer.reset();
+    return 0;
+}
@@ -147,7 +147,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     switch (id) {
     // Trigger IRQ
     case PICA_REG_INDEX(trigger_irq):
-        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::P3D);
+        GPU::SignalInterrupt(Service::GSP::InterruptId::P3D);
         break;
 
     case PICA_REG_INDEX(pipeline.triangle_topology):
@@ -360,7 +360,6 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         unsigned int vertex_cache_pos = 0;
 
         auto* shader_engine = Shader::GetEngine();
-        Shader::UnitState shader_unit;
 
         shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
 
@@ -369,11 +368,67 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (g_state.geometry_pipeline.NeedIndexInput())
             ASSERT(is_indexed);
 
+        // Indexed rendering doesn't use the start offset
+        const auto get_vertex = [&](unsigned int index) -> unsigned int {
+            return is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
+                              : (index + regs.pipeline.vertex_offset);
+        };
+
+        // Vertices are loaded and shaded in batches, ahead of their use. A batch only contains the
+        // vertices that will miss the vertex cache, which is found by replaying the cache updates.
+        constexpr std::size_t LOAD_BATCH_SIZE = 32;
+        std::array<u32, LOAD_BATCH_SIZE> batch_vertices;
+        std::array<Shader::AttributeBuffer, LOAD_BATCH_SIZE> batch_inputs;
+        std::array<Shader::UnitState, LOAD_BATCH_SIZE> batch_units;
+        std::array<Shader::AttributeBuffer, LOAD_BATCH_SIZE> batch_outputs;
+        std::size_t batch_size = 0;
+        std::size_t batch_pos = 0;
+
+        const auto load_batch = [&](unsigned int first_index) {
+            auto cache_valid = vertex_cache_valid;
+            auto cache_ids = vertex_cache_ids;
+            unsigned int cache_pos = vertex_cache_pos;
+
+            batch_size = 0;
+            batch_pos = 0;
+            for (unsigned int index = first_index;
+                 index < regs.pipeline.num_vertices && batch_size < LOAD_BATCH_SIZE; ++index) {
+                const unsigned int vertex = get_vertex(index);
+                if (is_indexed) {
+                    bool hit = false;
+                    for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
+                        if (cache_valid[i] && vertex == cache_ids[i]) {
+                            hit = true;
+                            break;
+                        }
+                    }
+                    if (hit) {
+                        continue;
+                    }
+                    cache_valid[cache_pos] = true;
+                    cache_ids[cache_pos] = vertex;
+                    cache_pos = (cache_pos + 1) % VERTEX_CACHE_SIZE;
+                }
+                batch_vertices[batch_size++] = vertex;
+            }
+            loader.LoadVertices(base_address, batch_vertices.data(), batch_size,
+                                batch_inputs.data(), memory_accesses);
+
+            // Send to vertex shader
+            for (std::size_t i = 0; i < batch_size; ++i) {
+                if (g_debug_context)
+                    g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
+                                             (void*)&batch_inputs[i]);
+                batch_units[i].LoadInput(regs.vs, batch_inputs[i]);
+            }
+            shader_engine->RunBatch(g_state.vs, batch_units.data(), batch_size);
+            for (std::size_t i = 0; i < batch_size; ++i) {
+                batch_units[i].WriteOutput(regs.vs, batch_outputs[i]);
+            }
+        };
+
         for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
-            // Indexed rendering doesn't use the start offset
-            unsigned int vertex =
-                is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
-                           : (index + regs.pipeline.vertex_offset);
+            unsigned int vertex = get_vertex(index);
 
             bool vertex_cache_hit = false;
 
@@ -399,17 +454,11 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             }
 
             if (!vertex_cache_hit) {
-                // Initialize data for the current vertex
-                Shader::AttributeBuffer input;
-                loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
-
-                // Send to vertex shader
-                if (g_debug_context)
-                    g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
-                                             (void*)&input);
-                shader_unit.LoadInput(regs.vs, input);
-                shader_engine->Run(g_state.vs, shader_unit);
-                shader_unit.WriteOutput(regs.vs, vs_output);
+                if (batch_pos == batch_size) {
+                    load_batch(index);
+                }
+                DEBUG_ASSERT(batch_vertices[batch_pos] == vertex);
+                vs_output = batch_outputs[batch_pos++];
 
                 if (is_indexed) {
                     vertex_cache[vertex_cache_pos] = vs_output;
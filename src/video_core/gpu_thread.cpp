@@ -0,0 +1,163 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/video_core.h"
+
+namespace VideoCore {
+
+GPUThread::GPUThread(EmuWindow& emu_window, Core::Timing& timing)
+    : emu_window(emu_window), timing(timing) {
+    emulation_thread_event = timing.RegisterEvent(
+        "VideoCore::GPUThread::EmulationThreadCommand", [](u64 userdata, s64 cycles_late) {
+            if (g_gpu_thread) {
+                g_gpu_thread->ExecuteEmulationThreadCommand();
+            }
+        });
+
+    // The GL context can only be current on one thread at a time
+    emu_window.DoneCurrent();
+
+    thread = std::thread(&GPUThread::ThreadLoop, this);
+    thread_id = thread.get_id();
+}
+
+GPUThread::~GPUThread() {
+    // Queued commands may still need the emulation thread
+    WaitIdle();
+
+    is_running = false;
+    wakeup_event.Set();
+    thread.join();
+
+    emu_window.MakeCurrent();
+}
+
+u64 GPUThread::PushCommand(Command command) {
+    u64 fence;
+    {
+        std::lock_guard<std::mutex> lock(push_mutex);
+        fence = ++last_fence;
+        command_queue.Push(CommandData{std::move(command), fence});
+    }
+    wakeup_event.Set();
+    return fence;
+}
+
+void GPUThread::PushCommandAndWait(Command command) {
+    if (IsGPUThread()) {
+        // Waiting for ourselves would deadlock
+        command();
+        return;
+    }
+    WaitForFence(PushCommand(std::move(command)));
+}
+
+void GPUThread::WaitForFence(u64 fence) {
+    ASSERT_MSG(!IsGPUThread(), "GPU thread can't wait for its own commands");
+    if (signaled_fence.load(std::memory_order_acquire) >= fence) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(fence_mutex);
+    while (true) {
+        fence_cv.wait(lock, [this, fence] {
+            return signaled_fence.load() >= fence || emulation_thread_command;
+        });
+        if (!emulation_thread_command) {
+            break;
+        }
+        // The GPU thread is blocked until the command has run, so serve it before waiting again
+        lock.unlock();
+        ExecuteEmulationThreadCommand();
+        lock.lock();
+    }
+}
+
+void GPUThread::WaitIdle() {
+    u64 fence;
+    {
+        std::lock_guard<std::mutex> lock(push_mutex);
+        fence = last_fence;
+    }
+    WaitForFence(fence);
+}
+
+bool GPUThread::IsGPUThread() const {
+    return std::this_thread::get_id() == thread_id;
+}
+
+void GPUThread::RunOnEmulationThread(Command command) {
+    ASSERT_MSG(IsGPUThread(), "Only the GPU thread can send commands to the emulation thread");
+    {
+        std::lock_guard<std::mutex> lock(fence_mutex);
+        emulation_thread_command = std::move(command);
+        ++emulation_thread_requests;
+    }
+    // Wakes the emulation thread up if it is waiting for us, otherwise it runs the command from
+    // CoreTiming
+    fence_cv.notify_all();
+    timing.ScheduleEventThreadsafe(0, emulation_thread_event, 0);
+
+    std::unique_lock<std::mutex> lock(fence_mutex);
+    emulation_thread_cv.wait(
+        lock, [this] { return emulation_thread_completed == emulation_thread_requests; });
+}
+
+void GPUThread::ExecuteEmulationThreadCommand() {
+    Command command;
+    {
+        std::lock_guard<std::mutex> lock(fence_mutex);
+        if (!emulation_thread_command) {
+            // Already executed while the emulation thread was waiting for a fence
+            return;
+        }
+        command = std::move(emulation_thread_command);
+        emulation_thread_command = nullptr;
+    }
+
+    command();
+
+    {
+        std::lock_guard<std::mutex> lock(fence_mutex);
+        ++emulation_thread_completed;
+    }
+    emulation_thread_cv.notify_all();
+}
+
+void GPUThread::ThreadLoop() {
+    Common::SetCurrentThreadName("GPUThread");
+    MicroProfileOnThreadCreate("GPUThread");
+    emu_window.MakeCurrent();
+
+    while (true) {
+        CommandData data;
+        while (command_queue.Pop(data)) {
+            data.command();
+            {
+                std::lock_guard<std::mutex> lock(fence_mutex);
+                signaled_fence.store(data.fence, std::memory_order_release);
+            }
+            fence_cv.notify_all();
+        }
+
+        // Commands pushed before the stop request have all been drained above
+        if (!is_running) {
+            break;
+        }
+        wakeup_event.Wait();
+    }
+
+    emu_window.DoneCurrent();
+#if MICROPROFILE_ENABLED
+    MicroProfileOnThreadExit();
+#endif
+}
+
+} // namespace VideoCore
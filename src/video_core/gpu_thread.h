@@ -0,0 +1,115 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "common/common_types.h"
+#include "common/thread.h"
+#include "common/threadsafe_queue.h"
+
+class EmuWindow;
+
+namespace Core {
+class Timing;
+struct TimingEventType;
+}
+
+namespace VideoCore {
+
+/**
+ * Executes emulated GPU work (PICA command lists, memory fills, display transfers and buffer
+ * swaps) on a dedicated host thread. While the thread is running it owns Pica::g_state, the
+ * renderer and the renderer's GL context. The emulation thread only queues work, and waits for the
+ * GPU thread at memory flush/invalidate points and at VBlank.
+ *
+ * Work that must not race with the emulated CPU, such as changes to the page tables, is sent back
+ * from the GPU thread to the emulation thread with RunOnEmulationThread.
+ */
+class GPUThread {
+public:
+    using Command = std::function<void()>;
+
+    /**
+     * Takes over the GL context of emu_window. The calling thread must have it current.
+     * @param timing CoreTiming of the emulation thread, which runs RunOnEmulationThread commands
+     */
+    GPUThread(EmuWindow& emu_window, Core::Timing& timing);
+
+    /// Executes all pending commands, stops the thread and makes the GL context current again on
+    /// the calling thread. Must be called on the emulation thread.
+    ~GPUThread();
+
+    /**
+     * Queues a command for execution on the GPU thread.
+     * @returns Fence value that is signaled once the command has been executed
+     */
+    u64 PushCommand(Command command);
+
+    /// Queues a command and blocks until the GPU thread has executed it
+    void PushCommandAndWait(Command command);
+
+    /**
+     * Blocks until the command identified by fence has been executed. Commands sent to the
+     * emulation thread in the meantime are executed while waiting.
+     */
+    void WaitForFence(u64 fence);
+
+    /// Blocks until every queued command has been executed
+    void WaitIdle();
+
+    /// Returns true if the caller is running on the GPU thread
+    bool IsGPUThread() const;
+
+    /**
+     * Executes a command on the emulation thread, and blocks the GPU thread until it has been
+     * executed. The emulation thread picks the command up at its next CoreTiming event, or right
+     * away if it is waiting for the GPU thread. Must be called on the GPU thread.
+     */
+    void RunOnEmulationThread(Command command);
+
+    /// Executes the command sent by RunOnEmulationThread, if any. Must be called on the emulation
+    /// thread.
+    void ExecuteEmulationThreadCommand();
+
+private:
+    struct CommandData {
+        Command command;
+        u64 fence;
+    };
+
+    void ThreadLoop();
+
+    EmuWindow& emu_window;
+    Core::Timing& timing;
+
+    Common::SPSCQueue<CommandData> command_queue;
+    /// Serializes producers, so that fences are pushed in increasing order
+    std::mutex push_mutex;
+    /// Set whenever a command is pushed or the thread is asked to stop
+    Common::Event wakeup_event;
+
+    u64 last_fence = 0;
+    std::atomic<u64> signaled_fence{0};
+    std::mutex fence_mutex;
+    std::condition_variable fence_cv;
+
+    /// Command sent to the emulation thread and not yet picked up. Guarded by fence_mutex, like
+    /// the request counters.
+    Command emulation_thread_command;
+    u64 emulation_thread_requests = 0;
+    u64 emulation_thread_completed = 0;
+    std::condition_variable emulation_thread_cv;
+    Core::TimingEventType* emulation_thread_event;
+
+    std::atomic<bool> is_running{true};
+    std::thread thread;
+    std::thread::id thread_id;
+};
+
+} // namespace VideoCore
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include "common/chunk_file.h"
 #include "video_core/geometry_pipeline.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
@@ -26,6 +27,87 @@ void Zero(T& o) {
     memset(&o, 0, sizeof(o));
 }
 
+template <typename T>
+static void DoRaw(PointerWrap& p, T& o) {
+    static_assert(std::is_trivially_copyable_v<T>, "Type must be trivially copyable");
+    p.DoVoid(&o, sizeof(o));
+}
+
+static void DoShaderState(PointerWrap& p, StateSnapshot::ShaderState& shader) {
+    DoRaw(p, shader.uniforms);
+    DoRaw(p, shader.program_code);
+    DoRaw(p, shader.swizzle_data);
+    p.Do(shader.entry_point);
+}
+
+void StateSnapshot::DoState(PointerWrap& p) {
+    auto section = p.Section("Pica", 1);
+    if (!section) {
+        return;
+    }
+
+    DoRaw(p, regs);
+    DoShaderState(p, vs);
+    DoShaderState(p, gs);
+    DoRaw(p, input_default_attributes);
+    DoRaw(p, proctex);
+    DoRaw(p, lighting);
+    DoRaw(p, fog);
+    DoRaw(p, immediate_input_vertex);
+    p.Do(immediate_current_attribute);
+}
+
+static void TakeShaderState(StateSnapshot::ShaderState& shader,
+                            const Shader::ShaderSetup& setup) {
+    shader.uniforms = setup.uniforms;
+    shader.program_code = setup.program_code;
+    shader.swizzle_data = setup.swizzle_data;
+    shader.entry_point = setup.engine_data.entry_point;
+}
+
+static void RestoreShaderState(Shader::ShaderSetup& setup,
+                               const StateSnapshot::ShaderState& shader) {
+    setup.uniforms = shader.uniforms;
+    setup.program_code = shader.program_code;
+    setup.swizzle_data = shader.swizzle_data;
+    setup.engine_data.entry_point = shader.entry_point;
+    setup.MarkProgramCodeDirty();
+    setup.MarkSwizzleDataDirty();
+    setup.engine_data.cached_shader = nullptr;
+}
+
+void TakeSnapshot(StateSnapshot& snapshot) {
+    snapshot.regs = g_state.regs;
+    TakeShaderState(snapshot.vs, g_state.vs);
+    TakeShaderState(snapshot.gs, g_state.gs);
+    snapshot.input_default_attributes = g_state.input_default_attributes;
+    snapshot.proctex = g_state.proctex;
+    snapshot.lighting = g_state.lighting;
+    snapshot.fog = g_state.fog;
+    snapshot.immediate_input_vertex = g_state.immediate.input_vertex;
+    snapshot.immediate_current_attribute = g_state.immediate.current_attribute;
+}
+
+void RestoreSnapshot(const StateSnapshot& snapshot) {
+    g_state.regs = snapshot.regs;
+    RestoreShaderState(g_state.vs, snapshot.vs);
+    RestoreShaderState(g_state.gs, snapshot.gs);
+    g_state.input_default_attributes = snapshot.input_default_attributes;
+    g_state.proctex = snapshot.proctex;
+    g_state.lighting = snapshot.lighting;
+    g_state.fog = snapshot.fog;
+    g_state.immediate.input_vertex = snapshot.immediate_input_vertex;
+    g_state.immediate.current_attribute = snapshot.immediate_current_attribute;
+
+    // Draws never span a save state, so the vertex pipeline starts out empty
+    g_state.primitive_assembler.Reconfigure(g_state.regs.pipeline.triangle_topology);
+    g_state.immediate.reset_geometry_pipeline = true;
+
+    for (u32 id = 0; id < Regs::NUM_REGS; ++id) {
+        VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
+    }
+}
+
 State::State() : geometry_pipeline(*this) {
     auto SubmitVertex = [this](const Shader::AttributeBuffer& vertex) {
         using Pica::Shader::OutputVertex;
@@ -5,12 +5,24 @@
 #pragma once
 
 #include "video_core/regs_texturing.h"
+
 namespace Pica {
 
+struct StateSnapshot;
+
 /// Initialize Pica state
 void Init();
 
 /// Shutdown Pica state
 void Shutdown();
 
+/// Copies the Pica state. Must not be called while a command list is being processed.
+void TakeSnapshot(StateSnapshot& snapshot);
+
+/**
+ * Restores the Pica state. Must not be called while a command list is being processed. The
+ * rasterizer is notified of every register so that it resynchronizes its state.
+ */
+void RestoreSnapshot(const StateSnapshot& snapshot);
+
 } // namespace Pica
@@ -13,6 +13,8 @@
 #include "video_core/regs.h"
 #include "video_core/shader/shader.h"
 
+class PointerWrap;
+
 namespace Pica {
 
 /// Struct used to describe current Pica state
@@ -156,4 +158,26 @@ struct State {
 
 extern State g_state; ///< Current Pica state
 
+/// Pica state as stored in save states
+struct StateSnapshot {
+    struct ShaderState {
+        Shader::Uniforms uniforms;
+        std::array<u32, Shader::MAX_PROGRAM_CODE_LENGTH> program_code;
+        std::array<u32, Shader::MAX_SWIZZLE_DATA_LENGTH> swizzle_data;
+        unsigned int entry_point;
+    };
+
+    Regs regs;
+    ShaderState vs;
+    ShaderState gs;
+    Shader::AttributeBuffer input_default_attributes;
+    State::ProcTex proctex;
+    State::Lighting lighting;
+    decltype(State::fog) fog;
+    Shader::AttributeBuffer immediate_input_vertex;
+    u32 immediate_current_attribute;
+
+    void DoState(PointerWrap& p);
+};
+
 } // namespace Pica
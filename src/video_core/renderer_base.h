@@ -4,9 +4,12 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
 #include "common/common_types.h"
 #include "core/core.h"
+#include "core/hw/gpu.h"
+#include "core/hw/lcd.h"
 #include "video_core/rasterizer_interface.h"
 
 class EmuWindow;
@@ -19,8 +22,18 @@ public:
     explicit RendererBase(EmuWindow& window);
     virtual ~RendererBase();
 
+    /**
+     * The display registers a frame is presented from. They are copied at VBlank, as the emulated
+     * CPU keeps writing them while the GPU thread presents the frame.
+     */
+    struct FrameRegs {
+        std::array<GPU::Regs::FramebufferConfig, 2> framebuffer_config;
+        /// Color fills of the top and bottom screens
+        std::array<LCD::Regs::ColorFill, 2> color_fill;
+    };
+
     /// Swap buffers (render frame)
-    virtual void SwapBuffers() = 0;
+    virtual void SwapBuffers(const FrameRegs& regs) = 0;
 
     /// Initialize the renderer
     virtual Core::System::ResultStatus Init() = 0;
@@ -0,0 +1,555 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include "common/alignment.h"
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/thread_worker.h"
+#include "core/memory.h"
+#include "video_core/renderer_opengl/gl_morton.h"
+#include "video_core/renderer_opengl/gl_vars.h"
+#include "video_core/utils.h"
+#include "video_core/video_core.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <immintrin.h>
+#include "common/x64/cpu_detect.h"
+#endif
+
+namespace OpenGL {
+
+using PixelFormat = SurfaceParams::PixelFormat;
+
+/// Ranges are only split across threads if every thread gets at least this many bytes
+constexpr u32 MIN_CHUNK_SIZE = 64 * 1024;
+/// Upper bound on the number of conversion threads, as the conversion is mostly memory bound
+constexpr unsigned MAX_WORKERS = 4;
+
+template <bool morton_to_gl, PixelFormat format>
+static void MortonCopyTile(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    constexpr u32 bytes_per_pixel = SurfaceParams::GetFormatBpp(format) / 8;
+    constexpr u32 gl_bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(format);
+    static_assert(gl_bytes_per_pixel >= bytes_per_pixel, "");
+    gl_buffer += gl_bytes_per_pixel - bytes_per_pixel;
+
+    for (u32 y = 0; y < 8; ++y) {
+        for (u32 x = 0; x < 8; ++x) {
+            u8* tile_ptr = tile_buffer + VideoCore::MortonInterleave(x, y) * bytes_per_pixel;
+            u8* gl_ptr = gl_buffer + ((7 - y) * stride + x) * gl_bytes_per_pixel;
+            if (morton_to_gl) {
+                if (format == PixelFormat::D24S8) {
+                    gl_ptr[0] = tile_ptr[3];
+                    std::memcpy(gl_ptr + 1, tile_ptr, 3);
+                } else if (format == PixelFormat::RGBA8 && GLES) {
+                    // because GLES does not have ABGR format
+                    // so we will do byteswapping here
+                    gl_ptr[0] = tile_ptr[3];
+                    gl_ptr[1] = tile_ptr[2];
+                    gl_ptr[2] = tile_ptr[1];
+                    gl_ptr[3] = tile_ptr[0];
+                } else if (format == PixelFormat::RGB8 && GLES) {
+                    gl_ptr[0] = tile_ptr[2];
+                    gl_ptr[1] = tile_ptr[1];
+                    gl_ptr[2] = tile_ptr[0];
+                } else {
+                    std::memcpy(gl_ptr, tile_ptr, bytes_per_pixel);
+                }
+            } else {
+                if (format == PixelFormat::D24S8) {
+                    std::memcpy(tile_ptr, gl_ptr + 1, 3);
+                    tile_ptr[3] = gl_ptr[0];
+                } else {
+                    std::memcpy(tile_ptr, gl_ptr, bytes_per_pixel);
+                }
+            }
+        }
+    }
+}
+
+template <bool morton_to_gl>
+static MortonTileFn GetScalarTileFn(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return MortonCopyTile<morton_to_gl, PixelFormat::RGBA8>;
+    case PixelFormat::RGB8:
+        return MortonCopyTile<morton_to_gl, PixelFormat::RGB8>;
+    case PixelFormat::RGB5A1:
+        return MortonCopyTile<morton_to_gl, PixelFormat::RGB5A1>;
+    case PixelFormat::RGB565:
+        return MortonCopyTile<morton_to_gl, PixelFormat::RGB565>;
+    case PixelFormat::RGBA4:
+        return MortonCopyTile<morton_to_gl, PixelFormat::RGBA4>;
+    case PixelFormat::D16:
+        return MortonCopyTile<morton_to_gl, PixelFormat::D16>;
+    case PixelFormat::D24:
+        return MortonCopyTile<morton_to_gl, PixelFormat::D24>;
+    case PixelFormat::D24S8:
+        return MortonCopyTile<morton_to_gl, PixelFormat::D24S8>;
+    default:
+        return nullptr;
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+// The vector kernels are selected at runtime, so they are compiled for their instruction set
+// regardless of the flags the rest of the file is compiled with.
+#ifdef _MSC_VER
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#else
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// The whole-tile kernels work on pairs of tile rows. In the PICA layout, the pixels of rows 2n and
+// 2n+1 are stored in four 2x2 pixel blocks: two contiguous blocks for columns 0-3, followed four
+// blocks later by two contiguous blocks for columns 4-7. Each block stores its bottom two pixels
+// (the even row) before its top two pixels (the odd row).
+
+/// Index of the first 2x2 block of tile rows 2 * row_pair and 2 * row_pair + 1, in Morton order
+constexpr u32 RowPairBlock(u32 row_pair) {
+    return ((row_pair & 1) << 1) | ((row_pair & 2) << 2);
+}
+
+static __m128i Load128(const u8* ptr) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+}
+
+static void Store128(u8* ptr, __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), value);
+}
+
+static void Store64(u8* ptr, __m128i value) {
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(ptr), value);
+}
+
+/// Gathers bytes of two registers. Shuffle indices with the top bit set select zero.
+static TARGET_SSSE3 __m128i Gather(__m128i a, __m128i a_indices, __m128i b, __m128i b_indices) {
+    return _mm_or_si128(_mm_shuffle_epi8(a, a_indices), _mm_shuffle_epi8(b, b_indices));
+}
+
+/// Applies the per-pixel byte reordering between the PICA and GL layouts of 32-bit pixels
+template <bool morton_to_gl, PixelFormat format>
+static TARGET_SSSE3 __m128i ConvertPixels32(__m128i pixels) {
+    if (format == PixelFormat::D24S8) {
+        // The stencil byte is the first byte in GL and the last byte in the PICA layout
+        return morton_to_gl ? _mm_or_si128(_mm_slli_epi32(pixels, 8), _mm_srli_epi32(pixels, 24))
+                            : _mm_or_si128(_mm_srli_epi32(pixels, 8), _mm_slli_epi32(pixels, 24));
+    }
+    if (format == PixelFormat::RGBA8 && morton_to_gl && GLES) {
+        const __m128i byteswap =
+            _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        return _mm_shuffle_epi8(pixels, byteswap);
+    }
+    return pixels;
+}
+
+template <bool morton_to_gl, PixelFormat format>
+static TARGET_SSSE3 void MortonCopyTile32SSSE3(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    const u32 gl_stride = stride * 4;
+    for (u32 row_pair = 0; row_pair < 4; ++row_pair) {
+        u8* const tile_left = tile_buffer + RowPairBlock(row_pair) * 16;
+        u8* const gl_even = gl_buffer + (7 - 2 * row_pair) * gl_stride;
+        u8* const gl_odd = gl_even - gl_stride;
+        for (u32 half = 0; half < 2; ++half) {
+            u8* const tile_ptr = tile_left + half * 64;
+            if (morton_to_gl) {
+                const __m128i block0 = Load128(tile_ptr);
+                const __m128i block1 = Load128(tile_ptr + 16);
+                Store128(gl_even + half * 16,
+                         ConvertPixels32<true, format>(_mm_unpacklo_epi64(block0, block1)));
+                Store128(gl_odd + half * 16,
+                         ConvertPixels32<true, format>(_mm_unpackhi_epi64(block0, block1)));
+            } else {
+                const __m128i even = ConvertPixels32<false, format>(Load128(gl_even + half * 16));
+                const __m128i odd = ConvertPixels32<false, format>(Load128(gl_odd + half * 16));
+                Store128(tile_ptr, _mm_unpacklo_epi64(even, odd));
+                Store128(tile_ptr + 16, _mm_unpackhi_epi64(even, odd));
+            }
+        }
+    }
+}
+
+template <bool morton_to_gl>
+static TARGET_SSSE3 void MortonCopyTile16SSSE3(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    const u32 gl_stride = stride * 2;
+    for (u32 row_pair = 0; row_pair < 4; ++row_pair) {
+        u8* const tile_left = tile_buffer + RowPairBlock(row_pair) * 8;
+        u8* const tile_right = tile_left + 32;
+        u8* const gl_even = gl_buffer + (7 - 2 * row_pair) * gl_stride;
+        u8* const gl_odd = gl_even - gl_stride;
+        // Each 32-bit lane holds a horizontal pair of pixels, lanes 0 and 2 belong to the even row
+        if (morton_to_gl) {
+            const __m128i left = _mm_shuffle_epi32(Load128(tile_left), _MM_SHUFFLE(3, 1, 2, 0));
+            const __m128i right = _mm_shuffle_epi32(Load128(tile_right), _MM_SHUFFLE(3, 1, 2, 0));
+            Store128(gl_even, _mm_unpacklo_epi64(left, right));
+            Store128(gl_odd, _mm_unpackhi_epi64(left, right));
+        } else {
+            const __m128i even = Load128(gl_even);
+            const __m128i odd = Load128(gl_odd);
+            Store128(tile_left, _mm_shuffle_epi32(_mm_unpacklo_epi64(even, odd),
+                                                  _MM_SHUFFLE(3, 1, 2, 0)));
+            Store128(tile_right, _mm_shuffle_epi32(_mm_unpackhi_epi64(even, odd),
+                                                   _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+    }
+}
+
+template <bool morton_to_gl, PixelFormat format>
+static TARGET_SSSE3 void MortonCopyTile24SSSE3(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    // D24 pixels are 4 bytes wide in GL, with the depth in the upper three bytes
+    constexpr bool expand = format == PixelFormat::D24;
+    constexpr u32 gl_bytes_per_pixel = expand ? 4 : 3;
+    constexpr s8 z = -1;
+
+    const u32 gl_stride = stride * gl_bytes_per_pixel;
+    const bool reverse = !expand && morton_to_gl && GLES;
+    const __m128i reverse_pixels = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, z, z, z, z);
+
+    for (u32 row_pair = 0; row_pair < 4; ++row_pair) {
+        u8* const tile_left = tile_buffer + RowPairBlock(row_pair) * 12;
+        u8* const gl_even = gl_buffer + (7 - 2 * row_pair) * gl_stride;
+        u8* const gl_odd = gl_even - gl_stride;
+
+        if (morton_to_gl) {
+            // Four pixels of each row, from the 24 bytes at tile_ptr split into bytes 0-15 (lo)
+            // and bytes 8-23 (hi)
+            __m128i even[2], odd[2];
+            for (u32 half = 0; half < 2; ++half) {
+                const u8* const tile_ptr = tile_left + half * 48;
+                const __m128i lo = Load128(tile_ptr);
+                const __m128i hi = Load128(tile_ptr + 8);
+                if (expand) {
+                    even[half] = Gather(
+                        lo, _mm_setr_epi8(z, 0, 1, 2, z, 3, 4, 5, z, 12, 13, 14, z, 15, z, z), hi,
+                        _mm_setr_epi8(z, z, z, z, z, z, z, z, z, z, z, z, z, z, 8, 9));
+                    odd[half] = Gather(
+                        lo, _mm_setr_epi8(z, 6, 7, 8, z, 9, 10, 11, z, z, z, z, z, z, z, z), hi,
+                        _mm_setr_epi8(z, z, z, z, z, z, z, z, z, 10, 11, 12, z, 13, 14, 15));
+                } else {
+                    even[half] = Gather(
+                        lo, _mm_setr_epi8(0, 1, 2, 3, 4, 5, 12, 13, 14, 15, z, z, z, z, z, z), hi,
+                        _mm_setr_epi8(z, z, z, z, z, z, z, z, z, z, 8, 9, z, z, z, z));
+                    odd[half] = Gather(
+                        lo, _mm_setr_epi8(6, 7, 8, 9, 10, 11, z, z, z, z, z, z, z, z, z, z), hi,
+                        _mm_setr_epi8(z, z, z, z, z, z, 10, 11, 12, 13, 14, 15, z, z, z, z));
+                    if (reverse) {
+                        even[half] = _mm_shuffle_epi8(even[half], reverse_pixels);
+                        odd[half] = _mm_shuffle_epi8(odd[half], reverse_pixels);
+                    }
+                }
+            }
+
+            if (expand) {
+                Store128(gl_even, even[0]);
+                Store128(gl_even + 16, even[1]);
+                Store128(gl_odd, odd[0]);
+                Store128(gl_odd + 16, odd[1]);
+            } else {
+                Store128(gl_even, _mm_or_si128(even[0], _mm_slli_si128(even[1], 12)));
+                Store64(gl_even + 16, _mm_srli_si128(even[1], 4));
+                Store128(gl_odd, _mm_or_si128(odd[0], _mm_slli_si128(odd[1], 12)));
+                Store64(gl_odd + 16, _mm_srli_si128(odd[1], 4));
+            }
+        } else {
+            for (u32 half = 0; half < 2; ++half) {
+                u8* const tile_ptr = tile_left + half * 48;
+                __m128i lo, hi;
+                if (expand) {
+                    const __m128i even = Load128(gl_even + half * 16);
+                    const __m128i odd = Load128(gl_odd + half * 16);
+                    lo = Gather(even,
+                                _mm_setr_epi8(1, 2, 3, 5, 6, 7, z, z, z, z, z, z, 9, 10, 11, 13),
+                                odd, _mm_setr_epi8(z, z, z, z, z, z, 1, 2, 3, 5, 6, 7, z, z, z, z));
+                    hi = Gather(even,
+                                _mm_setr_epi8(14, 15, z, z, z, z, z, z, z, z, z, z, z, z, z, z),
+                                odd,
+                                _mm_setr_epi8(z, z, 9, 10, 11, 13, 14, 15, z, z, z, z, z, z, z, z));
+                } else {
+                    // Rows are 24 bytes wide, the right half of a row is loaded from byte 8
+                    const __m128i even = Load128(gl_even + half * 8);
+                    const __m128i odd = Load128(gl_odd + half * 8);
+                    const s8 o = half * 4;
+                    lo = Gather(even,
+                                _mm_setr_epi8(o, o + 1, o + 2, o + 3, o + 4, o + 5, z, z, z, z, z,
+                                              z, o + 6, o + 7, o + 8, o + 9),
+                                odd,
+                                _mm_setr_epi8(z, z, z, z, z, z, o, o + 1, o + 2, o + 3, o + 4,
+                                              o + 5, z, z, z, z));
+                    hi = Gather(even,
+                                _mm_setr_epi8(o + 10, o + 11, z, z, z, z, z, z, z, z, z, z, z, z,
+                                              z, z),
+                                odd,
+                                _mm_setr_epi8(z, z, o + 6, o + 7, o + 8, o + 9, o + 10, o + 11, z,
+                                              z, z, z, z, z, z, z));
+                }
+                Store128(tile_ptr, lo);
+                Store64(tile_ptr + 16, hi);
+            }
+        }
+    }
+}
+
+template <bool morton_to_gl>
+static MortonTileFn GetSSSE3TileFn(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return MortonCopyTile32SSSE3<morton_to_gl, PixelFormat::RGBA8>;
+    case PixelFormat::RGB8:
+        return MortonCopyTile24SSSE3<morton_to_gl, PixelFormat::RGB8>;
+    case PixelFormat::RGB5A1:
+    case PixelFormat::RGB565:
+    case PixelFormat::RGBA4:
+    case PixelFormat::D16:
+        return MortonCopyTile16SSSE3<morton_to_gl>;
+    case PixelFormat::D24:
+        return MortonCopyTile24SSSE3<morton_to_gl, PixelFormat::D24>;
+    case PixelFormat::D24S8:
+        return MortonCopyTile32SSSE3<morton_to_gl, PixelFormat::D24S8>;
+    default:
+        return nullptr;
+    }
+}
+
+static TARGET_AVX2 __m256i Load256(const u8* ptr) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+}
+
+static TARGET_AVX2 void Store256(u8* ptr, __m256i value) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), value);
+}
+
+template <bool morton_to_gl, PixelFormat format>
+static TARGET_AVX2 __m256i ConvertPixels32(__m256i pixels) {
+    if (format == PixelFormat::D24S8) {
+        return morton_to_gl
+                   ? _mm256_or_si256(_mm256_slli_epi32(pixels, 8), _mm256_srli_epi32(pixels, 24))
+                   : _mm256_or_si256(_mm256_srli_epi32(pixels, 8), _mm256_slli_epi32(pixels, 24));
+    }
+    if (format == PixelFormat::RGBA8 && morton_to_gl && GLES) {
+        const __m256i byteswap =
+            _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7,
+                             6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        return _mm256_shuffle_epi8(pixels, byteswap);
+    }
+    return pixels;
+}
+
+template <bool morton_to_gl, PixelFormat format>
+static TARGET_AVX2 void MortonCopyTile32AVX2(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    const u32 gl_stride = stride * 4;
+    for (u32 row_pair = 0; row_pair < 4; ++row_pair) {
+        u8* const tile_left = tile_buffer + RowPairBlock(row_pair) * 16;
+        u8* const tile_right = tile_left + 64;
+        u8* const gl_even = gl_buffer + (7 - 2 * row_pair) * gl_stride;
+        u8* const gl_odd = gl_even - gl_stride;
+        // Each 64-bit lane holds a horizontal pair of pixels, lanes 0 and 2 belong to the even row
+        if (morton_to_gl) {
+            const __m256i left = _mm256_permute4x64_epi64(Load256(tile_left), 0xD8);
+            const __m256i right = _mm256_permute4x64_epi64(Load256(tile_right), 0xD8);
+            Store256(gl_even,
+                     ConvertPixels32<true, format>(_mm256_permute2x128_si256(left, right, 0x20)));
+            Store256(gl_odd,
+                     ConvertPixels32<true, format>(_mm256_permute2x128_si256(left, right, 0x31)));
+        } else {
+            const __m256i even = ConvertPixels32<false, format>(Load256(gl_even));
+            const __m256i odd = ConvertPixels32<false, format>(Load256(gl_odd));
+            Store256(tile_left,
+                     _mm256_permute4x64_epi64(_mm256_permute2x128_si256(even, odd, 0x20), 0xD8));
+            Store256(tile_right,
+                     _mm256_permute4x64_epi64(_mm256_permute2x128_si256(even, odd, 0x31), 0xD8));
+        }
+    }
+}
+
+template <bool morton_to_gl>
+static TARGET_AVX2 void MortonCopyTile16AVX2(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    const u32 gl_stride = stride * 2;
+    // Blocks 0-3 and 8-11 hold columns 0-3 of rows 0-3 and 4-7, the next four blocks columns 4-7
+    for (u32 quad = 0; quad < 2; ++quad) {
+        u8* const tile_left = tile_buffer + quad * 64;
+        u8* const tile_right = tile_left + 32;
+        u8* const gl_row0 = gl_buffer + (7 - 4 * quad) * gl_stride;
+        u8* const gl_row1 = gl_row0 - gl_stride;
+        u8* const gl_row2 = gl_row1 - gl_stride;
+        u8* const gl_row3 = gl_row2 - gl_stride;
+        if (morton_to_gl) {
+            const __m256i left = _mm256_shuffle_epi32(Load256(tile_left), _MM_SHUFFLE(3, 1, 2, 0));
+            const __m256i right =
+                _mm256_shuffle_epi32(Load256(tile_right), _MM_SHUFFLE(3, 1, 2, 0));
+            const __m256i rows02 = _mm256_unpacklo_epi64(left, right);
+            const __m256i rows13 = _mm256_unpackhi_epi64(left, right);
+            Store128(gl_row0, _mm256_castsi256_si128(rows02));
+            Store128(gl_row1, _mm256_castsi256_si128(rows13));
+            Store128(gl_row2, _mm256_extracti128_si256(rows02, 1));
+            Store128(gl_row3, _mm256_extracti128_si256(rows13, 1));
+        } else {
+            const __m256i rows02 = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(Load128(gl_row0)), Load128(gl_row2), 1);
+            const __m256i rows13 = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(Load128(gl_row1)), Load128(gl_row3), 1);
+            Store256(tile_left, _mm256_shuffle_epi32(_mm256_unpacklo_epi64(rows02, rows13),
+                                                     _MM_SHUFFLE(3, 1, 2, 0)));
+            Store256(tile_right, _mm256_shuffle_epi32(_mm256_unpackhi_epi64(rows02, rows13),
+                                                      _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+    }
+}
+
+template <bool morton_to_gl>
+static MortonTileFn GetAVX2TileFn(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return MortonCopyTile32AVX2<morton_to_gl, PixelFormat::RGBA8>;
+    case PixelFormat::RGB5A1:
+    case PixelFormat::RGB565:
+    case PixelFormat::RGBA4:
+    case PixelFormat::D16:
+        return MortonCopyTile16AVX2<morton_to_gl>;
+    case PixelFormat::D24S8:
+        return MortonCopyTile32AVX2<morton_to_gl, PixelFormat::D24S8>;
+    default:
+        // 24-bit pixels don't fit in 256-bit lanes any better than in 128-bit ones
+        return GetSSSE3TileFn<morton_to_gl>(format);
+    }
+}
+
+#endif // ARCHITECTURE_x86_64
+
+MortonKernel GetHostMortonKernel() {
+#ifdef ARCHITECTURE_x86_64
+    const auto& caps = Common::GetCPUCaps();
+    if (caps.avx2) {
+        return MortonKernel::AVX2;
+    }
+    if (caps.ssse3) {
+        return MortonKernel::SSSE3;
+    }
+#endif
+    return MortonKernel::Scalar;
+}
+
+MortonTileFn GetMortonTileFn(bool morton_to_gl, PixelFormat format, MortonKernel kernel) {
+    switch (kernel) {
+#ifdef ARCHITECTURE_x86_64
+    case MortonKernel::SSSE3:
+        return morton_to_gl ? GetSSSE3TileFn<true>(format) : GetSSSE3TileFn<false>(format);
+    case MortonKernel::AVX2:
+        return morton_to_gl ? GetAVX2TileFn<true>(format) : GetAVX2TileFn<false>(format);
+#endif
+    default:
+        return morton_to_gl ? GetScalarTileFn<true>(format) : GetScalarTileFn<false>(format);
+    }
+}
+
+static void MortonCopyRange(MortonTileFn copy_tile, bool morton_to_gl, PixelFormat format,
+                            u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr start,
+                            PAddr end) {
+    const u32 bytes_per_pixel = SurfaceParams::GetFormatBpp(format) / 8;
+    const u32 tile_size = bytes_per_pixel * 64;
+    const u32 gl_bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(format);
+
+    const PAddr aligned_down_start = base + Common::AlignDown(start - base, tile_size);
+    const PAddr aligned_start = base + Common::AlignUp(start - base, tile_size);
+    const PAddr aligned_end = base + Common::AlignDown(end - base, tile_size);
+
+    ASSERT(!morton_to_gl || (aligned_start == start && aligned_end == end));
+
+    const u32 begin_pixel_index = (aligned_down_start - base) / bytes_per_pixel;
+    u32 x = (begin_pixel_index % (stride * 8)) / 8;
+    u32 y = (begin_pixel_index / (stride * 8)) * 8;
+
+    gl_buffer += ((height - 8 - y) * stride + x) * gl_bytes_per_pixel;
+
+    auto glbuf_next_tile = [&] {
+        x = (x + 8) % stride;
+        gl_buffer += 8 * gl_bytes_per_pixel;
+        if (!x) {
+            y += 8;
+            gl_buffer -= stride * 9 * gl_bytes_per_pixel;
+        }
+    };
+
+    u8* tile_buffer = VideoCore::g_memory->GetPhysicalPointer(start);
+
+    if (start < aligned_start && !morton_to_gl) {
+        std::array<u8, 4 * 64> tmp_buf;
+        copy_tile(stride, &tmp_buf[0], gl_buffer);
+        std::memcpy(tile_buffer, &tmp_buf[start - aligned_down_start],
+                    std::min(aligned_start, end) - start);
+
+        tile_buffer += aligned_start - start;
+        glbuf_next_tile();
+    }
+
+    const u8* const buffer_end = tile_buffer + aligned_end - aligned_start;
+    PAddr current_paddr = aligned_start;
+    while (tile_buffer < buffer_end) {
+        // Pokemon Super Mystery Dungeon will try to use textures that go beyond
+        // the end address of VRAM. Stop reading if reaches invalid address
+        if (!VideoCore::g_memory->IsValidPhysicalAddress(current_paddr) ||
+            !VideoCore::g_memory->IsValidPhysicalAddress(current_paddr + tile_size)) {
+            LOG_ERROR(Render_OpenGL, "Out of bound texture");
+            break;
+        }
+        copy_tile(stride, tile_buffer, gl_buffer);
+        tile_buffer += tile_size;
+        current_paddr += tile_size;
+        glbuf_next_tile();
+    }
+
+    if (end > std::max(aligned_start, aligned_end) && !morton_to_gl) {
+        std::array<u8, 4 * 64> tmp_buf;
+        copy_tile(stride, &tmp_buf[0], gl_buffer);
+        std::memcpy(tile_buffer, &tmp_buf[0], end - aligned_end);
+    }
+}
+
+static Common::ThreadWorker* GetWorkers() {
+    static const std::unique_ptr<Common::ThreadWorker> workers = [] {
+        const unsigned num_workers = std::min(std::thread::hardware_concurrency(), MAX_WORKERS);
+        return num_workers > 1 ? std::make_unique<Common::ThreadWorker>(num_workers, "MortonCopy")
+                               : nullptr;
+    }();
+    return workers.get();
+}
+
+void MortonCopy(bool morton_to_gl, PixelFormat format, u32 stride, u32 height, u8* gl_buffer,
+                PAddr base, PAddr start, PAddr end) {
+    static const MortonKernel kernel = GetHostMortonKernel();
+    const MortonTileFn copy_tile = GetMortonTileFn(morton_to_gl, format, kernel);
+    ASSERT(copy_tile != nullptr);
+
+    Common::ThreadWorker* const workers = GetWorkers();
+    const u32 num_chunks = workers ? std::min(static_cast<u32>(workers->NumWorkers()),
+                                              (end - start) / MIN_CHUNK_SIZE)
+                                   : 1;
+    if (num_chunks <= 1) {
+        MortonCopyRange(copy_tile, morton_to_gl, format, stride, height, gl_buffer, base, start,
+                        end);
+        return;
+    }
+
+    // Split the range at tile boundaries, so that no two threads write to the same tile
+    const u32 tile_size = SurfaceParams::GetFormatBpp(format) * 8;
+    const u32 chunk_size = Common::AlignUp((end - start) / num_chunks, tile_size);
+    for (PAddr chunk_start = start; chunk_start < end;) {
+        const PAddr chunk_end =
+            std::min(end, base + Common::AlignUp(chunk_start - base + chunk_size, tile_size));
+        workers->QueueWork([=] {
+            MortonCopyRange(copy_tile, morton_to_gl, format, stride, height, gl_buffer, base,
+                            chunk_start, chunk_end);
+        });
+        chunk_start = chunk_end;
+    }
+    workers->WaitForRequests();
+}
+
+} // namespace OpenGL
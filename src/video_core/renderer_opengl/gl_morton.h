@@ -0,0 +1,44 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "video_core/renderer_opengl/gl_rasterizer_cache.h"
+
+namespace OpenGL {
+
+/// Implementations of the conversion between the tiled PICA layout and linear GL buffers
+enum class MortonKernel {
+    Scalar,
+    SSSE3,
+    AVX2,
+};
+
+/// Returns the fastest kernel supported by the host CPU
+MortonKernel GetHostMortonKernel();
+
+/**
+ * Converts one 8x8 tile.
+ * @param stride Width of the GL buffer in pixels
+ * @param tile_buffer Tile in the PICA layout
+ * @param gl_buffer First pixel of the bottom row of the tile in the GL buffer
+ */
+using MortonTileFn = void (*)(u32 stride, u8* tile_buffer, u8* gl_buffer);
+
+/**
+ * Returns the tile conversion function of a kernel, or nullptr if the pixel format isn't a color
+ * or depth format.
+ */
+MortonTileFn GetMortonTileFn(bool morton_to_gl, SurfaceParams::PixelFormat format,
+                             MortonKernel kernel);
+
+/**
+ * Converts the range [start, end) of the tiled surface at base between emulated memory and
+ * gl_buffer, using the fastest kernel of the host CPU. Large ranges are split across threads.
+ */
+void MortonCopy(bool morton_to_gl, SurfaceParams::PixelFormat format, u32 stride, u32 height,
+                u8* gl_buffer, PAddr base, PAddr start, PAddr end);
+
+} // namespace OpenGL
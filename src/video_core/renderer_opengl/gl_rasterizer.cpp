@@ -15,7 +15,10 @@
 #include "common/microprofile.h"
 #include "common/scope_exit.h"
 #include "common/vector_math.h"
+#include "core/core.h"
 #include "core/hw/gpu.h"
+#include "core/loader/loader.h"
+#include "core/settings.h"
 #include "video_core/pica_state.h"
 #include "video_core/regs_framebuffer.h"
 #include "video_core/regs_rasterizer.h"
@@ -157,6 +160,13 @@ RasterizerOpenGL::RasterizerOpenGL(EmuWindow& window)
     shader_program_manager =
         std::make_unique<ShaderProgramManager>(GLAD_GL_ARB_separate_shader_objects, is_amd);
 
+    u64 title_id = 0;
+    if (Settings::values.use_disk_shader_cache &&
+        Core::System::GetInstance().GetAppLoader().ReadProgramId(title_id) ==
+            Loader::ResultStatus::Success) {
+        shader_program_manager->LoadDiskCache(title_id);
+    }
+
     glEnable(GL_BLEND);
 
     SyncEntireState();
@@ -16,6 +16,7 @@
 #include <glad/glad.h>
 #include "common/alignment.h"
 #include "common/bit_field.h"
+#include "common/cityhash.h"
 #include "common/color.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
@@ -24,12 +25,13 @@
 #include "common/vector_math.h"
 #include "core/frontend/emu_window.h"
 #include "core/memory.h"
+#include "core/settings.h"
 #include "video_core/pica_state.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_opengl/gl_morton.h"
 #include "video_core/renderer_opengl/gl_rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_state.h"
 #include "video_core/renderer_opengl/gl_vars.h"
-#include "video_core/utils.h"
 #include "video_core/video_core.h"
 
 namespace OpenGL {
@@ -37,6 +39,10 @@ namespace OpenGL {
 using SurfaceType = SurfaceParams::SurfaceType;
 using PixelFormat = SurfaceParams::PixelFormat;
 
+/// Size of the shared textures the cache may hold before it drops the least recently used ones
+/// that no surface refers to anymore
+constexpr std::size_t MAX_SHARED_TEXTURES_SIZE = 128 * 1024 * 1024;
+
 struct FormatTuple {
     GLint internal_format;
     GLenum format;
@@ -163,151 +169,6 @@ constexpr auto RangeFromInterval(Map& map, const Interval& interval) {
     return boost::make_iterator_range(map.equal_range(interval));
 }
 
-template <bool morton_to_gl, PixelFormat format>
-static void MortonCopyTile(u32 stride, u8* tile_buffer, u8* gl_buffer) {
-    constexpr u32 bytes_per_pixel = SurfaceParams::GetFormatBpp(format) / 8;
-    constexpr u32 gl_bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(format);
-    for (u32 y = 0; y < 8; ++y) {
-        for (u32 x = 0; x < 8; ++x) {
-            u8* tile_ptr = tile_buffer + VideoCore::MortonInterleave(x, y) * bytes_per_pixel;
-            u8* gl_ptr = gl_buffer + ((7 - y) * stride + x) * gl_bytes_per_pixel;
-            if (morton_to_gl) {
-                if (format == PixelFormat::D24S8) {
-                    gl_ptr[0] = tile_ptr[3];
-                    std::memcpy(gl_ptr + 1, tile_ptr, 3);
-                } else if (format == PixelFormat::RGBA8 && GLES) {
-                    // because GLES does not have ABGR format
-                    // so we will do byteswapping here
-                    gl_ptr[0] = tile_ptr[3];
-                    gl_ptr[1] = tile_ptr[2];
-                    gl_ptr[2] = tile_ptr[1];
-                    gl_ptr[3] = tile_ptr[0];
-                } else if (format == PixelFormat::RGB8 && GLES) {
-                    gl_ptr[0] = tile_ptr[2];
-                    gl_ptr[1] = tile_ptr[1];
-                    gl_ptr[2] = tile_ptr[0];
-                } else {
-                    std::memcpy(gl_ptr, tile_ptr, bytes_per_pixel);
-                }
-            } else {
-                if (format == PixelFormat::D24S8) {
-                    std::memcpy(tile_ptr, gl_ptr + 1, 3);
-                    tile_ptr[3] = gl_ptr[0];
-                } else {
-                    std::memcpy(tile_ptr, gl_ptr, bytes_per_pixel);
-                }
-            }
-        }
-    }
-}
-
-template <bool morton_to_gl, PixelFormat format>
-static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr start, PAddr end) {
-    constexpr u32 bytes_per_pixel = SurfaceParams::GetFormatBpp(format) / 8;
-    constexpr u32 tile_size = bytes_per_pixel * 64;
-
-    constexpr u32 gl_bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(format);
-    static_assert(gl_bytes_per_pixel >= bytes_per_pixel, "");
-    gl_buffer += gl_bytes_per_pixel - bytes_per_pixel;
-
-    const PAddr aligned_down_start = base + Common::AlignDown(start - base, tile_size);
-    const PAddr aligned_start = base + Common::AlignUp(start - base, tile_size);
-    const PAddr aligned_end = base + Common::AlignDown(end - base, tile_size);
-
-    ASSERT(!morton_to_gl || (aligned_start == start && aligned_end == end));
-
-    const u32 begin_pixel_index = (aligned_down_start - base) / bytes_per_pixel;
-    u32 x = (begin_pixel_index % (stride * 8)) / 8;
-    u32 y = (begin_pixel_index / (stride * 8)) * 8;
-
-    gl_buffer += ((height - 8 - y) * stride + x) * gl_bytes_per_pixel;
-
-    auto glbuf_next_tile = [&] {
-        x = (x + 8) % stride;
-        gl_buffer += 8 * gl_bytes_per_pixel;
-        if (!x) {
-            y += 8;
-            gl_buffer -= stride * 9 * gl_bytes_per_pixel;
-        }
-    };
-
-    u8* tile_buffer = VideoCore::g_memory->GetPhysicalPointer(start);
-
-    if (start < aligned_start && !morton_to_gl) {
-        std::array<u8, tile_size> tmp_buf;
-        MortonCopyTile<morton_to_gl, format>(stride, &tmp_buf[0], gl_buffer);
-        std::memcpy(tile_buffer, &tmp_buf[start - aligned_down_start],
-                    std::min(aligned_start, end) - start);
-
-        tile_buffer += aligned_start - start;
-        glbuf_next_tile();
-    }
-
-    const u8* const buffer_end = tile_buffer + aligned_end - aligned_start;
-    PAddr current_paddr = aligned_start;
-    while (tile_buffer < buffer_end) {
-        // Pokemon Super Mystery Dungeon will try to use textures that go beyond
-        // the end address of VRAM. Stop reading if reaches invalid address
-        if (!VideoCore::g_memory->IsValidPhysicalAddress(current_paddr) ||
-            !VideoCore::g_memory->IsValidPhysicalAddress(current_paddr + tile_size)) {
-            LOG_ERROR(Render_OpenGL, "Out of bound texture");
-            break;
-        }
-        MortonCopyTile<morton_to_gl, format>(stride, tile_buffer, gl_buffer);
-        tile_buffer += tile_size;
-        current_paddr += tile_size;
-        glbuf_next_tile();
-    }
-
-    if (end > std::max(aligned_start, aligned_end) && !morton_to_gl) {
-        std::array<u8, tile_size> tmp_buf;
-        MortonCopyTile<morton_to_gl, format>(stride, &tmp_buf[0], gl_buffer);
-        std::memcpy(tile_buffer, &tmp_buf[0], end - aligned_end);
-    }
-}
-
-static constexpr std::array<void (*)(u32, u32, u8*, PAddr, PAddr, PAddr), 18> morton_to_gl_fns = {
-    MortonCopy<true, PixelFormat::RGBA8>,  // 0
-    MortonCopy<true, PixelFormat::RGB8>,   // 1
-    MortonCopy<true, PixelFormat::RGB5A1>, // 2
-    MortonCopy<true, PixelFormat::RGB565>, // 3
-    MortonCopy<true, PixelFormat::RGBA4>,  // 4
-    nullptr,
-    nullptr,
-    nullptr,
-    nullptr,
-    nullptr,
-    nullptr,
-    nullptr,
-    nullptr,
-    nullptr,                             // 5 - 13
-    MortonCopy<true, PixelFormat::D16>,  // 14
-    nullptr,                             // 15
-    MortonCopy<true, PixelFormat::D24>,  // 16
-    MortonCopy<true, PixelFormat::D24S8> // 17
-};
-
-static constexpr std::array<void (*)(u32, u32, u8*, PAddr, PAddr, PAddr), 18> gl_to_morton_fns = {
-    MortonCopy<false, PixelFormat::RGBA8>,  // 0
-    MortonCopy<false, PixelFormat::RGB8>,   // 1
-    MortonCopy<false, PixelFormat::RGB5A1>, // 2
-    MortonCopy<false, PixelFormat::RGB565>, // 3
-    MortonCopy<false, PixelFormat::RGBA4>,  // 4
-    nullptr,
-    nullptr,
-    nullptr,
-    nullptr,
-    nullptr,
-    nullptr,
-    nullptr,
-    nullptr,
-    nullptr,                              // 5 - 13
-    MortonCopy<false, PixelFormat::D16>,  // 14
-    nullptr,                              // 15
-    MortonCopy<false, PixelFormat::D24>,  // 16
-    MortonCopy<false, PixelFormat::D24S8> // 17
-};
-
 // Allocate an uninitialized texture of appropriate size and format for the surface
 static void AllocateSurfaceTexture(GLuint texture, const FormatTuple& format_tuple, u32 width,
                                    u32 height) {
@@ -611,6 +472,13 @@ bool SurfaceParams::CanTexCopy(const SurfaceParams& texcopy_params) const {
     return FromInterval(texcopy_params.GetInterval()).GetInterval() == texcopy_params.GetInterval();
 }
 
+CachedSurface::~CachedSurface() {
+    if (shared_texture != nullptr) {
+        // The handle belongs to the shared texture
+        texture.handle = 0;
+    }
+}
+
 bool CachedSurface::CanFill(const SurfaceParams& dest_surface,
                             SurfaceInterval fill_interval) const {
     if (type == SurfaceType::Fill && IsRegionValid(fill_interval) &&
@@ -703,6 +571,8 @@ void RasterizerCacheOpenGL::CopySurface(const Surface& src_surface, const Surfac
 
     ASSERT(src_surface != dst_surface);
 
+    DetachSharedTexture(dst_surface);
+
     // This is only called when CanCopy is true, no need to run checks here
     if (src_surface->type == SurfaceType::Fill) {
         // FillSurface needs a 4 bytes buffer
@@ -790,17 +660,22 @@ void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
             const auto rect = GetSubRect(FromInterval(load_interval));
             ASSERT(FromInterval(load_interval).GetInterval() == load_interval);
 
-            for (unsigned y = rect.bottom; y < rect.top; ++y) {
-                for (unsigned x = rect.left; x < rect.right; ++x) {
-                    auto vec4 =
-                        Pica::Texture::LookupTexture(texture_src_data, x, height - 1 - y, tex_info);
-                    const std::size_t offset = (x + (width * y)) * 4;
-                    std::memcpy(&gl_buffer[offset], vec4.AsArray(), 4);
-                }
-            }
+            // The rectangle is aligned to tiles. Texture rows are stored bottom to top in the
+            // buffer, so the decoded region starts at its top row and walks downwards.
+            const u32 first_row = height - rect.top;
+            const u8* const region_src = texture_src_data + (first_row / 8) * tex_info.stride +
+                                         (rect.left / 8) *
+                                             Pica::Texture::CalculateTileSize(tex_info.format);
+            Pica::Texture::TextureInfo region_info = tex_info;
+            region_info.width = rect.GetWidth();
+            region_info.height = rect.GetHeight();
+
+            const std::ptrdiff_t buffer_stride = static_cast<std::ptrdiff_t>(width) * 4;
+            u8* const region_dest = &gl_buffer[(rect.left + width * (rect.top - 1)) * 4];
+            Pica::Texture::DecodeTexture(region_src, region_info, region_dest, -buffer_stride);
         } else {
-            morton_to_gl_fns[static_cast<std::size_t>(pixel_format)](stride, height, &gl_buffer[0],
-                                                                     addr, load_start, load_end);
+            MortonCopy(true, pixel_format, stride, height, &gl_buffer[0], addr, load_start,
+                       load_end);
         }
     }
 }
@@ -845,8 +720,8 @@ void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
         ASSERT(type == SurfaceType::Color);
         std::memcpy(dst_buffer + start_offset, &gl_buffer[start_offset], flush_end - flush_start);
     } else {
-        gl_to_morton_fns[static_cast<std::size_t>(pixel_format)](stride, height, &gl_buffer[0],
-                                                                 addr, flush_start, flush_end);
+        MortonCopy(false, pixel_format, stride, height, &gl_buffer[0], addr, flush_start,
+                   flush_end);
     }
 }
 
@@ -1162,6 +1037,8 @@ bool RasterizerCacheOpenGL::BlitSurfaces(const Surface& src_surface,
     if (!SurfaceParams::CheckFormatsBlittable(src_surface->pixel_format, dst_surface->pixel_format))
         return false;
 
+    DetachSharedTexture(dst_surface);
+
     dst_surface->InvalidateAllWatcher();
 
     return BlitTextures(src_surface->texture.handle, src_rect, dst_surface->texture.handle,
@@ -1229,6 +1106,8 @@ void RasterizerCacheOpenGL::ConvertD24S8toABGR(GLuint src_tex,
 
 Surface RasterizerCacheOpenGL::GetSurface(const SurfaceParams& params, ScaleMatch match_res_scale,
                                           bool load_if_create) {
+    InvalidateWrittenPages();
+
     if (params.addr == 0 || params.height * params.width == 0) {
         return nullptr;
     }
@@ -1278,6 +1157,8 @@ Surface RasterizerCacheOpenGL::GetSurface(const SurfaceParams& params, ScaleMatc
 SurfaceRect_Tuple RasterizerCacheOpenGL::GetSurfaceSubRect(const SurfaceParams& params,
                                                            ScaleMatch match_res_scale,
                                                            bool load_if_create) {
+    InvalidateWrittenPages();
+
     if (params.addr == 0 || params.height * params.width == 0) {
         return std::make_tuple(nullptr, Common::Rectangle<u32>{});
     }
@@ -1386,10 +1267,17 @@ Surface RasterizerCacheOpenGL::GetTextureSurface(const Pica::Texture::TextureInf
         return tmp_surface;
     }
 
-    return GetSurface(params, ScaleMatch::Ignore, true);
+    Surface surface = GetSurface(params, ScaleMatch::Ignore, false);
+    if (surface != nullptr) {
+        ValidateTextureSurface(surface);
+    }
+    return surface;
 }
 
 const CachedTextureCube& RasterizerCacheOpenGL::GetTextureCube(const TextureCubeConfig& config) {
+    // Before looking at the watchers, which this can invalidate
+    InvalidateWrittenPages();
+
     auto& cube = texture_cube_cache[config];
 
     struct Face {
@@ -1556,11 +1444,13 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
     }
 
     if (color_surface != nullptr) {
+        DetachSharedTexture(color_surface);
         ValidateSurface(color_surface, boost::icl::first(color_vp_interval),
                         boost::icl::length(color_vp_interval));
         color_surface->InvalidateAllWatcher();
     }
     if (depth_surface != nullptr) {
+        DetachSharedTexture(depth_surface);
         ValidateSurface(depth_surface, boost::icl::first(depth_vp_interval),
                         boost::icl::length(depth_vp_interval));
         depth_surface->InvalidateAllWatcher();
@@ -1570,6 +1460,8 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
 }
 
 Surface RasterizerCacheOpenGL::GetFillSurface(const GPU::Regs::MemoryFillConfig& config) {
+    InvalidateWrittenPages();
+
     Surface new_surface = std::make_shared<CachedSurface>();
 
     new_surface->addr = config.GetStartAddress();
@@ -1592,6 +1484,8 @@ Surface RasterizerCacheOpenGL::GetFillSurface(const GPU::Regs::MemoryFillConfig&
 }
 
 SurfaceRect_Tuple RasterizerCacheOpenGL::GetTexCopySurface(const SurfaceParams& params) {
+    InvalidateWrittenPages();
+
     Common::Rectangle<u32> rect{};
 
     Surface match_surface = FindMatch<MatchFlags::TexCopy | MatchFlags::Invalid>(
@@ -1656,6 +1550,10 @@ void RasterizerCacheOpenGL::ValidateSurface(const Surface& surface, PAddr addr,
         if (it == surface->invalid_regions.end())
             break;
 
+        // Anything below writes to the texture. Contents outside the interval are only kept if
+        // there are any valid ones.
+        DetachSharedTexture(surface, !surface->IsSurfaceFullyInvalid());
+
         const auto interval = *it & validate_interval;
         // Look for a valid surface to copy from
         SurfaceParams params = surface->FromInterval(interval);
@@ -1699,6 +1597,97 @@ void RasterizerCacheOpenGL::ValidateSurface(const Surface& surface, PAddr addr,
     }
 }
 
+void RasterizerCacheOpenGL::ValidateTextureSurface(const Surface& surface) {
+    // Only textures that are loaded entirely from memory have contents determined by their data
+    const SurfaceInterval interval = surface->GetInterval();
+    const bool can_share = Settings::values.use_texture_dedup && surface->res_scale == 1 &&
+                           surface->IsSurfaceFullyInvalid() &&
+                           RangeFromInterval(dirty_regions, interval).empty() &&
+                           VideoCore::g_memory->IsValidPhysicalAddress(surface->end - 1);
+    const u8* const source =
+        can_share ? VideoCore::g_memory->GetPhysicalPointer(surface->addr) : nullptr;
+    if (source == nullptr) {
+        ValidateSurface(surface, surface->addr, surface->size);
+        return;
+    }
+
+    TextureContentKey key;
+    key.hash = Common::CityHash64(reinterpret_cast<const char*>(source), surface->size);
+    key.width = surface->width;
+    key.height = surface->height;
+    key.format = static_cast<Pica::TexturingRegs::TextureFormat>(surface->pixel_format);
+
+    auto& shared = shared_textures[key];
+    if (shared == nullptr) {
+        // Upload the texture as usual and hand it over to the store
+        ValidateSurface(surface, surface->addr, surface->size);
+        shared = std::make_shared<SharedTexture>();
+        shared->texture = std::move(surface->texture);
+        shared->size = surface->width * surface->height *
+                       CachedSurface::GetGLBytesPerPixel(surface->pixel_format);
+        shared_textures_size += shared->size;
+    } else {
+        if (surface->shared_texture != nullptr) {
+            surface->texture.handle = 0;
+        } else {
+            surface->texture.Release();
+        }
+        surface->invalid_regions.erase(interval);
+        surface->InvalidateAllWatcher();
+    }
+
+    shared->last_use = ++shared_texture_use_counter;
+    surface->texture.handle = shared->texture.handle;
+    surface->shared_texture = shared;
+    EvictSharedTextures();
+}
+
+void RasterizerCacheOpenGL::DetachSharedTexture(const Surface& surface, bool keep_contents) {
+    if (surface->shared_texture == nullptr) {
+        return;
+    }
+
+    OGLTexture texture;
+    texture.Create();
+    AllocateSurfaceTexture(texture.handle, GetFormatTuple(surface->pixel_format),
+                           surface->GetScaledWidth(), surface->GetScaledHeight());
+    if (keep_contents) {
+        const auto rect = surface->GetScaledRect();
+        BlitTextures(surface->texture.handle, rect, texture.handle, rect, surface->type,
+                     read_framebuffer.handle, draw_framebuffer.handle);
+    }
+
+    // The handle belongs to the shared texture
+    surface->texture.handle = 0;
+    surface->texture = std::move(texture);
+    surface->shared_texture.reset();
+}
+
+void RasterizerCacheOpenGL::EvictSharedTextures() {
+    if (shared_textures_size <= MAX_SHARED_TEXTURES_SIZE) {
+        return;
+    }
+
+    // Textures that only the store refers to are not used by any surface anymore
+    std::vector<decltype(shared_textures)::iterator> unused;
+    for (auto it = shared_textures.begin(); it != shared_textures.end(); ++it) {
+        if (it->second.use_count() == 1) {
+            unused.push_back(it);
+        }
+    }
+    std::sort(unused.begin(), unused.end(), [](const auto& a, const auto& b) {
+        return a->second->last_use < b->second->last_use;
+    });
+
+    for (auto it : unused) {
+        if (shared_textures_size <= MAX_SHARED_TEXTURES_SIZE) {
+            break;
+        }
+        shared_textures_size -= it->second->size;
+        shared_textures.erase(it);
+    }
+}
+
 void RasterizerCacheOpenGL::FlushRegion(PAddr addr, u32 size, Surface flush_surface) {
     if (size == 0)
         return;
@@ -1742,6 +1731,10 @@ void RasterizerCacheOpenGL::InvalidateRegion(PAddr addr, u32 size, const Surface
     const SurfaceInterval invalid_interval(addr, addr + size);
 
     if (region_owner != nullptr) {
+        // The GPU is about to own data in memory, which must not be on pages the CPU accesses
+        // without trapping
+        InvalidateWrittenPages();
+
         ASSERT(region_owner->type != SurfaceType::Texture);
         ASSERT(addr >= region_owner->addr && addr + size <= region_owner->end);
         // Surfaces can't have a gap
@@ -1828,6 +1821,12 @@ void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
     surface_cache.subtract({surface->GetInterval(), SurfaceSet{surface}});
 }
 
+void RasterizerCacheOpenGL::InvalidateWrittenPages() {
+    for (PAddr page : VideoCore::g_memory->RasterizerTakeWrittenPages()) {
+        InvalidateRegion(page, Memory::PAGE_SIZE, nullptr);
+    }
+}
+
 void RasterizerCacheOpenGL::UpdatePagesCachedCount(PAddr addr, u32 size, int delta) {
     const u32 num_pages =
         ((addr + size - 1) >> Memory::PAGE_BITS) - (addr >> Memory::PAGE_BITS) + 1;
@@ -53,9 +53,38 @@ struct TextureCubeConfig {
     }
 };
 
+/// Identifies the contents of a texture independently of its address
+struct TextureContentKey {
+    /// Hash of the source data of the texture
+    u64 hash;
+    u32 width;
+    u32 height;
+    Pica::TexturingRegs::TextureFormat format;
+
+    bool operator==(const TextureContentKey& rhs) const {
+        return std::tie(hash, width, height, format) ==
+               std::tie(rhs.hash, rhs.width, rhs.height, rhs.format);
+    }
+
+    bool operator!=(const TextureContentKey& rhs) const {
+        return !(*this == rhs);
+    }
+};
+
 } // namespace OpenGL
 
 namespace std {
+template <>
+struct hash<OpenGL::TextureContentKey> {
+    std::size_t operator()(const OpenGL::TextureContentKey& key) const {
+        std::size_t hash = static_cast<std::size_t>(key.hash);
+        boost::hash_combine(hash, key.width);
+        boost::hash_combine(hash, key.height);
+        boost::hash_combine(hash, static_cast<u32>(key.format));
+        return hash;
+    }
+};
+
 template <>
 struct hash<OpenGL::TextureCubeConfig> {
     std::size_t operator()(const OpenGL::TextureCubeConfig& config) const {
@@ -76,6 +105,7 @@ struct hash<OpenGL::TextureCubeConfig> {
 namespace OpenGL {
 
 struct CachedSurface;
+struct SharedTexture;
 using Surface = std::shared_ptr<CachedSurface>;
 using SurfaceSet = std::set<Surface>;
 
@@ -336,6 +366,8 @@ private:
 };
 
 struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface> {
+    ~CachedSurface();
+
     bool CanFill(const SurfaceParams& dest_surface, SurfaceInterval fill_interval) const;
     bool CanCopy(const SurfaceParams& dest_surface, SurfaceInterval copy_interval) const;
 
@@ -355,6 +387,9 @@ struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface
     std::array<u8, 4> fill_data;
 
     OGLTexture texture;
+    /// Set while texture borrows the handle of a texture shared with surfaces of identical
+    /// contents. The surface must be detached from it before its texture is written.
+    std::shared_ptr<SharedTexture> shared_texture;
 
     static constexpr unsigned int GetGLBytesPerPixel(PixelFormat format) {
         // OpenGL needs 4 bpp alignment for D24 since using GL_UNSIGNED_INT as type
@@ -407,6 +442,15 @@ struct CachedTextureCube {
     std::shared_ptr<SurfaceWatcher> nz;
 };
 
+/// A texture upload shared by all texture surfaces whose source data is identical
+struct SharedTexture {
+    OGLTexture texture;
+    /// Size of the texture in bytes
+    std::size_t size = 0;
+    /// Value of the use counter of the cache when the texture was last shared
+    u64 last_use = 0;
+};
+
 class RasterizerCacheOpenGL : NonCopyable {
 public:
     RasterizerCacheOpenGL();
@@ -464,6 +508,16 @@ private:
     /// Update surface's texture for given region when necessary
     void ValidateSurface(const Surface& surface, PAddr addr, u32 size);
 
+    /// Update the whole texture surface, sharing the upload with surfaces of identical source
+    /// data if texture deduplication is enabled
+    void ValidateTextureSurface(const Surface& surface);
+
+    /// Give the surface a texture of its own if it shares one, so that it can be written
+    void DetachSharedTexture(const Surface& surface, bool keep_contents = true);
+
+    /// Drop unused shared textures if the store grew beyond its budget
+    void EvictSharedTextures();
+
     /// Create a new surface
     Surface CreateSurface(const SurfaceParams& params);
 
@@ -473,6 +527,9 @@ private:
     /// Remove surface from the cache
     void UnregisterSurface(const Surface& surface);
 
+    /// Invalidate the pages that the CPU wrote to since the last call, and trap writes to them again
+    void InvalidateWrittenPages();
+
     /// Increase/decrease the number of surface in pages touching the specified region
     void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
 
@@ -492,5 +549,10 @@ private:
     GLint d24s8_abgr_viewport_u_id;
 
     std::unordered_map<TextureCubeConfig, CachedTextureCube> texture_cube_cache;
+
+    std::unordered_map<TextureContentKey, std::shared_ptr<SharedTexture>> shared_textures;
+    /// Combined size of all shared textures, in bytes
+    std::size_t shared_textures_size = 0;
+    u64 shared_texture_use_counter = 0;
 };
 } // namespace OpenGL
@@ -0,0 +1,287 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
+
+namespace OpenGL {
+
+static std::size_t Index(ShaderDiskCacheType type) {
+    return static_cast<std::size_t>(type);
+}
+
+static std::string GetDriverIdentity() {
+    const auto get_string = [](GLenum name) {
+        const GLubyte* value = glGetString(name);
+        return value ? std::string(reinterpret_cast<const char*>(value)) : std::string();
+    };
+    return fmt::format("{}\n{}\n{}", get_string(GL_VENDOR), get_string(GL_RENDERER),
+                       get_string(GL_VERSION));
+}
+
+/// Copies a cache entry into out, if the entry has the expected size
+template <typename T>
+static bool ReadEntry(T& out, const u8* value, u32 value_size) {
+    if (value_size != sizeof(T)) {
+        LOG_WARNING(Render_OpenGL, "Ignoring shader cache entry with invalid size {}", value_size);
+        return false;
+    }
+    std::memcpy(&out, value, sizeof(T));
+    return true;
+}
+
+class ShaderDiskCache::RawReader final
+    : public Common::LinearDiskCacheReader<ShaderDiskCacheKey, u8> {
+public:
+    explicit RawReader(ShaderDiskCache& cache) : cache(cache) {}
+
+    void Read(const ShaderDiskCacheKey& key, const u8* value, u32 value_size) override {
+        ShaderDiskCacheRaw& raw = cache.raw;
+        bool valid = false;
+        switch (key.type) {
+        case ShaderDiskCacheType::ProgramCode:
+            valid = ReadData(raw.program_codes, key.id, value, value_size);
+            break;
+        case ShaderDiskCacheType::SwizzleData:
+            valid = ReadData(raw.swizzle_data, key.id, value, value_size);
+            break;
+        case ShaderDiskCacheType::VS:
+            valid = ReadConfig(raw.vs_configs, value, value_size);
+            break;
+        case ShaderDiskCacheType::GS:
+            valid = ReadConfig(raw.gs_configs, value, value_size);
+            break;
+        case ShaderDiskCacheType::FixedGS:
+            valid = ReadConfig(raw.fixed_gs_configs, value, value_size);
+            break;
+        case ShaderDiskCacheType::FS:
+            valid = ReadConfig(raw.fs_configs, value, value_size);
+            break;
+        default:
+            LOG_WARNING(Render_OpenGL, "Unknown raw shader cache entry type {}",
+                        static_cast<u32>(key.type));
+            break;
+        }
+        if (valid) {
+            cache.stored[Index(key.type)].insert(key.id);
+        }
+    }
+
+private:
+    template <typename Data>
+    static bool ReadData(std::unordered_map<u64, Data>& map, u64 id, const u8* value,
+                         u32 value_size) {
+        Data data;
+        if (!ReadEntry(data, value, value_size)) {
+            return false;
+        }
+        map.insert_or_assign(id, data);
+        return true;
+    }
+
+    template <typename Config>
+    static bool ReadConfig(std::vector<Config>& configs, const u8* value, u32 value_size) {
+        Config config;
+        if (!ReadEntry(config.state, value, value_size)) {
+            return false;
+        }
+        configs.push_back(config);
+        return true;
+    }
+
+    ShaderDiskCache& cache;
+};
+
+class ShaderDiskCache::PrecompiledReader final
+    : public Common::LinearDiskCacheReader<ShaderDiskCacheKey, u8> {
+public:
+    PrecompiledReader(ShaderDiskCache& cache, const std::string& driver)
+        : cache(cache), driver(driver) {}
+
+    void Read(const ShaderDiskCacheKey& key, const u8* value, u32 value_size) override {
+        // The first entry identifies the driver that produced the binaries
+        if (num_entries++ == 0) {
+            const std::string entry_driver(reinterpret_cast<const char*>(value), value_size);
+            driver_matches = key.type == ShaderDiskCacheType::Driver && entry_driver == driver;
+            return;
+        }
+        if (!driver_matches || key.type != ShaderDiskCacheType::ProgramBinary ||
+            value_size < sizeof(GLenum)) {
+            return;
+        }
+
+        ProgramBinary binary;
+        std::memcpy(&binary.format, value, sizeof(GLenum));
+        binary.data.assign(value + sizeof(GLenum), value + value_size);
+        cache.binaries.insert_or_assign(key.id, std::move(binary));
+        cache.stored[Index(ShaderDiskCacheType::ProgramBinary)].insert(key.id);
+    }
+
+    bool DriverMatches() const {
+        return driver_matches;
+    }
+
+    u32 NumEntries() const {
+        return num_entries;
+    }
+
+private:
+    ShaderDiskCache& cache;
+    const std::string& driver;
+    u32 num_entries = 0;
+    bool driver_matches = false;
+};
+
+ShaderDiskCache::ShaderDiskCache(u64 title_id) {
+    const std::string dir = FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) +
+                            "shaders" DIR_SEP "opengl" DIR_SEP;
+    if (!FileUtil::CreateFullPath(dir)) {
+        LOG_ERROR(Render_OpenGL, "Failed to create shader cache directory {}", dir);
+    }
+    const std::string base_path = fmt::format("{}{:016X}", dir, title_id);
+
+    OpenRaw(base_path + ".bin");
+
+    GLint num_binary_formats = 0;
+    if (GLAD_GL_ARB_get_program_binary) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_binary_formats);
+    }
+    binaries_supported = num_binary_formats > 0;
+    if (binaries_supported) {
+        OpenPrecompiled(base_path + "_precompiled.bin");
+    } else {
+        LOG_INFO(Render_OpenGL, "Program binaries are not supported, only caching GLSL sources");
+    }
+}
+
+ShaderDiskCache::~ShaderDiskCache() {
+    raw_file.Close();
+    precompiled_file.Close();
+}
+
+void ShaderDiskCache::OpenRaw(const std::string& path) {
+    RawReader reader(*this);
+    const u32 num_entries = raw_file.OpenAndRead(path.c_str(), reader);
+    LOG_INFO(Render_OpenGL, "Loaded {} raw shader cache entries from {}", num_entries, path);
+}
+
+void ShaderDiskCache::OpenPrecompiled(const std::string& path) {
+    const std::string driver = GetDriverIdentity();
+    PrecompiledReader reader(*this, driver);
+    precompiled_file.OpenAndRead(path.c_str(), reader);
+    if (reader.DriverMatches()) {
+        LOG_INFO(Render_OpenGL, "Loaded {} program binaries from {}", binaries.size(), path);
+        return;
+    }
+
+    if (reader.NumEntries() != 0) {
+        LOG_INFO(Render_OpenGL, "Host driver changed, discarding program binaries in {}", path);
+    }
+    binaries.clear();
+    stored[Index(ShaderDiskCacheType::ProgramBinary)].clear();
+
+    precompiled_file.Close();
+    FileUtil::Delete(path);
+    precompiled_file.OpenAndRead(path.c_str(), reader);
+
+    const ShaderDiskCacheKey key{ShaderDiskCacheType::Driver, 0, 0};
+    precompiled_file.Append(key, reinterpret_cast<const u8*>(driver.data()),
+                            static_cast<u32>(driver.size()));
+}
+
+void ShaderDiskCache::FreeRaw() {
+    raw = {};
+}
+
+void ShaderDiskCache::AppendRaw(ShaderDiskCacheType type, u64 id, const void* data,
+                                std::size_t size) {
+    if (!stored[Index(type)].insert(id).second) {
+        return;
+    }
+    const ShaderDiskCacheKey key{type, 0, id};
+    raw_file.Append(key, static_cast<const u8*>(data), static_cast<u32>(size));
+}
+
+void ShaderDiskCache::SaveConfig(const PicaVSConfig& config,
+                                 const Pica::Shader::ShaderSetup& setup) {
+    AppendRaw(ShaderDiskCacheType::ProgramCode, config.state.program_hash,
+              setup.program_code.data(), sizeof(ProgramCode));
+    AppendRaw(ShaderDiskCacheType::SwizzleData, config.state.swizzle_hash,
+              setup.swizzle_data.data(), sizeof(SwizzleData));
+    AppendRaw(ShaderDiskCacheType::VS, config.Hash(), &config.state, sizeof(config.state));
+}
+
+void ShaderDiskCache::SaveConfig(const PicaGSConfig& config,
+                                 const Pica::Shader::ShaderSetup& setup) {
+    AppendRaw(ShaderDiskCacheType::ProgramCode, config.state.program_hash,
+              setup.program_code.data(), sizeof(ProgramCode));
+    AppendRaw(ShaderDiskCacheType::SwizzleData, config.state.swizzle_hash,
+              setup.swizzle_data.data(), sizeof(SwizzleData));
+    AppendRaw(ShaderDiskCacheType::GS, config.Hash(), &config.state, sizeof(config.state));
+}
+
+void ShaderDiskCache::SaveConfig(const PicaFixedGSConfig& config) {
+    AppendRaw(ShaderDiskCacheType::FixedGS, config.Hash(), &config.state, sizeof(config.state));
+}
+
+void ShaderDiskCache::SaveConfig(const PicaFSConfig& config) {
+    AppendRaw(ShaderDiskCacheType::FS, config.Hash(), &config.state, sizeof(config.state));
+}
+
+bool ShaderDiskCache::LoadProgramBinary(u64 source_hash, OGLProgram& program,
+                                        bool separable_program) {
+    auto it = binaries.find(source_hash);
+    if (it == binaries.end()) {
+        return false;
+    }
+
+    program.handle = glCreateProgram();
+    if (separable_program) {
+        glProgramParameteri(program.handle, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    }
+    glProgramBinary(program.handle, it->second.format, it->second.data.data(),
+                    static_cast<GLsizei>(it->second.data.size()));
+    // Each binary is only needed once, the program itself is kept by the in-memory caches
+    binaries.erase(it);
+
+    GLint link_status = GL_FALSE;
+    glGetProgramiv(program.handle, GL_LINK_STATUS, &link_status);
+    if (link_status != GL_TRUE) {
+        LOG_WARNING(Render_OpenGL, "Driver rejected cached program binary {:016X}", source_hash);
+        program.Release();
+        // Allow the binary of the recompiled program to replace the rejected one
+        stored[Index(ShaderDiskCacheType::ProgramBinary)].erase(source_hash);
+        return false;
+    }
+    return true;
+}
+
+void ShaderDiskCache::SaveProgramBinary(u64 source_hash, GLuint program) {
+    if (!binaries_supported ||
+        !stored[Index(ShaderDiskCacheType::ProgramBinary)].insert(source_hash).second) {
+        return;
+    }
+
+    GLint binary_length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+    if (binary_length <= 0) {
+        return;
+    }
+
+    std::vector<u8> value(sizeof(GLenum) + binary_length);
+    GLenum format = 0;
+    GLsizei length = 0;
+    glGetProgramBinary(program, binary_length, &length, &format, value.data() + sizeof(GLenum));
+    std::memcpy(value.data(), &format, sizeof(GLenum));
+
+    const ShaderDiskCacheKey key{ShaderDiskCacheType::ProgramBinary, 0, source_hash};
+    precompiled_file.Append(key, value.data(), static_cast<u32>(sizeof(GLenum) + length));
+}
+
+} // namespace OpenGL
@@ -0,0 +1,123 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/linear_disk_cache.h"
+#include "video_core/renderer_opengl/gl_shader_gen.h"
+#include "video_core/shader/shader.h"
+
+namespace OpenGL {
+
+class OGLProgram;
+
+enum class ShaderDiskCacheType : u32 {
+    // Raw cache file. These entries don't depend on the host driver.
+    ProgramCode,
+    SwizzleData,
+    VS,
+    GS,
+    FixedGS,
+    FS,
+
+    // Precompiled cache file
+    Driver,
+    ProgramBinary,
+
+    NumTypes,
+};
+
+/// Key of a record in the disk cache files
+struct ShaderDiskCacheKey {
+    ShaderDiskCacheType type;
+    u32 padding;
+    /// Hash of the stored configuration, or GLSL source hash for program binaries
+    u64 id;
+};
+static_assert(sizeof(ShaderDiskCacheKey) == 16, "ShaderDiskCacheKey has incorrect size");
+
+using ProgramCode = std::array<u32, Pica::Shader::MAX_PROGRAM_CODE_LENGTH>;
+using SwizzleData = std::array<u32, Pica::Shader::MAX_SWIZZLE_DATA_LENGTH>;
+
+/// Contents of the raw cache file, i.e. everything required to regenerate the GLSL shaders
+struct ShaderDiskCacheRaw {
+    std::unordered_map<u64, ProgramCode> program_codes;
+    std::unordered_map<u64, SwizzleData> swizzle_data;
+    std::vector<PicaVSConfig> vs_configs;
+    std::vector<PicaGSConfig> gs_configs;
+    std::vector<PicaFixedGSConfig> fixed_gs_configs;
+    std::vector<PicaFSConfig> fs_configs;
+};
+
+/**
+ * Per-title persistent storage of generated shaders. Two files are kept for each title:
+ *  - The raw file records the shader configurations and PICA programs seen so far, so that the
+ *    GLSL code can be regenerated and compiled when the title is booted again.
+ *  - The precompiled file stores program binaries retrieved with glGetProgramBinary, keyed by the
+ *    hash of their GLSL source. It is discarded whenever the host driver changes.
+ * Both files are discarded when the emulator version changes (see Common::LinearDiskCache).
+ */
+class ShaderDiskCache {
+public:
+    explicit ShaderDiskCache(u64 title_id);
+    ~ShaderDiskCache();
+
+    /// Returns the contents of the raw cache file loaded at construction
+    const ShaderDiskCacheRaw& GetRaw() const {
+        return raw;
+    }
+
+    /// Drops the raw entries loaded at construction once they are no longer needed
+    void FreeRaw();
+
+    void SaveConfig(const PicaVSConfig& config, const Pica::Shader::ShaderSetup& setup);
+    void SaveConfig(const PicaGSConfig& config, const Pica::Shader::ShaderSetup& setup);
+    void SaveConfig(const PicaFixedGSConfig& config);
+    void SaveConfig(const PicaFSConfig& config);
+
+    /**
+     * Creates program from the binary stored under the given source hash.
+     * @returns false if there is no such binary or if the driver rejected it
+     */
+    bool LoadProgramBinary(u64 source_hash, OGLProgram& program, bool separable_program);
+
+    /// Retrieves the binary of a linked program and stores it under the given source hash
+    void SaveProgramBinary(u64 source_hash, GLuint program);
+
+private:
+    class RawReader;
+    class PrecompiledReader;
+
+    using FileCache = Common::LinearDiskCache<ShaderDiskCacheKey, u8>;
+
+    struct ProgramBinary {
+        GLenum format;
+        std::vector<u8> data;
+    };
+
+    void OpenRaw(const std::string& path);
+    void OpenPrecompiled(const std::string& path);
+
+    /// Appends an entry to the raw file, unless an entry with the same key was stored before
+    void AppendRaw(ShaderDiskCacheType type, u64 id, const void* data, std::size_t size);
+
+    bool binaries_supported;
+
+    FileCache raw_file;
+    ShaderDiskCacheRaw raw;
+    std::array<std::unordered_set<u64>, static_cast<std::size_t>(ShaderDiskCacheType::NumTypes)>
+        stored;
+
+    FileCache precompiled_file;
+    std::unordered_map<u64, ProgramBinary> binaries;
+};
+
+} // namespace OpenGL
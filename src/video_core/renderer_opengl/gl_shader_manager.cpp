@@ -3,9 +3,15 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
 #include <unordered_map>
 #include <boost/functional/hash.hpp>
 #include <boost/variant.hpp>
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
 #include "video_core/renderer_opengl/gl_shader_manager.h"
 
 namespace OpenGL {
@@ -101,14 +107,25 @@ public:
         }
     }
 
-    void Create(const char* source, GLenum type) {
+    /**
+     * Creates the shader stage from GLSL source. If a disk cache is given, separable programs are
+     * loaded from and saved to its program binaries.
+     */
+    void Create(const char* source, GLenum type, ShaderDiskCache* disk_cache) {
+        source_hash = Common::ComputeHash64(source, std::strlen(source));
         if (shader_or_program.which() == 0) {
             boost::get<OGLShader>(shader_or_program).Create(source, type);
         } else {
-            OGLShader shader;
-            shader.Create(source, type);
             OGLProgram& program = boost::get<OGLProgram>(shader_or_program);
-            program.Create(true, {shader.handle});
+            if (disk_cache == nullptr ||
+                !disk_cache->LoadProgramBinary(source_hash, program, true)) {
+                OGLShader shader;
+                shader.Create(source, type);
+                program.Create(true, {shader.handle});
+                if (disk_cache != nullptr) {
+                    disk_cache->SaveProgramBinary(source_hash, program.handle);
+                }
+            }
             SetShaderUniformBlockBindings(program.handle);
             SetShaderSamplerBindings(program.handle);
         }
@@ -122,17 +139,23 @@ public:
         }
     }
 
+    /// Hash of the GLSL source code, used to identify the program binary in the disk cache
+    u64 GetSourceHash() const {
+        return source_hash;
+    }
+
 private:
     boost::variant<OGLShader, OGLProgram> shader_or_program;
+    u64 source_hash = 0;
 };
 
 class TrivialVertexShader {
 public:
     explicit TrivialVertexShader(bool separable) : program(separable) {
-        program.Create(GenerateTrivialVertexShader(separable).c_str(), GL_VERTEX_SHADER);
+        program.Create(GenerateTrivialVertexShader(separable).c_str(), GL_VERTEX_SHADER, nullptr);
     }
-    GLuint Get() const {
-        return program.GetHandle();
+    const OGLShaderStage& Get() const {
+        return program;
     }
 
 private:
@@ -144,13 +167,16 @@ template <typename KeyConfigType, std::string (*CodeGenerator)(const KeyConfigTy
 class ShaderCache {
 public:
     explicit ShaderCache(bool separable) : separable(separable) {}
-    GLuint Get(const KeyConfigType& config) {
+    const OGLShaderStage& Get(const KeyConfigType& config, ShaderDiskCache* disk_cache) {
         auto [iter, new_shader] = shaders.emplace(config, OGLShaderStage{separable});
         OGLShaderStage& cached_shader = iter->second;
         if (new_shader) {
-            cached_shader.Create(CodeGenerator(config, separable).c_str(), ShaderType);
+            cached_shader.Create(CodeGenerator(config, separable).c_str(), ShaderType, disk_cache);
+            if (disk_cache != nullptr) {
+                disk_cache->SaveConfig(config);
+            }
         }
-        return cached_shader.GetHandle();
+        return cached_shader;
     }
 
 private:
@@ -170,30 +196,31 @@ template <typename KeyConfigType,
 class ShaderDoubleCache {
 public:
     explicit ShaderDoubleCache(bool separable) : separable(separable) {}
-    GLuint Get(const KeyConfigType& key, const Pica::Shader::ShaderSetup& setup) {
+    /// Returns nullptr if the PICA program can't be translated to GLSL
+    const OGLShaderStage* Get(const KeyConfigType& key, const Pica::Shader::ShaderSetup& setup,
+                              ShaderDiskCache* disk_cache) {
         auto map_it = shader_map.find(key);
         if (map_it == shader_map.end()) {
             auto program_opt = CodeGenerator(setup, key, separable);
             if (!program_opt) {
                 shader_map[key] = nullptr;
-                return 0;
+                return nullptr;
             }
 
             std::string& program = *program_opt;
             auto [iter, new_shader] = shader_cache.emplace(program, OGLShaderStage{separable});
             OGLShaderStage& cached_shader = iter->second;
             if (new_shader) {
-                cached_shader.Create(program.c_str(), ShaderType);
+                cached_shader.Create(program.c_str(), ShaderType, disk_cache);
+            }
+            if (disk_cache != nullptr) {
+                disk_cache->SaveConfig(key, setup);
             }
             shader_map[key] = &cached_shader;
-            return cached_shader.GetHandle();
+            return &cached_shader;
         }
 
-        if (map_it->second == nullptr) {
-            return 0;
-        }
-
-        return map_it->second->GetHandle();
+        return map_it->second;
     }
 
 private:
@@ -228,6 +255,9 @@ public:
         GLuint gs = 0;
         GLuint fs = 0;
 
+        // GLSL source hashes of the stages, identifying the linked program in the disk cache
+        std::array<u64, 3> source_hashes{};
+
         bool operator==(const ShaderTuple& rhs) const {
             return std::tie(vs, gs, fs) == std::tie(rhs.vs, rhs.gs, rhs.fs);
         }
@@ -262,6 +292,8 @@ public:
     bool separable;
     std::unordered_map<ShaderTuple, OGLProgram, ShaderTuple::Hash> program_cache;
     OGLPipeline pipeline;
+
+    std::unique_ptr<ShaderDiskCache> disk_cache;
 };
 
 ShaderProgramManager::ShaderProgramManager(bool separable, bool is_amd)
@@ -269,38 +301,92 @@ ShaderProgramManager::ShaderProgramManager(bool separable, bool is_amd)
 
 ShaderProgramManager::~ShaderProgramManager() = default;
 
+void ShaderProgramManager::LoadDiskCache(u64 title_id) {
+    impl->disk_cache = std::make_unique<ShaderDiskCache>(title_id);
+    ShaderDiskCache* disk_cache = impl->disk_cache.get();
+    const ShaderDiskCacheRaw& raw = disk_cache->GetRaw();
+
+    // Restores the PICA program a VS/GS configuration was generated from. Returns false if the
+    // program wasn't recorded, e.g. because the cache file was truncated.
+    auto setup = std::make_unique<Pica::Shader::ShaderSetup>();
+    const auto restore_setup = [&raw, &setup](const PicaShaderConfigCommon& config) {
+        const auto code = raw.program_codes.find(config.program_hash);
+        const auto swizzle = raw.swizzle_data.find(config.swizzle_hash);
+        if (code == raw.program_codes.end() || swizzle == raw.swizzle_data.end()) {
+            return false;
+        }
+        setup->program_code = code->second;
+        setup->swizzle_data = swizzle->second;
+        return true;
+    };
+
+    for (const PicaVSConfig& config : raw.vs_configs) {
+        if (restore_setup(config.state)) {
+            impl->programmable_vertex_shaders.Get(config, *setup, disk_cache);
+        }
+    }
+    for (const PicaGSConfig& config : raw.gs_configs) {
+        if (restore_setup(config.state)) {
+            impl->programmable_geometry_shaders.Get(config, *setup, disk_cache);
+        }
+    }
+    for (const PicaFixedGSConfig& config : raw.fixed_gs_configs) {
+        impl->fixed_geometry_shaders.Get(config, disk_cache);
+    }
+    for (const PicaFSConfig& config : raw.fs_configs) {
+        impl->fragment_shaders.Get(config, disk_cache);
+    }
+
+    LOG_INFO(Render_OpenGL, "Preloaded {} vertex, {} geometry and {} fragment shaders",
+             raw.vs_configs.size(), raw.gs_configs.size() + raw.fixed_gs_configs.size(),
+             raw.fs_configs.size());
+    disk_cache->FreeRaw();
+}
+
 bool ShaderProgramManager::UseProgrammableVertexShader(const PicaVSConfig& config,
                                                        const Pica::Shader::ShaderSetup setup) {
-    GLuint handle = impl->programmable_vertex_shaders.Get(config, setup);
-    if (handle == 0)
+    const OGLShaderStage* stage =
+        impl->programmable_vertex_shaders.Get(config, setup, impl->disk_cache.get());
+    if (stage == nullptr)
         return false;
-    impl->current.vs = handle;
+    impl->current.vs = stage->GetHandle();
+    impl->current.source_hashes[0] = stage->GetSourceHash();
     return true;
 }
 
 void ShaderProgramManager::UseTrivialVertexShader() {
-    impl->current.vs = impl->trivial_vertex_shader.Get();
+    const OGLShaderStage& stage = impl->trivial_vertex_shader.Get();
+    impl->current.vs = stage.GetHandle();
+    impl->current.source_hashes[0] = stage.GetSourceHash();
 }
 
 bool ShaderProgramManager::UseProgrammableGeometryShader(const PicaGSConfig& config,
                                                          const Pica::Shader::ShaderSetup setup) {
-    GLuint handle = impl->programmable_geometry_shaders.Get(config, setup);
-    if (handle == 0)
+    const OGLShaderStage* stage =
+        impl->programmable_geometry_shaders.Get(config, setup, impl->disk_cache.get());
+    if (stage == nullptr)
         return false;
-    impl->current.gs = handle;
+    impl->current.gs = stage->GetHandle();
+    impl->current.source_hashes[1] = stage->GetSourceHash();
     return true;
 }
 
 void ShaderProgramManager::UseFixedGeometryShader(const PicaFixedGSConfig& config) {
-    impl->current.gs = impl->fixed_geometry_shaders.Get(config);
+    const OGLShaderStage& stage =
+        impl->fixed_geometry_shaders.Get(config, impl->disk_cache.get());
+    impl->current.gs = stage.GetHandle();
+    impl->current.source_hashes[1] = stage.GetSourceHash();
 }
 
 void ShaderProgramManager::UseTrivialGeometryShader() {
     impl->current.gs = 0;
+    impl->current.source_hashes[1] = 0;
 }
 
 void ShaderProgramManager::UseFragmentShader(const PicaFSConfig& config) {
-    impl->current.fs = impl->fragment_shaders.Get(config);
+    const OGLShaderStage& stage = impl->fragment_shaders.Get(config, impl->disk_cache.get());
+    impl->current.fs = stage.GetHandle();
+    impl->current.source_hashes[2] = stage.GetSourceHash();
 }
 
 void ShaderProgramManager::ApplyTo(OpenGLState& state) {
@@ -323,7 +409,17 @@ void ShaderProgramManager::ApplyTo(OpenGLState& state) {
     } else {
         OGLProgram& cached_program = impl->program_cache[impl->current];
         if (cached_program.handle == 0) {
-            cached_program.Create(false, {impl->current.vs, impl->current.gs, impl->current.fs});
+            ShaderDiskCache* disk_cache = impl->disk_cache.get();
+            const u64 program_hash = Common::ComputeHash64(impl->current.source_hashes.data(),
+                                                           sizeof(impl->current.source_hashes));
+            if (disk_cache == nullptr ||
+                !disk_cache->LoadProgramBinary(program_hash, cached_program, false)) {
+                cached_program.Create(false,
+                                      {impl->current.vs, impl->current.gs, impl->current.fs});
+                if (disk_cache != nullptr) {
+                    disk_cache->SaveProgramBinary(program_hash, cached_program.handle);
+                }
+            }
             SetShaderUniformBlockBindings(cached_program.handle);
             SetShaderSamplerBindings(cached_program.handle);
         }
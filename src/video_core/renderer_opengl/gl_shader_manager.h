@@ -106,6 +106,12 @@ public:
     ShaderProgramManager(bool separable, bool is_amd);
     ~ShaderProgramManager();
 
+    /**
+     * Opens the on-disk shader cache of the given title and compiles every shader recorded by
+     * previous runs, so that they don't need to be generated during gameplay.
+     */
+    void LoadDiskCache(u64 title_id);
+
     bool UseProgrammableVertexShader(const PicaVSConfig& config,
                                      const Pica::Shader::ShaderSetup setup);
 
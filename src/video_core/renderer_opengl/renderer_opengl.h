@@ -42,7 +42,7 @@ public:
     ~RendererOpenGL() override;
 
     /// Swap buffers (render frame)
-    void SwapBuffers() override;
+    void SwapBuffers(const FrameRegs& regs) override;
 
     /// Initialize the renderer
     Core::System::ResultStatus Init() override;
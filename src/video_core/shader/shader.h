@@ -254,6 +254,16 @@ public:
      * @param state Shader unit state, must be setup with input data before each shader invocation.
      */
     virtual void Run(const ShaderSetup& setup, UnitState& state) const = 0;
+
+    /**
+     * Runs the currently setup shader for several independent invocations, which engines may
+     * process together. The default implementation runs them one after the other.
+     *
+     * @param setup Shader engine state, must be setup with SetupBatch on each shader change.
+     * @param states Shader unit states, must be setup with input data.
+     * @param count Number of states.
+     */
+    virtual void RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count) const;
 };
 
 // TODO(yuriks): Remove and make it non-global state somewhere
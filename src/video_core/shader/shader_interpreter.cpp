@@ -18,6 +18,9 @@
 #include "video_core/pica_types.h"
 #include "video_core/shader/shader.h"
 #include "video_core/shader/shader_interpreter.h"
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#endif // ARCHITECTURE_x86_64
 
 using nihstro::Instruction;
 using nihstro::OpCode;
@@ -36,16 +39,14 @@ struct CallStackElement {
     u32 loop_address;   // The address where we'll return to after each loop iteration
 };
 
-template <bool Debug>
-static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData<Debug>& debug_data,
-                           unsigned offset) {
-    // TODO: Is there a maximal size for this?
-    boost::container::static_vector<CallStackElement, 16> call_stack;
-    u32 program_counter = offset;
-
-    state.conditional_code[0] = false;
-    state.conditional_code[1] = false;
+// TODO: Is there a maximal size for this?
+using CallStack = boost::container::static_vector<CallStackElement, 16>;
 
+/// Runs a shader from the given program counter and call stack until it ends
+template <bool Debug>
+static void ContinueInterpreter(const ShaderSetup& setup, UnitState& state,
+                                DebugData<Debug>& debug_data, u32 program_counter,
+                                CallStack call_stack) {
     auto call = [&program_counter, &call_stack](u32 offset, u32 num_instructions, u32 return_offset,
                                                 u8 repeat_count, u8 loop_increment) {
         // -1 to make sure when incrementing the PC we end up at the correct offset
@@ -666,6 +667,663 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
     }
 }
 
+template <bool Debug>
+static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData<Debug>& debug_data,
+                           unsigned offset) {
+    state.conditional_code[0] = false;
+    state.conditional_code[1] = false;
+
+    ContinueInterpreter(setup, state, debug_data, offset, {});
+}
+
+// Batched execution: the vertex shader is run for several vertices at once, with the registers
+// stored component-major so that every instruction becomes a loop over the vertices that the
+// compiler turns into vector operations. The batch shares one program counter; if the vertices
+// disagree on a branch, they are finished one by one by the scalar interpreter.
+
+/// Number of vertices that are shaded together
+constexpr std::size_t BATCH_LANES = 8;
+
+/// One register component of every vertex of a batch
+struct alignas(32) Lanes {
+    float v[BATCH_LANES];
+};
+
+/// One register of every vertex of a batch
+using LaneVec4 = std::array<Lanes, 4>;
+
+/// Per-lane counterpart of the scalar state of UnitState
+template <typename T>
+using LaneValues = std::array<T, BATCH_LANES>;
+
+/**
+ * Registers of a batch of vertices. Lanes past the end of a partial batch hold copies of the first
+ * vertex, so they never disagree with it on control flow and their results are simply dropped.
+ */
+struct BatchState {
+    LaneVec4 input[16];
+    LaneVec4 temporary[16];
+    LaneVec4 output[16];
+    LaneValues<bool> conditional_code[2];
+    LaneValues<s32> address_registers[3];
+};
+
+static void LoadBatchState(BatchState& batch, const UnitState* states, std::size_t count) {
+    for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+        const UnitState& state = states[lane < count ? lane : 0];
+        for (int reg = 0; reg < 16; ++reg) {
+            for (int comp = 0; comp < 4; ++comp) {
+                batch.input[reg][comp].v[lane] = state.registers.input[reg][comp].ToFloat32();
+                batch.temporary[reg][comp].v[lane] =
+                    state.registers.temporary[reg][comp].ToFloat32();
+                batch.output[reg][comp].v[lane] = state.registers.output[reg][comp].ToFloat32();
+            }
+        }
+        batch.conditional_code[0][lane] = false;
+        batch.conditional_code[1][lane] = false;
+        for (int i = 0; i < 3; ++i) {
+            batch.address_registers[i][lane] = state.address_registers[i];
+        }
+    }
+}
+
+static void StoreBatchState(const BatchState& batch, UnitState* states, std::size_t count) {
+    for (std::size_t lane = 0; lane < count; ++lane) {
+        UnitState& state = states[lane];
+        for (int reg = 0; reg < 16; ++reg) {
+            for (int comp = 0; comp < 4; ++comp) {
+                state.registers.temporary[reg][comp] =
+                    float24::FromFloat32(batch.temporary[reg][comp].v[lane]);
+                state.registers.output[reg][comp] =
+                    float24::FromFloat32(batch.output[reg][comp].v[lane]);
+            }
+        }
+        state.conditional_code[0] = batch.conditional_code[0][lane];
+        state.conditional_code[1] = batch.conditional_code[1][lane];
+        for (int i = 0; i < 3; ++i) {
+            state.address_registers[i] = batch.address_registers[i][lane];
+        }
+    }
+}
+
+static bool EvaluateCondition(Instruction::FlowControlType flow_control, bool conditional_code_x,
+                              bool conditional_code_y) {
+    using Op = Instruction::FlowControlType::Op;
+
+    bool result_x = flow_control.refx.Value() == conditional_code_x;
+    bool result_y = flow_control.refy.Value() == conditional_code_y;
+
+    switch (flow_control.op) {
+    case Op::Or:
+        return result_x || result_y;
+    case Op::And:
+        return result_x && result_y;
+    case Op::JustX:
+        return result_x;
+    case Op::JustY:
+        return result_y;
+    default:
+        UNREACHABLE();
+        return false;
+    }
+}
+
+/// Reads one component of a source register of one vertex, like LookupSourceRegister
+static float LookupLane(const BatchState& batch, const Uniforms& uniforms,
+                        const SourceRegister& source_reg, int comp, std::size_t lane) {
+    switch (source_reg.GetRegisterType()) {
+    case RegisterType::Input:
+        return batch.input[source_reg.GetIndex()][comp].v[lane];
+
+    case RegisterType::Temporary:
+        return batch.temporary[source_reg.GetIndex()][comp].v[lane];
+
+    case RegisterType::FloatUniform:
+        return uniforms.f[source_reg.GetIndex()][comp].ToFloat32();
+
+    default:
+        return 0.0f;
+    }
+}
+
+template <int SrcNum>
+static std::array<int, 4> GetSelectors(SwizzlePattern swizzle) {
+    if constexpr (SrcNum == 1) {
+        return {(int)swizzle.src1_selector_0.Value(), (int)swizzle.src1_selector_1.Value(),
+                (int)swizzle.src1_selector_2.Value(), (int)swizzle.src1_selector_3.Value()};
+    } else if constexpr (SrcNum == 2) {
+        return {(int)swizzle.src2_selector_0.Value(), (int)swizzle.src2_selector_1.Value(),
+                (int)swizzle.src2_selector_2.Value(), (int)swizzle.src2_selector_3.Value()};
+    } else {
+        return {(int)swizzle.src3_selector_0.Value(), (int)swizzle.src3_selector_1.Value(),
+                (int)swizzle.src3_selector_2.Value(), (int)swizzle.src3_selector_3.Value()};
+    }
+}
+
+template <int SrcNum>
+static bool GetNegate(SwizzlePattern swizzle) {
+    if constexpr (SrcNum == 1) {
+        return swizzle.negate_src1 != 0;
+    } else if constexpr (SrcNum == 2) {
+        return swizzle.negate_src2 != 0;
+    } else {
+        return swizzle.negate_src3 != 0;
+    }
+}
+
+/**
+ * Reads a source operand of every vertex, applying the swizzle and the negation.
+ * @param address_offsets Address register to add to the register index, nullptr if there is none
+ */
+template <int SrcNum>
+static FORCE_INLINE void GetSource(LaneVec4& out, const BatchState& batch,
+                                   const Uniforms& uniforms, const SourceRegister& source_reg,
+                                   const LaneValues<s32>* address_offsets,
+                                   SwizzlePattern swizzle) {
+    const std::array<int, 4> selectors = GetSelectors<SrcNum>(swizzle);
+
+    const bool same_offset =
+        address_offsets == nullptr ||
+        std::all_of(address_offsets->begin() + 1, address_offsets->end(),
+                    [&](s32 offset) { return offset == (*address_offsets)[0]; });
+    if (same_offset) {
+        const SourceRegister reg =
+            source_reg + (address_offsets == nullptr ? 0 : (*address_offsets)[0]);
+        const LaneVec4* lanes = nullptr;
+        switch (reg.GetRegisterType()) {
+        case RegisterType::Input:
+            lanes = &batch.input[reg.GetIndex()];
+            break;
+        case RegisterType::Temporary:
+            lanes = &batch.temporary[reg.GetIndex()];
+            break;
+        default:
+            break;
+        }
+
+        for (int comp = 0; comp < 4; ++comp) {
+            if (lanes != nullptr) {
+                out[comp] = (*lanes)[selectors[comp]];
+            } else {
+                const float value =
+                    reg.GetRegisterType() == RegisterType::FloatUniform
+                        ? uniforms.f[reg.GetIndex()][selectors[comp]].ToFloat32()
+                        : 0.0f;
+                std::fill(std::begin(out[comp].v), std::end(out[comp].v), value);
+            }
+        }
+    } else {
+        // Relative addressing with a different address for each vertex
+        for (int comp = 0; comp < 4; ++comp) {
+            for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                out[comp].v[lane] = LookupLane(batch, uniforms,
+                                               source_reg + (*address_offsets)[lane],
+                                               selectors[comp], lane);
+            }
+        }
+    }
+
+    if (GetNegate<SrcNum>(swizzle)) {
+        for (int comp = 0; comp < 4; ++comp) {
+            for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                out[comp].v[lane] = -out[comp].v[lane];
+            }
+        }
+    }
+}
+
+/// Same as float24::operator*: PICA gives 0 instead of NaN when multiplying by inf
+static FORCE_INLINE float Mul(float a, float b) {
+    const float result = a * b;
+    return (std::isnan(result) && !std::isnan(a) && !std::isnan(b)) ? 0.0f : result;
+}
+
+static FORCE_INLINE float Add(float a, float b) {
+    return a + b;
+}
+
+// NOTE: Exact forms required to match NaN semantics to hardware, see the scalar interpreter
+static FORCE_INLINE float Max(float a, float b) {
+    return (a > b) ? a : b;
+}
+
+static FORCE_INLINE float Min(float a, float b) {
+    return (a < b) ? a : b;
+}
+
+static FORCE_INLINE float SetGreaterEqual(float a, float b) {
+    return (a >= b) ? 1.0f : 0.0f;
+}
+
+static FORCE_INLINE float SetLessThan(float a, float b) {
+    return (a < b) ? 1.0f : 0.0f;
+}
+
+template <float (*Op)(float, float)>
+static FORCE_INLINE void ApplyBinary(LaneVec4& dest, const LaneVec4& src1, const LaneVec4& src2,
+                                     SwizzlePattern swizzle) {
+    for (int comp = 0; comp < 4; ++comp) {
+        if (!swizzle.DestComponentEnabled(comp))
+            continue;
+
+        for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+            dest[comp].v[lane] = Op(src1[comp].v[lane], src2[comp].v[lane]);
+        }
+    }
+}
+
+/// Writes a value computed once per vertex to all enabled components
+static FORCE_INLINE void Broadcast(LaneVec4& dest, const Lanes& value, SwizzlePattern swizzle) {
+    for (int comp = 0; comp < 4; ++comp) {
+        if (!swizzle.DestComponentEnabled(comp))
+            continue;
+
+        dest[comp] = value;
+    }
+}
+
+/// Applies a scalar function to the first component of src1, like RCP, RSQ, EX2 and LG2 do
+template <typename F>
+static FORCE_INLINE void ApplyScalar(LaneVec4& dest, const LaneVec4& src1, SwizzlePattern swizzle,
+                                     F function) {
+    Lanes result;
+    for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+        result.v[lane] = function(src1[0].v[lane]);
+    }
+    Broadcast(dest, result, swizzle);
+}
+
+static LaneVec4* GetDest(BatchState& batch, LaneVec4& dummy, const DestRegister& dest) {
+    return (dest < 0x10) ? &batch.output[dest.GetIndex()]
+                         : (dest < 0x20) ? &batch.temporary[dest.GetIndex()] : &dummy;
+}
+
+/// Returns whether all vertices of the batch agree on a flow control condition
+static bool EvaluateBatchCondition(const BatchState& batch,
+                                   Instruction::FlowControlType flow_control, bool& result) {
+    result = EvaluateCondition(flow_control, batch.conditional_code[0][0],
+                               batch.conditional_code[1][0]);
+    for (std::size_t lane = 1; lane < BATCH_LANES; ++lane) {
+        if (EvaluateCondition(flow_control, batch.conditional_code[0][lane],
+                              batch.conditional_code[1][lane]) != result) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static FORCE_INLINE void RunBatchImpl(const ShaderSetup& setup, UnitState* states,
+                                      std::size_t count) {
+    BatchState batch;
+    LoadBatchState(batch, states, count);
+
+    CallStack call_stack;
+    u32 program_counter = setup.engine_data.entry_point;
+
+    auto call = [&program_counter, &call_stack](u32 offset, u32 num_instructions, u32 return_offset,
+                                                u8 repeat_count, u8 loop_increment) {
+        // -1 to make sure when incrementing the PC we end up at the correct offset
+        program_counter = offset - 1;
+        ASSERT(call_stack.size() < call_stack.capacity());
+        call_stack.push_back(
+            {offset + num_instructions, return_offset, repeat_count, loop_increment, offset});
+    };
+
+    // Hands the vertices to the scalar interpreter, starting with the current instruction. Used
+    // when they take different paths, and for instructions that vertex shaders don't use.
+    auto finish_separately = [&] {
+        StoreBatchState(batch, states, count);
+        DebugData<false> dummy_debug_data;
+        for (std::size_t lane = 0; lane < count; ++lane) {
+            ContinueInterpreter(setup, states[lane], dummy_debug_data, program_counter,
+                                call_stack);
+        }
+    };
+
+    const auto& uniforms = setup.uniforms;
+    const auto& swizzle_data = setup.swizzle_data;
+    const auto& program_code = setup.program_code;
+
+    // Destination of instructions writing to invalid registers
+    LaneVec4 dummy;
+
+    LaneVec4 src1;
+    LaneVec4 src2;
+    LaneVec4 src3;
+
+    while (true) {
+        if (!call_stack.empty()) {
+            auto& top = call_stack.back();
+            if (program_counter == top.final_address) {
+                for (s32& loop_counter : batch.address_registers[2]) {
+                    loop_counter += top.loop_increment;
+                }
+
+                if (top.repeat_counter-- == 0) {
+                    program_counter = top.return_address;
+                    call_stack.pop_back();
+                } else {
+                    program_counter = top.loop_address;
+                }
+                continue;
+            }
+        }
+
+        const Instruction instr = {program_code[program_counter]};
+        const SwizzlePattern swizzle = {swizzle_data[instr.common.operand_desc_id]};
+
+        switch (instr.opcode.Value().GetInfo().type) {
+        case OpCode::Type::Arithmetic: {
+            const bool is_inverted =
+                (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+
+            const LaneValues<s32>* address_offsets =
+                (instr.common.address_register_index == 0)
+                    ? nullptr
+                    : &batch.address_registers[instr.common.address_register_index - 1];
+
+            GetSource<1>(src1, batch, uniforms, instr.common.GetSrc1(is_inverted),
+                         is_inverted ? nullptr : address_offsets, swizzle);
+            GetSource<2>(src2, batch, uniforms, instr.common.GetSrc2(is_inverted),
+                         is_inverted ? address_offsets : nullptr, swizzle);
+
+            LaneVec4& dest = *GetDest(batch, dummy, instr.common.dest.Value());
+
+            switch (instr.opcode.Value().EffectiveOpCode()) {
+            case OpCode::Id::ADD:
+                ApplyBinary<Add>(dest, src1, src2, swizzle);
+                break;
+
+            case OpCode::Id::MUL:
+                ApplyBinary<Mul>(dest, src1, src2, swizzle);
+                break;
+
+            case OpCode::Id::FLR:
+                for (int comp = 0; comp < 4; ++comp) {
+                    if (!swizzle.DestComponentEnabled(comp))
+                        continue;
+
+                    for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                        dest[comp].v[lane] = std::floor(src1[comp].v[lane]);
+                    }
+                }
+                break;
+
+            case OpCode::Id::MAX:
+                ApplyBinary<Max>(dest, src1, src2, swizzle);
+                break;
+
+            case OpCode::Id::MIN:
+                ApplyBinary<Min>(dest, src1, src2, swizzle);
+                break;
+
+            case OpCode::Id::DP3:
+            case OpCode::Id::DP4:
+            case OpCode::Id::DPH:
+            case OpCode::Id::DPHI: {
+                OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
+                if (opcode == OpCode::Id::DPH || opcode == OpCode::Id::DPHI)
+                    std::fill(std::begin(src1[3].v), std::end(src1[3].v), 1.0f);
+
+                int num_components = (opcode == OpCode::Id::DP3) ? 3 : 4;
+                Lanes dot{};
+                for (int comp = 0; comp < num_components; ++comp) {
+                    for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                        dot.v[lane] = dot.v[lane] + Mul(src1[comp].v[lane], src2[comp].v[lane]);
+                    }
+                }
+                Broadcast(dest, dot, swizzle);
+                break;
+            }
+
+            case OpCode::Id::RCP:
+                ApplyScalar(dest, src1, swizzle, [](float x) { return 1.0f / x; });
+                break;
+
+            case OpCode::Id::RSQ:
+                ApplyScalar(dest, src1, swizzle, [](float x) { return 1.0f / std::sqrt(x); });
+                break;
+
+            case OpCode::Id::MOVA:
+                for (int i = 0; i < 2; ++i) {
+                    if (!swizzle.DestComponentEnabled(i))
+                        continue;
+
+                    for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                        batch.address_registers[i][lane] = static_cast<s32>(src1[i].v[lane]);
+                    }
+                }
+                break;
+
+            case OpCode::Id::MOV:
+                for (int comp = 0; comp < 4; ++comp) {
+                    if (!swizzle.DestComponentEnabled(comp))
+                        continue;
+
+                    dest[comp] = src1[comp];
+                }
+                break;
+
+            case OpCode::Id::SGE:
+            case OpCode::Id::SGEI:
+                ApplyBinary<SetGreaterEqual>(dest, src1, src2, swizzle);
+                break;
+
+            case OpCode::Id::SLT:
+            case OpCode::Id::SLTI:
+                ApplyBinary<SetLessThan>(dest, src1, src2, swizzle);
+                break;
+
+            case OpCode::Id::CMP:
+                for (int i = 0; i < 2; ++i) {
+                    auto compare_op = instr.common.compare_op;
+                    auto op = (i == 0) ? compare_op.x.Value() : compare_op.y.Value();
+                    LaneValues<bool>& result = batch.conditional_code[i];
+                    const float* a = src1[i].v;
+                    const float* b = src2[i].v;
+
+                    switch (op) {
+                    case Instruction::Common::CompareOpType::Equal:
+                        for (std::size_t lane = 0; lane < BATCH_LANES; ++lane)
+                            result[lane] = (a[lane] == b[lane]);
+                        break;
+
+                    case Instruction::Common::CompareOpType::NotEqual:
+                        for (std::size_t lane = 0; lane < BATCH_LANES; ++lane)
+                            result[lane] = (a[lane] != b[lane]);
+                        break;
+
+                    case Instruction::Common::CompareOpType::LessThan:
+                        for (std::size_t lane = 0; lane < BATCH_LANES; ++lane)
+                            result[lane] = (a[lane] < b[lane]);
+                        break;
+
+                    case Instruction::Common::CompareOpType::LessEqual:
+                        for (std::size_t lane = 0; lane < BATCH_LANES; ++lane)
+                            result[lane] = (a[lane] <= b[lane]);
+                        break;
+
+                    case Instruction::Common::CompareOpType::GreaterThan:
+                        for (std::size_t lane = 0; lane < BATCH_LANES; ++lane)
+                            result[lane] = (a[lane] > b[lane]);
+                        break;
+
+                    case Instruction::Common::CompareOpType::GreaterEqual:
+                        for (std::size_t lane = 0; lane < BATCH_LANES; ++lane)
+                            result[lane] = (a[lane] >= b[lane]);
+                        break;
+
+                    default:
+                        LOG_ERROR(HW_GPU, "Unknown compare mode {:x}", static_cast<int>(op));
+                        break;
+                    }
+                }
+                break;
+
+            case OpCode::Id::EX2:
+                ApplyScalar(dest, src1, swizzle, [](float x) { return std::exp2(x); });
+                break;
+
+            case OpCode::Id::LG2:
+                ApplyScalar(dest, src1, swizzle, [](float x) { return std::log2(x); });
+                break;
+
+            default:
+                finish_separately();
+                return;
+            }
+
+            break;
+        }
+
+        case OpCode::Type::MultiplyAdd: {
+            if ((instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD) ||
+                (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI)) {
+                const SwizzlePattern& swizzle = *reinterpret_cast<const SwizzlePattern*>(
+                    &swizzle_data[instr.mad.operand_desc_id]);
+
+                bool is_inverted = (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI);
+
+                const LaneValues<s32>* address_offsets =
+                    (instr.mad.address_register_index == 0)
+                        ? nullptr
+                        : &batch.address_registers[instr.mad.address_register_index - 1];
+
+                GetSource<1>(src1, batch, uniforms, instr.mad.GetSrc1(is_inverted), nullptr,
+                             swizzle);
+                GetSource<2>(src2, batch, uniforms, instr.mad.GetSrc2(is_inverted),
+                             is_inverted ? nullptr : address_offsets, swizzle);
+                GetSource<3>(src3, batch, uniforms, instr.mad.GetSrc3(is_inverted),
+                             is_inverted ? address_offsets : nullptr, swizzle);
+
+                LaneVec4& dest = *GetDest(batch, dummy, instr.mad.dest.Value());
+                for (int comp = 0; comp < 4; ++comp) {
+                    if (!swizzle.DestComponentEnabled(comp))
+                        continue;
+
+                    for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                        dest[comp].v[lane] =
+                            Mul(src1[comp].v[lane], src2[comp].v[lane]) + src3[comp].v[lane];
+                    }
+                }
+            } else {
+                finish_separately();
+                return;
+            }
+            break;
+        }
+
+        default: {
+            bool condition;
+            switch (instr.opcode.Value()) {
+            case OpCode::Id::END:
+                StoreBatchState(batch, states, count);
+                return;
+
+            case OpCode::Id::JMPC:
+                if (!EvaluateBatchCondition(batch, instr.flow_control, condition)) {
+                    finish_separately();
+                    return;
+                }
+                if (condition) {
+                    program_counter = instr.flow_control.dest_offset - 1;
+                }
+                break;
+
+            case OpCode::Id::JMPU:
+                if (uniforms.b[instr.flow_control.bool_uniform_id] ==
+                    !(instr.flow_control.num_instructions & 1)) {
+                    program_counter = instr.flow_control.dest_offset - 1;
+                }
+                break;
+
+            case OpCode::Id::CALL:
+                call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                     program_counter + 1, 0, 0);
+                break;
+
+            case OpCode::Id::CALLU:
+                if (uniforms.b[instr.flow_control.bool_uniform_id]) {
+                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                         program_counter + 1, 0, 0);
+                }
+                break;
+
+            case OpCode::Id::CALLC:
+                if (!EvaluateBatchCondition(batch, instr.flow_control, condition)) {
+                    finish_separately();
+                    return;
+                }
+                if (condition) {
+                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                         program_counter + 1, 0, 0);
+                }
+                break;
+
+            case OpCode::Id::NOP:
+                break;
+
+            case OpCode::Id::IFU:
+            case OpCode::Id::IFC:
+                if (instr.opcode.Value() == OpCode::Id::IFU) {
+                    condition = uniforms.b[instr.flow_control.bool_uniform_id];
+                } else if (!EvaluateBatchCondition(batch, instr.flow_control, condition)) {
+                    finish_separately();
+                    return;
+                }
+
+                if (condition) {
+                    call(program_counter + 1, instr.flow_control.dest_offset - program_counter - 1,
+                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0,
+                         0);
+                } else {
+                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0,
+                         0);
+                }
+                break;
+
+            case OpCode::Id::LOOP: {
+                const auto& loop_param = uniforms.i[instr.flow_control.int_uniform_id];
+                batch.address_registers[2].fill(loop_param.y);
+
+                call(program_counter + 1, instr.flow_control.dest_offset - program_counter,
+                     instr.flow_control.dest_offset + 1, loop_param.x, loop_param.z);
+                break;
+            }
+
+            default:
+                // EMIT, SETEMIT and unknown instructions
+                finish_separately();
+                return;
+            }
+
+            break;
+        }
+        }
+
+        ++program_counter;
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+#ifdef _MSC_VER
+#define TARGET_AVX
+#else
+#define TARGET_AVX __attribute__((target("avx")))
+#endif
+
+// FMA is left out on purpose, fusing the multiplications and additions would change the results
+static TARGET_AVX void RunBatchAVX(const ShaderSetup& setup, UnitState* states,
+                                   std::size_t count) {
+    RunBatchImpl(setup, states, count);
+}
+#endif // ARCHITECTURE_x86_64
+
+static void RunBatchGeneric(const ShaderSetup& setup, UnitState* states, std::size_t count) {
+    RunBatchImpl(setup, states, count);
+}
+
 void InterpreterEngine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
     setup.engine_data.entry_point = entry_point;
@@ -681,6 +1339,32 @@ void InterpreterEngine::Run(const ShaderSetup& setup, UnitState& state) const {
     RunInterpreter(setup, state, dummy_debug_data, setup.engine_data.entry_point);
 }
 
+void InterpreterEngine::RunBatch(const ShaderSetup& setup, UnitState* states,
+                                 std::size_t count) const {
+    MICROPROFILE_SCOPE(GPU_Shader);
+
+#ifdef ARCHITECTURE_x86_64
+    const bool use_avx = Common::GetCPUCaps().avx;
+#endif // ARCHITECTURE_x86_64
+
+    for (std::size_t first = 0; first < count; first += BATCH_LANES) {
+        const std::size_t lanes = std::min(count - first, BATCH_LANES);
+        if (lanes == 1) {
+            DebugData<false> dummy_debug_data;
+            RunInterpreter(setup, states[first], dummy_debug_data, setup.engine_data.entry_point);
+            continue;
+        }
+
+#ifdef ARCHITECTURE_x86_64
+        if (use_avx) {
+            RunBatchAVX(setup, states + first, lanes);
+            continue;
+        }
+#endif // ARCHITECTURE_x86_64
+        RunBatchGeneric(setup, states + first, lanes);
+    }
+}
+
 DebugData<true> InterpreterEngine::ProduceDebugInfo(const ShaderSetup& setup,
                                                     const AttributeBuffer& input,
                                                     const ShaderRegs& config) const {
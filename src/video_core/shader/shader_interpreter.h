@@ -13,6 +13,7 @@ class InterpreterEngine final : public ShaderEngine {
 public:
     void SetupBatch(ShaderSetup& setup, unsigned int entry_point) override;
     void Run(const ShaderSetup& setup, UnitState& state) const override;
+    void RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count) const override;
 
     /**
      * Produce debug information based on the given shader and input vertex
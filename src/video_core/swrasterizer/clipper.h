@@ -4,16 +4,31 @@
 
 #pragma once
 
+#include <functional>
+
 namespace Pica {
 namespace Shader {
 struct OutputVertex;
 }
 
+namespace Rasterizer {
+struct Vertex;
+}
+
 namespace Clipper {
 
 using Shader::OutputVertex;
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2);
+using TriangleHandler = std::function<void(const Rasterizer::Vertex& v0,
+                                           const Rasterizer::Vertex& v1,
+                                           const Rasterizer::Vertex& v2)>;
+
+/**
+ * Clips the triangle against the view volume and passes the resulting triangles, transformed to
+ * screen coordinates, to the given handler.
+ */
+void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                     const TriangleHandler& triangle_handler);
 
 } // namespace Clipper
 } // namespace Pica
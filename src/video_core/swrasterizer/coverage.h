@@ -0,0 +1,228 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include "common/common_types.h"
+#include "common/vector_math.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+namespace Pica::Rasterizer {
+
+// NOTE: Assuming that rasterizer coordinates are 12.4 fixed-point values
+struct Fix12P4 {
+    Fix12P4() {}
+    Fix12P4(u16 val) : val(val) {}
+
+    static u16 FracMask() {
+        return 0xF;
+    }
+    static u16 IntMask() {
+        return (u16)~0xF;
+    }
+
+    operator u16() const {
+        return val;
+    }
+
+    bool operator<(const Fix12P4& oth) const {
+        return (u16) * this < (u16)oth;
+    }
+
+private:
+    u16 val;
+};
+
+/**
+ * Calculate signed area of the triangle spanned by the three argument vertices.
+ * The sign denotes an orientation.
+ *
+ * @todo define orientation concretely.
+ */
+inline int SignedArea(const Common::Vec2<Fix12P4>& vtx1, const Common::Vec2<Fix12P4>& vtx2,
+                      const Common::Vec2<Fix12P4>& vtx3) {
+    const auto vec1 = Common::MakeVec(vtx2 - vtx1, 0);
+    const auto vec2 = Common::MakeVec(vtx3 - vtx1, 0);
+    // TODO: There is a very small chance this will overflow for sizeof(int) == 4
+    return Common::Cross(vec1, vec2).z;
+}
+
+/**
+ * The signed area spanned by an edge and a pixel center, stepped incrementally across the pixels
+ * of a bounding box instead of being recomputed for each of them.
+ */
+struct EdgeFunction {
+    EdgeFunction(const Common::Vec2<Fix12P4>& vtx1, const Common::Vec2<Fix12P4>& vtx2, int bias,
+                 u16 origin_x, u16 origin_y)
+        : origin(bias + SignedArea(vtx1, vtx2, {origin_x, origin_y})),
+          step_x(((int)vtx1.y - (int)vtx2.y) * 16), step_y(((int)vtx2.x - (int)vtx1.x) * 16),
+          quad_offsets{0, step_x, step_y, step_x + step_y} {}
+
+    /// Value at the center of the pixel (x, y), relative to the origin pixel
+    int Evaluate(int x, int y) const {
+        return origin + x * step_x + y * step_y;
+    }
+
+    int origin;
+    int step_x;
+    int step_y;
+    /// Offsets of the pixels of a 2x2 quad from its top-left pixel
+    std::array<int, 4> quad_offsets;
+};
+
+/// Width and height, in pixels, of the blocks that are rejected as a whole
+constexpr int BLOCK_SIZE = 4;
+
+/**
+ * Whether the triangle misses the pixels of the block starting at (x, y). Since edge functions are
+ * linear, the block is outside of an edge if all four of its corners are.
+ */
+inline bool IsBlockOutside(const std::array<EdgeFunction, 3>& edges, int x, int y) {
+    for (const auto& edge : edges) {
+        const int top_left = edge.Evaluate(x, y);
+        const int right = (BLOCK_SIZE - 1) * edge.step_x;
+        const int bottom = (BLOCK_SIZE - 1) * edge.step_y;
+        if (top_left < 0 && top_left + right < 0 && top_left + bottom < 0 &&
+            top_left + right + bottom < 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Edge function values of the pixels of a 2x2 quad, in the order top-left, top-right,
+/// bottom-left and bottom-right
+using QuadWeights = std::array<std::array<int, 4>, 3>;
+
+/**
+ * Evaluates the edge functions for the 2x2 quad whose top-left pixel has the given values.
+ * @returns a mask with bit i set if the triangle covers pixel i of the quad
+ */
+inline unsigned EvaluateQuad(const std::array<EdgeFunction, 3>& edges,
+                             const std::array<int, 3>& origin, QuadWeights& weights) {
+#ifdef ARCHITECTURE_x86_64
+    __m128i outside = _mm_setzero_si128();
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        const __m128i offsets =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(edges[i].quad_offsets.data()));
+        const __m128i values = _mm_add_epi32(_mm_set1_epi32(origin[i]), offsets);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(weights[i].data()), values);
+        outside = _mm_or_si128(outside, values);
+    }
+    // A pixel is outside if any of its values is negative, i.e. has the sign bit set
+    return ~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF;
+#else
+    unsigned mask = 0xF;
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        for (unsigned pixel = 0; pixel < 4; ++pixel) {
+            weights[i][pixel] = origin[i] + edges[i].quad_offsets[pixel];
+            if (weights[i][pixel] < 0)
+                mask &= ~(1u << pixel);
+        }
+    }
+    return mask;
+#endif
+}
+
+/**
+ * Triangle filling rules: Pixels on the right-sided edge or on flat bottom edges are not drawn.
+ * Pixels on any other triangle border are drawn. This is implemented with a bias value which is
+ * added to the barycentric coordinate of the vertex opposite to each edge.
+ * NOTE: These are the PSP filling rules. Not sure if the 3DS uses the same ones...
+ * @returns the bias of the edge from line1 to line2, opposite to vtx
+ */
+inline int GetFillRuleBias(const Common::Vec2<Fix12P4>& vtx, const Common::Vec2<Fix12P4>& line1,
+                           const Common::Vec2<Fix12P4>& line2) {
+    bool is_right_side_or_flat_bottom;
+    if (line1.y == line2.y) {
+        // just check if vertex is above us => bottom line parallel to x-axis
+        is_right_side_or_flat_bottom = vtx.y < line1.y;
+    } else {
+        // check if vertex is on our left => right side
+        // TODO: Not sure how likely this is to overflow
+        is_right_side_or_flat_bottom =
+            (int)vtx.x < (int)line1.x + ((int)line2.x - (int)line1.x) *
+                                            ((int)vtx.y - (int)line1.y) /
+                                            ((int)line2.y - (int)line1.y);
+    }
+    return is_right_side_or_flat_bottom ? -1 : 0;
+}
+
+/**
+ * Visits the pixels of the bounding box [min_x, max_x) x [min_y, max_y) that the triangle covers.
+ * Blocks of the bounding box that the triangle misses are skipped as a whole, and the pixels of
+ * the others are tested for coverage in 2x2 quads.
+ * @param vtxpos Vertices of the triangle, wound counter-clockwise
+ * @param min_x,min_y,max_x,max_y Pixel aligned bounds, in 12.4 fixed point
+ * @param visit Called as visit(x, y, w0, w1, w2) with the 12.4 fixed point center of each covered
+ *              pixel and its barycentric coordinates, which include the fill rule bias
+ */
+template <typename Visitor>
+void WalkTriangle(const std::array<Common::Vec2<Fix12P4>, 3>& vtxpos, u16 min_x, u16 min_y,
+                  u16 max_x, u16 max_y, Visitor&& visit) {
+    const int bias0 = GetFillRuleBias(vtxpos[0], vtxpos[1], vtxpos[2]);
+    const int bias1 = GetFillRuleBias(vtxpos[1], vtxpos[2], vtxpos[0]);
+    const int bias2 = GetFillRuleBias(vtxpos[2], vtxpos[0], vtxpos[1]);
+
+    // Edge functions at the center of the top-left pixel of the bounding box. A pixel is covered
+    // when all of them are non-negative, in which case they are its barycentric coordinates.
+    const u16 origin_x = min_x + 8;
+    const u16 origin_y = min_y + 8;
+    const std::array<EdgeFunction, 3> edges{{
+        {vtxpos[1], vtxpos[2], bias0, origin_x, origin_y},
+        {vtxpos[2], vtxpos[0], bias1, origin_x, origin_y},
+        {vtxpos[0], vtxpos[1], bias2, origin_x, origin_y},
+    }};
+    const int width = (static_cast<int>(max_x) - min_x) / 16;
+    const int height = (static_cast<int>(max_y) - min_y) / 16;
+
+    for (int block_y = 0; block_y < height; block_y += BLOCK_SIZE) {
+        const int block_bottom = std::min(block_y + BLOCK_SIZE, height);
+        for (int block_x = 0; block_x < width; block_x += BLOCK_SIZE) {
+            const int block_right = std::min(block_x + BLOCK_SIZE, width);
+            if (IsBlockOutside(edges, block_x, block_y))
+                continue;
+
+            for (int quad_y = block_y; quad_y < block_bottom; quad_y += 2) {
+                std::array<int, 3> quad_origin;
+                for (std::size_t i = 0; i < edges.size(); ++i) {
+                    quad_origin[i] = edges[i].Evaluate(block_x, quad_y);
+                }
+
+                for (int quad_x = block_x; quad_x < block_right; quad_x += 2) {
+                    QuadWeights weights;
+                    unsigned mask = EvaluateQuad(edges, quad_origin, weights);
+                    for (std::size_t i = 0; i < edges.size(); ++i) {
+                        quad_origin[i] += 2 * edges[i].step_x;
+                    }
+
+                    // Drop the pixels past the right and bottom ends of the bounding box
+                    if (quad_x + 1 == block_right)
+                        mask &= 0b0101;
+                    if (quad_y + 1 == block_bottom)
+                        mask &= 0b0011;
+
+                    for (unsigned pixel = 0; pixel < 4; ++pixel) {
+                        if (!(mask & (1 << pixel)))
+                            continue;
+
+                        const int x = quad_x + (pixel & 1);
+                        const int y = quad_y + (pixel >> 1);
+                        visit(static_cast<u16>(origin_x + x * 16),
+                              static_cast<u16>(origin_y + y * 16), weights[0][pixel],
+                              weights[1][pixel], weights[2][pixel]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace Pica::Rasterizer
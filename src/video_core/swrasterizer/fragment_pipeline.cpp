@@ -0,0 +1,515 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <utility>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "video_core/swrasterizer/fragment_pipeline.h"
+#include "video_core/swrasterizer/framebuffer.h"
+#include "video_core/swrasterizer/texturing.h"
+
+namespace Pica::Rasterizer {
+
+using Source = TevStageConfig::Source;
+using ColorModifier = TevStageConfig::ColorModifier;
+using AlphaModifier = TevStageConfig::AlphaModifier;
+using Operation = TevStageConfig::Operation;
+using BlendFactor = FramebufferRegs::BlendFactor;
+using BlendEquation = FramebufferRegs::BlendEquation;
+using CompareFunc = FramebufferRegs::CompareFunc;
+
+FragmentConfig FragmentConfig::BuildFromRegs(const Regs& regs) {
+    FragmentConfig res;
+
+    auto& state = res.state;
+
+    const auto& tev_stages = regs.texturing.GetTevStages();
+    for (std::size_t i = 0; i < tev_stages.size(); i++) {
+        const auto& tev_stage = tev_stages[i];
+        state.tev_stages[i].sources_raw = tev_stage.sources_raw;
+        state.tev_stages[i].modifiers_raw = tev_stage.modifiers_raw;
+        state.tev_stages[i].ops_raw = tev_stage.ops_raw;
+        state.tev_stages[i].scales_raw = tev_stage.scales_raw;
+    }
+
+    state.combiner_buffer_input = regs.texturing.tev_combiner_buffer_input.update_mask_rgb.Value() |
+                                  regs.texturing.tev_combiner_buffer_input.update_mask_a.Value()
+                                      << 4;
+
+    const auto textures = regs.texturing.GetTextures();
+    for (std::size_t i = 0; i < state.texture_enable.size(); i++) {
+        state.texture_enable[i] = textures[i].enabled;
+    }
+    state.texture0_type = regs.texturing.texture0.type;
+    state.texture2_use_coord1 = regs.texturing.main_config.texture2_use_coord1 != 0;
+    state.proctex_enable = regs.texturing.main_config.texture3_enable != 0;
+    state.proctex_coord = regs.texturing.main_config.texture3_coordinates;
+    state.lighting_enable = !regs.lighting.disable;
+    state.fog_enable = regs.texturing.fog_mode == TexturingRegs::FogMode::Fog;
+    state.fog_flip = regs.texturing.fog_flip != 0;
+
+    const auto& output_merger = regs.framebuffer.output_merger;
+    const auto& framebuffer = regs.framebuffer.framebuffer;
+
+    state.shadow_rendering =
+        output_merger.fragment_operation_mode == FramebufferRegs::FragmentOperationMode::Shadow;
+    state.depth_format = framebuffer.depth_format;
+
+    state.alpha_test_func = output_merger.alpha_test.enable ? output_merger.alpha_test.func.Value()
+                                                            : CompareFunc::Always;
+
+    const auto& stencil_test = output_merger.stencil_test;
+    state.stencil_test_enable =
+        stencil_test.enable && framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
+    if (state.stencil_test_enable) {
+        state.stencil_test_func = stencil_test.func;
+        state.stencil_fail_action = stencil_test.action_stencil_fail;
+        state.depth_fail_action = stencil_test.action_depth_fail;
+        state.depth_pass_action = stencil_test.action_depth_pass;
+    }
+
+    state.depth_test_func = output_merger.depth_test_enable ? output_merger.depth_test_func.Value()
+                                                            : CompareFunc::Always;
+    state.depth_write_enable =
+        framebuffer.allow_depth_stencil_write != 0 && output_merger.depth_write_enable != 0;
+    state.stencil_write_enable = framebuffer.allow_depth_stencil_write != 0;
+
+    state.alphablend_enable = output_merger.alphablend_enable != 0;
+    if (state.alphablend_enable) {
+        const auto& params = output_merger.alpha_blending;
+        state.blend_equation_rgb = params.blend_equation_rgb;
+        state.blend_equation_a = params.blend_equation_a;
+        state.factor_source_rgb = params.factor_source_rgb;
+        state.factor_dest_rgb = params.factor_dest_rgb;
+        state.factor_source_a = params.factor_source_a;
+        state.factor_dest_a = params.factor_dest_a;
+    } else {
+        state.logic_op = output_merger.logic_op;
+    }
+
+    state.color_write_enable = framebuffer.allow_color_write != 0;
+    state.color_write_mask = {output_merger.red_enable != 0, output_merger.green_enable != 0,
+                              output_merger.blue_enable != 0, output_merger.alpha_enable != 0};
+
+    return res;
+}
+
+FragmentConstants FragmentConstants::BuildFromRegs(const Regs& regs) {
+    FragmentConstants constants;
+
+    const auto& tev_stages = regs.texturing.GetTevStages();
+    for (std::size_t i = 0; i < tev_stages.size(); i++) {
+        const auto& tev_stage = tev_stages[i];
+        constants.tev_const_colors[i] =
+            Common::MakeVec(tev_stage.const_r.Value(), tev_stage.const_g.Value(),
+                            tev_stage.const_b.Value(), tev_stage.const_a.Value())
+                .Cast<u8>();
+    }
+
+    const auto& buffer_color = regs.texturing.tev_combiner_buffer_color;
+    constants.tev_buffer_color = Common::MakeVec(buffer_color.r.Value(), buffer_color.g.Value(),
+                                                 buffer_color.b.Value(), buffer_color.a.Value())
+                                     .Cast<u8>();
+
+    const auto& fog_color = regs.texturing.fog_color;
+    constants.fog_color =
+        Common::MakeVec(fog_color.r.Value(), fog_color.g.Value(), fog_color.b.Value()).Cast<u8>();
+
+    const auto& output_merger = regs.framebuffer.output_merger;
+    const auto& blend_const = output_merger.blend_const;
+    constants.blend_const = Common::MakeVec(blend_const.r.Value(), blend_const.g.Value(),
+                                            blend_const.b.Value(), blend_const.a.Value())
+                                .Cast<u8>();
+
+    constants.alpha_test_ref = static_cast<u8>(output_merger.alpha_test.ref);
+    constants.stencil_ref = static_cast<u8>(output_merger.stencil_test.reference_value);
+    constants.stencil_input_mask = static_cast<u8>(output_merger.stencil_test.input_mask);
+    constants.stencil_write_mask = static_cast<u8>(output_merger.stencil_test.write_mask);
+
+    return constants;
+}
+
+namespace {
+
+template <ColorModifier modifier>
+Common::Vec3<u8> ModifyColor(const Common::Vec4<u8>& values) {
+    return GetColorModifier(modifier, values);
+}
+
+template <AlphaModifier modifier>
+u8 ModifyAlpha(const Common::Vec4<u8>& values) {
+    return GetAlphaModifier(modifier, values);
+}
+
+template <Operation op>
+Common::Vec3<u8> CombineColor(const Common::Vec3<u8> input[3]) {
+    return ColorCombine(op, input);
+}
+
+template <Operation op>
+u8 CombineAlpha(const std::array<u8, 3>& input) {
+    return AlphaCombine(op, input);
+}
+
+template <std::size_t... values>
+constexpr auto MakeColorModifierTable(std::index_sequence<values...>) {
+    return std::array<FragmentPipeline::ColorModifierFunc, sizeof...(values)>{
+        &ModifyColor<static_cast<ColorModifier>(values)>...};
+}
+
+template <std::size_t... values>
+constexpr auto MakeAlphaModifierTable(std::index_sequence<values...>) {
+    return std::array<FragmentPipeline::AlphaModifierFunc, sizeof...(values)>{
+        &ModifyAlpha<static_cast<AlphaModifier>(values)>...};
+}
+
+template <std::size_t... values>
+constexpr auto MakeColorCombineTable(std::index_sequence<values...>) {
+    return std::array<FragmentPipeline::ColorCombineFunc, sizeof...(values)>{
+        &CombineColor<static_cast<Operation>(values)>...};
+}
+
+template <std::size_t... values>
+constexpr auto MakeAlphaCombineTable(std::index_sequence<values...>) {
+    return std::array<FragmentPipeline::AlphaCombineFunc, sizeof...(values)>{
+        &CombineAlpha<static_cast<Operation>(values)>...};
+}
+
+// The tables cover every value the register fields can hold, so invalid ones reach the error
+// handling of the generic functions.
+constexpr auto color_modifiers = MakeColorModifierTable(std::make_index_sequence<16>{});
+constexpr auto alpha_modifiers = MakeAlphaModifierTable(std::make_index_sequence<8>{});
+constexpr auto color_combiners = MakeColorCombineTable(std::make_index_sequence<16>{});
+constexpr auto alpha_combiners = MakeAlphaCombineTable(std::make_index_sequence<16>{});
+
+template <CompareFunc func>
+bool Compare(u32 lhs, u32 rhs) {
+    if constexpr (func == CompareFunc::Never) {
+        return false;
+    } else if constexpr (func == CompareFunc::Always) {
+        return true;
+    } else if constexpr (func == CompareFunc::Equal) {
+        return lhs == rhs;
+    } else if constexpr (func == CompareFunc::NotEqual) {
+        return lhs != rhs;
+    } else if constexpr (func == CompareFunc::LessThan) {
+        return lhs < rhs;
+    } else if constexpr (func == CompareFunc::LessThanOrEqual) {
+        return lhs <= rhs;
+    } else if constexpr (func == CompareFunc::GreaterThan) {
+        return lhs > rhs;
+    } else {
+        return lhs >= rhs;
+    }
+}
+
+template <std::size_t... values>
+constexpr auto MakeCompareTable(std::index_sequence<values...>) {
+    return std::array<FragmentPipeline::TestFunc, sizeof...(values)>{
+        &Compare<static_cast<CompareFunc>(values)>...};
+}
+
+constexpr auto compare_funcs = MakeCompareTable(std::make_index_sequence<8>{});
+
+/// Returns the test for the given comparison, or null if it always passes
+FragmentPipeline::TestFunc SelectTest(CompareFunc func) {
+    if (func == CompareFunc::Always) {
+        return nullptr;
+    }
+    return compare_funcs[static_cast<std::size_t>(func)];
+}
+
+u8 LookupBlendFactor(BlendFactor factor, unsigned channel, const Common::Vec4<u8>& src,
+                     const Common::Vec4<u8>& dest, const Common::Vec4<u8>& blend_const) {
+    DEBUG_ASSERT(channel < 4);
+
+    switch (factor) {
+    case BlendFactor::Zero:
+        return 0;
+
+    case BlendFactor::One:
+        return 255;
+
+    case BlendFactor::SourceColor:
+        return src[channel];
+
+    case BlendFactor::OneMinusSourceColor:
+        return 255 - src[channel];
+
+    case BlendFactor::DestColor:
+        return dest[channel];
+
+    case BlendFactor::OneMinusDestColor:
+        return 255 - dest[channel];
+
+    case BlendFactor::SourceAlpha:
+        return src.a();
+
+    case BlendFactor::OneMinusSourceAlpha:
+        return 255 - src.a();
+
+    case BlendFactor::DestAlpha:
+        return dest.a();
+
+    case BlendFactor::OneMinusDestAlpha:
+        return 255 - dest.a();
+
+    case BlendFactor::ConstantColor:
+        return blend_const[channel];
+
+    case BlendFactor::OneMinusConstantColor:
+        return 255 - blend_const[channel];
+
+    case BlendFactor::ConstantAlpha:
+        return blend_const.a();
+
+    case BlendFactor::OneMinusConstantAlpha:
+        return 255 - blend_const.a();
+
+    case BlendFactor::SourceAlphaSaturate:
+        // Returns 1.0 for the alpha channel
+        if (channel == 3)
+            return 255;
+        return std::min(src.a(), static_cast<u8>(255 - dest.a()));
+
+    default:
+        LOG_CRITICAL(HW_GPU, "Unknown blend factor {:x}", static_cast<u32>(factor));
+        UNIMPLEMENTED();
+        break;
+    }
+
+    return src[channel];
+}
+
+Common::Vec4<u8> BlendGeneric(const FragmentConfigState& config, const Common::Vec4<u8>& src,
+                              const Common::Vec4<u8>& dest, const FragmentConstants& constants) {
+    const auto factor = [&](unsigned channel, BlendFactor factor) {
+        return LookupBlendFactor(factor, channel, src, dest, constants.blend_const);
+    };
+
+    const auto srcfactor =
+        Common::MakeVec(factor(0, config.factor_source_rgb), factor(1, config.factor_source_rgb),
+                        factor(2, config.factor_source_rgb), factor(3, config.factor_source_a));
+    const auto dstfactor =
+        Common::MakeVec(factor(0, config.factor_dest_rgb), factor(1, config.factor_dest_rgb),
+                        factor(2, config.factor_dest_rgb), factor(3, config.factor_dest_a));
+
+    auto output = EvaluateBlendEquation(src, srcfactor, dest, dstfactor, config.blend_equation_rgb);
+    output.a() =
+        EvaluateBlendEquation(src, srcfactor, dest, dstfactor, config.blend_equation_a).a();
+    return output;
+}
+
+/// Additive blending with the same factors for the color and alpha channels
+template <BlendFactor src_factor, BlendFactor dest_factor>
+Common::Vec4<u8> BlendAdd(const FragmentConfigState& config, const Common::Vec4<u8>& src,
+                          const Common::Vec4<u8>& dest, const FragmentConstants& constants) {
+    Common::Vec4<u8> output;
+    for (unsigned channel = 0; channel < 4; ++channel) {
+        const u8 srcfactor =
+            LookupBlendFactor(src_factor, channel, src, dest, constants.blend_const);
+        const u8 dstfactor =
+            LookupBlendFactor(dest_factor, channel, src, dest, constants.blend_const);
+        const int result = (src[channel] * srcfactor + dest[channel] * dstfactor) / 255;
+        output[channel] = static_cast<u8>(std::min(result, 255));
+    }
+    return output;
+}
+
+Common::Vec4<u8> ApplyLogicOp(const FragmentConfigState& config, const Common::Vec4<u8>& src,
+                              const Common::Vec4<u8>& dest, const FragmentConstants& constants) {
+    return Common::MakeVec(LogicOp(src.r(), dest.r(), config.logic_op),
+                           LogicOp(src.g(), dest.g(), config.logic_op),
+                           LogicOp(src.b(), dest.b(), config.logic_op),
+                           LogicOp(src.a(), dest.a(), config.logic_op));
+}
+
+Common::Vec4<u8> KeepSource(const FragmentConfigState& config, const Common::Vec4<u8>& src,
+                            const Common::Vec4<u8>& dest, const FragmentConstants& constants) {
+    return src;
+}
+
+FragmentPipeline::BlendFunc SelectBlend(const FragmentConfigState& config) {
+    if (!config.alphablend_enable) {
+        if (config.logic_op == FramebufferRegs::LogicOp::Copy) {
+            return &KeepSource;
+        }
+        return &ApplyLogicOp;
+    }
+
+    const bool same_factors = config.factor_source_rgb == config.factor_source_a &&
+                              config.factor_dest_rgb == config.factor_dest_a;
+    if (same_factors && config.blend_equation_rgb == BlendEquation::Add &&
+        config.blend_equation_a == BlendEquation::Add) {
+        const auto factors = std::make_pair(config.factor_source_rgb, config.factor_dest_rgb);
+        if (factors == std::make_pair(BlendFactor::One, BlendFactor::Zero)) {
+            return &KeepSource;
+        }
+        if (factors == std::make_pair(BlendFactor::SourceAlpha, BlendFactor::OneMinusSourceAlpha)) {
+            return &BlendAdd<BlendFactor::SourceAlpha, BlendFactor::OneMinusSourceAlpha>;
+        }
+        if (factors == std::make_pair(BlendFactor::One, BlendFactor::OneMinusSourceAlpha)) {
+            return &BlendAdd<BlendFactor::One, BlendFactor::OneMinusSourceAlpha>;
+        }
+        if (factors == std::make_pair(BlendFactor::SourceAlpha, BlendFactor::One)) {
+            return &BlendAdd<BlendFactor::SourceAlpha, BlendFactor::One>;
+        }
+        if (factors == std::make_pair(BlendFactor::One, BlendFactor::One)) {
+            return &BlendAdd<BlendFactor::One, BlendFactor::One>;
+        }
+    }
+    return &BlendGeneric;
+}
+
+/// Returns whether the stage outputs the result of the previous stage unchanged
+bool IsPassthroughStage(const TevStageConfig& stage) {
+    return stage.color_op == Operation::Replace && stage.color_source1 == Source::Previous &&
+           stage.color_modifier1 == ColorModifier::SourceColor &&
+           stage.alpha_op == Operation::Replace && stage.alpha_source1 == Source::Previous &&
+           stage.alpha_modifier1 == AlphaModifier::SourceAlpha &&
+           stage.GetColorMultiplier() == 1 && stage.GetAlphaMultiplier() == 1;
+}
+
+} // Anonymous namespace
+
+FragmentPipeline::FragmentPipeline(const FragmentConfig& config_) : config(config_.state) {
+    bool dropped_stage = false;
+    for (unsigned index = 0; index < config.tev_stages.size(); ++index) {
+        TevStageConfig stage;
+        stage.sources_raw = config.tev_stages[index].sources_raw;
+        stage.modifiers_raw = config.tev_stages[index].modifiers_raw;
+        stage.ops_raw = config.tev_stages[index].ops_raw;
+        stage.scales_raw = config.tev_stages[index].scales_raw;
+
+        const bool updates_buffer_color = config_.TevStageUpdatesCombinerBufferColor(index);
+        const bool updates_buffer_alpha = config_.TevStageUpdatesCombinerBufferAlpha(index);
+        if (IsPassthroughStage(stage) && !updates_buffer_color && !updates_buffer_alpha) {
+            dropped_stage = true;
+            continue;
+        }
+
+        const auto source = [](Source source) {
+            const auto value = static_cast<u8>(source);
+            if (value > static_cast<u8>(Source::Texture3) && source != Source::PreviousBuffer &&
+                source != Source::Constant && source != Source::Previous) {
+                LOG_ERROR(HW_GPU, "Unknown color combiner source {}", value);
+            }
+            return value;
+        };
+
+        TevStage& compiled = tev_stages[num_tev_stages++];
+        compiled.index = index;
+        compiled.color_sources = {source(stage.color_source1), source(stage.color_source2),
+                                  source(stage.color_source3)};
+        compiled.alpha_sources = {source(stage.alpha_source1), source(stage.alpha_source2),
+                                  source(stage.alpha_source3)};
+        compiled.color_modifiers = {
+            color_modifiers[static_cast<std::size_t>(stage.color_modifier1.Value())],
+            color_modifiers[static_cast<std::size_t>(stage.color_modifier2.Value())],
+            color_modifiers[static_cast<std::size_t>(stage.color_modifier3.Value())]};
+        compiled.alpha_modifiers = {
+            alpha_modifiers[static_cast<std::size_t>(stage.alpha_modifier1.Value())],
+            alpha_modifiers[static_cast<std::size_t>(stage.alpha_modifier2.Value())],
+            alpha_modifiers[static_cast<std::size_t>(stage.alpha_modifier3.Value())]};
+        compiled.color_combine = color_combiners[static_cast<std::size_t>(stage.color_op.Value())];
+        compiled.alpha_combine =
+            stage.color_op == Operation::Dot3_RGBA
+                ? nullptr
+                : alpha_combiners[static_cast<std::size_t>(stage.alpha_op.Value())];
+        compiled.color_multiplier = stage.GetColorMultiplier();
+        compiled.alpha_multiplier = stage.GetAlphaMultiplier();
+        compiled.updates_buffer_color = updates_buffer_color;
+        compiled.updates_buffer_alpha = updates_buffer_alpha;
+        compiled.follows_dropped_stage = dropped_stage;
+        dropped_stage = false;
+    }
+
+    alpha_test = SelectTest(config.alpha_test_func);
+    if (config.stencil_test_enable) {
+        stencil_test = compare_funcs[static_cast<std::size_t>(config.stencil_test_func)];
+    }
+    depth_test = SelectTest(config.depth_test_func);
+    early_fragment_tests = !config.shadow_rendering && !alpha_test;
+
+    blend = SelectBlend(config);
+    const bool writes_all_channels =
+        std::all_of(config.color_write_mask.begin(), config.color_write_mask.end(),
+                    [](bool enable) { return enable; });
+    reads_dest_color = blend != &KeepSource || !writes_all_channels;
+}
+
+Common::Vec4<u8> FragmentPipeline::CombineTev(TevSources& sources,
+                                              const FragmentConstants& constants) const {
+    auto& previous = sources[static_cast<std::size_t>(Source::Previous)];
+    auto& previous_buffer = sources[static_cast<std::size_t>(Source::PreviousBuffer)];
+    auto& constant = sources[static_cast<std::size_t>(Source::Constant)];
+
+    previous = {0, 0, 0, 0};
+    previous_buffer = {0, 0, 0, 0};
+    Common::Vec4<u8> next_buffer = constants.tev_buffer_color;
+
+    for (std::size_t i = 0; i < num_tev_stages; ++i) {
+        const TevStage& stage = tev_stages[i];
+
+        // Dropped stages don't update the buffer, so moving it along once stands in for all of
+        // them
+        if (stage.follows_dropped_stage) {
+            previous_buffer = next_buffer;
+        }
+        constant = constants.tev_const_colors[stage.index];
+
+        // NOTE: Not sure if the alpha combiner might use the color output of the previous stage
+        //       as input. Hence, the color result is kept in a temporary variable until alpha
+        //       combining has been done.
+        const Common::Vec3<u8> color_input[3] = {
+            stage.color_modifiers[0](sources[stage.color_sources[0]]),
+            stage.color_modifiers[1](sources[stage.color_sources[1]]),
+            stage.color_modifiers[2](sources[stage.color_sources[2]]),
+        };
+        const Common::Vec3<u8> color_output = stage.color_combine(color_input);
+
+        u8 alpha_output;
+        if (stage.alpha_combine) {
+            alpha_output = stage.alpha_combine({{
+                stage.alpha_modifiers[0](sources[stage.alpha_sources[0]]),
+                stage.alpha_modifiers[1](sources[stage.alpha_sources[1]]),
+                stage.alpha_modifiers[2](sources[stage.alpha_sources[2]]),
+            }});
+        } else {
+            // result of Dot3_RGBA operation is also placed to the alpha component
+            alpha_output = color_output.x;
+        }
+
+        previous[0] = std::min(255u, color_output.r() * stage.color_multiplier);
+        previous[1] = std::min(255u, color_output.g() * stage.color_multiplier);
+        previous[2] = std::min(255u, color_output.b() * stage.color_multiplier);
+        previous[3] = std::min(255u, alpha_output * stage.alpha_multiplier);
+
+        previous_buffer = next_buffer;
+
+        if (stage.updates_buffer_color) {
+            next_buffer.r() = previous.r();
+            next_buffer.g() = previous.g();
+            next_buffer.b() = previous.b();
+        }
+
+        if (stage.updates_buffer_alpha) {
+            next_buffer.a() = previous.a();
+        }
+    }
+
+    return previous;
+}
+
+const FragmentPipeline& FragmentPipelineCache::Get(const Regs& regs) {
+    const FragmentConfig config = FragmentConfig::BuildFromRegs(regs);
+    auto [it, inserted] = pipelines.try_emplace(config);
+    if (inserted) {
+        it->second = std::make_unique<FragmentPipeline>(config);
+    }
+    return *it->second;
+}
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,223 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include "common/common_types.h"
+#include "common/hash.h"
+#include "common/vector_math.h"
+#include "video_core/regs.h"
+
+namespace Pica::Rasterizer {
+
+/**
+ * The part of the Pica register configuration that decides which operations the software
+ * rasterizer performs on each fragment. As with the OpenGL backend's PicaFSConfig, constant colors
+ * and reference values are left out, since they change far more often than the operations.
+ */
+struct FragmentConfigState {
+    struct TevStage {
+        u32 sources_raw;
+        u32 modifiers_raw;
+        u32 ops_raw;
+        u32 scales_raw;
+    };
+
+    std::array<TevStage, 6> tev_stages;
+    u32 combiner_buffer_input;
+
+    std::array<bool, 3> texture_enable;
+    TexturingRegs::TextureConfig::TextureType texture0_type;
+    bool texture2_use_coord1;
+    bool proctex_enable;
+    u32 proctex_coord;
+    bool lighting_enable;
+    bool fog_enable;
+    bool fog_flip;
+
+    bool shadow_rendering;
+    FramebufferRegs::DepthFormat depth_format;
+    /// Always when alpha testing is disabled
+    FramebufferRegs::CompareFunc alpha_test_func;
+    /// Whether stencil testing is enabled and the depth buffer has a stencil component
+    bool stencil_test_enable;
+    FramebufferRegs::CompareFunc stencil_test_func;
+    FramebufferRegs::StencilAction stencil_fail_action;
+    FramebufferRegs::StencilAction depth_fail_action;
+    FramebufferRegs::StencilAction depth_pass_action;
+    /// Always when depth testing is disabled
+    FramebufferRegs::CompareFunc depth_test_func;
+    bool depth_write_enable;
+    bool stencil_write_enable;
+
+    bool alphablend_enable;
+    FramebufferRegs::BlendEquation blend_equation_rgb;
+    FramebufferRegs::BlendEquation blend_equation_a;
+    FramebufferRegs::BlendFactor factor_source_rgb;
+    FramebufferRegs::BlendFactor factor_dest_rgb;
+    FramebufferRegs::BlendFactor factor_source_a;
+    FramebufferRegs::BlendFactor factor_dest_a;
+    FramebufferRegs::LogicOp logic_op;
+    bool color_write_enable;
+    std::array<bool, 4> color_write_mask;
+};
+
+struct FragmentConfig : Common::HashableStruct<FragmentConfigState> {
+    /// Construct a FragmentConfig with the given Pica register configuration.
+    static FragmentConfig BuildFromRegs(const Regs& regs);
+
+    bool TevStageUpdatesCombinerBufferColor(unsigned stage_index) const {
+        return (stage_index < 4) && (state.combiner_buffer_input & (1 << stage_index));
+    }
+
+    bool TevStageUpdatesCombinerBufferAlpha(unsigned stage_index) const {
+        return (stage_index < 4) && ((state.combiner_buffer_input >> 4) & (1 << stage_index));
+    }
+};
+
+/// The values that the operations of a fragment pipeline are parameterized with
+struct FragmentConstants {
+    std::array<Common::Vec4<u8>, 6> tev_const_colors;
+    Common::Vec4<u8> tev_buffer_color;
+    Common::Vec3<u8> fog_color;
+    Common::Vec4<u8> blend_const;
+    u8 alpha_test_ref;
+    u8 stencil_ref;
+    u8 stencil_input_mask;
+    u8 stencil_write_mask;
+
+    static FragmentConstants BuildFromRegs(const Regs& regs);
+};
+
+/**
+ * The per-fragment operations of one configuration, resolved up front: texture environment
+ * sources are turned into table indices, stages that pass their input through unchanged are
+ * dropped, and the combiners, tests and blending are bound to routines specialized for their
+ * operation, so that the rasterizer loop does not branch on the registers for every pixel.
+ */
+class FragmentPipeline {
+public:
+    /// Texture environment inputs, indexed by TevStageConfig::Source
+    using TevSources = std::array<Common::Vec4<u8>, 16>;
+
+    using ColorModifierFunc = Common::Vec3<u8> (*)(const Common::Vec4<u8>& values);
+    using AlphaModifierFunc = u8 (*)(const Common::Vec4<u8>& values);
+    using ColorCombineFunc = Common::Vec3<u8> (*)(const Common::Vec3<u8> input[3]);
+    using AlphaCombineFunc = u8 (*)(const std::array<u8, 3>& input);
+    using TestFunc = bool (*)(u32 lhs, u32 rhs);
+    using BlendFunc = Common::Vec4<u8> (*)(const FragmentConfigState& config,
+                                           const Common::Vec4<u8>& src,
+                                           const Common::Vec4<u8>& dest,
+                                           const FragmentConstants& constants);
+
+    explicit FragmentPipeline(const FragmentConfig& config);
+
+    const FragmentConfigState& GetConfig() const {
+        return config;
+    }
+
+    /**
+     * Runs the texture environment stages.
+     * @param sources The primary color, fragment lighting and texture inputs. The remaining
+     *                entries are overwritten while combining.
+     * @returns the color output of the last stage
+     */
+    Common::Vec4<u8> CombineTev(TevSources& sources, const FragmentConstants& constants) const;
+
+    bool PassesAlphaTest(u8 alpha, const FragmentConstants& constants) const {
+        return !alpha_test || alpha_test(alpha, constants.alpha_test_ref);
+    }
+
+    /// Only valid if stencil testing is enabled
+    bool PassesStencilTest(u8 ref, u8 dest) const {
+        return stencil_test(ref, dest);
+    }
+
+    bool HasDepthTest() const {
+        return depth_test != nullptr;
+    }
+
+    bool PassesDepthTest(u32 z, u32 ref_z) const {
+        return !depth_test || depth_test(z, ref_z);
+    }
+
+    /**
+     * Whether the stencil and depth tests may run before the fragment is shaded, since nothing
+     * before them in the pipeline can discard it
+     */
+    bool HasEarlyFragmentTests() const {
+        return early_fragment_tests;
+    }
+
+    /// Whether the framebuffer color is needed to compute the color written to it
+    bool ReadsDestColor() const {
+        return reads_dest_color;
+    }
+
+    /// Applies alpha blending or the logic operation
+    Common::Vec4<u8> Blend(const Common::Vec4<u8>& src, const Common::Vec4<u8>& dest,
+                           const FragmentConstants& constants) const {
+        return blend(config, src, dest, constants);
+    }
+
+private:
+    struct TevStage {
+        unsigned index;
+        std::array<u8, 3> color_sources;
+        std::array<u8, 3> alpha_sources;
+        std::array<ColorModifierFunc, 3> color_modifiers;
+        std::array<AlphaModifierFunc, 3> alpha_modifiers;
+        ColorCombineFunc color_combine;
+        /// Null for Dot3_RGBA, whose alpha is the color result
+        AlphaCombineFunc alpha_combine;
+        unsigned color_multiplier;
+        unsigned alpha_multiplier;
+        bool updates_buffer_color;
+        bool updates_buffer_alpha;
+        /// Whether dropped stages ran since the previous stage, which still have to move the
+        /// combiner buffer along
+        bool follows_dropped_stage;
+    };
+
+    FragmentConfigState config;
+
+    std::array<TevStage, 6> tev_stages;
+    std::size_t num_tev_stages = 0;
+
+    TestFunc alpha_test = nullptr;
+    TestFunc stencil_test = nullptr;
+    TestFunc depth_test = nullptr;
+    BlendFunc blend = nullptr;
+    bool reads_dest_color = true;
+    bool early_fragment_tests = false;
+};
+
+} // namespace Pica::Rasterizer
+
+namespace std {
+template <>
+struct hash<Pica::Rasterizer::FragmentConfig> {
+    std::size_t operator()(const Pica::Rasterizer::FragmentConfig& k) const {
+        return k.Hash();
+    }
+};
+} // namespace std
+
+namespace Pica::Rasterizer {
+
+/// Pipelines built for the configurations seen so far, looked up by their configuration
+class FragmentPipelineCache {
+public:
+    /// Returns the pipeline for the given registers, building it on first use
+    const FragmentPipeline& Get(const Regs& regs);
+
+private:
+    std::unordered_map<FragmentConfig, std::unique_ptr<FragmentPipeline>> pipelines;
+};
+
+} // namespace Pica::Rasterizer
@@ -4,10 +4,14 @@
 
 #pragma once
 
+#include "common/math_util.h"
 #include "video_core/shader/shader.h"
 
 namespace Pica::Rasterizer {
 
+class FragmentPipeline;
+struct TextureUnits;
+
 struct Vertex : Shader::OutputVertex {
     Vertex(const OutputVertex& v) : OutputVertex(v) {}
 
@@ -39,6 +43,30 @@ struct Vertex : Shader::OutputVertex {
     }
 };
 
-void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+/**
+ * Rasterizes the triangle.
+ * @param pipeline Fragment pipeline built for the current register configuration
+ * @param texture_units Decoded textures bound to the texture units
+ */
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     const FragmentPipeline& pipeline, const TextureUnits& texture_units);
+
+/**
+ * Rasterizes only the pixels of the triangle that lie inside the given framebuffer region.
+ * Rasterizing a triangle over a set of disjoint regions produces exactly the same output as
+ * rasterizing it in one go.
+ * @param region Pixel rectangle spanning [left, right) x [top, bottom)
+ * @param pipeline Fragment pipeline built for the current register configuration
+ * @param texture_units Decoded textures bound to the texture units
+ */
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     const Common::Rectangle<u16>& region, const FragmentPipeline& pipeline,
+                     const TextureUnits& texture_units);
+
+/**
+ * Returns the pixel rectangle that may be touched when rasterizing the triangle, in the same
+ * [left, right) x [top, bottom) form as used by ProcessTriangle.
+ */
+Common::Rectangle<u16> GetBoundingBox(const Vertex& v0, const Vertex& v1, const Vertex& v2);
 
 } // namespace Pica::Rasterizer
@@ -2,15 +2,183 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "common/math_util.h"
+#include "common/microprofile.h"
+#include "common/thread_worker.h"
+#include "video_core/pica_state.h"
 #include "video_core/swrasterizer/clipper.h"
 #include "video_core/swrasterizer/swrasterizer.h"
 
 namespace VideoCore {
 
+/// Width and height of the screen tiles that triangles are binned into, in pixels. This is a
+/// multiple of the 8x8 pixel framebuffer tiling, so no two screen tiles share framebuffer bytes.
+constexpr u16 TILE_SIZE = 32;
+/// Upper bound on the number of rasterizer threads, as the 3DS framebuffers are fairly small
+constexpr unsigned MAX_WORKERS = 8;
+
+MICROPROFILE_DEFINE(GPU_TileBinning, "GPU", "Tile Binning", MP_RGB(50, 100, 240));
+
+SWRasterizer::SWRasterizer() {
+    const unsigned num_workers = std::min(std::thread::hardware_concurrency(), MAX_WORKERS);
+    if (num_workers > 1) {
+        workers = std::make_unique<Common::ThreadWorker>(num_workers, "SWRasterizer");
+    }
+}
+
+SWRasterizer::~SWRasterizer() = default;
+
 void SWRasterizer::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                const Pica::Shader::OutputVertex& v1,
                                const Pica::Shader::OutputVertex& v2) {
-    Pica::Clipper::ProcessTriangle(v0, v1, v2);
+    if (!workers) {
+        const auto& pipeline = GetFragmentPipeline();
+        const auto& textures = GetTextureUnits();
+        Pica::Clipper::ProcessTriangle(
+            v0, v1, v2, [&pipeline, &textures](const auto& vtx0, const auto& vtx1,
+                                               const auto& vtx2) {
+                Pica::Rasterizer::ProcessTriangle(vtx0, vtx1, vtx2, pipeline, textures);
+            });
+        return;
+    }
+
+    // The rasterizer registers can't change before the draw ends with a call to DrawTriangles,
+    // so rasterization of the clipped triangles can be deferred until then.
+    Pica::Clipper::ProcessTriangle(v0, v1, v2, [this](const auto& vtx0, const auto& vtx1,
+                                                      const auto& vtx2) {
+        triangles.push_back({vtx0, vtx1, vtx2});
+    });
+}
+
+void SWRasterizer::DrawTriangles() {
+    FlushTriangles();
+    InvalidateFramebuffers();
+    // Registers can also change without notification between draws, e.g. by loading a state
+    fragment_pipeline = nullptr;
+    texture_units_dirty = true;
+}
+
+void SWRasterizer::NotifyPicaRegisterChanged(u32 id) {
+    fragment_pipeline = nullptr;
+    texture_units_dirty = true;
+}
+
+void SWRasterizer::FlushAll() {
+    FlushTriangles();
+}
+
+void SWRasterizer::FlushRegion(PAddr addr, u32 size) {
+    FlushTriangles();
+}
+
+void SWRasterizer::InvalidateRegion(PAddr addr, u32 size) {
+    texture_cache.InvalidateRegion(addr, size);
+    texture_units_dirty = true;
+}
+
+void SWRasterizer::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    FlushTriangles();
+    InvalidateRegion(addr, size);
+}
+
+void SWRasterizer::FlushTriangles() {
+    if (triangles.empty()) {
+        return;
+    }
+
+    const auto& pipeline = GetFragmentPipeline();
+    const auto& textures = GetTextureUnits();
+
+    std::vector<Common::Rectangle<u16>> bounds(triangles.size());
+    u16 max_right = 0;
+    u16 max_bottom = 0;
+    {
+        MICROPROFILE_SCOPE(GPU_TileBinning);
+        for (std::size_t i = 0; i < triangles.size(); ++i) {
+            const Triangle& triangle = triangles[i];
+            bounds[i] = Pica::Rasterizer::GetBoundingBox(triangle[0], triangle[1], triangle[2]);
+            max_right = std::max(max_right, bounds[i].right);
+            max_bottom = std::max(max_bottom, bounds[i].bottom);
+        }
+    }
+
+    const u32 tiles_x = (max_right + TILE_SIZE - 1) / TILE_SIZE;
+    const u32 tiles_y = (max_bottom + TILE_SIZE - 1) / TILE_SIZE;
+    const u32 num_tiles = tiles_x * tiles_y;
+
+    {
+        MICROPROFILE_SCOPE(GPU_TileBinning);
+        if (tile_bins.size() < num_tiles) {
+            tile_bins.resize(num_tiles);
+        }
+        for (u32 i = 0; i < triangles.size(); ++i) {
+            const auto& rect = bounds[i];
+            if (rect.left >= rect.right || rect.top >= rect.bottom) {
+                continue;
+            }
+            for (u32 tile_y = rect.top / TILE_SIZE; tile_y * TILE_SIZE < rect.bottom; ++tile_y) {
+                for (u32 tile_x = rect.left / TILE_SIZE; tile_x * TILE_SIZE < rect.right;
+                     ++tile_x) {
+                    tile_bins[tile_y * tiles_x + tile_x].push_back(i);
+                }
+            }
+        }
+    }
+
+    // Every tile rasterizes its triangles in submission order, which keeps depth/stencil testing
+    // and blending results identical to rasterizing the triangles one after another.
+    std::atomic<u32> next_tile{0};
+    const auto process_tiles = [&] {
+        for (u32 tile = next_tile++; tile < num_tiles; tile = next_tile++) {
+            auto& bin = tile_bins[tile];
+            const u16 left = static_cast<u16>((tile % tiles_x) * TILE_SIZE);
+            const u16 top = static_cast<u16>((tile / tiles_x) * TILE_SIZE);
+            const Common::Rectangle<u16> region{left, top, static_cast<u16>(left + TILE_SIZE),
+                                                static_cast<u16>(top + TILE_SIZE)};
+            for (u32 index : bin) {
+                const Triangle& triangle = triangles[index];
+                Pica::Rasterizer::ProcessTriangle(triangle[0], triangle[1], triangle[2], region,
+                                                  pipeline, textures);
+            }
+            bin.clear();
+        }
+    };
+
+    for (std::size_t i = 0; i < workers->NumWorkers(); ++i) {
+        workers->QueueWork(process_tiles);
+    }
+    workers->WaitForRequests();
+
+    triangles.clear();
+}
+
+const Pica::Rasterizer::FragmentPipeline& SWRasterizer::GetFragmentPipeline() {
+    if (!fragment_pipeline) {
+        fragment_pipeline = &fragment_pipelines.Get(Pica::g_state.regs);
+    }
+    return *fragment_pipeline;
+}
+
+const Pica::Rasterizer::TextureUnits& SWRasterizer::GetTextureUnits() {
+    if (texture_units_dirty) {
+        texture_units = texture_cache.GetTextures(Pica::g_state.regs);
+        texture_units_dirty = false;
+    }
+    return texture_units;
+}
+
+void SWRasterizer::InvalidateFramebuffers() {
+    const auto& framebuffer = Pica::g_state.regs.framebuffer.framebuffer;
+    const u32 num_pixels = framebuffer.GetWidth() * framebuffer.GetHeight();
+    texture_cache.InvalidateRegion(framebuffer.GetColorBufferPhysicalAddress(),
+                                   num_pixels * Pica::FramebufferRegs::BytesPerColorPixel(
+                                                    framebuffer.color_format));
+    texture_cache.InvalidateRegion(framebuffer.GetDepthBufferPhysicalAddress(),
+                                   num_pixels * Pica::FramebufferRegs::BytesPerDepthPixel(
+                                                    framebuffer.depth_format));
 }
 
 } // namespace VideoCore
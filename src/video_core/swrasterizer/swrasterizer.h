@@ -4,8 +4,18 @@
 
 #pragma once
 
+#include <array>
+#include <memory>
+#include <vector>
 #include "common/common_types.h"
 #include "video_core/rasterizer_interface.h"
+#include "video_core/swrasterizer/fragment_pipeline.h"
+#include "video_core/swrasterizer/rasterizer.h"
+#include "video_core/swrasterizer/texture_cache.h"
+
+namespace Common {
+class ThreadWorker;
+}
 
 namespace Pica::Shader {
 struct OutputVertex;
@@ -14,14 +24,51 @@ struct OutputVertex;
 namespace VideoCore {
 
 class SWRasterizer : public RasterizerInterface {
+public:
+    SWRasterizer();
+    ~SWRasterizer() override;
+
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
-    void DrawTriangles() override {}
-    void NotifyPicaRegisterChanged(u32 id) override {}
-    void FlushAll() override {}
-    void FlushRegion(PAddr addr, u32 size) override {}
-    void InvalidateRegion(PAddr addr, u32 size) override {}
-    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
+    void DrawTriangles() override;
+    void NotifyPicaRegisterChanged(u32 id) override;
+    void FlushAll() override;
+    void FlushRegion(PAddr addr, u32 size) override;
+    void InvalidateRegion(PAddr addr, u32 size) override;
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override;
+
+private:
+    using Triangle = std::array<Pica::Rasterizer::Vertex, 3>;
+
+    /// Rasterizes all queued triangles, binned into screen tiles that are shaded in parallel
+    void FlushTriangles();
+
+    /// Returns the fragment pipeline for the current register configuration
+    const Pica::Rasterizer::FragmentPipeline& GetFragmentPipeline();
+
+    /// Returns the decoded textures for the current register configuration
+    const Pica::Rasterizer::TextureUnits& GetTextureUnits();
+
+    /// Invalidates the textures in the buffers the last draw rendered to, which are written
+    /// without going through the memory system
+    void InvalidateFramebuffers();
+
+    /// Triangles of the current draw, in submission order
+    std::vector<Triangle> triangles;
+    /// Indices into triangles for each screen tile, in submission order
+    std::vector<std::vector<u32>> tile_bins;
+
+    Pica::Rasterizer::FragmentPipelineCache fragment_pipelines;
+    /// Pipeline of the current register configuration, null once the registers changed
+    const Pica::Rasterizer::FragmentPipeline* fragment_pipeline = nullptr;
+
+    Pica::Rasterizer::TextureCache texture_cache;
+    Pica::Rasterizer::TextureUnits texture_units;
+    /// Whether texture_units has to be looked up again
+    bool texture_units_dirty = true;
+
+    /// Not created on single core hosts, in which case triangles are rasterized immediately
+    std::unique_ptr<Common::ThreadWorker> workers;
 };
 
 } // namespace VideoCore
@@ -0,0 +1,196 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/microprofile.h"
+#include "core/memory.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/texture/texture_decode.h"
+#include "video_core/video_core.h"
+
+namespace Pica::Rasterizer {
+
+/// Size of the decoded texels the cache may hold before it drops the least recently used ones
+constexpr std::size_t MAX_CACHED_SIZE = 64 * 1024 * 1024;
+
+MICROPROFILE_DEFINE(GPU_TextureDecode, "GPU", "Texture Decode", MP_RGB(200, 100, 50));
+
+/// Returns the number of bytes spanned by the tiles of the texture
+static u32 CalculateSourceSize(const Texture::TextureInfo& info) {
+    const u32 tiles_x = (info.width + 7) / 8;
+    const u32 tiles_y = (info.height + 7) / 8;
+    return static_cast<u32>((tiles_y - 1) * info.stride +
+                            tiles_x * Texture::CalculateTileSize(info.format));
+}
+
+static void DecodeTexture(const u8* source, const Texture::TextureInfo& info,
+                          DecodedTexture& texture) {
+    MICROPROFILE_SCOPE(GPU_TextureDecode);
+
+    texture.width = info.width;
+    texture.height = info.height;
+    texture.texels.resize(info.width * info.height);
+    Texture::DecodeTexture(source, info, texture.texels.front().AsArray(),
+                           info.width * sizeof(Common::Vec4<u8>));
+}
+
+TextureCache::TextureCache() = default;
+
+TextureCache::~TextureCache() {
+    for (const auto& [key, entry] : entries) {
+        UpdatePagesCachedCount(entry.addr, entry.size, -1);
+    }
+}
+
+TextureUnits TextureCache::GetTextures(const Regs& regs) {
+    // Writes to cached pages are only recorded until now
+    for (PAddr page : VideoCore::g_memory->RasterizerTakeWrittenPages()) {
+        InvalidateRegion(page, Memory::PAGE_SIZE);
+    }
+    EvictTextures();
+    ++use_counter;
+
+    TextureUnits units;
+    const auto textures = regs.texturing.GetTextures();
+    for (std::size_t i = 0; i < textures.size(); ++i) {
+        const auto& texture = textures[i];
+        if (!texture.enabled) {
+            continue;
+        }
+
+        // Only unit 0 respects the texturing type
+        const auto type = i == 0 ? regs.texturing.texture0.type.Value()
+                                 : TexturingRegs::TextureConfig::Texture2D;
+        if (type == TexturingRegs::TextureConfig::Disabled) {
+            continue;
+        }
+
+        auto info = Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
+        if (type == TexturingRegs::TextureConfig::TextureCube ||
+            type == TexturingRegs::TextureConfig::ShadowCube) {
+            for (std::size_t face = 0; face < units.cube_faces.size(); ++face) {
+                info.physical_address = regs.texturing.GetCubePhysicalAddress(
+                    static_cast<TexturingRegs::CubeFace>(face));
+                units.cube_faces[face] = Get(info);
+            }
+        } else {
+            units.textures[i] = Get(info);
+        }
+    }
+    return units;
+}
+
+void TextureCache::InvalidateRegion(PAddr addr, u32 size) {
+    for (auto& [key, entry] : entries) {
+        if (addr < entry.addr + entry.size && entry.addr < addr + size) {
+            entry.dirty = true;
+        }
+    }
+}
+
+const DecodedTexture* TextureCache::Get(const Texture::TextureInfo& info) {
+    if (info.width == 0 || info.height == 0) {
+        return nullptr;
+    }
+
+    TextureCacheKey key;
+    key.state.address = info.physical_address;
+    key.state.format = info.format;
+    key.state.width = info.width;
+    key.state.height = info.height;
+
+    auto [it, inserted] = entries.try_emplace(key);
+    Entry& entry = it->second;
+    if (inserted) {
+        entry.addr = info.physical_address;
+        entry.size = CalculateSourceSize(info);
+        UpdatePagesCachedCount(entry.addr, entry.size, 1);
+    }
+    entry.last_use = use_counter;
+
+    if (entry.dirty) {
+        auto& memory = *VideoCore::g_memory;
+        const u8* source = memory.GetPhysicalPointer(entry.addr);
+        if (!source || !memory.IsValidPhysicalAddress(entry.addr + entry.size - 1)) {
+            LOG_ERROR(HW_GPU, "Texture at {:08X} is not in accessible memory", entry.addr);
+            return nullptr;
+        }
+
+        // Textures are often invalidated by writes that leave their data as it was, e.g. to a
+        // different part of the same page
+        const u64 hash = Common::ComputeHash64(source, entry.size);
+        if (inserted || hash != entry.hash) {
+            if (!inserted) {
+                cached_size -= entry.texture.texels.size() * sizeof(Common::Vec4<u8>);
+            }
+            DecodeTexture(source, info, entry.texture);
+            cached_size += entry.texture.texels.size() * sizeof(Common::Vec4<u8>);
+            entry.hash = hash;
+        }
+        entry.dirty = false;
+    }
+    return &entry.texture;
+}
+
+void TextureCache::EvictTextures() {
+    if (cached_size <= MAX_CACHED_SIZE) {
+        return;
+    }
+
+    std::vector<decltype(entries)::iterator> by_use;
+    by_use.reserve(entries.size());
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        by_use.push_back(it);
+    }
+    std::sort(by_use.begin(), by_use.end(),
+              [](const auto& a, const auto& b) { return a->second.last_use < b->second.last_use; });
+
+    // Leave some room, so that the next few new textures do not have to evict again
+    for (auto it : by_use) {
+        if (cached_size <= MAX_CACHED_SIZE / 2) {
+            break;
+        }
+        const Entry& entry = it->second;
+        cached_size -= entry.texture.texels.size() * sizeof(Common::Vec4<u8>);
+        UpdatePagesCachedCount(entry.addr, entry.size, -1);
+        entries.erase(it);
+    }
+}
+
+void TextureCache::UpdatePagesCachedCount(PAddr addr, u32 size, int delta) {
+    const u32 num_pages =
+        ((addr + size - 1) >> Memory::PAGE_BITS) - (addr >> Memory::PAGE_BITS) + 1;
+    const u32 page_start = addr >> Memory::PAGE_BITS;
+    const u32 page_end = page_start + num_pages;
+
+    // Interval maps will erase segments if count reaches 0, so if delta is negative we have to
+    // subtract after iterating
+    const auto pages_interval = PageMap::interval_type::right_open(page_start, page_end);
+    if (delta > 0) {
+        cached_pages.add({pages_interval, delta});
+    }
+
+    for (const auto& pair : cached_pages & pages_interval) {
+        const auto interval = pair.first;
+        const int count = pair.second;
+
+        const PAddr interval_start_addr = boost::icl::first(interval) << Memory::PAGE_BITS;
+        const PAddr interval_end_addr = boost::icl::last_next(interval) << Memory::PAGE_BITS;
+        const u32 interval_size = interval_end_addr - interval_start_addr;
+
+        if (delta > 0 && count == delta) {
+            VideoCore::g_memory->RasterizerMarkRegionCached(interval_start_addr, interval_size,
+                                                            true);
+        } else if (delta < 0 && count == -delta) {
+            VideoCore::g_memory->RasterizerMarkRegionCached(interval_start_addr, interval_size,
+                                                            false);
+        }
+    }
+
+    if (delta < 0) {
+        cached_pages.add({pages_interval, delta});
+    }
+}
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,115 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include <boost/icl/interval_map.hpp>
+#include "common/common_types.h"
+#include "common/hash.h"
+#include "common/vector_math.h"
+#include "video_core/regs.h"
+
+namespace Pica::Texture {
+struct TextureInfo;
+}
+
+namespace Pica::Rasterizer {
+
+/// A texture decoded to RGBA8, addressed with the same texel coordinates as LookupTexture
+struct DecodedTexture {
+    u32 width = 0;
+    u32 height = 0;
+    std::vector<Common::Vec4<u8>> texels;
+
+    Common::Vec4<u8> LookupTexel(unsigned x, unsigned y) const {
+        return texels[y * width + x];
+    }
+};
+
+/// The decoded textures sampled by a draw. Units that are disabled or whose memory is not
+/// accessible are null.
+struct TextureUnits {
+    std::array<const DecodedTexture*, 3> textures{};
+    /// Faces of the cube map bound to unit 0, indexed by TexturingRegs::CubeFace
+    std::array<const DecodedTexture*, 6> cube_faces{};
+};
+
+struct TextureCacheKeyState {
+    PAddr address;
+    TexturingRegs::TextureFormat format;
+    u32 width;
+    u32 height;
+};
+
+struct TextureCacheKey : Common::HashableStruct<TextureCacheKeyState> {};
+
+} // namespace Pica::Rasterizer
+
+namespace std {
+template <>
+struct hash<Pica::Rasterizer::TextureCacheKey> {
+    std::size_t operator()(const Pica::Rasterizer::TextureCacheKey& k) const {
+        return k.Hash();
+    }
+};
+} // namespace std
+
+namespace Pica::Rasterizer {
+
+/**
+ * Keeps the textures sampled by the software rasterizer decoded, so that sampling does not have
+ * to decode a texel from the tiled source for every fragment. The pages of cached textures are
+ * marked as cached in the memory system to be notified of writes to them. A texture invalidated
+ * by a write is only decoded again if the hash of its source data changed.
+ */
+class TextureCache {
+public:
+    TextureCache();
+    ~TextureCache();
+
+    /**
+     * Returns the textures sampled with the given registers, decoding those that are not cached.
+     * The returned textures stay valid until the next call.
+     */
+    TextureUnits GetTextures(const Regs& regs);
+
+    /// Marks the textures overlapping the given region as possibly modified
+    void InvalidateRegion(PAddr addr, u32 size);
+
+private:
+    struct Entry {
+        DecodedTexture texture;
+        PAddr addr = 0;
+        u32 size = 0;
+        /// Hash of the source data the texture was decoded from
+        u64 hash = 0;
+        /// Whether the source data may have changed since it was last hashed
+        bool dirty = true;
+        /// Value of use_counter when the texture was last returned
+        u64 last_use = 0;
+    };
+
+    using PageMap = boost::icl::interval_map<u32, int>;
+
+    /// Returns the decoded texture, or null if its source data is not accessible
+    const DecodedTexture* Get(const Texture::TextureInfo& info);
+
+    /// Drops the least recently used textures if the cache grew beyond its budget
+    void EvictTextures();
+
+    /// Increase/decrease the number of cached textures in pages touching the specified region
+    void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
+
+    std::unordered_map<TextureCacheKey, Entry> entries;
+    PageMap cached_pages;
+    /// Combined size of the decoded texels of all entries, in bytes
+    std::size_t cached_size = 0;
+    u64 use_counter = 0;
+};
+
+} // namespace Pica::Rasterizer
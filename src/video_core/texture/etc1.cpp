@@ -14,17 +14,6 @@ namespace Pica::Texture {
 
 namespace {
 
-constexpr std::array<std::array<u8, 2>, 8> etc1_modifier_table = {{
-    {2, 8},
-    {5, 17},
-    {9, 29},
-    {13, 42},
-    {18, 60},
-    {24, 80},
-    {33, 106},
-    {47, 183},
-}};
-
 union ETC1Tile {
     u64 raw;
 
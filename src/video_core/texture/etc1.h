@@ -4,11 +4,24 @@
 
 #pragma once
 
+#include <array>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 
 namespace Pica::Texture {
 
+/// Intensity modifiers of the ETC1 subblocks, indexed by table index and table subindex
+constexpr std::array<std::array<u8, 2>, 8> etc1_modifier_table = {{
+    {2, 8},
+    {5, 17},
+    {9, 29},
+    {13, 42},
+    {18, 60},
+    {24, 80},
+    {33, 106},
+    {47, 183},
+}};
+
 Common::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y);
 
 } // namespace Pica::Texture
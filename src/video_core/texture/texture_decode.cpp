@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/logging/log.h"
@@ -11,6 +14,7 @@
 #include "video_core/regs_texturing.h"
 #include "video_core/texture/etc1.h"
 #include "video_core/texture/texture_decode.h"
+#include "video_core/texture/tile_decoder.h"
 #include "video_core/utils.h"
 
 using TextureFormat = Pica::TexturingRegs::TextureFormat;
@@ -211,6 +215,67 @@ Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned in
     }
 }
 
+/// Applies the disable_alpha conversion of LookupTexelInTile to a row of decoded texels
+static void DisableAlpha(u8* texels, unsigned int count, TextureFormat format) {
+    for (u8* texel = texels; texel != texels + count * 4; texel += 4) {
+        switch (format) {
+        case TextureFormat::IA8:
+        case TextureFormat::IA4:
+            // Show intensity as red, alpha as green
+            texel[1] = texel[3];
+            texel[2] = 0;
+            break;
+        case TextureFormat::A8:
+        case TextureFormat::A4:
+            texel[0] = texel[1] = texel[2] = texel[3];
+            break;
+        default:
+            break;
+        }
+        texel[3] = 255;
+    }
+}
+
+void DecodeTexture(const u8* source, const TextureInfo& info, u8* dest, std::ptrdiff_t dest_stride,
+                   bool disable_alpha) {
+    static const DecodeKernel kernel = GetHostDecodeKernel();
+    const DecodeTileFn decode_tile = GetDecodeTileFn(info.format, kernel);
+    if (!decode_tile) {
+        LOG_ERROR(HW_GPU, "Unknown texture format: {:x}", static_cast<u32>(info.format));
+        return;
+    }
+
+    // Tiles cut off by the texture size are decoded aside and only partially copied
+    std::array<u8, TILE_SIZE * 4> partial_tile;
+    constexpr std::ptrdiff_t partial_stride = 8 * 4;
+
+    const std::size_t tile_size = CalculateTileSize(info.format);
+    for (unsigned int tile_y = 0; tile_y < info.height; tile_y += 8) {
+        const u8* tile = source + (tile_y / 8) * info.stride;
+        u8* const dest_row = dest + tile_y * dest_stride;
+        const unsigned int rows = std::min(8u, info.height - tile_y);
+        for (unsigned int tile_x = 0; tile_x < info.width; tile_x += 8, tile += tile_size) {
+            u8* const tile_dest = dest_row + tile_x * 4;
+            const unsigned int columns = std::min(8u, info.width - tile_x);
+            if (rows == 8 && columns == 8) {
+                decode_tile(tile, tile_dest, dest_stride);
+                continue;
+            }
+            decode_tile(tile, partial_tile.data(), partial_stride);
+            for (unsigned int y = 0; y < rows; ++y) {
+                std::memcpy(tile_dest + y * dest_stride, &partial_tile[y * partial_stride],
+                            columns * 4);
+            }
+        }
+
+        if (disable_alpha) {
+            for (unsigned int y = 0; y < rows; ++y) {
+                DisableAlpha(dest_row + y * dest_stride, info.width, info.format);
+            }
+        }
+    }
+}
+
 TextureInfo TextureInfo::FromPicaRegister(const TexturingRegs::TextureConfig& config,
                                           const TexturingRegs::TextureFormat& format) {
     TextureInfo info;
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
@@ -55,4 +56,18 @@ Common::Vec4<u8> LookupTexture(const u8* source, unsigned int x, unsigned int y,
 Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned int y,
                                    const TextureInfo& info, bool disable_alpha);
 
+/**
+ * Decodes a whole texture to RGBA8 one tile at a time, using the fastest tile decoder the host
+ * supports. This is considerably faster than calling LookupTexture for every texel.
+ *
+ * @param source Source pointer to read data from
+ * @param info TextureInfo object describing the texture setup
+ * @param dest Receives the texel at texture coordinates (0, 0), as four bytes in R, G, B, A order.
+ * @param dest_stride Distance between the starts of rows with consecutive texture coordinates in
+ *                    dest, in bytes. Negative strides store the rows bottom to top.
+ * @param disable_alpha See LookupTexture
+ */
+void DecodeTexture(const u8* source, const TextureInfo& info, u8* dest, std::ptrdiff_t dest_stride,
+                   bool disable_alpha = false);
+
 } // namespace Pica::Texture
@@ -0,0 +1,585 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include "common/color.h"
+#include "video_core/texture/etc1.h"
+#include "video_core/texture/texture_decode.h"
+#include "video_core/texture/tile_decoder.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <immintrin.h>
+#include "common/x64/cpu_detect.h"
+#endif
+
+namespace Pica::Texture {
+
+using TextureFormat = TexturingRegs::TextureFormat;
+
+template <TextureFormat format>
+static void DecodeTileScalar(const u8* tile, u8* dest, std::ptrdiff_t dest_stride) {
+    TextureInfo info{};
+    info.format = format;
+    for (u32 y = 0; y < 8; ++y, dest += dest_stride) {
+        for (u32 x = 0; x < 8; ++x) {
+            auto texel = LookupTexelInTile(tile, x, y, info, false);
+            std::memcpy(dest + x * 4, texel.AsArray(), 4);
+        }
+    }
+}
+
+static DecodeTileFn GetScalarTileFn(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::RGBA8:
+        return DecodeTileScalar<TextureFormat::RGBA8>;
+    case TextureFormat::RGB8:
+        return DecodeTileScalar<TextureFormat::RGB8>;
+    case TextureFormat::RGB5A1:
+        return DecodeTileScalar<TextureFormat::RGB5A1>;
+    case TextureFormat::RGB565:
+        return DecodeTileScalar<TextureFormat::RGB565>;
+    case TextureFormat::RGBA4:
+        return DecodeTileScalar<TextureFormat::RGBA4>;
+    case TextureFormat::IA8:
+        return DecodeTileScalar<TextureFormat::IA8>;
+    case TextureFormat::RG8:
+        return DecodeTileScalar<TextureFormat::RG8>;
+    case TextureFormat::I8:
+        return DecodeTileScalar<TextureFormat::I8>;
+    case TextureFormat::A8:
+        return DecodeTileScalar<TextureFormat::A8>;
+    case TextureFormat::IA4:
+        return DecodeTileScalar<TextureFormat::IA4>;
+    case TextureFormat::I4:
+        return DecodeTileScalar<TextureFormat::I4>;
+    case TextureFormat::A4:
+        return DecodeTileScalar<TextureFormat::A4>;
+    case TextureFormat::ETC1:
+        return DecodeTileScalar<TextureFormat::ETC1>;
+    case TextureFormat::ETC1A4:
+        return DecodeTileScalar<TextureFormat::ETC1A4>;
+    default:
+        return nullptr;
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+// The vector kernels are selected at runtime, so they are compiled for their instruction set
+// regardless of the flags the rest of the file is compiled with.
+#ifdef _MSC_VER
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#else
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Except for ETC1, the kernels first decode the texels of 2x2 blocks, which are stored in Morton
+// order, and then place the blocks into rows. The texels of tile rows 2n and 2n+1 are in four
+// blocks: two contiguous blocks for columns 0-3, followed four blocks later by two contiguous
+// blocks for columns 4-7. Each block holds its two texels of row 2n before those of row 2n+1.
+
+/// Index of the first 2x2 block of tile rows 2 * row_pair and 2 * row_pair + 1, in Morton order
+constexpr u32 RowPairBlock(u32 row_pair) {
+    return ((row_pair & 1) << 1) | ((row_pair & 2) << 2);
+}
+
+/// Size of a 2x2 block of the format in bytes
+constexpr u32 BlockSize(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::RGBA8:
+        return 16;
+    case TextureFormat::RGB8:
+        return 12;
+    case TextureFormat::RGB5A1:
+    case TextureFormat::RGB565:
+    case TextureFormat::RGBA4:
+    case TextureFormat::IA8:
+    case TextureFormat::RG8:
+        return 8;
+    case TextureFormat::I8:
+    case TextureFormat::A8:
+    case TextureFormat::IA4:
+        return 4;
+    default:
+        return 2;
+    }
+}
+
+static __m128i Load128(const u8* ptr) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+}
+
+static __m128i Load64(const u8* ptr) {
+    return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr));
+}
+
+static __m128i Load32(const u8* ptr) {
+    u32 value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return _mm_cvtsi32_si128(static_cast<int>(value));
+}
+
+static __m128i Load16(const u8* ptr) {
+    u16 value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return _mm_cvtsi32_si128(value);
+}
+
+static void Store128(u8* ptr, __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), value);
+}
+
+/// Takes the bits of a where mask is set and the bits of b elsewhere
+static __m128i Select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+constexpr s8 z = -1;
+
+/// Shuffle indices that copy the first byte of each texel to R, G and B
+#define INTENSITY_INDICES 0, 0, 0, z, 1, 1, 1, z, 2, 2, 2, z, 3, 3, 3, z
+/// Shuffle indices that copy the first byte of each texel to A
+#define ALPHA_INDICES z, z, z, 0, z, z, z, 1, z, z, z, 2, z, z, z, 3
+
+// The bit expansions work on values stored in the bytes of 32-bit lanes. The shifts may move bits
+// into neighbouring bytes, which the masks discard.
+
+/// Expands the 4-bit values in the bytes of x to 8 bits
+static __m128i Expand4To8(__m128i x) {
+    return _mm_or_si128(_mm_slli_epi32(x, 4), x);
+}
+
+/// Expands the 5-bit values in the bytes of x to 8 bits
+static __m128i Expand5To8(__m128i x) {
+    return _mm_or_si128(_mm_slli_epi32(x, 3),
+                        _mm_and_si128(_mm_srli_epi32(x, 2), _mm_set1_epi8(7)));
+}
+
+/// Expands the 6-bit values in the bytes of x to 8 bits
+static __m128i Expand6To8(__m128i x) {
+    return _mm_or_si128(_mm_slli_epi32(x, 2),
+                        _mm_and_si128(_mm_srli_epi32(x, 4), _mm_set1_epi8(3)));
+}
+
+/// Splits the nibbles of the bytes of x into bytes, low nibble first, and expands them to 8 bits
+static __m128i UnpackNibbles(__m128i x) {
+    const __m128i mask = _mm_set1_epi8(0xF);
+    const __m128i low = _mm_and_si128(x, mask);
+    const __m128i high = _mm_and_si128(_mm_srli_epi16(x, 4), mask);
+    return Expand4To8(_mm_unpacklo_epi8(low, high));
+}
+
+/// Decodes 16-bit texels stored in the low half of 32-bit lanes
+template <TextureFormat format>
+static __m128i DecodePixels16(__m128i pixels) {
+    const __m128i mask5 = _mm_set1_epi32(0x1F);
+    if (format == TextureFormat::RGB565) {
+        const __m128i r = _mm_srli_epi32(pixels, 11);
+        const __m128i g = _mm_and_si128(_mm_srli_epi32(pixels, 5), _mm_set1_epi32(0x3F));
+        const __m128i b = _mm_and_si128(pixels, mask5);
+        const __m128i rb = Expand5To8(_mm_or_si128(r, _mm_slli_epi32(b, 16)));
+        return _mm_or_si128(_mm_or_si128(rb, _mm_slli_epi32(Expand6To8(g), 8)),
+                            _mm_set1_epi32(0xFF000000));
+    }
+    if (format == TextureFormat::RGB5A1) {
+        const __m128i r = _mm_srli_epi32(pixels, 11);
+        const __m128i g = _mm_and_si128(_mm_srli_epi32(pixels, 6), mask5);
+        const __m128i b = _mm_and_si128(_mm_srli_epi32(pixels, 1), mask5);
+        // 0 - a is either all zeroes or all ones
+        const __m128i a = _mm_sub_epi32(_mm_setzero_si128(),
+                                        _mm_and_si128(pixels, _mm_set1_epi32(1)));
+        const __m128i rgb = _mm_or_si128(r, _mm_or_si128(_mm_slli_epi32(g, 8),
+                                                         _mm_slli_epi32(b, 16)));
+        return _mm_or_si128(Expand5To8(rgb), _mm_slli_epi32(a, 24));
+    }
+    // RGBA4
+    const __m128i mask4 = _mm_set1_epi32(0xF);
+    const __m128i r = _mm_srli_epi32(pixels, 12);
+    const __m128i g = _mm_and_si128(_mm_srli_epi32(pixels, 8), mask4);
+    const __m128i b = _mm_and_si128(_mm_srli_epi32(pixels, 4), mask4);
+    const __m128i a = _mm_and_si128(pixels, mask4);
+    const __m128i rg = _mm_or_si128(r, _mm_slli_epi32(g, 8));
+    const __m128i ba = _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24));
+    return Expand4To8(_mm_or_si128(rg, ba));
+}
+
+/// Decodes the four texels of a 2x2 block
+template <TextureFormat format>
+static TARGET_SSSE3 __m128i DecodeBlockSSSE3(const u8* tile, u32 block) {
+    const u8* const ptr = tile + block * BlockSize(format);
+    const __m128i opaque = _mm_set1_epi32(0xFF000000);
+    switch (format) {
+    case TextureFormat::RGBA8:
+        return _mm_shuffle_epi8(
+            Load128(ptr), _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+    case TextureFormat::RGB8: {
+        // Don't read past the end of the tile
+        const __m128i pixels = _mm_unpacklo_epi64(Load64(ptr), Load32(ptr + 8));
+        return _mm_or_si128(_mm_shuffle_epi8(pixels, _mm_setr_epi8(2, 1, 0, z, 5, 4, 3, z, 8, 7,
+                                                                   6, z, 11, 10, 9, z)),
+                            opaque);
+    }
+    case TextureFormat::RGB5A1:
+    case TextureFormat::RGB565:
+    case TextureFormat::RGBA4:
+        return DecodePixels16<format>(_mm_unpacklo_epi16(Load64(ptr), _mm_setzero_si128()));
+    case TextureFormat::IA8:
+        return _mm_shuffle_epi8(Load64(ptr),
+                                _mm_setr_epi8(1, 1, 1, 0, 3, 3, 3, 2, 5, 5, 5, 4, 7, 7, 7, 6));
+    case TextureFormat::RG8:
+        return _mm_or_si128(_mm_shuffle_epi8(Load64(ptr), _mm_setr_epi8(1, 0, z, z, 3, 2, z, z, 5,
+                                                                        4, z, z, 7, 6, z, z)),
+                            opaque);
+    case TextureFormat::I8:
+        return _mm_or_si128(_mm_shuffle_epi8(Load32(ptr), _mm_setr_epi8(INTENSITY_INDICES)),
+                            opaque);
+    case TextureFormat::A8:
+        return _mm_shuffle_epi8(Load32(ptr), _mm_setr_epi8(ALPHA_INDICES));
+    case TextureFormat::IA4: {
+        // The intensity is in the high nibble, the alpha in the low nibble
+        const __m128i nibbles = UnpackNibbles(Load32(ptr));
+        return _mm_shuffle_epi8(nibbles,
+                                _mm_setr_epi8(1, 1, 1, 0, 3, 3, 3, 2, 5, 5, 5, 4, 7, 7, 7, 6));
+    }
+    case TextureFormat::I4:
+        return _mm_or_si128(
+            _mm_shuffle_epi8(UnpackNibbles(Load16(ptr)), _mm_setr_epi8(INTENSITY_INDICES)),
+            opaque);
+    case TextureFormat::A4:
+        return _mm_shuffle_epi8(UnpackNibbles(Load16(ptr)), _mm_setr_epi8(ALPHA_INDICES));
+    default:
+        return _mm_setzero_si128();
+    }
+}
+
+template <TextureFormat format>
+static TARGET_SSSE3 void DecodeTileSSSE3(const u8* tile, u8* dest, std::ptrdiff_t dest_stride) {
+    for (u32 row_pair = 0; row_pair < 4; ++row_pair) {
+        u8* const even = dest + 2 * row_pair * dest_stride;
+        u8* const odd = even + dest_stride;
+        for (u32 half = 0; half < 2; ++half) {
+            const u32 block = RowPairBlock(row_pair) + half * 4;
+            const __m128i left = DecodeBlockSSSE3<format>(tile, block);
+            const __m128i right = DecodeBlockSSSE3<format>(tile, block + 1);
+            Store128(even + half * 16, _mm_unpacklo_epi64(left, right));
+            Store128(odd + half * 16, _mm_unpackhi_epi64(left, right));
+        }
+    }
+}
+
+/**
+ * Decodes an ETC1 tile, which consists of four 4x4 subtiles. A row of a subtile fits in a vector,
+ * and every texel picks its base color and intensity modifier with masks instead of branches.
+ * The saturating additions perform the clamping to [0, 255].
+ */
+template <bool has_alpha>
+static TARGET_SSSE3 void DecodeTileETC1SSSE3(const u8* tile, u8* dest,
+                                              std::ptrdiff_t dest_stride) {
+    constexpr u32 subtile_size = has_alpha ? 16 : 8;
+    for (u32 subtile = 0; subtile < 4; ++subtile) {
+        const u8* ptr = tile + subtile * subtile_size;
+        u64 alpha = 0;
+        if (has_alpha) {
+            std::memcpy(&alpha, ptr, sizeof(u64));
+            ptr += sizeof(u64);
+        }
+        u64 value;
+        std::memcpy(&value, ptr, sizeof(u64));
+
+        // See ETC1Tile for the bit layout
+        const bool flip = (value >> 32) & 1;
+        const bool differential_mode = (value >> 33) & 1;
+        const auto& table_2 = etc1_modifier_table[(value >> 34) & 7];
+        const auto& table_1 = etc1_modifier_table[(value >> 37) & 7];
+
+        u32 base_1 = 0;
+        u32 base_2 = 0;
+        for (u32 channel = 0; channel < 3; ++channel) {
+            // Red is stored in the highest bits, but is the lowest byte of the decoded color
+            const u32 shift = 59 - channel * 8;
+            u8 color_1, color_2;
+            if (differential_mode) {
+                const int base = static_cast<int>((value >> shift) & 0x1F);
+                const int delta = static_cast<int>(static_cast<s64>(value << (64 - shift)) >> 61);
+                color_1 = Color::Convert5To8(static_cast<u8>(base));
+                color_2 = Color::Convert5To8(static_cast<u8>(base + delta));
+            } else {
+                color_1 = Color::Convert4To8(static_cast<u8>((value >> (shift + 1)) & 0xF));
+                color_2 = Color::Convert4To8(static_cast<u8>((value >> (shift - 3)) & 0xF));
+            }
+            base_1 |= color_1 << (channel * 8);
+            base_2 |= color_2 << (channel * 8);
+        }
+
+        const __m128i table_indexes = _mm_set1_epi32(static_cast<u32>(value & 0xFFFF));
+        const __m128i negation_flags = _mm_set1_epi32(static_cast<u32>((value >> 16) & 0xFFFF));
+        const auto to_rgb = [](u8 value) { return _mm_set1_epi32(value * 0x010101); };
+        const __m128i modifiers_1[2] = {to_rgb(table_1[0]), to_rgb(table_1[1])};
+        const __m128i modifiers_2[2] = {to_rgb(table_2[0]), to_rgb(table_2[1])};
+
+        u8* const subtile_dest = dest + (subtile >> 1) * 4 * dest_stride + (subtile & 1) * 16;
+        for (u32 y = 0; y < 4; ++y) {
+            // Texels are numbered column by column
+            const __m128i bits = _mm_setr_epi32(1 << y, 1 << (4 + y), 1 << (8 + y), 1 << (12 + y));
+            const __m128i second_index =
+                _mm_cmpeq_epi32(_mm_and_si128(table_indexes, bits), bits);
+            const __m128i negate = _mm_cmpeq_epi32(_mm_and_si128(negation_flags, bits), bits);
+
+            // The subblocks are split vertically, or horizontally if flipped
+            const __m128i second_subblock = flip ? _mm_set1_epi32(y >= 2 ? -1 : 0)
+                                                 : _mm_setr_epi32(0, 0, -1, -1);
+            const __m128i base = Select(second_subblock, _mm_set1_epi32(base_2),
+                                        _mm_set1_epi32(base_1));
+            const __m128i modifier =
+                Select(second_subblock, Select(second_index, modifiers_2[1], modifiers_2[0]),
+                       Select(second_index, modifiers_1[1], modifiers_1[0]));
+            __m128i color = Select(negate, _mm_subs_epu8(base, modifier),
+                                   _mm_adds_epu8(base, modifier));
+
+            if (has_alpha) {
+                // The alpha values are numbered column by column as well, with four bits each
+                const __m128i row_alpha = _mm_and_si128(
+                    _mm_unpacklo_epi16(_mm_cvtsi64_si128(static_cast<s64>(alpha >> (4 * y))),
+                                       _mm_setzero_si128()),
+                    _mm_set1_epi32(0xF));
+                color = _mm_or_si128(color, _mm_slli_epi32(Expand4To8(row_alpha), 24));
+            } else {
+                color = _mm_or_si128(color, _mm_set1_epi32(0xFF000000));
+            }
+            Store128(subtile_dest + y * dest_stride, color);
+        }
+    }
+}
+
+static DecodeTileFn GetSSSE3TileFn(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::RGBA8:
+        return DecodeTileSSSE3<TextureFormat::RGBA8>;
+    case TextureFormat::RGB8:
+        return DecodeTileSSSE3<TextureFormat::RGB8>;
+    case TextureFormat::RGB5A1:
+        return DecodeTileSSSE3<TextureFormat::RGB5A1>;
+    case TextureFormat::RGB565:
+        return DecodeTileSSSE3<TextureFormat::RGB565>;
+    case TextureFormat::RGBA4:
+        return DecodeTileSSSE3<TextureFormat::RGBA4>;
+    case TextureFormat::IA8:
+        return DecodeTileSSSE3<TextureFormat::IA8>;
+    case TextureFormat::RG8:
+        return DecodeTileSSSE3<TextureFormat::RG8>;
+    case TextureFormat::I8:
+        return DecodeTileSSSE3<TextureFormat::I8>;
+    case TextureFormat::A8:
+        return DecodeTileSSSE3<TextureFormat::A8>;
+    case TextureFormat::IA4:
+        return DecodeTileSSSE3<TextureFormat::IA4>;
+    case TextureFormat::I4:
+        return DecodeTileSSSE3<TextureFormat::I4>;
+    case TextureFormat::A4:
+        return DecodeTileSSSE3<TextureFormat::A4>;
+    case TextureFormat::ETC1:
+        return DecodeTileETC1SSSE3<false>;
+    case TextureFormat::ETC1A4:
+        return DecodeTileETC1SSSE3<true>;
+    default:
+        return nullptr;
+    }
+}
+
+static TARGET_AVX2 __m256i Load256(const u8* ptr) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+}
+
+static TARGET_AVX2 void Store256(u8* ptr, __m256i value) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), value);
+}
+
+/// Repeats the byte shuffle indices of a 128-bit lane in both lanes
+static TARGET_AVX2 __m256i LaneIndices(__m128i indices) {
+    return _mm256_broadcastsi128_si256(indices);
+}
+
+static TARGET_AVX2 __m256i Expand4To8(__m256i x) {
+    return _mm256_or_si256(_mm256_slli_epi32(x, 4), x);
+}
+
+static TARGET_AVX2 __m256i Expand5To8(__m256i x) {
+    return _mm256_or_si256(_mm256_slli_epi32(x, 3),
+                           _mm256_and_si256(_mm256_srli_epi32(x, 2), _mm256_set1_epi8(7)));
+}
+
+static TARGET_AVX2 __m256i Expand6To8(__m256i x) {
+    return _mm256_or_si256(_mm256_slli_epi32(x, 2),
+                           _mm256_and_si256(_mm256_srli_epi32(x, 4), _mm256_set1_epi8(3)));
+}
+
+template <TextureFormat format>
+static TARGET_AVX2 __m256i DecodePixels16(__m256i pixels) {
+    const __m256i mask5 = _mm256_set1_epi32(0x1F);
+    if (format == TextureFormat::RGB565) {
+        const __m256i r = _mm256_srli_epi32(pixels, 11);
+        const __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixels, 5), _mm256_set1_epi32(0x3F));
+        const __m256i b = _mm256_and_si256(pixels, mask5);
+        const __m256i rb = Expand5To8(_mm256_or_si256(r, _mm256_slli_epi32(b, 16)));
+        return _mm256_or_si256(_mm256_or_si256(rb, _mm256_slli_epi32(Expand6To8(g), 8)),
+                               _mm256_set1_epi32(0xFF000000));
+    }
+    if (format == TextureFormat::RGB5A1) {
+        const __m256i r = _mm256_srli_epi32(pixels, 11);
+        const __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixels, 6), mask5);
+        const __m256i b = _mm256_and_si256(_mm256_srli_epi32(pixels, 1), mask5);
+        const __m256i a = _mm256_sub_epi32(_mm256_setzero_si256(),
+                                           _mm256_and_si256(pixels, _mm256_set1_epi32(1)));
+        const __m256i rgb = _mm256_or_si256(
+            r, _mm256_or_si256(_mm256_slli_epi32(g, 8), _mm256_slli_epi32(b, 16)));
+        return _mm256_or_si256(Expand5To8(rgb), _mm256_slli_epi32(a, 24));
+    }
+    const __m256i mask4 = _mm256_set1_epi32(0xF);
+    const __m256i r = _mm256_srli_epi32(pixels, 12);
+    const __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixels, 8), mask4);
+    const __m256i b = _mm256_and_si256(_mm256_srli_epi32(pixels, 4), mask4);
+    const __m256i a = _mm256_and_si256(pixels, mask4);
+    const __m256i rg = _mm256_or_si256(r, _mm256_slli_epi32(g, 8));
+    const __m256i ba = _mm256_or_si256(_mm256_slli_epi32(b, 16), _mm256_slli_epi32(a, 24));
+    return Expand4To8(_mm256_or_si256(rg, ba));
+}
+
+/// Decodes the texels of two consecutive 2x2 blocks, one block per 128-bit lane
+template <TextureFormat format>
+static TARGET_AVX2 __m256i DecodeBlocksAVX2(const u8* tile, u32 block) {
+    const u8* const ptr = tile + block * BlockSize(format);
+    const __m256i opaque = _mm256_set1_epi32(0xFF000000);
+    switch (format) {
+    case TextureFormat::RGBA8:
+        return _mm256_shuffle_epi8(Load256(ptr), LaneIndices(_mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+                                                                           11, 10, 9, 8, 15, 14,
+                                                                           13, 12)));
+    case TextureFormat::RGB8: {
+        // The second block starts at byte 4 of the upper lane
+        const __m256i pixels =
+            _mm256_inserti128_si256(_mm256_castsi128_si256(Load128(ptr)), Load128(ptr + 8), 1);
+        const __m256i indices = _mm256_setr_epi8(2, 1, 0, z, 5, 4, 3, z, 8, 7, 6, z, 11, 10, 9, z,
+                                                 6, 5, 4, z, 9, 8, 7, z, 12, 11, 10, z, 15, 14, 13,
+                                                 z);
+        return _mm256_or_si256(_mm256_shuffle_epi8(pixels, indices), opaque);
+    }
+    case TextureFormat::RGB5A1:
+    case TextureFormat::RGB565:
+    case TextureFormat::RGBA4:
+        return DecodePixels16<format>(_mm256_cvtepu16_epi32(Load128(ptr)));
+    case TextureFormat::IA8:
+        return _mm256_shuffle_epi8(_mm256_cvtepu16_epi32(Load128(ptr)),
+                                   LaneIndices(_mm_setr_epi8(1, 1, 1, 0, 5, 5, 5, 4, 9, 9, 9, 8,
+                                                             13, 13, 13, 12)));
+    case TextureFormat::RG8:
+        return _mm256_or_si256(
+            _mm256_shuffle_epi8(_mm256_cvtepu16_epi32(Load128(ptr)),
+                                LaneIndices(_mm_setr_epi8(1, 0, z, z, 5, 4, z, z, 9, 8, z, z, 13,
+                                                          12, z, z))),
+            opaque);
+    case TextureFormat::I8:
+        return _mm256_or_si256(
+            _mm256_mullo_epi32(_mm256_cvtepu8_epi32(Load64(ptr)), _mm256_set1_epi32(0x010101)),
+            opaque);
+    case TextureFormat::A8:
+        return _mm256_slli_epi32(_mm256_cvtepu8_epi32(Load64(ptr)), 24);
+    case TextureFormat::IA4: {
+        const __m256i pixels = _mm256_cvtepu8_epi32(Load64(ptr));
+        const __m256i i = _mm256_srli_epi32(pixels, 4);
+        const __m256i a = _mm256_and_si256(pixels, _mm256_set1_epi32(0xF));
+        return Expand4To8(_mm256_or_si256(_mm256_mullo_epi32(i, _mm256_set1_epi32(0x010101)),
+                                          _mm256_slli_epi32(a, 24)));
+    }
+    case TextureFormat::I4:
+        return _mm256_or_si256(_mm256_mullo_epi32(_mm256_cvtepu8_epi32(UnpackNibbles(Load32(ptr))),
+                                                  _mm256_set1_epi32(0x010101)),
+                               opaque);
+    case TextureFormat::A4:
+        return _mm256_slli_epi32(_mm256_cvtepu8_epi32(UnpackNibbles(Load32(ptr))), 24);
+    default:
+        return _mm256_setzero_si256();
+    }
+}
+
+template <TextureFormat format>
+static TARGET_AVX2 void DecodeTileAVX2(const u8* tile, u8* dest, std::ptrdiff_t dest_stride) {
+    for (u32 row_pair = 0; row_pair < 4; ++row_pair) {
+        u8* const even = dest + 2 * row_pair * dest_stride;
+        u8* const odd = even + dest_stride;
+        // Each 64-bit lane holds a horizontal pair of texels, lanes 0 and 2 belong to the even row
+        const u32 block = RowPairBlock(row_pair);
+        const __m256i left = _mm256_permute4x64_epi64(DecodeBlocksAVX2<format>(tile, block), 0xD8);
+        const __m256i right =
+            _mm256_permute4x64_epi64(DecodeBlocksAVX2<format>(tile, block + 4), 0xD8);
+        Store256(even, _mm256_permute2x128_si256(left, right, 0x20));
+        Store256(odd, _mm256_permute2x128_si256(left, right, 0x31));
+    }
+}
+
+static DecodeTileFn GetAVX2TileFn(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::RGBA8:
+        return DecodeTileAVX2<TextureFormat::RGBA8>;
+    case TextureFormat::RGB8:
+        return DecodeTileAVX2<TextureFormat::RGB8>;
+    case TextureFormat::RGB5A1:
+        return DecodeTileAVX2<TextureFormat::RGB5A1>;
+    case TextureFormat::RGB565:
+        return DecodeTileAVX2<TextureFormat::RGB565>;
+    case TextureFormat::RGBA4:
+        return DecodeTileAVX2<TextureFormat::RGBA4>;
+    case TextureFormat::IA8:
+        return DecodeTileAVX2<TextureFormat::IA8>;
+    case TextureFormat::RG8:
+        return DecodeTileAVX2<TextureFormat::RG8>;
+    case TextureFormat::I8:
+        return DecodeTileAVX2<TextureFormat::I8>;
+    case TextureFormat::A8:
+        return DecodeTileAVX2<TextureFormat::A8>;
+    case TextureFormat::IA4:
+        return DecodeTileAVX2<TextureFormat::IA4>;
+    case TextureFormat::I4:
+        return DecodeTileAVX2<TextureFormat::I4>;
+    case TextureFormat::A4:
+        return DecodeTileAVX2<TextureFormat::A4>;
+    default:
+        // A row of an ETC1 subtile only fills a 128-bit vector
+        return GetSSSE3TileFn(format);
+    }
+}
+
+#undef INTENSITY_INDICES
+#undef ALPHA_INDICES
+
+#endif // ARCHITECTURE_x86_64
+
+DecodeKernel GetHostDecodeKernel() {
+#ifdef ARCHITECTURE_x86_64
+    const auto& caps = Common::GetCPUCaps();
+    if (caps.avx2) {
+        return DecodeKernel::AVX2;
+    }
+    if (caps.ssse3) {
+        return DecodeKernel::SSSE3;
+    }
+#endif
+    return DecodeKernel::Scalar;
+}
+
+DecodeTileFn GetDecodeTileFn(TextureFormat format, DecodeKernel kernel) {
+    switch (kernel) {
+#ifdef ARCHITECTURE_x86_64
+    case DecodeKernel::SSSE3:
+        return GetSSSE3TileFn(format);
+    case DecodeKernel::AVX2:
+        return GetAVX2TileFn(format);
+#endif
+    default:
+        return GetScalarTileFn(format);
+    }
+}
+
+} // namespace Pica::Texture
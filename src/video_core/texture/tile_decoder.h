@@ -0,0 +1,36 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+#include "video_core/regs_texturing.h"
+
+namespace Pica::Texture {
+
+/// Implementations of the tile decoders
+enum class DecodeKernel {
+    Scalar,
+    SSSE3,
+    AVX2,
+};
+
+/// Returns the fastest kernel supported by the host CPU
+DecodeKernel GetHostDecodeKernel();
+
+/**
+ * Decodes one 8x8 tile to RGBA8.
+ * @param tile Tile in the PICA layout
+ * @param dest Receives the texel at in-tile coordinates (0, 0), as four bytes in R, G, B, A order.
+ *             The other texels follow with the same coordinates as in LookupTexelInTile.
+ * @param dest_stride Distance between the starts of consecutive rows in dest, in bytes. Negative
+ *                    strides store the rows bottom to top.
+ */
+using DecodeTileFn = void (*)(const u8* tile, u8* dest, std::ptrdiff_t dest_stride);
+
+/// Returns the tile decoder of a kernel, or nullptr if the texture format is unknown
+DecodeTileFn GetDecodeTileFn(TexturingRegs::TextureFormat format, DecodeKernel kernel);
+
+} // namespace Pica::Texture
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <boost/range/algorithm/fill.hpp>
 #include "common/alignment.h"
@@ -15,8 +17,102 @@
 #include "video_core/vertex_loader.h"
 #include "video_core/video_core.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
 namespace Pica {
 
+namespace {
+
+u32 GetElementSize(PipelineRegs::VertexAttributeFormat format) {
+    switch (format) {
+    case PipelineRegs::VertexAttributeFormat::FLOAT:
+        return 4;
+    case PipelineRegs::VertexAttributeFormat::SHORT:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+template <typename T, u32 N>
+void LoadAttribute(const u8* source, Common::Vec4<float24>& attribute) {
+    for (u32 comp = 0; comp < N; ++comp) {
+        T element;
+        std::memcpy(&element, source + comp * sizeof(T), sizeof(T));
+        attribute[comp] = float24::FromFloat32(static_cast<float>(element));
+    }
+
+    // Default attribute values set if array elements have < 4 components. This
+    // is *not* carried over from the default attribute settings even if they're
+    // enabled for this attribute.
+    for (u32 comp = N; comp < 4; ++comp) {
+        attribute[comp] = comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+// float24 is stored as a float, so four-element attributes are converted in one SSE2 register
+
+static_assert(sizeof(Common::Vec4<float24>) == 4 * sizeof(float),
+              "Vec4<float24> must have the layout of four floats");
+
+template <>
+void LoadAttribute<s8, 4>(const u8* source, Common::Vec4<float24>& attribute) {
+    u32 word;
+    std::memcpy(&word, source, sizeof(word));
+    __m128i data = _mm_cvtsi32_si128(static_cast<int>(word));
+    // Move each byte to the top of its dword, then sign-extend it with an arithmetic shift
+    data = _mm_unpacklo_epi8(data, data);
+    data = _mm_srai_epi32(_mm_unpacklo_epi16(data, data), 24);
+    _mm_storeu_ps(reinterpret_cast<float*>(&attribute), _mm_cvtepi32_ps(data));
+}
+
+template <>
+void LoadAttribute<u8, 4>(const u8* source, Common::Vec4<float24>& attribute) {
+    u32 word;
+    std::memcpy(&word, source, sizeof(word));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i data = _mm_cvtsi32_si128(static_cast<int>(word));
+    data = _mm_unpacklo_epi16(_mm_unpacklo_epi8(data, zero), zero);
+    _mm_storeu_ps(reinterpret_cast<float*>(&attribute), _mm_cvtepi32_ps(data));
+}
+
+template <>
+void LoadAttribute<s16, 4>(const u8* source, Common::Vec4<float24>& attribute) {
+    __m128i data = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source));
+    data = _mm_srai_epi32(_mm_unpacklo_epi16(data, data), 16);
+    _mm_storeu_ps(reinterpret_cast<float*>(&attribute), _mm_cvtepi32_ps(data));
+}
+
+template <>
+void LoadAttribute<float, 4>(const u8* source, Common::Vec4<float24>& attribute) {
+    _mm_storeu_ps(reinterpret_cast<float*>(&attribute),
+                  _mm_loadu_ps(reinterpret_cast<const float*>(source)));
+}
+#endif // ARCHITECTURE_x86_64
+
+template <typename T>
+constexpr std::array<void (*)(const u8*, Common::Vec4<float24>&), 4> load_attribute_fns{
+    LoadAttribute<T, 1>, LoadAttribute<T, 2>, LoadAttribute<T, 3>, LoadAttribute<T, 4>};
+
+auto GetLoadAttributeFn(PipelineRegs::VertexAttributeFormat format, u32 elements) {
+    switch (format) {
+    case PipelineRegs::VertexAttributeFormat::BYTE:
+        return load_attribute_fns<s8>[elements - 1];
+    case PipelineRegs::VertexAttributeFormat::UBYTE:
+        return load_attribute_fns<u8>[elements - 1];
+    case PipelineRegs::VertexAttributeFormat::SHORT:
+        return load_attribute_fns<s16>[elements - 1];
+    case PipelineRegs::VertexAttributeFormat::FLOAT:
+    default:
+        return load_attribute_fns<float>[elements - 1];
+    }
+}
+
+} // Anonymous namespace
+
 void VertexLoader::Setup(const PipelineRegs& regs) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
@@ -55,6 +151,9 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
                     attribute_config.GetFormat(attribute_index);
                 vertex_attribute_elements[attribute_index] =
                     attribute_config.GetNumElements(attribute_index);
+                vertex_attribute_load_fns[attribute_index] =
+                    GetLoadAttributeFn(vertex_attribute_formats[attribute_index],
+                                       vertex_attribute_elements[attribute_index]);
                 offset += attribute_config.GetStride(attribute_index);
             } else if (attribute_index < 16) {
                 // Attribute ids 12, 13, 14 and 15 signify 4, 8, 12 and 16-byte paddings,
@@ -74,84 +173,77 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
 void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
                               Shader::AttributeBuffer& input,
                               DebugUtils::MemoryAccessTracker& memory_accesses) {
+    const u32 vertex_index = static_cast<u32>(vertex);
+    LoadVertices(base_address, &vertex_index, 1, &input, memory_accesses);
+}
+
+void VertexLoader::LoadVertices(u32 base_address, const u32* vertices, std::size_t count,
+                                Shader::AttributeBuffer* inputs,
+                                DebugUtils::MemoryAccessTracker& memory_accesses) {
     ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
 
+    if (count == 0) {
+        return;
+    }
+    const auto [min_vertex, max_vertex] = std::minmax_element(vertices, vertices + count);
+
     for (int i = 0; i < num_total_attributes; ++i) {
         if (vertex_attribute_elements[i] != 0) {
             // Load per-vertex data from the loader arrays
-            u32 source_addr =
-                base_address + vertex_attribute_sources[i] + vertex_attribute_strides[i] * vertex;
+            const AttributeLoadFn load = vertex_attribute_load_fns[i];
+            const u32 stride = vertex_attribute_strides[i];
+            const u32 attribute_address = base_address + vertex_attribute_sources[i];
 
             if (g_debug_context && Pica::g_debug_context->recorder) {
-                memory_accesses.AddAccess(
-                    source_addr,
-                    vertex_attribute_elements[i] *
-                        ((vertex_attribute_formats[i] == PipelineRegs::VertexAttributeFormat::FLOAT)
-                             ? 4
-                             : (vertex_attribute_formats[i] ==
-                                PipelineRegs::VertexAttributeFormat::SHORT)
-                                   ? 2
-                                   : 1));
-            }
-
-            switch (vertex_attribute_formats[i]) {
-            case PipelineRegs::VertexAttributeFormat::BYTE: {
-                const s8* srcdata = reinterpret_cast<const s8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
+                const u32 size = vertex_attribute_elements[i] *
+                                 GetElementSize(vertex_attribute_formats[i]);
+                for (std::size_t v = 0; v < count; ++v) {
+                    memory_accesses.AddAccess(attribute_address + stride * vertices[v], size);
                 }
-                break;
             }
-            case PipelineRegs::VertexAttributeFormat::UBYTE: {
-                const u8* srcdata = reinterpret_cast<const u8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::SHORT: {
-                const s16* srcdata = reinterpret_cast<const s16*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
+
+            // The attribute array is addressed directly if all vertices of the batch are in the
+            // same host mapping, which is almost always the case
+            const u8* first = VideoCore::g_memory->GetPhysicalPointer(attribute_address +
+                                                                      stride * *min_vertex);
+            const u8* last = VideoCore::g_memory->GetPhysicalPointer(attribute_address +
+                                                                     stride * *max_vertex);
+            if (first != nullptr && last != nullptr &&
+                last - first == static_cast<std::ptrdiff_t>(stride) * (*max_vertex - *min_vertex)) {
+                const u8* array = first - static_cast<std::ptrdiff_t>(stride) * *min_vertex;
+                for (std::size_t v = 0; v < count; ++v) {
+                    load(array + stride * vertices[v], inputs[v].attr[i]);
                 }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::FLOAT: {
-                const float* srcdata = reinterpret_cast<const float*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
+            } else {
+                for (std::size_t v = 0; v < count; ++v) {
+                    const u8* source = VideoCore::g_memory->GetPhysicalPointer(
+                        attribute_address + stride * vertices[v]);
+                    if (source == nullptr) {
+                        LOG_ERROR(HW_GPU, "Vertex attribute {} of vertex {} is out of memory", i,
+                                  vertices[v]);
+                        inputs[v].attr[i] = {float24::Zero(), float24::Zero(), float24::Zero(),
+                                             float24::FromFloat32(1.0f)};
+                        continue;
+                    }
+                    load(source, inputs[v].attr[i]);
                 }
-                break;
-            }
-            }
-
-            // Default attribute values set if array elements have < 4 components. This
-            // is *not* carried over from the default attribute settings even if they're
-            // enabled for this attribute.
-            for (unsigned int comp = vertex_attribute_elements[i]; comp < 4; ++comp) {
-                input.attr[i][comp] =
-                    comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
             }
 
             LOG_TRACE(HW_GPU,
-                      "Loaded {} components of attribute {:x} for vertex {:x} (index {:x}) from "
-                      "0x{:08x} + 0x{:08x} + 0x{:04x}: {} {} {} {}",
-                      vertex_attribute_elements[i], i, vertex, index, base_address,
-                      vertex_attribute_sources[i], vertex_attribute_strides[i] * vertex,
-                      input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                      input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
+                      "Loaded {} components of attribute {:x} for {} vertices from 0x{:08x} + "
+                      "0x{:08x} with stride 0x{:x}",
+                      vertex_attribute_elements[i], i, count, base_address,
+                      vertex_attribute_sources[i], stride);
         } else if (vertex_attribute_is_default[i]) {
             // Load the default attribute if we're configured to do so
-            input.attr[i] = g_state.input_default_attributes.attr[i];
-            LOG_TRACE(
-                HW_GPU,
-                "Loaded default attribute {:x} for vertex {:x} (index {:x}): ({}, {}, {}, {})", i,
-                vertex, index, input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
+            for (std::size_t v = 0; v < count; ++v) {
+                inputs[v].attr[i] = g_state.input_default_attributes.attr[i];
+            }
+            LOG_TRACE(HW_GPU, "Loaded default attribute {:x} for {} vertices: ({}, {}, {}, {})", i,
+                      count, g_state.input_default_attributes.attr[i][0].ToFloat32(),
+                      g_state.input_default_attributes.attr[i][1].ToFloat32(),
+                      g_state.input_default_attributes.attr[i][2].ToFloat32(),
+                      g_state.input_default_attributes.attr[i][3].ToFloat32());
         } else {
             // TODO(yuriks): In this case, no data gets loaded and the vertex
             // remains with the last value it had. This isn't currently maintained
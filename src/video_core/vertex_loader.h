@@ -1,7 +1,10 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/pica_types.h"
 #include "video_core/regs_pipeline.h"
 
 namespace Pica {
@@ -25,16 +28,29 @@ public:
     void LoadVertex(u32 base_address, int index, int vertex, Shader::AttributeBuffer& input,
                     DebugUtils::MemoryAccessTracker& memory_accesses);
 
+    /**
+     * Loads the attributes of several vertices, one attribute at a time.
+     * @param vertices Indices of the vertices in the attribute arrays
+     * @param inputs Receives the attributes of each vertex
+     */
+    void LoadVertices(u32 base_address, const u32* vertices, std::size_t count,
+                      Shader::AttributeBuffer* inputs,
+                      DebugUtils::MemoryAccessTracker& memory_accesses);
+
     int GetNumTotalAttributes() const {
         return num_total_attributes;
     }
 
 private:
+    /// Converts one attribute of one vertex, specialized for a format and number of elements
+    using AttributeLoadFn = void (*)(const u8* source, Common::Vec4<float24>& attribute);
+
     std::array<u32, 16> vertex_attribute_sources;
     std::array<u32, 16> vertex_attribute_strides{};
     std::array<PipelineRegs::VertexAttributeFormat, 16> vertex_attribute_formats;
     std::array<u32, 16> vertex_attribute_elements{};
     std::array<bool, 16> vertex_attribute_is_default;
+    std::array<AttributeLoadFn, 16> vertex_attribute_load_fns{};
     int num_total_attributes = 0;
     bool is_setup = false;
 };
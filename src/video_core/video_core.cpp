@@ -3,8 +3,11 @@
 // Refer to the license.txt file included.
 
 #include <memory>
+#include <utility>
 #include "common/logging/log.h"
+#include "core/core.h"
 #include "core/settings.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica.h"
 #include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/gl_vars.h"
@@ -17,6 +20,7 @@
 namespace VideoCore {
 
 std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
+std::unique_ptr<GPUThread> g_gpu_thread;
 
 std::atomic<bool> g_hw_renderer_enabled;
 std::atomic<bool> g_shader_jit_enabled;
@@ -45,6 +49,10 @@ Core::System::ResultStatus Init(EmuWindow& emu_window, Memory::MemorySystem& mem
     if (result != Core::System::ResultStatus::Success) {
         LOG_ERROR(Render, "initialization failed !");
     } else {
+        if (Settings::values.use_asynchronous_gpu_emulation) {
+            g_gpu_thread = std::make_unique<GPUThread>(
+                emu_window, Core::System::GetInstance().CoreTiming());
+        }
         LOG_DEBUG(Render, "initialized OK");
     }
 
@@ -53,6 +61,9 @@ Core::System::ResultStatus Init(EmuWindow& emu_window, Memory::MemorySystem& mem
 
 /// Shutdown the video core
 void Shutdown() {
+    // Finish all queued work and take the GL context back before tearing down the renderer
+    g_gpu_thread.reset();
+
     Pica::Shutdown();
 
     g_renderer.reset();
@@ -60,6 +71,22 @@ void Shutdown() {
     LOG_DEBUG(Render, "shutdown OK");
 }
 
+void RunGPUCommand(std::function<void()> command) {
+    if (g_gpu_thread) {
+        g_gpu_thread->PushCommand(std::move(command));
+    } else {
+        command();
+    }
+}
+
+void RunGPUCommandAndWait(std::function<void()> command) {
+    if (g_gpu_thread) {
+        g_gpu_thread->PushCommandAndWait(std::move(command));
+    } else {
+        command();
+    }
+}
+
 void RequestScreenshot(void* data, std::function<void()> callback,
                        const Layout::FramebufferLayout& layout) {
     if (g_renderer_screenshot_requested) {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include "core/core.h"
 #include "core/frontend/emu_window.h"
@@ -21,7 +22,10 @@ class MemorySystem;
 
 namespace VideoCore {
 
+class GPUThread;
+
 extern std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
+extern std::unique_ptr<GPUThread> g_gpu_thread;  ///< Only set in asynchronous GPU mode
 
 // TODO: Wrap these in a user settings struct along with any other graphics settings (often set from
 // qt ui)
@@ -45,6 +49,15 @@ Core::System::ResultStatus Init(EmuWindow& emu_window, Memory::MemorySystem& mem
 /// Shutdown the video core
 void Shutdown();
 
+/**
+ * Runs work for the emulated GPU. In asynchronous GPU mode the work is queued on the GPU thread,
+ * otherwise it is executed immediately on the calling thread.
+ */
+void RunGPUCommand(std::function<void()> command);
+
+/// Like RunGPUCommand, but blocks until the work has been executed
+void RunGPUCommandAndWait(std::function<void()> command);
+
 /// Request a screenshot of the next frame
 void RequestScreenshot(void* data, std::function<void()> callback,
                        const Layout::FramebufferLayout& layout);